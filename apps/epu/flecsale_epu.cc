@@ -0,0 +1,558 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+///////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Merges the per-process exodus files of a distributed run into one.
+///
+/// The parts are expected to follow the Nemesis naming convention, i.e.
+/// name.<num_parts>.<part>, and to carry global node and element id maps.
+/// Nodes are placed by their global id, and the elements of each block are
+/// concatenated in part order.  Polyhedral face blocks are concatenated too,
+/// so faces on part boundaries appear once per part.
+///
+/// The exodus library is not thread safe, so the parts are read one at a
+/// time, but the data is scattered into the merged arrays in parallel.
+///////////////////////////////////////////////////////////////////////////////
+
+// user includes
+#include "../common/parse_arguments.h"
+
+// system includes
+#include <exodusII.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+//! \brief The exodus index type.
+using ex_index_t = int;
+
+//! \brief The real type the data is merged in.
+using ex_real_t = double;
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief An element or face block.
+///////////////////////////////////////////////////////////////////////////////
+struct block_t {
+  //! the block id
+  ex_index_t id = 0;
+  //! the block type, e.g. nsided or nfaced
+  std::string type;
+  //! the number of entries
+  ex_index_t num_entries = 0;
+  //! the number of nodes per entry, or in total for nsided blocks
+  ex_index_t num_nodes = 0;
+  //! the number of faces per entry, or in total for nfaced blocks
+  ex_index_t num_faces = 0;
+  //! the node or face connectivity
+  std::vector<ex_index_t> conn;
+  //! the number of nodes or faces of each entry, for arbitrary polytopes
+  std::vector<ex_index_t> counts;
+
+  //! \brief Return true if the block is made of arbitrary polygons.
+  bool is_nsided() const
+  { return type == "nsided" || type == "NSIDED"; }
+
+  //! \brief Return true if the block is made of arbitrary polyhedra.
+  bool is_nfaced() const
+  { return type == "nfaced" || type == "NFACED"; }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Everything read from one part.
+///////////////////////////////////////////////////////////////////////////////
+struct part_t {
+  //! the exodus file handle
+  int exoid = -1;
+  //! the number of dimensions
+  int num_dims = 0;
+  //! the global id of each node, 1-based
+  std::vector<ex_index_t> node_map;
+  //! the global id of each element, 1-based
+  std::vector<ex_index_t> elem_map;
+  //! the coordinates, one dimension after the other
+  std::vector<ex_real_t> coords;
+  //! the element blocks
+  std::vector<block_t> elem_blocks;
+  //! the face blocks
+  std::vector<block_t> face_blocks;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Abort with a message if an exodus call failed.
+///////////////////////////////////////////////////////////////////////////////
+void check( int status, const std::string & what )
+{
+  if ( status < 0 )
+    raise_runtime_error( "Exodus error " << status << " during " << what );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Read the blocks of one kind.
+///////////////////////////////////////////////////////////////////////////////
+std::vector<block_t> read_blocks( int exoid, ex_entity_type kind, int num )
+{
+  std::vector<block_t> blocks( num );
+  if ( num == 0 ) return blocks;
+
+  std::vector<ex_index_t> ids( num );
+  check( ex_get_ids( exoid, kind, ids.data() ), "reading block ids" );
+
+  for ( int b=0; b<num; b++ ) {
+    auto & blk = blocks[b];
+    blk.id = ids[b];
+
+    char type[MAX_STR_LENGTH+1];
+    ex_index_t num_edges = 0, num_attr = 0;
+    check(
+      ex_get_block(
+        exoid, kind, blk.id, type, &blk.num_entries, &blk.num_nodes,
+        &num_edges, &blk.num_faces, &num_attr ),
+      "reading a block header"
+    );
+    blk.type = type;
+
+    if ( blk.is_nfaced() ) {
+      blk.conn.resize( blk.num_faces );
+      blk.counts.resize( blk.num_entries );
+      check(
+        ex_get_conn( exoid, kind, blk.id, nullptr, nullptr, blk.conn.data() ),
+        "reading face connectivity"
+      );
+    }
+    else {
+      auto size = blk.is_nsided() ?
+        blk.num_nodes : blk.num_entries * blk.num_nodes;
+      blk.conn.resize( size );
+      check(
+        ex_get_conn( exoid, kind, blk.id, blk.conn.data(), nullptr, nullptr ),
+        "reading node connectivity"
+      );
+      if ( blk.is_nsided() ) blk.counts.resize( blk.num_entries );
+    }
+
+    if ( !blk.counts.empty() )
+      check(
+        ex_get_entity_count_per_polyhedra(
+          exoid, kind, blk.id, blk.counts.data() ),
+        "reading entity counts"
+      );
+  }
+
+  return blocks;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Open a part and read its mesh.
+///////////////////////////////////////////////////////////////////////////////
+part_t read_part( const std::string & name )
+{
+  part_t part;
+
+  int cpu_word_size = sizeof(ex_real_t);
+  int io_word_size = 0;
+  float version;
+  part.exoid = ex_open(
+    name.c_str(), EX_READ, &cpu_word_size, &io_word_size, &version );
+  if ( part.exoid < 0 ) raise_runtime_error( "Could not open " << name );
+
+  ex_init_params exopar;
+  check( ex_get_init_ext( part.exoid, &exopar ), "reading " + name );
+
+  part.num_dims = exopar.num_dim;
+  auto num_nodes = exopar.num_nodes;
+  auto num_elem = exopar.num_elem;
+
+  // the global ids.  Files without maps get the identity.
+  part.node_map.resize( num_nodes );
+  part.elem_map.resize( num_elem );
+  check( ex_get_id_map( part.exoid, EX_NODE_MAP, part.node_map.data() ),
+    "reading the node map" );
+  check( ex_get_id_map( part.exoid, EX_ELEM_MAP, part.elem_map.data() ),
+    "reading the element map" );
+
+  part.coords.resize( 3*num_nodes, 0 );
+  check(
+    ex_get_coord(
+      part.exoid, part.coords.data(), part.coords.data()+num_nodes,
+      part.coords.data()+2*num_nodes ),
+    "reading coordinates"
+  );
+
+  part.face_blocks = read_blocks( part.exoid, EX_FACE_BLOCK, exopar.num_face_blk );
+  part.elem_blocks = read_blocks( part.exoid, EX_ELEM_BLOCK, exopar.num_elem_blk );
+
+  return part;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Read the names of one kind of variable.
+///////////////////////////////////////////////////////////////////////////////
+std::vector<std::string> read_var_names( int exoid, ex_entity_type kind )
+{
+  int num = 0;
+  check( ex_get_variable_param( exoid, kind, &num ), "reading variables" );
+  if ( num == 0 ) return {};
+
+  std::vector< std::vector<char> > storage(
+    num, std::vector<char>( MAX_STR_LENGTH+1, '\0' ) );
+  std::vector<char*> names( num );
+  for ( int i=0; i<num; i++ ) names[i] = storage[i].data();
+  check( ex_get_variable_names( exoid, kind, num, names.data() ),
+    "reading variable names" );
+
+  return { names.begin(), names.end() };
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Write the names of one kind of variable.
+///////////////////////////////////////////////////////////////////////////////
+void write_var_names(
+  int exoid, ex_entity_type kind, const std::vector<std::string> & names )
+{
+  if ( names.empty() ) return;
+  std::vector<char*> ptrs;
+  for ( const auto & n : names ) ptrs.emplace_back( const_cast<char*>( n.c_str() ) );
+  check( ex_put_variable_param( exoid, kind, names.size() ), "writing variables" );
+  check( ex_put_variable_names( exoid, kind, names.size(), ptrs.data() ),
+    "writing variable names" );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Concatenate one block over all the parts.
+//!
+//! \param [in] parts  The parts.
+//! \param [in] blk  The index of the block.
+//! \param [in] face_blocks  True for face blocks.
+//! \param [in] face_maps  The merged id of each face of each part, used to
+//!                        renumber the faces of polyhedra.
+//! \return The merged block.
+///////////////////////////////////////////////////////////////////////////////
+block_t merge_block(
+  const std::vector<part_t> & parts, std::size_t blk, bool face_blocks,
+  const std::vector< std::vector<ex_index_t> > & face_maps )
+{
+  auto num_parts = parts.size();
+
+  const auto & first =
+    face_blocks ? parts[0].face_blocks[blk] : parts[0].elem_blocks[blk];
+
+  block_t merged;
+  merged.id = first.id;
+  merged.type = first.type;
+
+  // figure out where each part goes
+  std::vector<std::size_t> entry_offset( num_parts+1, 0 ), conn_offset( num_parts+1, 0 );
+  for ( std::size_t p=0; p<num_parts; p++ ) {
+    const auto & b = face_blocks ? parts[p].face_blocks[blk] : parts[p].elem_blocks[blk];
+    if ( b.id != first.id )
+      raise_runtime_error( "The parts list their blocks in different orders" );
+    if ( b.type != first.type )
+      raise_runtime_error( "Block " << b.id << " has different types in different parts" );
+    entry_offset[p+1] = entry_offset[p] + b.num_entries;
+    conn_offset[p+1] = conn_offset[p] + b.conn.size();
+  }
+
+  merged.num_entries = entry_offset.back();
+  merged.conn.resize( conn_offset.back() );
+  if ( !first.counts.empty() ) merged.counts.resize( merged.num_entries );
+  if ( first.is_nsided() )      merged.num_nodes = merged.conn.size();
+  else if ( first.is_nfaced() ) merged.num_faces = merged.conn.size();
+  else                          merged.num_nodes = first.num_nodes;
+
+  // each part fills its own slice
+  #pragma omp parallel for
+  for ( std::size_t p=0; p<num_parts; p++ ) {
+    const auto & part = parts[p];
+    const auto & b = face_blocks ? part.face_blocks[blk] : part.elem_blocks[blk];
+    auto conn = merged.conn.data() + conn_offset[p];
+    if ( b.is_nfaced() )
+      for ( std::size_t i=0; i<b.conn.size(); i++ )
+        conn[i] = face_maps[p][ b.conn[i]-1 ];
+    else
+      for ( std::size_t i=0; i<b.conn.size(); i++ )
+        conn[i] = part.node_map[ b.conn[i]-1 ];
+    std::copy( b.counts.begin(), b.counts.end(),
+      merged.counts.begin() + entry_offset[p] );
+  }
+
+  return merged;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Write a merged block.
+///////////////////////////////////////////////////////////////////////////////
+void write_block( int exoid, ex_entity_type kind, const block_t & blk )
+{
+  check(
+    ex_put_block(
+      exoid, kind, blk.id, blk.type.c_str(), blk.num_entries, blk.num_nodes,
+      0, blk.num_faces, 0 ),
+    "writing a block header"
+  );
+  if ( blk.is_nfaced() )
+    check( ex_put_conn( exoid, kind, blk.id, nullptr, nullptr, blk.conn.data() ),
+      "writing face connectivity" );
+  else
+    check( ex_put_conn( exoid, kind, blk.id, blk.conn.data(), nullptr, nullptr ),
+      "writing node connectivity" );
+  if ( !blk.counts.empty() )
+    check(
+      ex_put_entity_count_per_polyhedra( exoid, kind, blk.id, blk.counts.data() ),
+      "writing entity counts"
+    );
+}
+
+} // namespace
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief The main program.
+///////////////////////////////////////////////////////////////////////////////
+int main( int argc, char** argv )
+{
+
+  //===========================================================================
+  // Parse arguments
+  //===========================================================================
+
+  option long_options[] = {
+    {"help",   no_argument,       0, 'h'},
+    {"parts",  required_argument, 0, 'p'},
+    {"output", required_argument, 0, 'o'},
+    {0, 0, 0, 0}
+  };
+  const char * short_options = "hp:o:";
+
+  auto args = parse_arguments( argc, argv, long_options, short_options );
+
+  auto print_usage = [&]() {
+    std::cout << "Usage: " << argv[0]
+      << " -p <num_parts> [-o <output>] <name>" << std::endl << std::endl
+      << "Merges the files <name>.<num_parts>.<part> into <output>, which"
+      << std::endl << "defaults to <name>." << std::endl;
+  };
+
+  if ( args.count("h") ) {
+    print_usage();
+    return 0;
+  }
+
+  if ( !args.count("p") || optind+1 != argc ) {
+    print_usage();
+    return 1;
+  }
+
+  std::string name = argv[optind];
+  int num_parts = std::stoi( args.at("p") );
+  std::string output = args.count("o") ? args.at("o") : name;
+
+  if ( num_parts < 1 ) raise_runtime_error( "Need at least one part" );
+
+  //===========================================================================
+  // Read the meshes
+  //===========================================================================
+
+  auto width = std::to_string( num_parts-1 ).size();
+
+  std::vector<part_t> parts;
+  parts.reserve( num_parts );
+
+  for ( int p=0; p<num_parts; p++ ) {
+    std::stringstream ss;
+    ss << name << "." << num_parts << "."
+       << std::setw( width ) << std::setfill( '0' ) << p;
+    std::cout << "Reading " << ss.str() << std::endl;
+    parts.emplace_back( read_part( ss.str() ) );
+  }
+
+  auto num_dims = parts[0].num_dims;
+  auto num_elem_blk = parts[0].elem_blocks.size();
+  auto num_face_blk = parts[0].face_blocks.size();
+
+  for ( const auto & part : parts )
+    if ( part.num_dims != num_dims ||
+         part.elem_blocks.size() != num_elem_blk ||
+         part.face_blocks.size() != num_face_blk )
+      raise_runtime_error( "The parts do not describe the same mesh" );
+
+  //===========================================================================
+  // Merge the meshes
+  //===========================================================================
+
+  // every node is placed by its global id
+  ex_index_t num_nodes = 0;
+  for ( const auto & part : parts )
+    for ( auto id : part.node_map ) num_nodes = std::max( num_nodes, id );
+
+  std::vector<ex_real_t> coords( 3*num_nodes, 0 );
+  for ( const auto & part : parts ) {
+    auto n = part.node_map.size();
+    #pragma omp parallel for
+    for ( std::size_t i=0; i<n; i++ )
+      for ( int d=0; d<num_dims; d++ )
+        coords[ d*num_nodes + part.node_map[i]-1 ] = part.coords[ d*n + i ];
+  }
+
+  // the faces are merged block by block, and each block concatenates the 
+  // parts in order.  Work out where each face of each part ends up; the 
+  // faces of a part are numbered block by block too.
+  std::vector< std::vector<ex_index_t> > face_maps( num_parts );
+  {
+    ex_index_t merged_id = 0;
+    for ( std::size_t b=0; b<num_face_blk; b++ )
+      for ( int p=0; p<num_parts; p++ ) {
+        auto n = parts[p].face_blocks[b].num_entries;
+        for ( ex_index_t i=0; i<n; i++ ) face_maps[p].emplace_back( ++merged_id );
+      }
+  }
+
+  std::vector<block_t> face_blocks;
+  for ( std::size_t b=0; b<num_face_blk; b++ )
+    face_blocks.emplace_back( merge_block( parts, b, true, face_maps ) );
+
+  std::vector<block_t> elem_blocks;
+  for ( std::size_t b=0; b<num_elem_blk; b++ )
+    elem_blocks.emplace_back( merge_block( parts, b, false, face_maps ) );
+
+  // the elements are ordered by block, then by part
+  std::vector<ex_index_t> elem_map;
+  for ( std::size_t b=0; b<num_elem_blk; b++ )
+    for ( const auto & part : parts ) {
+      ex_index_t start = 0;
+      for ( std::size_t k=0; k<b; k++ ) start += part.elem_blocks[k].num_entries;
+      auto n = part.elem_blocks[b].num_entries;
+      elem_map.insert( elem_map.end(),
+        part.elem_map.begin() + start, part.elem_map.begin() + start + n );
+    }
+  ex_index_t num_elem = elem_map.size();
+  ex_index_t num_faces = 0;
+  for ( const auto & b : face_blocks ) num_faces += b.num_entries;
+
+  //===========================================================================
+  // Write the merged mesh
+  //===========================================================================
+
+  std::cout << "Writing " << output << " with " << num_nodes << " nodes and "
+    << num_elem << " elements" << std::endl;
+
+  int cpu_word_size = sizeof(ex_real_t);
+  int io_word_size = sizeof(ex_real_t);
+  auto exoid = ex_create( output.c_str(), EX_CLOBBER, &cpu_word_size, &io_word_size );
+  if ( exoid < 0 ) raise_runtime_error( "Could not create " << output );
+
+  ex_init_params exopar;
+  std::memset( &exopar, 0, sizeof(exopar) );
+  std::strcpy( exopar.title, "Exodus II output from flecsi." );
+  exopar.num_dim = num_dims;
+  exopar.num_nodes = num_nodes;
+  exopar.num_face = num_faces;
+  exopar.num_face_blk = num_face_blk;
+  exopar.num_elem = num_elem;
+  exopar.num_elem_blk = num_elem_blk;
+  check( ex_put_init_ext( exoid, &exopar ), "initializing the output" );
+
+  check(
+    ex_put_coord( exoid, coords.data(), coords.data()+num_nodes,
+      coords.data()+2*num_nodes ),
+    "writing coordinates"
+  );
+  const char * coord_names[3] = { "x", "y", "z" };
+  check( ex_put_coord_names( exoid, const_cast<char**>(coord_names) ),
+    "writing coordinate names" );
+
+  for ( const auto & b : face_blocks ) write_block( exoid, EX_FACE_BLOCK, b );
+  for ( const auto & b : elem_blocks ) write_block( exoid, EX_ELEM_BLOCK, b );
+
+  check( ex_put_id_map( exoid, EX_ELEM_MAP, elem_map.data() ),
+    "writing the element map" );
+
+  //===========================================================================
+  // Merge the fields
+  //===========================================================================
+
+  auto nodal_names = read_var_names( parts[0].exoid, EX_NODAL );
+  auto elem_names = read_var_names( parts[0].exoid, EX_ELEM_BLOCK );
+  write_var_names( exoid, EX_NODAL, nodal_names );
+  write_var_names( exoid, EX_ELEM_BLOCK, elem_names );
+
+  auto num_steps = ex_inquire_int( parts[0].exoid, EX_INQ_TIME );
+
+  std::vector<ex_real_t> values, part_values;
+
+  for ( int step=1; step<=num_steps; step++ ) {
+
+    ex_real_t time;
+    check( ex_get_time( parts[0].exoid, step, &time ), "reading the time" );
+    check( ex_put_time( exoid, step, &time ), "writing the time" );
+
+    // nodal fields go by global id
+    for ( std::size_t v=0; v<nodal_names.size(); v++ ) {
+      values.assign( num_nodes, 0 );
+      for ( const auto & part : parts ) {
+        auto n = part.node_map.size();
+        part_values.resize( n );
+        check(
+          ex_get_var( part.exoid, step, EX_NODAL, v+1, 1, n, part_values.data() ),
+          "reading a nodal field"
+        );
+        #pragma omp parallel for
+        for ( std::size_t i=0; i<n; i++ )
+          values[ part.node_map[i]-1 ] = part_values[i];
+      }
+      check(
+        ex_put_var( exoid, step, EX_NODAL, v+1, 1, num_nodes, values.data() ),
+        "writing a nodal field"
+      );
+    }
+
+    // element fields are concatenated block by block
+    for ( std::size_t v=0; v<elem_names.size(); v++ ) {
+      for ( const auto & blk : elem_blocks ) {
+        values.clear();
+        values.reserve( blk.num_entries );
+        for ( const auto & part : parts ) {
+          auto it = std::find_if(
+            part.elem_blocks.begin(), part.elem_blocks.end(),
+            [&]( const auto & b ) { return b.id == blk.id; } );
+          if ( it == part.elem_blocks.end() )
+            raise_runtime_error( "Element block " << blk.id << " is missing from a part" );
+          auto n = it->num_entries;
+          part_values.resize( n );
+          if ( n > 0 )
+            check(
+              ex_get_var(
+                part.exoid, step, EX_ELEM_BLOCK, v+1, blk.id, n,
+                part_values.data() ),
+              "reading an element field"
+            );
+          values.insert( values.end(), part_values.begin(), part_values.end() );
+        }
+        check(
+          ex_put_var(
+            exoid, step, EX_ELEM_BLOCK, v+1, blk.id, blk.num_entries,
+            values.data() ),
+          "writing an element field"
+        );
+      }
+    }
+
+  }
+
+  //===========================================================================
+  // Done
+  //===========================================================================
+
+  for ( auto & part : parts ) ex_close( part.exoid );
+  check( ex_close( exoid ), "closing the output" );
+
+  return 0;
+
+}
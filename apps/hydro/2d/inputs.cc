@@ -31,11 +31,21 @@ template<> string base_t::postfix = "dat";
 // output frequency
 template<> size_t base_t::output_freq = 100;
 
+// what gets written to each output file
+template<> flecsale::mesh::output_profile_t base_t::output_profile = {};
+
 // the CFL and final solution time
 template<> real_t base_t::CFL = 1.0/2.0;
 template<> real_t base_t::final_time = 0.2;
 template<> size_t base_t::max_steps = 1e6;
 
+// global time stepping by default
+template<> size_t base_t::time_step_levels = 1;
+
+// only the cells and faces are needed
+template<> unsigned base_t::mesh_requirements =
+  flecsale::mesh::burton::attributes::require_none;
+
 // the equation of state
 template<> std::shared_ptr<eos_t> base_t::eos = 
   std::make_shared< flecsale::eos::ideal_gas_t<real_t> >( 
@@ -60,6 +70,10 @@ inputs_t::ics_function_t base_t::ics =
     return std::make_tuple( d, v, p );
   };
 
+// the pointwise function above is used unless this is set
+template<>
+inputs_t::ics_block_function_t base_t::ics_block = {};
+
 // This function builds and returns a mesh
 template<>
 inputs_t::mesh_function_t base_t::make_mesh = 
@@ -0,0 +1,38 @@
+hydro = {
+  -- The case prefix and postfixes
+  prefix = "shock_box_2d_block",
+  postfix = "dat",
+  -- The frequency of outputs
+  output_freq = "7",
+  -- The time stepping parameters
+  final_time = 0.2,
+  max_steps = 1e6,
+  CFL = 1./2.,
+  -- the mesh
+  mesh = {
+    type = "box",
+    dimensions = {10, 10},
+    xmin = {-0.5, -0.5},
+    xmax = { 0.5,  0.5}
+  },
+  -- the equation of state
+  eos = {
+    type = "ideal_gas",
+    gas_constant = 1.4,
+    specific_heat = 1.0
+  },
+  -- the initial conditions, a block of cells at a time
+  -- return densities, velocities, pressures
+  ics_block = function (x,y,t)
+    local d, vx, vy, p = {}, {}, {}, {}
+    for i = 1, #x do
+      if x[i] < 0 and y[i] < 0 then
+        d[i], p[i] = 0.125, 0.1
+      else
+        d[i], p[i] = 1.0, 1.0
+      end
+      vx[i], vy[i] = 0, 0
+    end
+    return d, {vx, vy}, p
+  end
+}
@@ -0,0 +1,36 @@
+hydro = {
+  -- The case prefix and postfixes
+  prefix = "shock_box_2d_expr",
+  postfix = "dat",
+  -- The frequency of outputs
+  output_freq = "7",
+  -- The time stepping parameters
+  final_time = 0.2,
+  max_steps = 1e6,
+  CFL = 1./2.,
+  -- the mesh
+  mesh = {
+    type = "box",
+    dimensions = {10, 10},
+    xmin = {-0.5, -0.5},
+    xmax = { 0.5,  0.5}
+  },
+  -- the equation of state
+  eos = {
+    type = "ideal_gas",
+    gas_constant = 1.4,
+    specific_heat = 1.0
+  },
+  -- named constants for the initial conditions
+  constants = {
+    d_low = 0.125,
+    p_low = 0.1
+  },
+  -- the initial conditions as an expression, which lists the
+  -- density, velocity components and pressure
+  ics = [[
+    if x < 0 and y < 0 then d_low else 1 end,
+    0, 0,
+    if x < 0 and y < 0 then p_low else 1 end
+  ]]
+}
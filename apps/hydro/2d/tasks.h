@@ -27,7 +27,7 @@ namespace hydro {
 //! \return 0 for success
 ////////////////////////////////////////////////////////////////////////////////
 int initial_conditions_task( 
-  mesh_2d_t & mesh, inputs_t::ics_function_t ics 
+  mesh_2d_t & mesh, inputs_t::ics_block_function_t ics 
 ) {
   return initial_conditions( mesh, ics );
 }
@@ -96,6 +96,19 @@ solution_error_t apply_update_task(
   return apply_update( mesh, tolerance, first_time );
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! \brief The main task to update the solution using local time stepping.
+//!
+//! \param [in,out] mesh the mesh object
+//! \return the state of the solution
+////////////////////////////////////////////////////////////////////////////////
+solution_error_t apply_local_update_task( 
+  mesh_2d_t & mesh, const eos_t * eos, size_t num_levels, 
+  real_t tolerance, bool first_time
+) {
+  return apply_local_update( mesh, eos, num_levels, tolerance, first_time );
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! \brief The main task to save the coordinates
 //!
@@ -128,6 +141,7 @@ flecsi_register_task(update_state_from_energy_task, loc, single);
 flecsi_register_task(evaluate_time_step_task, loc, single);
 flecsi_register_task(evaluate_fluxes_task, loc, single);
 flecsi_register_task(apply_update_task, loc, single);
+flecsi_register_task(apply_local_update_task, loc, single);
 flecsi_register_task(save_solution_task, loc, single);
 flecsi_register_task(restore_solution_task, loc, single);
 
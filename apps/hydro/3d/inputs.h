@@ -62,17 +62,21 @@ public:
 
     // now set some dimension specific inputs
 
-    // set the ics function
-    auto ics_func = lua_try_access( hydro_input, "ics" );
-    ics = [ics_func]( const vector_t & x, const real_t & t )
-      {
-        real_t d, p;
-        vector_t v(0);
-        std::tie(d, v, p) = 
-          ics_func(x[0], x[1], x[2], t).as<real_t, vector_t, real_t>();
-        return std::make_tuple( d, std::move(v), p );
-      };
-      
+    // set the ics function, unless a block-wise one was given.  Lua is
+    // not thread safe, so the cells are set one block at a time.
+    if ( !ics_block ) {
+      flecsale::utils::lua_function_t ics_func( 
+        lua_try_access( hydro_input, "ics" ) );
+      ics = [ics_func]( const vector_t & x, const real_t & t )
+        {
+          real_t d, p;
+          vector_t v(0);
+          ics_func.call_into( std::tie(d, v, p), x[0], x[1], x[2], t );
+          return std::make_tuple( d, std::move(v), p );
+        };
+      ics_block = make_ics_block( ics, /* thread_safe */ false );
+    }
+
     // now set the mesh building function
     auto mesh_input = lua_try_access( hydro_input, "mesh" );
     auto mesh_type = lua_try_access_as(mesh_input, "type", std::string );
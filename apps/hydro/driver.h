@@ -14,7 +14,11 @@
 #include "../common/parse_arguments.h"
 
 // user includes
+#include <flecsale/io/lossy.h>
+#include <flecsale/mesh/decomposition.h>
 #include <flecsale/mesh/mesh_utils.h>
+#include <flecsale/utils/memory_utils.h>
+#include <flecsale/utils/mpi_utils.h>
 #include <flecsale/utils/time_utils.h>
 #include <flecsale/io/catalyst/adaptor.h>
 
@@ -24,6 +28,7 @@
 #include <iomanip>
 #include <iostream>
 #include <sstream>
+#include <type_traits>
 #include <utility>
 
 namespace apps {
@@ -40,6 +45,9 @@ int driver(int argc, char** argv)
   // set exceptions 
   enable_exceptions();
 
+  // make sure mpi is running if we need it
+  utils::mpi_session_t mpi_session( argc, argv );
+
   //===========================================================================
   // Parse arguments
   //===========================================================================
@@ -49,12 +57,20 @@ int driver(int argc, char** argv)
     std::cout << "Usage: " << argv[0] 
               << " [--file INPUT_FILE]"
               << " [--catalyst PYTHON_SCRIPT]"
+              << " [--validate LEVEL]"
+              << " [--totals FILE]"
               << " [--help]"
               << std::endl << std::endl;
     std::cout << "\t--file INPUT_FILE:\t Override the input file "
               << "with INPUT_FILE." << std::endl;
     std::cout << "\t--catalyst PYTHON_SCRIPT:\t Load catalyst with "
               << "using PYTHON_SCRIPT." << std::endl;
+    std::cout << "\t--validate LEVEL:\t Check the mesh with LEVEL, i.e. "
+              << "none, quick (the default) or full.  Full only adds the "
+              << "corner and wedge checks, so it is the same as quick for "
+              << "meshes built without corners." << std::endl;
+    std::cout << "\t--totals FILE:\t Write the final conserved totals "
+              << "and center of mass to FILE." << std::endl;
     std::cout << "\t--help:\t Print a help message." << std::endl;
   };
 
@@ -64,9 +80,11 @@ int driver(int argc, char** argv)
       {"help",           no_argument, 0, 'h'},
       {"file",     required_argument, 0, 'f'},
       {"catalyst", required_argument, 0, 'c'},
+      {"validate", required_argument, 0, 'v'},
+      {"totals",   required_argument, 0, 't'},
       {0, 0, 0, 0}
     };
-  const char * short_options = "hf:c:";
+  const char * short_options = "hf:c:v:t:";
 
   // parse the arguments
   auto args = parse_arguments(argc, argv, long_options, short_options);
@@ -92,6 +110,14 @@ int driver(int argc, char** argv)
     inputs_t::load( input_file_name );
   }
 
+  // how much checking of the mesh to do
+  auto validation = mesh::burton::attributes::to_validation(
+    args.count("v") ? args.at("v") : std::string("quick") );
+
+  // where to write the final totals, if anywhere
+  auto totals_file_name = 
+    args.count("t") ? args.at("t") : std::string();
+
   // get the catalyst arguments
   auto catalyst_args = 
     args.count("c") ? args.at("c") : std::string();
@@ -110,14 +136,35 @@ int driver(int argc, char** argv)
   // Mesh Setup
   //===========================================================================
 
-  // make the mesh
-  auto mesh = inputs_t::make_mesh( /* solution time */ 0.0 );
+  // make the mesh, with only the parts the solver needs
+  inputs_t::mesh_t::default_requirements() = inputs_t::mesh_requirements;
+  auto tmesh = utils::get_wall_time();
+
+  // with more than one process, only the first one builds the whole mesh,
+  // and hands every other process its own part
+  auto mesh = utils::comm_rank() == 0 ?
+    inputs_t::make_mesh( /* solution time */ 0.0 ) :
+    typename inputs_t::mesh_t();
+  mesh::distribute( mesh );
+
+  // what gets written to the output files
+  mesh.set_output_profile( inputs_t::output_profile );
+
+  // the full checks are all about the corners
+  if ( validation == mesh::burton::attributes::validate_full && 
+       !mesh.has_corners() )
+    cout << "Warning: the mesh has no corners, so full validation only "
+         << "checks the face normals." << endl;
 
   // this is the mesh object
-  mesh.is_valid();
+  mesh.is_valid( validation );
   
   cout << mesh;
 
+  tmesh = utils::get_wall_time() - tmesh;
+  cout << "Mesh setup took " << tmesh << " s, peak memory " 
+       << utils::get_peak_memory() / 1048576. << " MB." << endl;
+
   //===========================================================================
   // Some typedefs
   //===========================================================================
@@ -169,25 +216,45 @@ int driver(int argc, char** argv)
   // type since I will only ever be accesissing all the data at once.
   flecsi_register_data(mesh, hydro, flux, flux_data_t, dense, 1, faces);
 
-  // register the time step and set a cfl
+  // register the time step and set a cfl.  The stable time step is the
+  // cfl limit for the current solution.
   flecsi_register_data( mesh, hydro, time_step, real_t, global, 1 );
+  flecsi_register_data( mesh, hydro, stable_time_step, real_t, global, 1 );
   flecsi_register_data( mesh, hydro, cfl, real_t, global, 1 );
   *flecsi_get_accessor( mesh, hydro, cfl, real_t, global, 0) = inputs_t::CFL;  
 
   // Register the total energy
   flecsi_register_data( mesh, hydro, sum_total_energy, real_t, global, 1 );
 
+  // local time stepping needs a few more fields, and keeps track of the 
+  // work it saves
+  const auto use_local_time_steps = inputs_t::time_step_levels > 1;
+
+  if ( use_local_time_steps ) {
+    flecsi_register_data(mesh, hydro, flux_integral, flux_data_t, dense, 1, cells);
+    flecsi_register_data(mesh, hydro, cell_time_level, int, dense, 1, cells);
+    flecsi_register_data(mesh, hydro, face_time_level, int, dense, 1, faces);
+    flecsi_register_data( mesh, hydro, local_cell_updates, real_t, global, 1 );
+    flecsi_register_data( mesh, hydro, global_cell_updates, real_t, global, 1 );
+    *flecsi_get_accessor( mesh, hydro, local_cell_updates, real_t, global, 0 ) = 0;
+    *flecsi_get_accessor( mesh, hydro, global_cell_updates, real_t, global, 0 ) = 0;
+  }
+
 
   //===========================================================================
   // Initial conditions
   //===========================================================================
   
   // now call the main task to set the ics.  Here we set primitive/physical 
-  // quanties
-  flecsi_execute_task( initial_conditions_task, loc, single, mesh, inputs_t::ics );
+  // quanties, a block of cells at a time
+  auto ics = inputs_t::ics_block ? 
+    inputs_t::ics_block : inputs_t::make_ics_block( inputs_t::ics );
+  flecsi_execute_task( initial_conditions_task, loc, single, mesh, ics );
   
   #ifdef HAVE_CATALYST
     auto insitu = io::catalyst::adaptor_t(catalyst_scripts);
+    // the topology is built once, and the fields are shared with the mesh
+    mesh::vtk_grid_t< std::decay_t<decltype(mesh)> > vtk_grid;
     std::cout << "Catalyst on!" << std::endl;
   #endif
 
@@ -196,6 +263,10 @@ int driver(int argc, char** argv)
     update_state_from_pressure_task, loc, single, mesh, inputs_t::eos.get() 
   );
 
+  // compute the first time step, update_state_from_energy takes care of
+  // the rest
+  flecsi_execute_task( evaluate_time_step_task, loc, single, mesh );
+
   //===========================================================================
   // Pre-processing
   //===========================================================================
@@ -215,10 +286,15 @@ int driver(int argc, char** argv)
 
   // get an accessor for the time step
   auto time_step = flecsi_get_accessor( mesh, hydro, time_step, real_t, global, 0 );   
+  auto stable_time_step = 
+    flecsi_get_accessor( mesh, hydro, stable_time_step, real_t, global, 0 );   
 
   // a counter for this session
   size_t num_steps = 0; 
 
+  // set if the solver had to give up
+  bool failed = false;
+
   for ( size_t num_retries = 0;
     (num_steps < inputs_t::max_steps && soln_time < inputs_t::final_time); 
     ++num_steps 
@@ -228,17 +304,21 @@ int driver(int argc, char** argv)
     if (num_retries == 0)
       flecsi_execute_task( save_solution_task, loc, single, mesh );
 
-    // compute the time step
-    flecsi_execute_task( evaluate_time_step_task, loc, single, mesh );
- 
-    // access the computed time step and make sure its not too large
-    *time_step = std::min( *time_step, inputs_t::final_time - soln_time );       
+    // the stable time step was computed when the state was last updated.
+    // With local time stepping, this is the step of the finest level.
+    *time_step = *stable_time_step;
+    if ( use_local_time_steps )
+      *time_step *= ( 1 << (inputs_t::time_step_levels-1) );
+
+    // make sure its not too large
+    *time_step = std::min( *time_step, inputs_t::final_time - soln_time );
 
     //-------------------------------------------------------------------------
     // try a timestep
 
-    // compute the fluxes
-    flecsi_execute_task( evaluate_fluxes_task, loc, single, mesh );
+    // compute the fluxes, local time stepping does this for each sub-step
+    if ( !use_local_time_steps )
+      flecsi_execute_task( evaluate_fluxes_task, loc, single, mesh );
 
     // reset the time stepping mode
     auto mode = mode_t::normal;
@@ -259,11 +339,22 @@ int driver(int argc, char** argv)
       cout.precision(ss);
 
       // Loop over each cell, scattering the fluxes to the cell
-      auto err = 
-        flecsi_execute_task( 
-          apply_update_task, loc, single, mesh, machine_zero, true 
-        );
-      auto update_flag = err.get();
+      auto update_flag = solution_error_t::ok;
+      if ( use_local_time_steps ) {
+        auto err = 
+          flecsi_execute_task( 
+            apply_local_update_task, loc, single, mesh, inputs_t::eos.get(),
+            inputs_t::time_step_levels, machine_zero, true 
+          );
+        update_flag = err.get();
+      }
+      else {
+        auto err = 
+          flecsi_execute_task( 
+            apply_update_task, loc, single, mesh, machine_zero, true 
+          );
+        update_flag = err.get();
+      }
 
 
       // dump the current errored solution to a file
@@ -301,12 +392,18 @@ int driver(int argc, char** argv)
       if (mode==mode_t::retry || mode==mode_t::restart) {
         // restore the initial solution
         flecsi_execute_task( restore_solution_task, loc, single, mesh );
+        // local time stepping updated the derived quantities along the way
+        if ( use_local_time_steps )
+          flecsi_execute_task( 
+            update_state_from_energy_task, loc, single, mesh, inputs_t::eos.get() 
+          );
         // don't retry forever
         if ( ++num_retries > max_retries ) {
           // Print a message we are exiting
           std::cout << "Too many retries, exiting..." << std::endl;
           // flag that we want to quit
           mode = mode_t::quit;
+          failed = true;
         }
       }
 
@@ -329,9 +426,10 @@ int driver(int argc, char** argv)
 
     #ifdef HAVE_CATALYST
     if (!catalyst_scripts.empty()) {
-      auto vtk_grid = mesh::to_vtk( mesh );
+      // the grid is only updated if a pipeline wants this step
       insitu.process( 
-        vtk_grid, soln_time, num_steps, (num_steps==inputs_t::max_steps-1)
+        [&]() { return vtk_grid.update( mesh ); },
+        soln_time, num_steps, (num_steps==inputs_t::max_steps-1)
       );
     }
     #endif
@@ -365,13 +463,34 @@ int driver(int argc, char** argv)
   std::cout << "Elapsed wall time is " << std::setprecision(4) << std::fixed 
             << tdelta << "s." << std::endl;
 
+  // report the work saved by local time stepping
+  if ( use_local_time_steps ) {
+    auto lts_work = 
+      *flecsi_get_accessor( mesh, hydro, local_cell_updates, real_t, global, 0 );
+    auto global_work = 
+      *flecsi_get_accessor( mesh, hydro, global_cell_updates, real_t, global, 0 );
+    std::cout << "Local time stepping used " << std::setprecision(0) 
+              << lts_work << " cell-updates versus " << global_work 
+              << " with global time stepping (" << std::setprecision(1)
+              << 100 * (1 - lts_work / global_work) << "% saved)." 
+              << std::endl;
+  }
+
 
   // now output the checksums
   mesh::checksum(mesh);
 
+  // and the totals, so runs can be compared
+  if ( !totals_file_name.empty() )
+    write_totals( mesh, totals_file_name );
+
+  // and how well the lossily stored fields compressed
+  const auto & lossy_stats = io::lossy_stats_t::instance();
+  if ( !lossy_stats.empty() ) lossy_stats.report( std::cout );
+
 
-  // success if you reached here
-  return 0;
+  // success if you reached here without giving up
+  return failed ? 1 : 0;
 
 }
 
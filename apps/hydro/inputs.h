@@ -14,10 +14,21 @@
 #include <flecsale/eos/eos_base.h>
 #include <flecsale/eos/ideal_gas.h>
 #include <flecsale/mesh/burton/burton.h>
+#include <flecsale/mesh/output_profile.h>
+#include <flecsale/utils/expression.h>
 #include <flecsale/utils/lua_utils.h>
 
 // system includes
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 namespace apps {
 namespace hydro {
@@ -54,6 +65,14 @@ public:
     std::function< ics_return_t(const vector_t & x, const real_t & t) >;
   //! \}
 
+  //! \brief The block-wise ics function type.  It is called with the number
+  //!        of cells in the block, their centroids and the time, and fills
+  //!        their density, velocity and pressure.
+  using ics_block_function_t = std::function< 
+    void( std::size_t n, const vector_t * x, const real_t & t,
+      real_t * d, vector_t * v, real_t * p ) 
+  >;
+
   //! the mesh function type
   using mesh_function_t = std::function< mesh_t(const real_t & t) >;
 
@@ -66,6 +85,9 @@ public:
   //! \brief output frequency
   static size_t output_freq;
 
+  //! \brief what gets written to each kind of output file
+  static flecsale::mesh::output_profile_t output_profile;
+
   //! \brief the CFL and final solution time
   //! \{
   static real_t CFL;
@@ -73,17 +95,192 @@ public:
   static size_t max_steps;
   //! \}
 
+  //! \brief The number of local time step levels.  A value of one 
+  //!        advances all cells with the same time step.
+  static size_t time_step_levels;
+
   //! \brief the equation of state
   static std::shared_ptr<eos_t> eos;
 
   //! \brief this is a lambda function to set the initial conditions
   static ics_function_t ics;
 
+  //! \brief This sets the initial conditions a block of cells at a time.  
+  //!        If it is set, it is used instead of ics.
+  static ics_block_function_t ics_block;
+
   //! \brief This function builds and returns a mesh
   static mesh_function_t make_mesh; 
 
+  //! \brief The optional parts of the mesh to build, a combination of
+  //!        flecsale::mesh::burton::attributes::requirements_t.  The solver
+  //!        itself only needs cells and faces.
+  static unsigned mesh_requirements;
+
+  //===========================================================================
+  //! \brief Turn a pointwise ics function into a block-wise one.
+  //! \param [in] func  The pointwise function.
+  //! \param [in] thread_safe  If false, only one block is set at a time.
+  //! \return The block-wise function, which just loops over the cells.
+  //===========================================================================
+  static ics_block_function_t make_ics_block( 
+    ics_function_t func, bool thread_safe = true ) 
+  {
+    auto loop = [func]( std::size_t n, const vector_t * x, const real_t & t,
+      real_t * d, vector_t * v, real_t * p ) 
+    {
+      for ( std::size_t i=0; i<n; i++ )
+        std::tie( d[i], v[i], p[i] ) = func( x[i], t );
+    };
+    if ( thread_safe ) return loop;
+
+    auto mutex = std::make_shared<std::mutex>();
+    return [loop, mutex]( std::size_t n, const vector_t * x, const real_t & t,
+      real_t * d, vector_t * v, real_t * p ) 
+    {
+      std::lock_guard<std::mutex> lock( *mutex );
+      loop( n, x, t, d, v, p );
+    };
+  }
+
+  //===========================================================================
+  //! \brief Compile an ics expression into a block-wise function.
+  //!
+  //! The expression lists the density, each velocity component and the
+  //! pressure, separated by commas.  It can use the coordinates x, y[, z],
+  //! the time t and any named constants.
+  //!
+  //! \param [in] str  The expression.
+  //! \param [in] constants  The named constants.
+  //! \return The block-wise function.
+  //===========================================================================
+  static ics_block_function_t make_expression_ics_block( 
+    const std::string & str, 
+    const std::map<std::string, real_t> & constants = {} ) 
+  {
+    using expression_t = flecsale::utils::compiled_expression<real_t>;
+    using flecsale::utils::strided_ptr_t;
+
+    std::vector<std::string> vars = {"x", "y", "z"};
+    vars.resize( num_dimensions );
+    vars.emplace_back( "t" );
+
+    auto expr = std::make_shared<const expression_t>( str, vars, constants );
+    if ( expr->num_outputs() != num_dimensions + 2 )
+      raise_runtime_error( 
+        "The ics expression \"" << str << "\" should have " << 
+        num_dimensions + 2 << " outputs, it has " << expr->num_outputs()
+      );
+
+    // the vectors are read and written in place, a component at a time
+    constexpr auto vec_stride = sizeof(vector_t) / sizeof(real_t);
+
+    return [expr]( std::size_t n, const vector_t * x, const real_t & t,
+      real_t * d, vector_t * v, real_t * p ) 
+    {
+      std::array< strided_ptr_t<const real_t>, num_dimensions+1 > in;
+      std::array< strided_ptr_t<real_t>, num_dimensions+2 > out;
+      for ( int dim=0; dim<num_dimensions; dim++ ) {
+        in[dim] = { x[0].data() + dim, vec_stride };
+        out[dim+1] = { v[0].data() + dim, vec_stride };
+      }
+      in[num_dimensions] = { &t, 0 };
+      out.front() = { d, 1 };
+      out.back() = { p, 1 };
+      expr->evaluate( n, in.data(), out.data() );
+    };
+  }
+
 #ifdef HAVE_LUA
 
+  //===========================================================================
+  //! \brief Wrap a block-wise lua ics function.
+  //!
+  //! The lua function is called as f(x, y[, z], t), where each coordinate
+  //! is a table with one entry per cell.  It returns the tables of 
+  //! densities, velocities and pressures, the velocity table holding one
+  //! table per component.  Lua is not thread safe, so only one block is set
+  //! at a time, but the data is gathered and scattered in parallel.  It is
+  //! called inside a parallel region, so the caller has to catch its errors.
+  //!
+  //! \param [in] func  The lua function.
+  //! \return The block-wise function.
+  //===========================================================================
+  static ics_block_function_t make_lua_ics_block( 
+    const flecsale::utils::lua_result_t & func ) 
+  {
+    auto mutex = std::make_shared<std::mutex>();
+    flecsale::utils::lua_function_t lua_func( func );
+    return [lua_func, mutex]( std::size_t n, const vector_t * x, 
+      const real_t & t, real_t * d, vector_t * v, real_t * p ) 
+    {
+      using std::vector;
+      std::array< vector<real_t>, num_dimensions > coords;
+      for ( int dim=0; dim<num_dimensions; dim++ ) {
+        coords[dim].resize( n );
+        for ( std::size_t i=0; i<n; i++ ) coords[dim][i] = x[i][dim];
+      }
+
+      vector<real_t> dens, pres;
+      vector< vector<real_t> > vel;
+      {
+        std::lock_guard<std::mutex> lock( *mutex );
+        call_lua_ics( lua_func, std::tie( dens, vel, pres ), coords, t, 
+          std::make_index_sequence<num_dimensions>{} );
+      }
+
+      if ( dens.size() != n || pres.size() != n || vel.size() != num_dimensions )
+        raise_runtime_error( "The block ics function returned the wrong sizes" );
+      for ( const auto & comp : vel )
+        if ( comp.size() != n )
+          raise_runtime_error( "The block ics function returned the wrong sizes" );
+
+      std::copy( dens.begin(), dens.end(), d );
+      std::copy( pres.begin(), pres.end(), p );
+      for ( std::size_t i=0; i<n; i++ )
+        for ( int dim=0; dim<num_dimensions; dim++ ) v[i][dim] = vel[dim][i];
+    };
+  }
+
+  //===========================================================================
+  //! \brief Call a lua function with each coordinate as an argument.
+  //===========================================================================
+  template< typename Tup, typename C, std::size_t...I >
+  static void call_lua_ics( 
+    const flecsale::utils::lua_function_t & func, Tup && results,
+    const C & coords, const real_t & t, std::index_sequence<I...> ) 
+  {
+    func.call_into( std::forward<Tup>(results), coords[I]..., t );
+  }
+
+  //===========================================================================
+  //! \brief Load an output format from a lua table.
+  //! \param [in] input  The lua table with optional "fields", "precision",
+  //!                    "regions", "error_bound" and "error_mode" entries.
+  //! \param [in,out] format  The format to modify.
+  //===========================================================================
+  template< typename T >
+  static void load_output_format( 
+    const T & input, flecsale::mesh::output_format_t & format ) 
+  {
+    if ( !input["fields"].empty() )
+      format.fields = input["fields"].template as<std::vector<std::string>>();
+    if ( !input["precision"].empty() )
+      format.precision = flecsale::mesh::to_output_precision( 
+        input["precision"].template as<std::string>() );
+    if ( !input["regions"].empty() )
+      format.set_regions( 
+        input["regions"].template as<std::vector<size_t>>() );
+    if ( !input["error_bound"].empty() )
+      format.error_bound = input["error_bound"].template as<double>();
+    if ( !input["error_mode"].empty() ) {
+      auto mode = input["error_mode"].template as<std::string>();
+      if ( mode != "absolute" && mode != "relative" )
+        raise_runtime_error( "Unknown error mode \"" << mode << "\"" );
+      format.relative_error = ( mode == "relative" );
+    }
+  }
+
   //===========================================================================
   //! \brief Load the lua input file
   //! \param [in] file  The name of the lua file to load.
@@ -106,6 +303,53 @@ public:
     final_time = lua_try_access_as( hydro_input, "final_time", real_t );
     max_steps = lua_try_access_as( hydro_input, "max_steps", size_t );
 
+    // local time stepping is optional
+    if ( !hydro_input["time_step_levels"].empty() )
+      time_step_levels = hydro_input["time_step_levels"].as<size_t>();
+
+    // so is a block-wise ics function, which is used instead of the 
+    // pointwise one
+    if ( !hydro_input["ics_block"].empty() )
+      ics_block = make_lua_ics_block( hydro_input["ics_block"] );
+
+    // the ics can also be an expression, which is compiled instead of
+    // calling into lua for every cell
+    else if ( hydro_input["ics"].type() == LUA_TSTRING ) {
+      std::map<std::string, real_t> constants;
+      if ( !hydro_input["constants"].empty() ) {
+        auto constants_input = hydro_input["constants"];
+        for ( const auto & key : constants_input.keys() )
+          constants[key] = constants_input[key].as<real_t>();
+      }
+      ics_block = make_expression_ics_block( 
+        hydro_input["ics"].as<std::string>(), constants );
+    }
+
+    // extra mesh entities and geometry are only built when asked for
+    auto mesh_input = hydro_input["mesh"];
+    if ( !mesh_input["requirements"].empty() ) {
+      namespace attributes = flecsale::mesh::burton::attributes;
+      auto names = mesh_input["requirements"].as<std::vector<std::string>>();
+      for ( const auto & name : names ) {
+        if ( name == "edge_geometry" )
+          mesh_requirements |= attributes::require_edge_geometry;
+        else if ( name == "corners" )
+          mesh_requirements |= attributes::require_corners;
+        else
+          raise_implemented_error("Unknown mesh requirement \""<<name<<"\"");
+      }
+    }
+
+    // so is the output profile.  The top level sets the defaults, which
+    // each file extension can override.
+    if ( !hydro_input["output"].empty() ) {
+      auto output_input = hydro_input["output"];
+      load_output_format( output_input, output_profile.defaults() );
+      for ( auto ext : {"exo", "g", "dat", "plt", "vtk", "vtu", "pvtu", "vtm"} )
+        if ( !output_input[ext].empty() )
+          load_output_format( output_input[ext], output_profile[ext] );
+    }
+
     // setup the equation of state
     auto eos_input = lua_try_access( hydro_input, "eos" );
     auto eos_type = lua_try_access_as( eos_input, "type", std::string );
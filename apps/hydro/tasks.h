@@ -12,24 +12,42 @@
 // hydro includes
 #include "types.h"
 
+// user includes
+#include <flecsale/utils/errors.h>
+#include <flecsale/utils/mpi_utils.h>
+#include <flecsale/utils/reduce.h>
+
 // system includes
+#include <algorithm>
+#include <cmath>
+#include <fstream>
 #include <iomanip>
+#include <numeric>
+#include <string>
+#include <vector>
 
 namespace apps {
 namespace hydro {
 
+//! \brief The number of cells handed to the ics function at a time.
+static constexpr std::size_t ics_block_size = 4096;
+
 ////////////////////////////////////////////////////////////////////////////////
 //! \brief The main task for setting initial conditions
 //!
+//! The cells are split into blocks that are set in parallel.  The fields are
+//! stored in cell order, so each block is handed to the ics function 
+//! straight from storage.  A failure in any block is raised once every
+//! block has been tried.
+//!
 //! \param [in,out] mesh the mesh object
-//! \param [in]     ics  the initial conditions to set
+//! \param [in]     ics  the block-wise initial conditions to set
 //! \return 0 for success
 ////////////////////////////////////////////////////////////////////////////////
 template< typename T, typename F >
 int initial_conditions( T & mesh, F && ics ) {
 
   // type aliases
-  using counter_t = typename T::counter_t;
   using real_t = typename T::real_t;
   using vector_t = typename T::vector_t;
 
@@ -44,15 +62,36 @@ int initial_conditions( T & mesh, F && ics ) {
   auto xc = flecsi_get_accessor( mesh, mesh, cell_centroid, vector_t, dense, 0 );
 
   auto cs = mesh.cells();
-  auto num_cells = cs.size();
+  std::size_t num_cells = cs.size();
+  if ( num_cells == 0 ) return 0;
 
-  // This doesn't work with lua input
-  //#pragma omp parallel for
-  for ( counter_t i=0; i<num_cells; i++ ) {
-    auto c = cs[i];
-    std::tie( d[c], v[c], p[c] ) = std::forward<F>(ics)( xc[c], soln_time );
+  auto c0 = cs[0];
+  const vector_t * x = &xc[c0];
+  real_t * dens = &d[c0];
+  real_t * pres = &p[c0];
+  vector_t * vel = &v[c0];
+
+  auto num_blocks = ( num_cells + ics_block_size - 1 ) / ics_block_size;
+  std::vector<char> failed( num_blocks, 0 );
+
+  // errors can't leave the parallel region, so they are raised afterwards
+  #pragma omp parallel for
+  for ( std::size_t b=0; b<num_blocks; b++ ) {
+    auto first = b * ics_block_size;
+    auto n = std::min( ics_block_size, num_cells - first );
+    try {
+      ics( n, x+first, soln_time, dens+first, vel+first, pres+first );
+    }
+    catch ( ... ) {
+      failed[b] = 1;
+    }
   }
 
+  for ( std::size_t b=0; b<num_blocks; b++ )
+    if ( failed[b] )
+      raise_runtime_error( 
+        "Setting the initial conditions failed in block " << b );
+
   return 0;
 }
 
@@ -80,32 +119,70 @@ int update_state_from_pressure( T & mesh, const EOS * eos )
   auto volume = mesh.cell_volumes();
 
 
+  // only the owned cells are updated, the ghosts get their values from
+  // their owners
   auto cs = mesh.cells();
-  auto num_cells = cs.size();
+  auto num_cells = mesh.num_owned_cells();
 
-  real_t ener(0);
+  auto ener = utils::deterministic_sum( num_cells, real_t(0),
+    [&]( counter_t i, real_t & acc ) {
+      auto c = cs[i];
+      auto u = state(c);
+      eqns_t::update_state_from_pressure( u, *eos );
+      // sum total energy
+      auto et = eqns_t::total_energy(u);
+      auto rho  = eqns_t::density(u);
+      acc += rho * et * volume[c];
+    } );
 
-  #pragma omp parallel for reduction(+:ener)
-  for ( counter_t i=0; i<num_cells; i++ ) {
-    auto c = cs[i];
-    auto u = state(c);
-    eqns_t::update_state_from_pressure( u, *eos );
-    // sum total energy
-    auto et = eqns_t::total_energy(u);
-    auto rho  = eqns_t::density(u);
-    ener += rho * et * volume[c];
-  }
-
-  *ener0 = ener;
+  *ener0 = utils::global_sum( ener );
 
   return 0;
 }
 
 
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Compute the inverse of the time scale of a single cell.
+//!
+//! This is the largest wavespeed over all the faces of the cell divided by
+//! the length scale normal to each face.
+//!
+//! \tparam E  The equation of state object to use.
+//! \param [in] mesh  the mesh object
+//! \param [in] c  the cell to evaluate
+//! \param [in] u  the state of cell \a c
+//! \param [in] area,normal,volume  the mesh geometry
+//! \return the inverse time scale
+////////////////////////////////////////////////////////////////////////////////
+template< 
+  typename E, typename T, typename C, typename U, 
+  typename A, typename N, typename V 
+>
+auto inverse_time_scale( 
+  T & mesh, C && c, const U & u, 
+  const A & area, const N & normal, const V & volume ) 
+{
+  typename T::real_t dt_inv(0);
+
+  // loop over each face
+  for ( auto f : mesh.faces(c) ) {
+    // estimate the length scale normal to the face
+    auto delta_x = volume[c] / area[f];
+    // compute the inverse of the time scale
+    auto dti =  E::fastest_wavespeed(u, normal[f]) / delta_x;
+    // check for the maximum value
+    dt_inv = std::max( dti, dt_inv );
+  } // edge
+
+  return dt_inv;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! \brief The main task for updating the state from energy.
 //!
 //! Updates the state from density and energy and computes the new pressure.
+//! Since the state is final at this point, the stable time step for the 
+//! next step is computed in the same pass.
 //!
 //! \param [in,out] mesh the mesh object
 //! \return 0 for success
@@ -116,23 +193,38 @@ int update_state_from_energy( T & mesh, const EOS * eos )
 
   // type aliases
   using counter_t = typename T::counter_t;
+  using real_t = typename T::real_t;
   using eqns_t = eqns_t<T::num_dimensions>;
 
   // get the collection accesor
   state_accessor<T> state( mesh );
 
-  // get the cells
-  auto cs = mesh.cells();
-  auto num_cells = cs.size();
+  auto stable_dt = flecsi_get_accessor( mesh, hydro, stable_time_step, real_t, global, 0 );
+  const auto cfl = flecsi_get_accessor( mesh, hydro, cfl, real_t, global, 0 );
+
+  auto area   = mesh.face_areas();
+  auto normal = mesh.face_normals();
+  auto volume = mesh.cell_volumes();
 
-  real_t ener(0);
+  // get the owned cells
+  auto cs = mesh.cells();
+  auto num_cells = mesh.num_owned_cells();
+
+  // update the state, and compute the maximum 1/dt along the way
+  auto dt_inv = utils::deterministic_max( num_cells, real_t(0),
+    [&]( counter_t i, real_t & acc ) {
+      auto c = cs[i];
+      auto u = state(c);
+      eqns_t::update_state_from_energy( u, *eos );
+      auto dti = inverse_time_scale<eqns_t>( mesh, c, u, area, normal, volume );
+      acc = std::max( dti, acc );
+    } );
+
+  dt_inv = utils::global_max( dt_inv );
+  assert( dt_inv > 0 && "infinite delta t" );
 
-  #pragma omp parallel for
-  for ( counter_t i=0; i<num_cells; i++ ) {
-    auto c = cs[i];
-    auto u = state(c);
-    eqns_t::update_state_from_energy( u, *eos );
-  }
+  // invert dt and apply cfl
+  *stable_dt = static_cast<real_t>(cfl) / dt_inv;
 
   return 0;
 }
@@ -141,6 +233,9 @@ int update_state_from_energy( T & mesh, const EOS * eos )
 ////////////////////////////////////////////////////////////////////////////////
 //! \brief The main task to compute the time step size.
 //!
+//! The stable time step is normally computed by update_state_from_energy,
+//! so this is only needed when the state was set some other way.
+//!
 //! \tparam E  The equation of state object to use.
 //! \param [in,out] mesh the mesh object
 //! \return 0 for success
@@ -156,7 +251,7 @@ int evaluate_time_step( T & mesh ) {
   // access what we need
   state_accessor<T> state( mesh );
 
-  auto delta_t = flecsi_get_accessor( mesh, hydro, time_step, real_t, global, 0 );
+  auto stable_dt = flecsi_get_accessor( mesh, hydro, stable_time_step, real_t, global, 0 );
   const auto cfl = flecsi_get_accessor( mesh, hydro, cfl, real_t, global, 0 );
  
   auto area   = mesh.face_areas();
@@ -165,41 +260,62 @@ int evaluate_time_step( T & mesh ) {
  
   // Loop over each cell, computing the minimum time step,
   // which is also the maximum 1/dt
-  real_t dt_inv(0);
 
-  // get the cells
+  // get the owned cells
   auto cs = mesh.cells();
-  auto num_cells = cs.size();
-
-  #pragma omp parallel for reduction(max:dt_inv)
-  for ( counter_t i=0; i<num_cells; i++ ) {
-    auto c = cs[i];
-
-    // get cell properties
-    auto u = state( c );
+  auto num_cells = mesh.num_owned_cells();
 
-    // loop over each face
-    for ( auto f : mesh.faces(c) ) {
-      // estimate the length scale normal to the face
-      auto delta_x = volume[c] / area[f];
-      // compute the inverse of the time scale
-      auto dti =  E::fastest_wavespeed(u, normal[f]) / delta_x;
-      // std::cout << dti << " " << delta_x << std::endl;
-      // check for the maximum value
-      dt_inv = std::max( dti, dt_inv );
-    } // edge
-
-  } // cell
+  auto dt_inv = utils::deterministic_max( num_cells, real_t(0),
+    [&]( counter_t i, real_t & acc ) {
+      auto c = cs[i];
+      auto u = state( c );
+      auto dti = inverse_time_scale<E>( mesh, c, u, area, normal, volume );
+      acc = std::max( dti, acc );
+    } ); // cell
 
+  dt_inv = utils::global_max( dt_inv );
   assert( dt_inv > 0 && "infinite delta t" );
 
   // invert dt and apply cfl
-  *delta_t = static_cast<real_t>(cfl) / dt_inv;
+  *stable_dt = static_cast<real_t>(cfl) / dt_inv;
 
   return 0;
 
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Start updating the ghost cells with their owners' state.
+//!
+//! This does nothing unless the mesh is distributed.
+//!
+//! \param [in,out] mesh the mesh object
+//! \param [in,out] pending  The exchange the fields are added to.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+void begin_ghost_cell_update( T & mesh, mesh::halo_exchange_t & pending ) {
+
+  // type aliases
+  using real_t = typename T::real_t;
+  using vector_t = typename T::vector_t;
+
+  if ( !mesh.is_distributed() ) return;
+
+  // access what we need
+  auto d = flecsi_get_accessor( mesh, hydro, density, real_t, dense, 0 );
+  auto p = flecsi_get_accessor( mesh, hydro, pressure, real_t, dense, 0 );
+  auto v = flecsi_get_accessor( mesh, hydro, velocity, vector_t, dense, 0 );
+  auto e = flecsi_get_accessor( mesh, hydro, internal_energy, real_t, dense, 0 );
+  auto t = flecsi_get_accessor( mesh, hydro, temperature, real_t, dense, 0 );
+  auto a = flecsi_get_accessor( mesh, hydro, sound_speed, real_t, dense, 0 );
+
+  mesh.begin_exchange_cells( pending, d );
+  mesh.begin_exchange_cells( pending, p );
+  mesh.begin_exchange_cells( pending, v );
+  mesh.begin_exchange_cells( pending, e );
+  mesh.begin_exchange_cells( pending, t );
+  mesh.begin_exchange_cells( pending, a );
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! \brief The main task to evaluate fluxes at each face.
 //!
@@ -228,13 +344,8 @@ int evaluate_fluxes( T & mesh ) {
  
   // get the faces
   auto fs = mesh.faces();
-  auto num_faces = fs.size();
 
-  //for ( auto fit = fs.begin(); fit < fs.end(); ++fit  ) {
-
-  #pragma omp parallel for
-  for ( counter_t i=0; i<num_faces; i++ ) {
-    auto f = fs[i];
+  auto compute_flux = [&]( auto f ) {
 
     // get the cell neighbors
     auto cells = mesh.cells(f);
@@ -259,107 +370,123 @@ int evaluate_fluxes( T & mesh ) {
     // scale the flux by the face area
     flux[f] *= area[f];
 
-    // std::cout << flux[f] << std::endl;
-    
-  } // for
-  //----------------------------------------------------------------------------
+  };
 
-  return 0;
-}
+  // send the ghost state while the faces that don't need it are done
+  mesh::halo_exchange_t pending;
+  begin_ghost_cell_update( mesh, pending );
 
-////////////////////////////////////////////////////////////////////////////////
-//! \brief The main task to update the solution in each cell.
-//!
-//! \param [in,out] mesh the mesh object
-//! \return 0 for success
-////////////////////////////////////////////////////////////////////////////////
-template< typename T >
-solution_error_t
-apply_update( T & mesh, real_t tolerance, bool first_time ) 
-{
-
-  // type aliases
-  using counter_t = typename T::counter_t;
-  using real_t = typename T::real_t;
-  using vector_t = typename T::vector_t;
-  using flux_data_t = flux_data_t<T::num_dimensions>;
-  using eqns_t = eqns_t<T::num_dimensions>;
+  const auto & interior = mesh.halo_interior_faces();
+  auto num_interior = interior.size();
 
-  // access what we need
-  auto flux = flecsi_get_accessor( mesh, hydro, flux, flux_data_t, dense, 0 );
-  state_accessor<T> state( mesh );
-  
-  auto volume = mesh.cell_volumes();
+  #pragma omp parallel for
+  for ( counter_t i=0; i<num_interior; i++ )
+    compute_flux( fs[ interior[i] ] );
 
-  // read only access
-  const auto delta_t = flecsi_get_accessor( mesh, hydro, time_step, real_t, global, 0 );
-  auto ener0 = flecsi_get_accessor( mesh, hydro, sum_total_energy, real_t, global, 0 );
+  // the faces next to ghost cells have to wait for the exchange
+  pending.wait();
 
-  real_t mass(0);
-  vector_t mom(0);
-  real_t ener(0);
-  bool bad_cell(false);
+  const auto & boundary = mesh.halo_boundary_faces();
+  auto num_boundary = boundary.size();
 
+  #pragma omp parallel for
+  for ( counter_t i=0; i<num_boundary; i++ )
+    compute_flux( fs[ boundary[i] ] );
   //----------------------------------------------------------------------------
-  // Loop over each cell, scattering the fluxes to the cell
 
-  auto cs = mesh.cells();
-  auto num_cells = cs.size();
-  
-  #pragma omp declare reduction( + : vector_t : omp_out += omp_in ) \
-    initializer (omp_priv(omp_orig))
+  return 0;
+}
 
-  #pragma omp parallel for reduction( + : mass, mom, ener ) \
-    reduction( || : bad_cell )
-  for ( counter_t i=0; i<num_cells; i++ ) {
-    
-    auto c = cs[i];
-    flux_data_t delta_u( 0 );
-
-    // loop over each connected edge
-    for ( auto f : mesh.faces(c) ) {
-      
-      // get the cell neighbors
-      auto neigh = mesh.cells(f);
-      auto num_neigh = neigh.size();
-
-      // add the contribution to this cell only
-      if ( neigh[0] == c )
-        delta_u -= flux[f];
-      else
-        delta_u += flux[f];
-
-    } // edge
-
-    // now compute the final update
-    delta_u *= static_cast<real_t>(delta_t)/volume[c];
-
-    // apply the update
-    auto u = state( c );
-    eqns_t::update_state_from_flux( u, delta_u );
-
-    // post update sums
-    auto vel = eqns_t::velocity(u);
-    auto ie = eqns_t::internal_energy(u);
-    auto rho  = eqns_t::density(u);
-    auto m = rho*volume[c];
+////////////////////////////////////////////////////////////////////////////////
+//! \brief The conserved quantities, summed over all cells.
+//!
+//! \tparam R  The real type.
+//! \tparam V  The vector type.
+////////////////////////////////////////////////////////////////////////////////
+template< typename R, typename V >
+struct conserved_totals_t {
+
+  R mass = 0;
+  V mom = 0;
+  R ener = 0;
+  //! the number of cells with an unphysical state
+  std::size_t bad_cells = 0;
+
+  //! \brief Combine two partial sums.
+  friend conserved_totals_t 
+  operator+( conserved_totals_t a, const conserved_totals_t & b )
+  {
+    a.mass += b.mass;
+    a.mom += b.mom;
+    a.ener += b.ener;
+    a.bad_cells += b.bad_cells;
+    return a;
+  }
+
+  //! \brief Add the contribution of one cell.
+  //! \tparam E  The equations object to use.
+  //! \param [in] u  The cell state.
+  //! \param [in] volume  The cell volume.
+  template< typename E, typename U >
+  void add( const U & u, R volume ) 
+  {
+    auto vel = E::velocity(u);
+    auto ie = E::internal_energy(u);
+    auto rho  = E::density(u);
+    auto m = rho*volume;
     mass += m;
     ener += m * ie;
-    for ( int d=0; d<T::num_dimensions; ++d ) {
+    for ( std::size_t d=0; d<vel.size(); ++d ) {
       auto tmp = m * vel[d];
       mom[d] += tmp;
       ener += 0.5 * tmp * vel[d];
     }
-
     // check the solution quantities
     if ( ie < 0 || rho < 0 ) 
-      bad_cell = true;
+      bad_cells++;
+  }
 
-  } // for
-  //----------------------------------------------------------------------------
+  //! \brief Sum the totals over all processes.
+  void global_sum()
+  {
+    utils::global_sum( &mass, 1 );
+    utils::global_sum( mom.data(), mom.size() );
+    utils::global_sum( &ener, 1 );
+    utils::global_sum( &bad_cells, 1 );
+  }
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Report the conserved quantities and check the invariants.
+//!
+//! \param [in,out] mesh the mesh object
+//! \param [in] totals  the conserved quantities summed over the owned cells
+//! \param [in] tolerance  the allowable change in the total energy
+//! \param [in] first_time  if true, print the totals
+//! \return the state of the solution
+////////////////////////////////////////////////////////////////////////////////
+template< typename T, typename R, typename V >
+solution_error_t
+check_totals( 
+  T & mesh, conserved_totals_t<R,V> totals, 
+  real_t tolerance, bool first_time ) 
+{
+
+  // combine the contributions of all the processes
+  totals.global_sum();
+
+  // type aliases
+  using real_t = typename T::real_t;
+
+  auto ener0 = flecsi_get_accessor( mesh, hydro, sum_total_energy, real_t, global, 0 );
+
+  const auto & mass = totals.mass;
+  const auto & mom = totals.mom;
+  const auto & ener = totals.ener;
   
   // return unphysical if something went wrong
-  if (bad_cell) {
+  if ( totals.bad_cells > 0 ) {
     std::cout << "Negative internal energy or density encountered in a cell" 
       << std::endl;
     return solution_error_t::unphysical;
@@ -403,6 +530,323 @@ apply_update( T & mesh, real_t tolerance, bool first_time )
   
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! \brief The main task to update the solution in each cell.
+//!
+//! \param [in,out] mesh the mesh object
+//! \return 0 for success
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+solution_error_t
+apply_update( T & mesh, real_t tolerance, bool first_time ) 
+{
+
+  // type aliases
+  using counter_t = typename T::counter_t;
+  using real_t = typename T::real_t;
+  using vector_t = typename T::vector_t;
+  using flux_data_t = flux_data_t<T::num_dimensions>;
+  using eqns_t = eqns_t<T::num_dimensions>;
+  using totals_t = conserved_totals_t<real_t, vector_t>;
+
+  // access what we need
+  auto flux = flecsi_get_accessor( mesh, hydro, flux, flux_data_t, dense, 0 );
+  state_accessor<T> state( mesh );
+  
+  auto volume = mesh.cell_volumes();
+
+  // read only access
+  const auto delta_t = flecsi_get_accessor( mesh, hydro, time_step, real_t, global, 0 );
+
+  //----------------------------------------------------------------------------
+  // Loop over each owned cell, scattering the fluxes to the cell
+
+  auto cs = mesh.cells();
+  auto num_cells = mesh.num_owned_cells();
+
+  // the conserved quantities are summed in a reproducible order
+  auto totals = utils::deterministic_sum( num_cells, totals_t{},
+    [&]( counter_t i, totals_t & acc ) {
+    
+      auto c = cs[i];
+      flux_data_t delta_u( 0 );
+
+      // loop over each connected edge
+      for ( auto f : mesh.faces(c) ) {
+        
+        // get the cell neighbors
+        auto neigh = mesh.cells(f);
+        auto num_neigh = neigh.size();
+
+        // add the contribution to this cell only
+        if ( neigh[0] == c )
+          delta_u -= flux[f];
+        else
+          delta_u += flux[f];
+
+      } // edge
+
+      // now compute the final update
+      delta_u *= static_cast<real_t>(delta_t)/volume[c];
+
+      // apply the update
+      auto u = state( c );
+      eqns_t::update_state_from_flux( u, delta_u );
+
+      // post update sums
+      acc.template add<eqns_t>( u, volume[c] );
+
+    } ); // for
+  //----------------------------------------------------------------------------
+
+  return check_totals( mesh, totals, tolerance, first_time );
+  
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief The main task to advance the solution using local time stepping.
+//!
+//! Each cell is assigned to a time step level from its local CFL limit.  A
+//! cell on level l takes steps of size dt/2^l, where dt is the coarse step 
+//! stored in the time_step global.  Neighboring cells differ by at most one
+//! level.  Each face is advanced with the finer of its two cells, and the 
+//! time integrated fluxes are accumulated in both cells.  A cell is only 
+//! updated at the end of each of its own steps, so the scheme stays 
+//! conservative across level interfaces.  All cells are in sync at the end
+//! of the coarse step.
+//!
+//! \param [in,out] mesh the mesh object
+//! \param [in] eos  the equation of state
+//! \param [in] num_levels  the maximum number of time step levels
+//! \param [in] tolerance  the allowable change in the total energy
+//! \param [in] first_time  if true, print the totals
+//! \return the state of the solution
+////////////////////////////////////////////////////////////////////////////////
+template< typename T, typename EOS >
+solution_error_t
+apply_local_update( 
+  T & mesh, const EOS * eos, size_t num_levels, 
+  real_t tolerance, bool first_time ) 
+{
+
+  // type aliases
+  using counter_t = typename T::counter_t;
+  using real_t = typename T::real_t;
+  using vector_t = typename T::vector_t;
+  using flux_data_t = flux_data_t<T::num_dimensions>;
+  using eqns_t = eqns_t<T::num_dimensions>;
+  using totals_t = conserved_totals_t<real_t, vector_t>;
+
+  // the levels would need to be agreed upon across process boundaries
+  if ( mesh.is_distributed() )
+    raise_implemented_error( 
+      "Local time stepping is not supported on distributed meshes" 
+    );
+
+  // access what we need
+  auto flux = flecsi_get_accessor( mesh, hydro, flux, flux_data_t, dense, 0 );
+  auto flux_integral = flecsi_get_accessor( mesh, hydro, flux_integral, flux_data_t, dense, 0 );
+  auto cell_level = flecsi_get_accessor( mesh, hydro, cell_time_level, int, dense, 0 );
+  auto face_level = flecsi_get_accessor( mesh, hydro, face_time_level, int, dense, 0 );
+  state_accessor<T> state( mesh );
+
+  const auto delta_t = flecsi_get_accessor( mesh, hydro, time_step, real_t, global, 0 );
+  const auto cfl = flecsi_get_accessor( mesh, hydro, cfl, real_t, global, 0 );
+  auto lts_work = flecsi_get_accessor( mesh, hydro, local_cell_updates, real_t, global, 0 );
+  auto global_work = flecsi_get_accessor( mesh, hydro, global_cell_updates, real_t, global, 0 );
+
+  auto area   = mesh.face_areas();
+  auto normal = mesh.face_normals();
+  auto volume = mesh.cell_volumes();
+  
+  auto cs = mesh.cells();
+  auto num_cells = cs.size();
+
+  auto fs = mesh.faces();
+  auto num_faces = fs.size();
+
+  // the finest level and the number of fine steps per coarse step
+  const int finest = std::max<int>( num_levels, 1 ) - 1;
+  const counter_t num_substeps = counter_t(1) << finest;
+  const real_t fine_dt = static_cast<real_t>(delta_t) / num_substeps;
+
+  //----------------------------------------------------------------------------
+  // Assign each cell a level using its local time step
+
+  auto dt_inv_max = utils::deterministic_max( num_cells, real_t(0),
+    [&]( counter_t i, real_t & acc ) {
+      auto c = cs[i];
+      auto u = state( c );
+      auto dti = inverse_time_scale<eqns_t>( mesh, c, u, area, normal, volume );
+      acc = std::max( dti, acc );
+      // the coarsest level whose step is still stable
+      auto local_dt = static_cast<real_t>(cfl) / dti;
+      int coarsening = 0;
+      while ( coarsening < finest && fine_dt * (2 << coarsening) <= local_dt )
+        coarsening++;
+      cell_level[c] = finest - coarsening;
+      flux_integral[c] = 0;
+    } );
+
+  // neighbors can only differ by one level
+  std::vector<int> new_level( num_cells );
+  for ( int iter=0; iter<finest; iter++ ) {
+    #pragma omp parallel for
+    for ( counter_t i=0; i<num_cells; i++ ) {
+      auto c = cs[i];
+      auto lvl = cell_level[c];
+      for ( auto f : mesh.faces(c) )
+        for ( auto nb : mesh.cells(f) )
+          lvl = std::max( lvl, cell_level[nb] - 1 );
+      new_level[i] = lvl;
+    }
+    #pragma omp parallel for
+    for ( counter_t i=0; i<num_cells; i++ )
+      cell_level[ cs[i] ] = new_level[i];
+  }
+
+  // faces use the finer of their cells.  A cell needs to gather fluxes 
+  // whenever any of its faces were advanced
+  std::vector<int> gather_level( num_cells );
+
+  #pragma omp parallel for
+  for ( counter_t i=0; i<num_faces; i++ ) {
+    auto f = fs[i];
+    int lvl = 0;
+    for ( auto c : mesh.cells(f) ) lvl = std::max( lvl, cell_level[c] );
+    face_level[f] = lvl;
+  }
+
+  #pragma omp parallel for
+  for ( counter_t i=0; i<num_cells; i++ ) {
+    auto c = cs[i];
+    int lvl = cell_level[c];
+    for ( auto f : mesh.faces(c) ) lvl = std::max( lvl, face_level[f] );
+    gather_level[i] = lvl;
+  }
+
+  // order everything from finest to coarsest, so the entities active 
+  // during each sub-step are always a prefix of the list
+  std::vector<counter_t> cell_order( num_cells ), gather_order( num_cells );
+  std::vector<counter_t> face_order( num_faces );
+  std::iota( cell_order.begin(), cell_order.end(), 0 );
+  std::iota( gather_order.begin(), gather_order.end(), 0 );
+  std::iota( face_order.begin(), face_order.end(), 0 );
+
+  std::stable_sort( cell_order.begin(), cell_order.end(), 
+    [&]( auto a, auto b ) { return cell_level[cs[a]] > cell_level[cs[b]]; } );
+  std::stable_sort( gather_order.begin(), gather_order.end(), 
+    [&]( auto a, auto b ) { return gather_level[a] > gather_level[b]; } );
+  std::stable_sort( face_order.begin(), face_order.end(), 
+    [&]( auto a, auto b ) { return face_level[fs[a]] > face_level[fs[b]]; } );
+
+  // the number of entities on each level or finer
+  auto count_levels = [finest]( auto n, auto && level_of ) {
+    std::vector<counter_t> counts( finest+2, 0 );
+    for ( counter_t i=0; i<n; i++ ) counts[ level_of(i) ]++;
+    for ( int l=finest; l>0; l-- ) counts[l-1] += counts[l];
+    return counts;
+  };
+
+  auto num_cells_at = count_levels( num_cells, 
+    [&]( auto i ) { return cell_level[cs[i]]; } );
+  auto num_gather_at = count_levels( num_cells, 
+    [&]( auto i ) { return gather_level[i]; } );
+  auto num_faces_at = count_levels( num_faces, 
+    [&]( auto i ) { return face_level[fs[i]]; } );
+
+  // the coarsest level whose steps start (or end) at a fine step
+  auto coarsest_level = [finest]( counter_t k ) {
+    int l = finest;
+    while ( l > 0 && k % ( counter_t(1) << (finest-l+1) ) == 0 ) l--;
+    return l;
+  };
+
+  //----------------------------------------------------------------------------
+  // Advance each of the fine sub-steps
+
+  counter_t num_bad = 0;
+  real_t num_updates = 0;
+
+  for ( counter_t k=0; k<num_substeps; k++ ) {
+
+    // advance the faces whose steps start now
+    auto start_level = coarsest_level( k );
+    auto num_active_faces = num_faces_at[ start_level ];
+
+    #pragma omp parallel for
+    for ( counter_t j=0; j<num_active_faces; j++ ) {
+      auto f = fs[ face_order[j] ];
+      auto cells = mesh.cells(f);
+      auto w_left = state( cells[0] );    
+      if ( cells.size() == 2 ) {
+        auto w_right = state( cells[1] );
+        flux[f] = flux_function<eqns_t>( w_left, w_right, normal[f] );
+      } 
+      else {
+        flux[f] = boundary_flux<eqns_t>( w_left, normal[f] );
+      }
+      // integrate over this face's time step
+      flux[f] *= area[f] * static_cast<real_t>(delta_t) / (1 << face_level[f]);
+    }
+
+    // accumulate the fluxes in the cells
+    auto num_active_gathers = num_gather_at[ start_level ];
+
+    #pragma omp parallel for
+    for ( counter_t j=0; j<num_active_gathers; j++ ) {
+      auto c = cs[ gather_order[j] ];
+      for ( auto f : mesh.faces(c) ) {
+        if ( face_level[f] < start_level ) continue;
+        if ( mesh.cells(f)[0] == c )
+          flux_integral[c] -= flux[f];
+        else
+          flux_integral[c] += flux[f];
+      }
+    }
+
+    // update the cells whose steps end now
+    auto end_level = coarsest_level( k+1 );
+    auto num_active_cells = num_cells_at[ end_level ];
+
+    num_bad += utils::deterministic_sum( num_active_cells, counter_t(0),
+      [&]( counter_t j, counter_t & acc ) {
+        auto c = cs[ cell_order[j] ];
+        auto u = state( c );
+        auto delta_u = flux_integral[c];
+        delta_u *= 1 / volume[c];
+        eqns_t::update_state_from_flux( u, delta_u );
+        flux_integral[c] = 0;
+        // neighbors may need the new pressure before the coarse step ends
+        if ( eqns_t::internal_energy(u) < 0 || eqns_t::density(u) < 0 )
+          acc++;
+        else
+          eqns_t::update_state_from_energy( u, *eos );
+      } );
+
+    num_updates += num_active_cells;
+
+    if ( num_bad > 0 ) break;
+
+  } // sub-steps
+  //----------------------------------------------------------------------------
+
+  // the work done, and the work global time stepping would have done
+  *lts_work += num_updates;
+  *global_work += num_cells * 
+    std::ceil( static_cast<real_t>(delta_t) * dt_inv_max / cfl );
+
+  // now sum the conserved quantities
+  auto totals = utils::deterministic_sum( num_cells, totals_t{},
+    [&]( counter_t i, totals_t & acc ) {
+      auto c = cs[i];
+      acc.template add<eqns_t>( state( c ), volume[c] );
+    } );
+
+  return check_totals( mesh, totals, tolerance, first_time );
+  
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! \brief The main task to save the coordinates
 //!
@@ -509,10 +953,83 @@ int output( T & mesh,
   ss << std::setw( 7 ) << std::setfill( '0' ) << cnt++;
   ss << "."+postfix;
   
-  mesh::write_mesh( ss.str(), mesh );
+  // each process writes its own part
+  mesh::write_mesh_part( ss.str(), mesh );
   
   return 0;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Write the conserved totals and the center of mass to a file.
+//!
+//! The first line holds the mass and total energy, which any conservative
+//! scheme keeps fixed in a closed box.  The second holds the momentum, and
+//! the third the center of mass.  These depend on the whole solution, so
+//! runs that should give the same answer can be compared through them.
+//! Only the first process writes the file.
+//!
+//! \param [in] mesh the mesh object
+//! \param [in] filename  the file to write
+//! \return 0 for success
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+int write_totals( T & mesh, const std::string & filename ) 
+{
+
+  // type aliases
+  using counter_t = typename T::counter_t;
+  using real_t = typename T::real_t;
+  using vector_t = typename T::vector_t;
+  using eqns_t = eqns_t<T::num_dimensions>;
+  using totals_t = conserved_totals_t<real_t, vector_t>;
+
+  // the totals, and the first moment of the mass
+  struct sums_t {
+    totals_t totals;
+    vector_t moment = 0;
+  };
+
+  state_accessor<T> state( mesh );
+  auto volume = mesh.cell_volumes();
+  auto xc = mesh.cell_centroids();
+
+  auto cs = mesh.cells();
+  auto num_cells = mesh.num_owned_cells();
+
+  auto sums = utils::deterministic_reduce( num_cells, sums_t{},
+    [&]( counter_t i, sums_t & acc ) {
+      auto c = cs[i];
+      auto u = state( c );
+      acc.totals.template add<eqns_t>( u, volume[c] );
+      acc.moment += eqns_t::density(u) * volume[c] * xc[c];
+    },
+    []( sums_t a, const sums_t & b ) {
+      a.totals = a.totals + b.totals;
+      a.moment += b.moment;
+      return a;
+    } );
+
+  auto & totals = sums.totals;
+  totals.global_sum();
+  utils::global_sum( sums.moment.data(), sums.moment.size() );
+
+  if ( utils::comm_rank() != 0 ) return 0;
+
+  std::ofstream file( filename );
+  if ( !file.good() ) 
+    raise_runtime_error( "Problem opening totals file \"" << filename << "\"" );
+
+  file.setf( std::ios::scientific );
+  file.precision( 16 );
+
+  file << totals.mass << " " << totals.ener << std::endl;
+  for ( const auto & x : totals.mom ) file << x << " ";
+  file << std::endl;
+  for ( const auto & x : sums.moment ) file << x / totals.mass << " ";
+  file << std::endl;
+
+  return 0;
+}
+
 } // namespace hydro
 } // namespace apps
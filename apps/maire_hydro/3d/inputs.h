@@ -62,14 +62,14 @@ public:
     // now set some dimension specific inputs
 
     // set the ics function
-    auto ics_func = lua_try_access( hydro_input, "ics" );
+    flecsale::utils::lua_function_t ics_func( 
+      lua_try_access( hydro_input, "ics" ) );
     ics = 
       [ics_func]( const vector_t & x, const real_t & t )
       {
         real_t d, p;
         vector_t v(0);
-        std::tie(d, v, p) = 
-          ics_func(x[0], x[1], x[2], t).as<real_t, vector_t, real_t>();
+        ics_func.call_into( std::tie(d, v, p), x[0], x[1], x[2], t );
         return std::make_tuple( d, std::move(v), p );
       };
       
@@ -111,11 +111,12 @@ public:
       // get each bc pair
       auto bc_input = bcs_input[i+1];
       auto bc_type = lua_try_access_as( bc_input, "type", std::string );
-      auto bc_func = lua_try_access( bc_input, "func" );
+      flecsale::utils::lua_function_t bc_func( 
+        lua_try_access( bc_input, "func" ) );
       // make the boundary condition function
       auto bc_predicate = [=]( const vector_t & x, const real_t & t )
         { 
-          return bc_func(x[0], x[1], x[2], t).as<bool>();
+          return bc_func.call<bool>(x[0], x[1], x[2], t);
         };
       // make a new boundary condition type
       auto bc_object = bcs_ptr_t( 
@@ -121,6 +121,17 @@ solution_error_t apply_update_task(
   return apply_update( mesh, coef, tolerance, first_time );
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! \brief The main task to update the ghost vertices and corners.
+//!
+//! \param [in,out] mesh the mesh object
+//! \return 0 for success
+////////////////////////////////////////////////////////////////////////////////
+int update_ghost_vertices_task( mesh_3d_t & mesh ) 
+{
+  return update_ghost_vertices( mesh );
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! \brief The main task to move the mesh
 //!
@@ -188,6 +199,7 @@ flecsi_register_task(estimate_nodal_state_task, loc, single);
 flecsi_register_task(evaluate_nodal_state_task, loc, single);
 flecsi_register_task(evaluate_residual_task, loc, single);
 flecsi_register_task(apply_update_task, loc, single);
+flecsi_register_task(update_ghost_vertices_task, loc, single);
 flecsi_register_task(move_mesh_task, loc, single);
 flecsi_register_task(save_coordinates_task, loc, single);
 flecsi_register_task(restore_coordinates_task, loc, single);
@@ -14,7 +14,9 @@
 
 // user includes
 #include <flecsale/eos/ideal_gas.h>
+#include <flecsale/mesh/decomposition.h>
 #include <flecsale/mesh/mesh_utils.h>
+#include <flecsale/utils/mpi_utils.h>
 #include <flecsale/utils/time_utils.h>
 
 // system includes
@@ -38,6 +40,9 @@ int driver(int argc, char** argv)
   // set exceptions 
   enable_exceptions();
 
+  // make sure mpi is running if we need it
+  utils::mpi_session_t mpi_session( argc, argv );
+
   //===========================================================================
   // Parse arguments
   //===========================================================================
@@ -46,21 +51,31 @@ int driver(int argc, char** argv)
   auto print_usage = [&argv]() {
     std::cout << "Usage: " << argv[0] 
               << " [--file INPUT_FILE]"
+              << " [--validate LEVEL]"
+              << " [--totals FILE]"
               << " [--help]"
               << std::endl << std::endl;
     std::cout << "\t--file INPUT_FILE:\t Override the input file "
               << "with INPUT_FILE." << std::endl;
+    std::cout << "\t--validate LEVEL:\t Check the mesh with LEVEL, i.e. "
+              << "none, quick (the default) or full.  Full only adds the "
+              << "corner and wedge checks, so it is the same as quick for "
+              << "meshes built without corners." << std::endl;
+    std::cout << "\t--totals FILE:\t Write the final conserved totals "
+              << "and center of mass to FILE." << std::endl;
     std::cout << "\t--help:\t Print a help message." << std::endl;
   };
 
   // Define the options
   struct option long_options[] =
     {
-      {"help",       no_argument, 0, 'h'},
-      {"file", required_argument, 0, 'f'},
+      {"help",           no_argument, 0, 'h'},
+      {"file",     required_argument, 0, 'f'},
+      {"validate", required_argument, 0, 'v'},
+      {"totals",   required_argument, 0, 't'},
       {0, 0, 0, 0}
     };
-  const char * short_options = "hf:";
+  const char * short_options = "hf:v:t:";
 
   // parse the arguments
   auto args = parse_arguments(argc, argv, long_options, short_options);
@@ -86,15 +101,27 @@ int driver(int argc, char** argv)
     inputs_t::load( input_file_name );
   }
 
+  // how much checking of the mesh to do
+  auto validation = mesh::burton::attributes::to_validation(
+    args.count("v") ? args.at("v") : std::string("quick") );
+
+  // where to write the final totals, if anywhere
+  auto totals_file_name = 
+    args.count("t") ? args.at("t") : std::string();
+
   //===========================================================================
   // Mesh Setup
   //===========================================================================
 
-  // make the mesh
-  auto mesh = inputs_t::make_mesh( /* solution time */ 0.0 );
+  // make the mesh.  With more than one process, only the first one builds
+  // the whole mesh, and hands every other process its own part.
+  auto mesh = utils::comm_rank() == 0 ?
+    inputs_t::make_mesh( /* solution time */ 0.0 ) :
+    typename inputs_t::mesh_t();
+  mesh::distribute( mesh );
 
   // this is the mesh object
-  mesh.is_valid();
+  mesh.is_valid( validation );
   
   cout << mesh;
 
@@ -149,6 +176,7 @@ int driver(int argc, char** argv)
 
   flecsi_register_data(mesh, hydro, corner_normal, vector_t, dense, 1, corners);
   flecsi_register_data(mesh, hydro, corner_force, vector_t, dense, 1, corners);
+  flecsi_register_data(mesh, hydro, corner_matrix, matrix_t, dense, 1, corners);
   
   // register the time step and set a cfl
   flecsi_register_data( mesh, hydro, time_step, real_t, global, 1 );
@@ -237,6 +265,9 @@ int driver(int argc, char** argv)
   // a counter for this session
   size_t num_steps = 0; 
 
+  // set if the solver had to give up
+  bool failed = false;
+
   for (
     size_t num_retries = 0;
     (num_steps < inputs_t::max_steps && soln_time < inputs_t::final_time); 
@@ -267,6 +298,7 @@ int driver(int argc, char** argv)
     flecsi_execute_task( 
       evaluate_nodal_state_task, loc, single, mesh, boundaries
     );
+    flecsi_execute_task( update_ghost_vertices_task, loc, single, mesh );
 
     // compute the fluxes
     flecsi_execute_task( evaluate_residual_task, loc, single, mesh );
@@ -366,6 +398,7 @@ int driver(int argc, char** argv)
           std::cout << "Too many retries, exiting..." << std::endl;
           // flag that we want to quit
           mode = mode_t::quit;
+          failed = true;
         }
       }
 
@@ -378,6 +411,7 @@ int driver(int argc, char** argv)
       flecsi_execute_task( 
         evaluate_nodal_state_task, loc, single, mesh, boundaries
       );
+      flecsi_execute_task( update_ghost_vertices_task, loc, single, mesh );
 
       // if we are retrying, then restart the loop since all the state has been 
       // reset
@@ -453,8 +487,12 @@ int driver(int argc, char** argv)
   // now output the checksums
   mesh::checksum(mesh);
 
-  // success
-  return 0;
+  // and the totals, so runs can be compared
+  if ( !totals_file_name.empty() )
+    write_totals( mesh, totals_file_name );
+
+  // success if the solver did not give up
+  return failed ? 1 : 0;
 
 }
 
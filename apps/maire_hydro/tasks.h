@@ -13,12 +13,17 @@
 #include "types.h"
 
 #include <flecsale/linalg/qr.h>
+#include <flecsale/math/batched_solve.h>
 #include <flecsale/utils/algorithm.h>
 #include <flecsale/utils/array_view.h>
 #include <flecsale/utils/filter_iterator.h>
+#include <flecsale/utils/mpi_utils.h>
+#include <flecsale/utils/reduce.h>
 
 // system includes
+ #include <fstream>
  #include <iomanip>
+ #include <string>
  
 namespace apps {
 namespace hydro {
@@ -86,23 +91,23 @@ int update_state_from_pressure( T & mesh, const EOS * eos ) {
   auto cell_state = cell_state_accessor<T>( mesh );
   auto ener0 = flecsi_get_accessor( mesh, hydro, sum_total_energy, real_t, global, 0 );
 
+  // only the owned cells are updated, the ghosts get their values from
+  // their owners
   auto cs = mesh.cells();
-  auto num_cells = cs.size();
-
-  real_t ener(0);
+  auto num_cells = mesh.num_owned_cells();
 
-  #pragma omp parallel for reduction(+:ener)
-  for ( counter_t i=0; i<num_cells; ++i ) {
-    auto c = cs[i];
-    auto u = cell_state(c);
-    eqns_t::update_state_from_pressure( u, *eos );
-    // sum total energy
-    auto et = eqns_t::total_energy(u);
-    auto m  = eqns_t::mass(u);
-    ener += m * et;
-  }
+  auto ener = utils::deterministic_sum( num_cells, real_t(0),
+    [&]( counter_t i, real_t & acc ) {
+      auto c = cs[i];
+      auto u = cell_state(c);
+      eqns_t::update_state_from_pressure( u, *eos );
+      // sum total energy
+      auto et = eqns_t::total_energy(u);
+      auto m  = eqns_t::mass(u);
+      acc += m * et;
+    } );
 
-  *ener0 = ener;
+  *ener0 = utils::global_sum( ener );
 
   return 0;
 }
@@ -126,7 +131,7 @@ int update_state_from_energy( T & mesh, const EOS * eos ) {
   auto cell_state = cell_state_accessor<T>( mesh );
 
   auto cs = mesh.cells();
-  auto num_cells = cs.size();
+  auto num_cells = mesh.num_owned_cells();
 
   // loop over materials first?
 
@@ -173,29 +178,37 @@ int evaluate_time_step( T & mesh, std::string & limit_string )
   //----------------------------------------------------------------------------
   // Loop over each cell, computing the minimum time step,
   // which is also the maximum 1/dt
-  real_t dt_acc_inv(0);
-  real_t dt_vol_inv(0);
+  using dt_inv_t = std::array<real_t, 2>;
 
   auto cs = mesh.cells();
-  auto num_cells = cs.size();
-
-  #pragma omp parallel for reduction( max : dt_acc_inv, dt_vol_inv )
-  for ( counter_t i=0; i<num_cells; ++i ) {
-    auto c = cs[i];
+  auto num_cells = mesh.num_owned_cells();
+
+  auto dt_inv = utils::deterministic_reduce( 
+    num_cells, dt_inv_t{ 0, 0 },
+    [&]( counter_t i, dt_inv_t & acc ) {
+      auto c = cs[i];
+
+      // compute the inverse of the time scale
+      auto dti =  sound_speed[c] / cell_min_length[c] / cfl->accoustic;
+      // check for the maximum value
+      acc[0] = std::max( dti, acc[0] );
+
+      // now check the volume change
+      auto dVdt = eqns_t::volumetric_rate_of_change( dudt[c] );
+      dti = std::abs(dVdt) / cell_volume[c] / cfl->volume;
+      // check for the maximum value
+      acc[1] = std::max( dti, acc[1] );
+
+    }, 
+    []( const dt_inv_t & a, const dt_inv_t & b ) {
+      return dt_inv_t{ std::max( a[0], b[0] ), std::max( a[1], b[1] ) };
+    } ); // cell
+  //----------------------------------------------------------------------------
 
-    // compute the inverse of the time scale
-    auto dti =  sound_speed[c] / cell_min_length[c] / cfl->accoustic;
-    // check for the maximum value
-    dt_acc_inv = std::max( dti, dt_acc_inv );
+  utils::global_max( dt_inv.data(), dt_inv.size() );
 
-    // now check the volume change
-    auto dVdt = eqns_t::volumetric_rate_of_change( dudt[c] );
-    dti = std::abs(dVdt) / cell_volume[c] / cfl->volume;
-    // check for the maximum value
-    dt_vol_inv = std::max( dti, dt_vol_inv );
-
-  } // cell
-  //----------------------------------------------------------------------------
+  auto dt_acc_inv = dt_inv[0];
+  auto dt_vol_inv = dt_inv[1];
 
 
   assert( dt_acc_inv > 0 && "infinite delta t" );
@@ -233,6 +246,43 @@ int evaluate_time_step( T & mesh, std::string & limit_string )
 
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Start updating the ghost cells with their owners' state.
+//!
+//! This does nothing unless the mesh is distributed.
+//!
+//! \param [in,out] mesh the mesh object
+//! \param [in,out] pending  The exchange the fields are added to.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+void begin_ghost_cell_update( T & mesh, mesh::halo_exchange_t & pending ) {
+
+  // type aliases
+  using real_t = typename T::real_t;
+  using vector_t = typename T::vector_t;
+
+  if ( !mesh.is_distributed() ) return;
+
+  // access what we need
+  auto M = flecsi_get_accessor( mesh, hydro, cell_mass, real_t, dense, 0 );
+  auto V = flecsi_get_accessor( mesh, hydro, cell_volume, real_t, dense, 0 );
+  auto p = flecsi_get_accessor( mesh, hydro, cell_pressure, real_t, dense, 0 );
+  auto v = flecsi_get_accessor( mesh, hydro, cell_velocity, vector_t, dense, 0 );
+  auto d = flecsi_get_accessor( mesh, hydro, cell_density, real_t, dense, 0 );
+  auto e = flecsi_get_accessor( mesh, hydro, cell_internal_energy, real_t, dense, 0 );
+  auto t = flecsi_get_accessor( mesh, hydro, cell_temperature, real_t, dense, 0 );
+  auto a = flecsi_get_accessor( mesh, hydro, cell_sound_speed, real_t, dense, 0 );
+
+  mesh.begin_exchange_cells( pending, M );
+  mesh.begin_exchange_cells( pending, V );
+  mesh.begin_exchange_cells( pending, p );
+  mesh.begin_exchange_cells( pending, v );
+  mesh.begin_exchange_cells( pending, d );
+  mesh.begin_exchange_cells( pending, e );
+  mesh.begin_exchange_cells( pending, t );
+  mesh.begin_exchange_cells( pending, a );
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! \brief The main task to compute nodal quantities
 //!
@@ -270,6 +320,104 @@ int estimate_nodal_state( T & mesh ) {
 }
 
 
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Solve the nodal system augmented with symmetry constraints.
+//!
+//! This version uses the fixed-size, allocation-free qr solver.
+//!
+//! \tparam Rows  The size of the augmented system.
+//!
+//! \param [in] Mp  The nodal system matrix.
+//! \param [in] rhs  The nodal right hand side.
+//! \param [in] symmetry_normals  The symmetry plane normals.
+//! \param [out] vel  The resulting nodal velocity.
+////////////////////////////////////////////////////////////////////////////////
+template< 
+  std::size_t Rows, typename T, std::size_t N, typename M, typename V 
+>
+void solve_constrained_system( 
+  const math::matrix<T,N,N> & Mp, 
+  const math::vector<T,N> & rhs,
+  const M & symmetry_normals,
+  V & vel
+) {
+  // create the new system on the stack
+  math::matrix< T, Rows, Rows > A(0);
+  math::vector< T, Rows > b(0);
+  // insert the old system into the new one
+  for ( std::size_t d=0; d<N; ++d )
+    b[d] = rhs[d];
+  for ( std::size_t i=0; i<N; i++ ) 
+    for ( std::size_t j=0; j<N; j++ ) 
+      A(i,j) = Mp(i,j);
+  // insert each constraint
+  std::size_t k = N;
+  for ( const auto & n : symmetry_normals ) {
+    for ( std::size_t d=0; d<N; d++ ) {
+      A( d, k ) = n.second[d];
+      A( k, d ) = n.second[d];
+    }
+    k++;
+  }
+  // solve the system
+  flecsale::linalg::qr( A, b );
+  // copy the results back
+  for ( std::size_t d=0; d<N; ++d )
+    vel[d] = b[d];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Solve the nodal system augmented with symmetry constraints.
+//!
+//! This version is for an arbitrary number of constraints.
+//!
+//! \param [in] Mp  The nodal system matrix.
+//! \param [in] rhs  The nodal right hand side.
+//! \param [in] symmetry_normals  The symmetry plane normals.
+//! \param [out] vel  The resulting nodal velocity.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T, std::size_t N, typename M, typename V >
+void solve_constrained_system( 
+  const math::matrix<T,N,N> & Mp, 
+  const math::vector<T,N> & rhs,
+  const M & symmetry_normals,
+  V & vel
+) {
+  // how many extra constraints ( there are two wedges per face )
+  auto num_symmetry = symmetry_normals.size();
+  // the matrix size
+  auto num_rows = N+num_symmetry;
+  // create storage for the new system in a 1d array
+  std::vector< T > A( num_rows * num_rows, 0 ); // zerod
+  std::vector< T > b( num_rows ); // zerod
+  // create the views
+  auto A_view = utils::make_array_view( A, num_rows, num_rows );
+  auto b_view = utils::make_array_view( b );
+  // insert the old system into the new one
+  for ( std::size_t d=0; d<N; ++d )
+    b_view[d] = rhs[d];
+  for ( std::size_t i=0; i<N; i++ ) 
+    for ( std::size_t j=0; j<N; j++ ) 
+      A_view(i,j) = Mp(i,j);
+  // insert each constraint
+  for ( std::size_t i=0; i<N; i++ ) {
+    std::size_t j = N;
+    for ( const auto & n : symmetry_normals )
+      A_view( i, j++ ) = n.second[i];          
+  }
+  std::size_t i = N;
+  for ( const auto & n : symmetry_normals ) {
+    for ( std::size_t j=0; j<N; j++ ) 
+      A_view( i, j ) = n.second[j];          
+    i++;
+  }               
+  // solve the system
+  flecsale::linalg::qr( A_view, b_view );
+  // copy the results back
+  for ( std::size_t d=0; d<N; ++d )
+    vel[d] = b_view[d];
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! \brief The main task to compute nodal quantities
 //!
@@ -301,19 +449,40 @@ int evaluate_nodal_state( T & mesh, const BC & boundary_map ) {
 
   auto npc = flecsi_get_accessor( mesh, hydro, corner_normal, vector_t, dense, 0 );
   auto Fpc = flecsi_get_accessor( mesh, hydro, corner_force, vector_t, dense, 0 );
+  auto Mpc = flecsi_get_accessor( mesh, hydro, corner_matrix, matrix_t, dense, 0 );
 
   // get the current time
   auto soln_time = mesh.time();
 
+  // the boundaries with a prescribed velocity, as a tag set, so a vertex can
+  // check all of its tags against them at once
+  typename T::tag_list_t velocity_tags;
+  for ( const auto & bc : boundary_map )
+    if ( bc.second->has_prescribed_velocity() ) velocity_tags.insert( bc.first );
+
+  // add the vertex component to the corner forces
+  auto scatter_corner_forces = [&]( auto vt ) {
+    for ( auto cn : mesh.corners(vt) )
+      matrix_vector( 
+        static_cast<real_t>(-1), Mpc[cn], vertex_velocity[vt], 
+        static_cast<real_t>(1), Fpc[cn]
+      );
+  };
+
   //----------------------------------------------------------------------------
-  // Loop over each vertex
+  // Loop over each owned vertex, assembling the point systems
   //----------------------------------------------------------------------------
 
+  // all the cells around an owned vertex are available locally.  The ghost 
+  // vertices, and their corners, get their values from their owners.
   auto vs = mesh.vertices();
-  auto num_verts = vs.size();
+  auto num_verts = mesh.num_owned_vertices();
 
-  #pragma omp parallel for schedule(dynamic)
-  for ( counter_t i=0; i<num_verts; ++i ) {
+  // the interior point systems are all solved at once
+  math::symmetric_system_batch< real_t, dims > interior_systems( num_verts );
+
+  // assemble the system for one point
+  auto assemble_point = [&]( size_t i ) {
 
     auto vt = vs[i];
 
@@ -325,9 +494,6 @@ int evaluate_nodal_state( T & mesh, const BC & boundary_map ) {
     auto cnrs = mesh.corners(vt);
     auto num_corners = cnrs.size();
 
-    // create some corner storage
-    std::vector< matrix_t > Mpc(num_corners, 0);
-
     //--------------------------------------------------------------------------
     // build point matrix
     for ( int j=0; j<num_corners; ++j ) {
@@ -338,6 +504,7 @@ int evaluate_nodal_state( T & mesh, const BC & boundary_map ) {
       // initialize the corner force
       Fpc[cn] = 0;
       npc[cn] = 0;
+      Mpc[cn] = 0;
 
       // corner attaches to one cell and one point
       auto cl = mesh.cells(cn).front();
@@ -360,17 +527,17 @@ int evaluate_nodal_state( T & mesh, const BC & boundary_map ) {
         const auto & l = wedge_facet_area[w];
         // the final matrix
         // Mpc = zc * ( lpc^- npc^-.npc^-  + lpc^+ npc^+.npc^+ );
-        math::outer_product( n, n, Mpc[j], zc*l );
+        math::outer_product( n, n, Mpc[cn], zc*l );
         // compute the pressure coefficient
         for ( int d=0; d<T::num_dimensions; ++d ) 
           npc[cn][d] += l * n[d];
       } // wedges
 
       // add to the global matrix
-      Mp += Mpc[j];
+      Mp += Mpc[cn];
       // compute a portion of the corner force and 
       // add the pressure and velocity contributions to the system
-      ax_plus_y( Mpc[j], uc, Fpc[cn] );   
+      ax_plus_y( Mpc[cn], uc, Fpc[cn] );   
       for ( int d=0; d<dims; ++d ) {
         Fpc[cn][d] += pc * npc[cn][d];
         rhs[d] += Fpc[cn][d];
@@ -383,21 +550,19 @@ int evaluate_nodal_state( T & mesh, const BC & boundary_map ) {
     //---------- boundary point
     if ( vt->is_boundary() ) {
 
+      // boundary points are solved here, so skip them in the batch
+      interior_systems.set_identity( i );
+
       // this is used to keep track of the symmetry normals
       std::map< tag_t, vector_t > symmetry_normals;
 
       // get the boundary tags
-      const auto & point_tags =  vt->tags();
+      auto vel_tags = vt->tags() & velocity_tags;
 
       // first check if this has a prescribed velocity.  If it does, then nothing to do
-      auto vel_bc = std::find_if( 
-        point_tags.begin(), point_tags.end(), 
-        [&boundary_map](const auto & id) { 
-          return boundary_map.at(id)->has_prescribed_velocity();
-        } );
-      if ( vel_bc != point_tags.end() ) {
-        vertex_velocity[vt] = boundary_map.at(*vel_bc)->velocity( vt->coordinates(), soln_time );
-        continue;
+      if ( !vel_tags.empty() ) {
+        vertex_velocity[vt] = boundary_map.at(vel_tags.front())->velocity( vt->coordinates(), soln_time );
+        return;
       }
 
       // otherwise, apply the pressure conditions
@@ -444,74 +609,85 @@ int evaluate_nodal_state( T & mesh, const BC & boundary_map ) {
       }
       // add symmetry constraints and grow the system
       else {
-        // how many dimensions
-        constexpr auto num_dims = T::num_dimensions;
         // how many extra constraints ( there are two wedges per face )
         auto num_symmetry = symmetry_normals.size();
-        // the matrix size
-        auto num_rows = num_dims+num_symmetry;
-        // create storage for the new system in a 1d array
-        std::vector< real_t > A( num_rows * num_rows, 0 ); // zerod
-        std::vector< real_t > b( num_rows ); // zerod
-        // create the views
-        auto A_view = utils::make_array_view( A, num_rows, num_rows );
-        auto M_view = utils::make_array_view( Mp.data(), num_dims, num_dims );
-        auto b_view = utils::make_array_view( b );
-        // insert the old system into the new one
-        for ( int d=0; d<num_dims; ++d )
-          b_view[d] = rhs[d];
-        for ( int i=0; i<num_dims; i++ ) 
-          for ( int j=0; j<num_dims; j++ ) 
-            A_view(i,j) = Mp(i,j);
-        // insert each constraint
-        for ( int i=0; i<num_dims; i++ ) {
-          int j = num_dims;
-          for ( const auto & n : symmetry_normals )
-            A_view( i, j++ ) = n.second[i];          
+        // solve the system, using the fixed-size solver when possible
+        switch ( num_symmetry ) {
+        case 1:
+          solve_constrained_system<dims+1>( 
+            Mp, rhs, symmetry_normals, vertex_velocity[vt] );
+          break;
+        case 2:
+          solve_constrained_system<dims+2>( 
+            Mp, rhs, symmetry_normals, vertex_velocity[vt] );
+          break;
+        case 3:
+          solve_constrained_system<dims+3>( 
+            Mp, rhs, symmetry_normals, vertex_velocity[vt] );
+          break;
+        default:
+          solve_constrained_system( 
+            Mp, rhs, symmetry_normals, vertex_velocity[vt] );
+          break;
         }
-        int i = num_dims;
-        for ( const auto & n : symmetry_normals ) {
-          for ( int j=0; j<num_dims; j++ ) 
-            A_view( i, j ) = n.second[j];          
-          i++;
-        }               
-        // solve the system
-        flecsale::linalg::qr( A_view, b_view );
-        // copy the results back
-        for ( int d=0; d<num_dims; ++d )
-          vertex_velocity[vt][d] = b_view[d];
-
       } // end has symmetry
 
+      // add the vertex component to the force
+      scatter_corner_forces( vt );
+
     } // boundary point
 
     //---------- internal point
     // make sure sum(lpc) = 0
     // assert( abs(np) < eps && "error in norms" );
-    // now solve for point velocity
+    // now store the system for the point velocity
     else {
       
-      vertex_velocity[vt] = math::solve( Mp, rhs );
+      interior_systems.set( i, Mp, rhs );
 
     } // internal point
 
+  }; // vertex
 
-    //--------------------------------------------------------------------------
-    // Scatter RHS
-    for ( int j=0; j<num_corners; ++j ) {
+  // send the ghost cell state while the vertices that don't need it are 
+  // assembled
+  mesh::halo_exchange_t pending;
+  begin_ghost_cell_update( mesh, pending );
 
-      // get the corner
-      auto cn = cnrs[j];
-      // corner attaches to one cell and one point
-      auto cl = mesh.cells(cn).front();
+  const auto & interior = mesh.halo_interior_vertices();
+  auto num_interior = interior.size();
 
-      // now add the vertex component to the force
-      matrix_vector( 
-        static_cast<real_t>(-1), Mpc[j], vertex_velocity[vt], 
-        static_cast<real_t>(1), Fpc[cn]
-      );
+  #pragma omp parallel for schedule(dynamic)
+  for ( counter_t j=0; j<num_interior; ++j )
+    assemble_point( interior[j] );
 
-    }
+  // the vertices next to ghost cells have to wait for the exchange
+  pending.wait();
+
+  const auto & boundary = mesh.halo_boundary_vertices();
+  auto num_boundary = boundary.size();
+
+  #pragma omp parallel for schedule(dynamic)
+  for ( counter_t j=0; j<num_boundary; ++j )
+    assemble_point( boundary[j] );
+
+  //----------------------------------------------------------------------------
+  // Solve for the interior point velocities
+  //----------------------------------------------------------------------------
+
+  interior_systems.solve();
+
+  #pragma omp parallel for
+  for ( counter_t i=0; i<num_verts; ++i ) {
+
+    auto vt = vs[i];
+    if ( vt->is_boundary() ) continue;
+
+    assert( !interior_systems.is_singular(i) && "singular point system" );
+    interior_systems.get_solution( i, vertex_velocity[vt] );
+
+    // add the vertex component to the force
+    scatter_corner_forces( vt );
 
   } // vertex
   //----------------------------------------------------------------------------
@@ -550,9 +726,9 @@ int32_t evaluate_residual( T & mesh ) {
   //----------------------------------------------------------------------------
   // TASK: loop over each cell and compute the residual
   
-  // get the cells
+  // get the owned cells
   auto cs = mesh.cells();
-  auto num_cells = cs.size();
+  auto num_cells = mesh.num_owned_cells();
 
   #pragma omp parallel for
   for ( counter_t i=0; i<num_cells; i++ ) {
@@ -613,57 +789,75 @@ apply_update( T & mesh, real_t coef, real_t tolerance, bool first_time )
   // the time step factor
   auto fact = coef * (*delta_t);
 
-  real_t mass(0);
-  vector_t mom(0);
-  real_t ener(0);
-  bool bad_cell(false);
+  // the conserved quantities, summed in a reproducible order
+  struct totals_t {
+    real_t mass;
+    vector_t mom;
+    real_t ener;
+    bool bad_cell;
+  };
  
   //----------------------------------------------------------------------------
-  // Loop over each cell, scattering the fluxes to the cell
+  // Loop over each owned cell, scattering the fluxes to the cell
 
   auto cs = mesh.cells();
-  auto num_cells = cs.size();
-  
-  #pragma omp declare reduction( + : vector_t : omp_out += omp_in ) \
-    initializer (omp_priv(omp_orig))
-
-  #pragma omp parallel for reduction( + : mass, mom, ener ) \
-    reduction( || : bad_cell )
-  for ( counter_t i=0; i<num_cells; i++ ) {
+  auto num_cells = mesh.num_owned_cells();
 
-    // get the cell_t pointer
-    auto cl = cs[i];
- 
-    //--------------------------------------------------------------------------
-    // Using the cell residual, update the state
-
-    // get the cell state
-    auto u = cell_state( cl );
-
-    // apply the update
-    eqns_t::update_state_from_flux( u, dudt[cl], fact );
-    eqns_t::update_volume( u, cell_volume[cl] );
-
-    // post update sums
-    auto vel = eqns_t::velocity(u);
-    auto ie = eqns_t::internal_energy(u);
-    auto m  = eqns_t::mass(u);
-    auto rho  = eqns_t::density(u);
-    mass += m;
-    ener += m * ie;
-    for ( int d=0; d<T::num_dimensions; ++d ) {
-      auto tmp = m * vel[d];
-      mom[d] += tmp;
-      ener += 0.5 * tmp * vel[d];
-    }
-    
-    // check the solution quantities
-    if ( ie < 0 || rho < 0 || cell_volume[cl] < 0 )
-      bad_cell = true;
+  auto totals = utils::deterministic_reduce( 
+    num_cells, totals_t{ 0, vector_t(0), 0, false },
+    [&]( counter_t i, totals_t & acc ) {
 
-  } // for
+      // get the cell_t pointer
+      auto cl = cs[i];
+   
+      //------------------------------------------------------------------------
+      // Using the cell residual, update the state
+
+      // get the cell state
+      auto u = cell_state( cl );
+
+      // apply the update
+      eqns_t::update_state_from_flux( u, dudt[cl], fact );
+      eqns_t::update_volume( u, cell_volume[cl] );
+
+      // post update sums
+      auto vel = eqns_t::velocity(u);
+      auto ie = eqns_t::internal_energy(u);
+      auto m  = eqns_t::mass(u);
+      auto rho  = eqns_t::density(u);
+      acc.mass += m;
+      acc.ener += m * ie;
+      for ( int d=0; d<T::num_dimensions; ++d ) {
+        auto tmp = m * vel[d];
+        acc.mom[d] += tmp;
+        acc.ener += 0.5 * tmp * vel[d];
+      }
+      
+      // check the solution quantities
+      if ( ie < 0 || rho < 0 || cell_volume[cl] < 0 )
+        acc.bad_cell = true;
+
+    }, 
+    []( totals_t a, const totals_t & b ) {
+      a.mass += b.mass;
+      a.mom += b.mom;
+      a.ener += b.ener;
+      a.bad_cell = a.bad_cell || b.bad_cell;
+      return a;
+    } ); // for
   //----------------------------------------------------------------------------
 
+  // combine the contributions of all the processes
+  utils::global_sum( &totals.mass, 1 );
+  utils::global_sum( totals.mom.data(), totals.mom.size() );
+  utils::global_sum( &totals.ener, 1 );
+  totals.bad_cell = utils::global_max( static_cast<int>(totals.bad_cell) );
+
+  const auto & mass = totals.mass;
+  const auto & mom = totals.mom;
+  const auto & ener = totals.ener;
+  const auto & bad_cell = totals.bad_cell;
+
   // return unphysical if something went wrong
   if (bad_cell) {
     std::cout << "Negative internal energy or density encountered in a cell" 
@@ -713,6 +907,37 @@ apply_update( T & mesh, real_t coef, real_t tolerance, bool first_time )
 
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! \brief The main task to update the ghost vertices and corners with their
+//!        owners' nodal solution.
+//!
+//! This keeps the mesh motion identical on all processes, and gives every 
+//! owned cell the corner forces computed by the owners of its vertices.
+//! This does nothing unless the mesh is distributed.
+//!
+//! \param [in,out] mesh the mesh object
+//! \return 0 for success
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+int update_ghost_vertices( T & mesh ) {
+
+  // type aliases
+  using vector_t = typename T::vector_t;
+
+  if ( !mesh.is_distributed() ) return 0;
+
+  // access what we need
+  auto uv = flecsi_get_accessor( mesh, hydro, node_velocity, vector_t, dense, 0 );
+  auto npc = flecsi_get_accessor( mesh, hydro, corner_normal, vector_t, dense, 0 );
+  auto Fpc = flecsi_get_accessor( mesh, hydro, corner_force, vector_t, dense, 0 );
+
+  mesh.exchange_vertices( uv );
+  mesh.exchange_corners( npc );
+  mesh.exchange_corners( Fpc );
+
+  return 0;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! \brief The main task to move the mesh
 //!
@@ -913,13 +1138,96 @@ int output( T & mesh,
   ss << std::setw( 7 ) << std::setfill( '0' ) << cnt++;
   ss << "."+postfix;
   
+  // each process writes its own part
   cout << endl;
-  mesh::write_mesh( ss.str(), mesh );
+  mesh::write_mesh_part( ss.str(), mesh );
   cout << endl;
   
   return 0;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Write the conserved totals and the center of mass to a file.
+//!
+//! The first line holds the mass and total energy, the second the
+//! momentum, and the third the center of mass.  Only the first process
+//! writes the file.
+//!
+//! \param [in] mesh the mesh object
+//! \param [in] filename  the file to write
+//! \return 0 for success
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+int write_totals( T & mesh, const std::string & filename ) 
+{
+
+  // type aliases
+  using counter_t = typename T::counter_t;
+  using real_t = typename T::real_t;
+  using vector_t = typename T::vector_t;
+  using eqns_t = eqns_t<T::num_dimensions>;
+
+  // the conserved quantities, and the first moment of the mass
+  struct totals_t {
+    real_t mass;
+    vector_t mom;
+    real_t ener;
+    vector_t moment;
+  };
+
+  auto cell_state = cell_state_accessor<T>( mesh );
+  auto xc = mesh.cell_centroids();
+
+  auto cs = mesh.cells();
+  auto num_cells = mesh.num_owned_cells();
+
+  auto totals = utils::deterministic_reduce( 
+    num_cells, totals_t{ 0, vector_t(0), 0, vector_t(0) },
+    [&]( counter_t i, totals_t & acc ) {
+      auto cl = cs[i];
+      auto u = cell_state( cl );
+      auto vel = eqns_t::velocity(u);
+      auto m  = eqns_t::mass(u);
+      acc.mass += m;
+      acc.ener += m * eqns_t::internal_energy(u);
+      for ( int d=0; d<T::num_dimensions; ++d ) {
+        auto tmp = m * vel[d];
+        acc.mom[d] += tmp;
+        acc.ener += 0.5 * tmp * vel[d];
+        acc.moment[d] += m * xc[cl][d];
+      }
+    }, 
+    []( totals_t a, const totals_t & b ) {
+      a.mass += b.mass;
+      a.mom += b.mom;
+      a.ener += b.ener;
+      a.moment += b.moment;
+      return a;
+    } );
+
+  // combine the contributions of all the processes
+  utils::global_sum( &totals.mass, 1 );
+  utils::global_sum( totals.mom.data(), totals.mom.size() );
+  utils::global_sum( &totals.ener, 1 );
+  utils::global_sum( totals.moment.data(), totals.moment.size() );
+
+  if ( utils::comm_rank() != 0 ) return 0;
+
+  std::ofstream file( filename );
+  if ( !file.good() ) 
+    raise_runtime_error( "Problem opening totals file \"" << filename << "\"" );
+
+  file.setf( std::ios::scientific );
+  file.precision( 16 );
+
+  file << totals.mass << " " << totals.ener << std::endl;
+  for ( const auto & x : totals.mom ) file << x << " ";
+  file << std::endl;
+  for ( const auto & x : totals.moment ) file << x / totals.mass << " ";
+  file << std::endl;
+
+  return 0;
+}
 
 } // namespace hydro
 } // namespace apps
@@ -0,0 +1,398 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+///////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Converts vtu files with lossily stored fields back to plain vtu
+///        files.
+///
+/// Only files written by flecsale's native vtu writer are understood, i.e.
+/// raw appended data with UInt64 headers, in the native byte order.  Every
+/// array is decoded, whether it was stored as is, compressed with zlib or
+/// lz4, or stored with the lossy codec, and the result is written
+/// uncompressed so that any vtk reader can load it.  The blocks of each
+/// array are decoded in parallel.
+///////////////////////////////////////////////////////////////////////////////
+
+// user includes
+#include "../common/parse_arguments.h"
+
+#include <flecsale/io/lossy.h>
+#include <flecsale/io/vtu.h>
+
+// system includes
+#ifdef HAVE_ZLIB
+#  include <zlib.h>
+#endif
+
+#ifdef HAVE_LZ4
+#  include <lz4.h>
+#endif
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+//! \brief The header type preceding each array.
+using header_t = std::uint64_t;
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief One DataArray element of the xml header.
+///////////////////////////////////////////////////////////////////////////////
+struct array_t {
+  //! where the element starts and ends in the xml header
+  std::size_t begin = 0, end = 0;
+  //! the array name, empty for the points
+  std::string name;
+  //! the vtk type name
+  std::string type;
+  //! where the encoded data starts in the appended section
+  std::size_t offset = 0;
+  //! true if the data is a lossy stream
+  bool lossy = false;
+  //! the decoded data
+  std::vector<char> data;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Return the value of an attribute of an xml element.
+//! \param [in] element  The text of the element.
+//! \param [in] attr  The attribute name.
+//! \return The value, or an empty string if the attribute is missing.
+///////////////////////////////////////////////////////////////////////////////
+std::string get_attribute( const std::string & element, const std::string & attr )
+{
+  auto key = " " + attr + "=\"";
+  auto pos = element.find( key );
+  if ( pos == std::string::npos ) return {};
+  pos += key.size();
+  return element.substr( pos, element.find( '"', pos ) - pos );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Remove an attribute from an xml element.
+//! \param [in,out] element  The text of the element.
+//! \param [in] attr  The attribute name.
+///////////////////////////////////////////////////////////////////////////////
+void remove_attribute( std::string & element, const std::string & attr )
+{
+  auto key = " " + attr + "=\"";
+  auto pos = element.find( key );
+  if ( pos == std::string::npos ) return;
+  auto end = element.find( '"', pos + key.size() );
+  element.erase( pos, end + 1 - pos );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Return the size of a vtk type.
+///////////////////////////////////////////////////////////////////////////////
+std::size_t type_size( const std::string & type )
+{
+  if ( type == "Int8" || type == "UInt8" ) return 1;
+  if ( type == "Int16" || type == "UInt16" ) return 2;
+  if ( type == "Int32" || type == "UInt32" || type == "Float32" ) return 4;
+  if ( type == "Int64" || type == "UInt64" || type == "Float64" ) return 8;
+  raise_runtime_error( "Unknown vtk type \"" << type << "\"" );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Decompress one block.
+//!
+//! This runs inside parallel loops, so it reports failures instead of
+//! raising them.
+//!
+//! \return True on success.
+///////////////////////////////////////////////////////////////////////////////
+bool decompress_block(
+  const std::string & compressor, const char * in, std::size_t in_bytes,
+  char * out, std::size_t out_bytes )
+{
+#ifdef HAVE_ZLIB
+  if ( compressor == "vtkZLibDataCompressor" ) {
+    uLongf len = out_bytes;
+    auto ierr = uncompress(
+      reinterpret_cast<Bytef*>( out ), &len,
+      reinterpret_cast<const Bytef*>( in ), in_bytes );
+    return ierr == Z_OK && len == out_bytes;
+  }
+#endif
+#ifdef HAVE_LZ4
+  if ( compressor == "vtkLZ4DataCompressor" ) {
+    auto len = LZ4_decompress_safe( in, out, in_bytes, out_bytes );
+    return len >= 0 && static_cast<std::size_t>(len) == out_bytes;
+  }
+#endif
+  (void)in; (void)in_bytes; (void)out; (void)out_bytes;
+  return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Decode one array.
+//! \param [in] appended  The start of the appended data.
+//! \param [in] end  The end of the file.
+//! \param [in] compressor  The compressor of the file, if any.
+//! \param [in,out] a  The array to decode.
+//! \return The number of encoded bytes.
+///////////////////////////////////////////////////////////////////////////////
+std::size_t decode(
+  const char * appended, const char * end, const std::string & compressor,
+  array_t & a )
+{
+  auto p = appended + a.offset;
+  auto remaining = [&]() { return static_cast<std::size_t>( end - p ); };
+  auto read_header = [&]() {
+    header_t h;
+    if ( remaining() < sizeof(header_t) )
+      raise_runtime_error( "Truncated array \"" << a.name << "\"" );
+    std::memcpy( &h, p, sizeof(header_t) );
+    p += sizeof(header_t);
+    return h;
+  };
+
+  // lossy arrays
+  if ( a.lossy ) {
+    auto bytes = read_header();
+    if ( remaining() < bytes )
+      raise_runtime_error( "Truncated array \"" << a.name << "\"" );
+    auto n = flecsale::io::lossy_codec::size( p, bytes );
+    a.data.resize( n * type_size( a.type ) );
+    if ( a.type == "Float32" )
+      flecsale::io::lossy_codec::decompress(
+        p, bytes, reinterpret_cast<float*>( a.data.data() ) );
+    else if ( a.type == "Float64" )
+      flecsale::io::lossy_codec::decompress(
+        p, bytes, reinterpret_cast<double*>( a.data.data() ) );
+    else
+      raise_runtime_error( "Lossy array \"" << a.name << "\" is not real" );
+    return sizeof(header_t) + bytes;
+  }
+
+  // plain arrays
+  if ( compressor.empty() ) {
+    auto bytes = read_header();
+    if ( remaining() < bytes )
+      raise_runtime_error( "Truncated array \"" << a.name << "\"" );
+    a.data.assign( p, p + bytes );
+    return sizeof(header_t) + bytes;
+  }
+
+  // compressed arrays
+  auto num_blocks = read_header();
+  auto block_size = read_header();
+  auto last_size = read_header();
+  std::vector<std::size_t> in_offsets( num_blocks+1, 0 );
+  for ( std::size_t b=0; b<num_blocks; b++ )
+    in_offsets[b+1] = in_offsets[b] + read_header();
+  if ( remaining() < in_offsets.back() )
+    raise_runtime_error( "Truncated array \"" << a.name << "\"" );
+
+  auto bytes = num_blocks * block_size;
+  if ( num_blocks && last_size ) bytes -= block_size - last_size;
+  a.data.resize( bytes );
+
+#if !defined(HAVE_ZLIB) && !defined(HAVE_LZ4)
+  raise_implemented_error( "Not built with support for " << compressor );
+#endif
+
+  int failed = 0;
+
+  #pragma omp parallel for
+  for ( std::size_t b=0; b<num_blocks; b++ ) {
+    auto start = b * block_size;
+    auto len = std::min<std::size_t>( block_size, bytes - start );
+    auto ok = decompress_block( compressor,
+      p + in_offsets[b], in_offsets[b+1] - in_offsets[b],
+      a.data.data() + start, len );
+    if ( !ok ) {
+      #pragma omp atomic write
+      failed = 1;
+    }
+  }
+
+  if ( failed )
+    raise_runtime_error( 
+      "Decompressing array \"" << a.name << "\" with " << compressor 
+      << " failed" );
+
+  return ( 3 + num_blocks ) * sizeof(header_t) + in_offsets.back();
+}
+
+} // namespace
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief The main program.
+///////////////////////////////////////////////////////////////////////////////
+int main( int argc, char** argv )
+{
+
+  //===========================================================================
+  // Parse arguments
+  //===========================================================================
+
+  option long_options[] = {
+    {"help",   no_argument,       0, 'h'},
+    {"output", required_argument, 0, 'o'},
+    {0, 0, 0, 0}
+  };
+  const char * short_options = "ho:";
+
+  auto args = parse_arguments( argc, argv, long_options, short_options );
+
+  auto print_usage = [&]() {
+    std::cout << "Usage: " << argv[0] << " [-o <output>] <name>"
+      << std::endl << std::endl
+      << "Decodes every array of the vtu file <name> and writes them"
+      << std::endl << "uncompressed to <output>, which defaults to <name>."
+      << std::endl;
+  };
+
+  if ( args.count("h") ) {
+    print_usage();
+    return 0;
+  }
+
+  if ( optind+1 != argc ) {
+    print_usage();
+    return 1;
+  }
+
+  std::string name = argv[optind];
+  std::string output = args.count("o") ? args.at("o") : name;
+
+  //===========================================================================
+  // Read the file
+  //===========================================================================
+
+  std::vector<char> contents;
+  {
+    std::ifstream file( name, std::ifstream::binary );
+    if ( !file.good() ) raise_runtime_error( "Cannot open " << name );
+    contents.assign(
+      std::istreambuf_iterator<char>( file ), std::istreambuf_iterator<char>() );
+  }
+
+  // the xml header ends where the raw data starts
+  const std::string appended_tag = "<AppendedData encoding=\"raw\">";
+  std::string text( contents.data(),
+    std::min<std::size_t>( contents.size(), 1 << 20 ) );
+  auto tag_pos = text.find( appended_tag );
+  if ( tag_pos == std::string::npos )
+    raise_runtime_error( name << " has no raw appended data" );
+  auto data_pos = text.find( '_', tag_pos );
+  if ( data_pos == std::string::npos )
+    raise_runtime_error( name << " has no raw appended data" );
+  text.resize( tag_pos );
+  data_pos++;
+
+  auto appended = contents.data() + data_pos;
+  auto end = contents.data() + contents.size();
+
+  // the file attributes
+  auto file_begin = text.find( "<VTKFile" );
+  auto file_end = text.find( '>', file_begin );
+  if ( file_begin == std::string::npos || file_end == std::string::npos )
+    raise_runtime_error( name << " is not a vtk file" );
+  auto file_element = text.substr( file_begin, file_end - file_begin );
+
+  if ( get_attribute( file_element, "header_type" ) != "UInt64" )
+    raise_runtime_error( "Only UInt64 headers are supported" );
+  auto byte_order = flecsale::io::isBigEndian() ? "BigEndian" : "LittleEndian";
+  if ( get_attribute( file_element, "byte_order" ) != byte_order )
+    raise_runtime_error( name << " is not in the native byte order" );
+  auto compressor = get_attribute( file_element, "compressor" );
+
+  // the arrays
+  std::vector<array_t> arrays;
+  for ( auto pos = text.find( "<DataArray", file_end );
+        pos != std::string::npos;
+        pos = text.find( "<DataArray", pos ) )
+  {
+    array_t a;
+    a.begin = pos;
+    a.end = text.find( '>', pos ) + 1;
+    auto element = text.substr( a.begin, a.end - a.begin );
+    if ( get_attribute( element, "format" ) != "appended" )
+      raise_runtime_error( "Only appended arrays are supported" );
+    a.name = get_attribute( element, "Name" );
+    a.type = get_attribute( element, "type" );
+    a.offset = std::stoull( get_attribute( element, "offset" ) );
+    a.lossy = ( get_attribute( element, "compressor" ) ==
+      flecsale::io::vtu_writer::lossy_compressor );
+    arrays.emplace_back( std::move(a) );
+    pos = arrays.back().end;
+  }
+
+  //===========================================================================
+  // Decode the arrays
+  //===========================================================================
+
+  using clock_t = std::chrono::steady_clock;
+
+  std::cout << "Decoding " << arrays.size() << " arrays from " << name
+    << std::endl;
+
+  std::size_t appended_end = 0;
+  for ( auto & a : arrays ) {
+    auto start = clock_t::now();
+    auto bytes = decode( appended, end, compressor, a );
+    std::chrono::duration<double> elapsed = clock_t::now() - start;
+    appended_end = std::max( appended_end, a.offset + bytes );
+    if ( a.lossy )
+      std::cout << " " << std::setw(23) << std::left << a.name << std::right
+        << std::fixed << std::setprecision(1)
+        << std::setw(12) << a.data.size() / 1.e6 / elapsed.count()
+        << " MB/s" << std::endl;
+  }
+
+  //===========================================================================
+  // Write the plain file
+  //===========================================================================
+
+  std::ofstream file( output, std::ofstream::binary );
+  if ( !file.good() ) raise_runtime_error( "Cannot open " << output );
+
+  // the header, without the compressors, and with the new offsets
+  remove_attribute( file_element, "compressor" );
+  file << text.substr( 0, file_begin ) << file_element;
+
+  std::size_t pos = file_end;
+  std::size_t offset = 0;
+  for ( const auto & a : arrays ) {
+    file << text.substr( pos, a.begin - pos );
+    auto element = text.substr( a.begin, a.end - a.begin );
+    remove_attribute( element, "compressor" );
+    auto off = element.find( " offset=\"" );
+    auto off_end = element.find( '"', off + 9 );
+    element.replace( off, off_end + 1 - off,
+      " offset=\"" + std::to_string( offset ) + "\"" );
+    file << element;
+    offset += sizeof(header_t) + a.data.size();
+    pos = a.end;
+  }
+  file << text.substr( pos ) << appended_tag << std::endl << "   _";
+
+  // the data
+  for ( const auto & a : arrays ) {
+    header_t bytes = a.data.size();
+    file.write( reinterpret_cast<const char*>( &bytes ), sizeof(header_t) );
+    file.write( a.data.data(), a.data.size() );
+  }
+
+  // and whatever followed it
+  file.write( appended + appended_end, end - appended - appended_end );
+
+  if ( !file.good() ) raise_runtime_error( "Failed to write " << output );
+  std::cout << "Wrote " << output << std::endl;
+
+  return 0;
+
+}
@@ -15,14 +15,33 @@ set(REGRESSION_CMAKE_DIR ${CMAKE_CURRENT_LIST_DIR} )
 function(create_regression_test)
   if (ENABLE_REGRESSION_TESTS)
 
-    # the command to run to compare outputs
-    set (TEST_COMMAND "${PYTHON_EXECUTABLE} ${FleCSALE_TOOL_DIR}/numdiff.py --verbose --absolute ${TEST_TOLERANCE}")
-
     # parse the arguments
     set(options)
-    set(oneValueArgs NAME COMPARE STANDARD THREADS)
-    set(multiValueArgs COMMAND INPUTS)
+    set(oneValueArgs NAME COMPARE STANDARD THREADS PROCS TOLERANCE COMPARE_LINES)
+    set(multiValueArgs COMMAND INPUTS DEPENDS)
     cmake_parse_arguments(args "${options}" "${oneValueArgs}" "${multiValueArgs}" ${ARGN} )
+
+    # the tolerance can be loosened for comparisons between different runs
+    if( NOT args_TOLERANCE )
+      set( args_TOLERANCE ${TEST_TOLERANCE} )
+    endif()
+
+    # the command to run to compare outputs
+    set (TEST_COMMAND "${PYTHON_EXECUTABLE} ${FleCSALE_TOOL_DIR}/numdiff.py --verbose --absolute ${args_TOLERANCE}")
+
+    # only compare the leading lines if asked
+    if( args_COMPARE_LINES )
+      set (TEST_COMMAND "${TEST_COMMAND} --lines ${args_COMPARE_LINES}")
+    endif()
+
+    # run with mpi if asked
+    if( args_PROCS )
+      list( GET args_COMMAND 0 args_EXECUTABLE )
+      list( REMOVE_AT args_COMMAND 0 )
+      set( args_COMMAND ${MPIEXEC} ${MPIEXEC_NUMPROC_FLAG} ${args_PROCS} 
+        ${MPIEXEC_PREFLAGS} ${args_EXECUTABLE} ${MPIEXEC_POSTFLAGS} 
+        ${args_COMMAND} )
+    endif()
   
     # check the preconditions
     if( NOT args_NAME )
@@ -70,6 +89,11 @@ function(create_regression_test)
       # for openmp
       SET_TESTS_PROPERTIES( ${args_NAME}
         PROPERTIES ENVIRONMENT "OMP_NUM_THREADS=${args_THREADS}")
+
+      # tests that compare against another test's output must run after it
+      if( args_DEPENDS )
+        SET_TESTS_PROPERTIES( ${args_NAME} PROPERTIES DEPENDS "${args_DEPENDS}")
+      endif()
       
     endif()
   
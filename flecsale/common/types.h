@@ -38,6 +38,13 @@ using index_t = uint64_t;
 using index_t = uint32_t;
 #endif
 
+//! type of the ids local to one process, e.g. in the id lists the mesh
+//! caches.  The connectivity stored by flecsi keeps its own id type.
+using local_index_t = uint32_t;
+
+//! type of the ids that are unique across all processes
+using global_index_t = uint64_t;
+
 //! type of integer data to use
 #ifdef DOUBLE_PRECISION
 using integer_t = int64_t;
@@ -29,6 +29,8 @@
 // system includes
 #include <iostream>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace flecsale {
@@ -66,12 +68,43 @@ public:
 	  }
   }
   
+  //! \brief Run the pipelines on a grid.
+  //! \param [in] grid  The grid to process.
+  //! \param [in] time  The solution time.
+  //! \param [in] timeStep  The time step counter.
+  //! \param [in] lastTimeStep  True if this is the last step.
   void process( 
     vtkUnstructuredGrid * grid, 
     double time, 
     unsigned int timeStep, 
     bool lastTimeStep 
   ) {
+    process( [grid]() { return grid; }, time, timeStep, lastTimeStep );
+  }
+
+  //! \brief Run the pipelines if any of them wants this step.
+  //!
+  //! The grid is only built if a pipeline asks for it, so the cost of 
+  //! converting the mesh is not paid on steps nobody looks at.
+  //!
+  //! \param [in] make_grid  Called to get the grid to process.
+  //! \param [in] time  The solution time.
+  //! \param [in] timeStep  The time step counter.
+  //! \param [in] lastTimeStep  True if this is the last step.
+  //! \return True if the pipelines were run.
+  //! \remark Only callables returning a grid pointer bind here, so grids 
+  //!         held in smart pointers still go to the overload above.
+  template< 
+    typename F,
+    typename = std::enable_if_t< std::is_convertible<
+      decltype( std::declval<F&>()() ), vtkUnstructuredGrid * >::value >
+  >
+  bool process( 
+    F && make_grid, 
+    double time, 
+    unsigned int timeStep, 
+    bool lastTimeStep 
+  ) {
   
 	  vtkNew<vtkCPDataDescription> dataDescription;
 	  dataDescription->AddInput("input");
@@ -87,11 +120,13 @@ public:
     // determine if any coprocessing needs to be done at this TimeStep/Time
     auto do_coprocessing = 
       processor_->RequestDataDescription(dataDescription.GetPointer()); 
-	  if (do_coprocessing)
-    {
-		  dataDescription->GetInputDescriptionByName("input")->SetGrid(grid);
-      processor_->CoProcess(dataDescription.GetPointer());
-    }
+	  if (!do_coprocessing) return false;
+
+    vtkUnstructuredGrid * grid = make_grid();
+		dataDescription->GetInputDescriptionByName("input")->SetGrid(grid);
+    processor_->CoProcess(dataDescription.GetPointer());
+
+    return true;
 
   }
 
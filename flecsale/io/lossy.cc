@@ -0,0 +1,203 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+///
+/// \file
+/// \brief The entropy coder of the lossy codec.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+// user includes
+#include "flecsale/io/lossy.h"
+
+// system includes
+#include <queue>
+#include <utility>
+
+namespace flecsale {
+namespace io {
+
+namespace {
+
+//! \brief The longest code allowed.  A block of block_size symbols never
+//!        needs more than this.
+constexpr int max_code_length = 32;
+
+//! \brief The number of distinct symbols.
+constexpr std::size_t num_symbols =
+  std::numeric_limits<lossy_codec::symbol_t>::max() + std::size_t{1};
+
+//! \brief The type of the symbol table entries.
+using table_entry_t = std::pair< lossy_codec::symbol_t, std::uint8_t >;
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Huffman code some symbols
+//
+// The code lengths are stored as a table of (symbol, length) pairs, sorted
+// by length then symbol, from which the canonical code is rebuilt.  The code
+// itself is written most significant bit first.
+////////////////////////////////////////////////////////////////////////////////
+void lossy_codec::huffman_encode(
+  const symbol_t * symbols, std::size_t n, std::vector<char> & out )
+{
+  // count the symbols
+  std::vector<std::uint32_t> counts( num_symbols, 0 );
+  for ( std::size_t i=0; i<n; i++ ) counts[ symbols[i] ]++;
+
+  std::vector<symbol_t> used;
+  for ( std::size_t s=0; s<num_symbols; s++ )
+    if ( counts[s] ) used.emplace_back( s );
+
+  // build the tree, leaves first, then the internal nodes
+  auto num_used = used.size();
+  std::vector<std::size_t> parent( 2*num_used, 0 );
+
+  using node_t = std::pair< std::uint64_t, std::size_t >;
+  std::priority_queue< node_t, std::vector<node_t>, std::greater<node_t> > heap;
+  for ( std::size_t i=0; i<num_used; i++ )
+    heap.emplace( counts[ used[i] ], i );
+
+  auto next = num_used;
+  while ( heap.size() > 1 ) {
+    auto a = heap.top(); heap.pop();
+    auto b = heap.top(); heap.pop();
+    parent[a.second] = next;
+    parent[b.second] = next;
+    heap.emplace( a.first + b.first, next++ );
+  }
+
+  // the code length of a leaf is its depth, and a lone symbol gets one bit
+  std::vector<table_entry_t> table( num_used );
+  for ( std::size_t i=0; i<num_used; i++ ) {
+    int len = 0;
+    for ( auto j = i; j+1 < next; j = parent[j] ) len++;
+    if ( len > max_code_length )
+      raise_runtime_error( "Huffman code too long" );
+    table[i] = { used[i], std::max( len, 1 ) };
+  }
+  std::sort( table.begin(), table.end(),
+    []( const auto & a, const auto & b )
+    { return a.second < b.second ||
+        ( a.second == b.second && a.first < b.first ); } );
+
+  // assign the canonical codes
+  std::vector<std::uint32_t> codes( num_symbols, 0 );
+  std::vector<std::uint8_t> lengths( num_symbols, 0 );
+  std::uint32_t code = 0;
+  int len = table.empty() ? 0 : table.front().second;
+  for ( const auto & entry : table ) {
+    code <<= ( entry.second - len );
+    len = entry.second;
+    codes[ entry.first ] = code++;
+    lengths[ entry.first ] = len;
+  }
+
+  // write the table
+  std::uint32_t table_size = num_used;
+  auto pos = out.size();
+  out.resize( pos + sizeof(table_size) + table_size*3 );
+  auto p = out.data() + pos;
+  std::memcpy( p, &table_size, sizeof(table_size) );
+  p += sizeof(table_size);
+  for ( const auto & entry : table ) {
+    std::memcpy( p, &entry.first, sizeof(symbol_t) );
+    p[2] = static_cast<char>( entry.second );
+    p += 3;
+  }
+
+  // write the code, after its size
+  pos = out.size();
+  out.resize( pos + sizeof(header_t) );
+  out.reserve( out.size() + n/2 );
+
+  std::uint64_t bits = 0;
+  int num_bits = 0;
+  for ( std::size_t i=0; i<n; i++ ) {
+    auto s = symbols[i];
+    bits = ( bits << lengths[s] ) | codes[s];
+    num_bits += lengths[s];
+    while ( num_bits >= 8 ) {
+      num_bits -= 8;
+      out.push_back( static_cast<char>( bits >> num_bits ) );
+    }
+  }
+  if ( num_bits > 0 )
+    out.push_back( static_cast<char>( bits << ( 8 - num_bits ) ) );
+
+  header_t code_bytes = out.size() - pos - sizeof(header_t);
+  std::memcpy( out.data() + pos, &code_bytes, sizeof(header_t) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Decode Huffman coded symbols
+////////////////////////////////////////////////////////////////////////////////
+const char * lossy_codec::huffman_decode(
+  const char * data, const char * end, symbol_t * symbols, std::size_t n )
+{
+  auto remaining = [&]() { return static_cast<std::size_t>( end - data ); };
+
+  // read the table
+  std::uint32_t table_size;
+  if ( remaining() < sizeof(table_size) )
+    raise_runtime_error( "Truncated Huffman table" );
+  std::memcpy( &table_size, data, sizeof(table_size) );
+  data += sizeof(table_size);
+  if ( remaining() < table_size*std::size_t{3} + sizeof(header_t) )
+    raise_runtime_error( "Truncated Huffman table" );
+
+  std::vector<symbol_t> sorted( table_size );
+  std::vector<std::int64_t> count( max_code_length+1, 0 );
+  for ( std::uint32_t i=0; i<table_size; i++ ) {
+    std::memcpy( &sorted[i], data, sizeof(symbol_t) );
+    auto len = static_cast<std::uint8_t>( data[2] );
+    if ( len < 1 || len > max_code_length )
+      raise_runtime_error( "Corrupt Huffman table" );
+    count[len]++;
+    data += 3;
+  }
+
+  header_t code_bytes;
+  std::memcpy( &code_bytes, data, sizeof(header_t) );
+  data += sizeof(header_t);
+  if ( remaining() < code_bytes )
+    raise_runtime_error( "Truncated Huffman code" );
+  auto code_end = data + code_bytes;
+
+  if ( n > 0 && table_size == 0 )
+    raise_runtime_error( "Corrupt Huffman table" );
+
+  // decode one bit at a time, walking the canonical code lengths
+  std::size_t byte = 0;
+  int bit = 7;
+  for ( std::size_t i=0; i<n; i++ ) {
+    std::int64_t code = 0, first = 0, index = 0;
+    for ( int len=1; ; len++ ) {
+      if ( len > max_code_length || data + byte >= code_end )
+        raise_runtime_error( "Corrupt Huffman code" );
+      code |= ( static_cast<unsigned char>( data[byte] ) >> bit ) & 1;
+      if ( --bit < 0 ) { bit = 7; byte++; }
+      auto cnt = count[len];
+      if ( code - cnt < first ) {
+        symbols[i] = sorted[ index + ( code - first ) ];
+        break;
+      }
+      index += cnt;
+      first = ( first + cnt ) << 1;
+      code <<= 1;
+    }
+  }
+
+  return code_end;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// the block size is odr-used by std::min, so it needs a definition
+////////////////////////////////////////////////////////////////////////////////
+constexpr std::size_t lossy_codec::block_size;
+
+} // namespace
+} // namespace
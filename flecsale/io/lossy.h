@@ -0,0 +1,490 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+///
+/// \file
+/// \brief An error bounded lossy codec for real valued fields.
+///
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// user includes
+#include "flecsale/utils/errors.h"
+
+// system includes
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace flecsale {
+namespace io {
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief An error bounded lossy codec for arrays of reals.
+//!
+//! The array is split into blocks that are coded independently, and in
+//! parallel.  Within a block, each value is predicted from the previously
+//! reconstructed value of the same component, and the difference is
+//! quantized into intervals twice the error bound wide.  Values that cannot be predicted within the bound,
+//! including non-finite ones, are stored exactly.  The quantization codes
+//! are then Huffman coded.  Every reconstructed value is within the error
+//! bound of the original.
+//!
+//! The stream starts with a header holding the number of values, the size
+//! of each value, the absolute error bound, the number of interleaved
+//! components and the size of each block.
+////////////////////////////////////////////////////////////////////////////////
+class lossy_codec {
+
+public :
+
+  //! \brief How the error bound is interpreted.
+  enum class bound_t
+  {
+    //! the bound is the maximum absolute error
+    absolute,
+    //! the bound is relative to the range of the values
+    relative
+  };
+
+  //! \brief The number of values in each block.
+  static constexpr std::size_t block_size = 1 << 16;
+
+  //! \brief The number of quantization intervals on each side of the
+  //!        prediction.
+  static constexpr std::int64_t radius = 1 << 15;
+
+  //! \brief The type of the stream header entries.
+  using header_t = std::uint64_t;
+
+  //! \brief The type of the quantization codes.
+  using symbol_t = std::uint16_t;
+
+  /*! *************************************************************************
+   * \brief Constructor.
+   * \param [in] mode  How the bound is interpreted.
+   * \param [in] bound  The error bound.  Zero stores values exactly.
+   ****************************************************************************/
+  lossy_codec( bound_t mode = bound_t::absolute, double bound = 0 ) :
+    mode_( mode ), bound_( bound )
+  {
+    if ( !( bound_ >= 0 ) )
+      raise_runtime_error( "Invalid lossy error bound " << bound_ );
+  }
+
+  //! \brief Return how the error bound is interpreted.
+  auto mode() const noexcept { return mode_; }
+
+  //! \brief Return the error bound.
+  auto bound() const noexcept { return bound_; }
+
+  /*! *************************************************************************
+   * \brief Return the absolute error bound used for some data.
+   * \param [in] data  The values.
+   * \param [in] n  The number of values.
+   * \tparam T  The type of the values.
+   ****************************************************************************/
+  template< typename T >
+  double absolute_bound( const T * data, std::size_t n ) const
+  {
+    if ( mode_ == bound_t::absolute ) return bound_;
+    // the range of the finite values
+    T lo = std::numeric_limits<T>::max();
+    T hi = std::numeric_limits<T>::lowest();
+    #pragma omp parallel for reduction(min:lo) reduction(max:hi)
+    for ( std::size_t i=0; i<n; i++ )
+      if ( std::isfinite( data[i] ) ) {
+        lo = std::min( lo, data[i] );
+        hi = std::max( hi, data[i] );
+      }
+    return ( hi > lo ) ? bound_ * ( static_cast<double>(hi) - lo ) : 0;
+  }
+
+  /*! *************************************************************************
+   * \brief Compress an array.
+   * \param [in] data  The values.
+   * \param [in] n  The number of values.
+   * \param [in] num_comps  The number of interleaved components.
+   * \tparam T  The type of the values, float or double.
+   * \return The compressed stream.
+   ****************************************************************************/
+  template< typename T >
+  std::vector<char> compress(
+    const T * data, std::size_t n, std::size_t num_comps = 1 ) const
+  {
+    static_assert( std::is_floating_point<T>::value,
+      "Only reals can be compressed" );
+    if ( num_comps < 1 )
+      raise_runtime_error( "Need at least one component" );
+
+    auto eb = absolute_bound( data, n );
+    auto num_blocks = ( n + block_size - 1 ) / block_size;
+    std::vector< std::vector<char> > blocks( num_blocks );
+    std::vector<char> failed( num_blocks, 0 );
+
+    #pragma omp parallel for
+    for ( std::size_t b=0; b<num_blocks; b++ ) {
+      auto start = b * block_size;
+      auto len = std::min( block_size, n - start );
+      try {
+        compress_block( data + start, len, num_comps, eb, blocks[b] );
+      }
+      catch ( const std::exception & ) {
+        failed[b] = 1;
+      }
+    }
+    raise_block_errors( failed );
+
+    // the header, then the blocks
+    std::vector<header_t> header( num_header + num_blocks );
+    header[0] = n;
+    header[1] = sizeof(T);
+    std::memcpy( &header[2], &eb, sizeof(double) );
+    header[3] = num_comps;
+    for ( std::size_t b=0; b<num_blocks; b++ )
+      header[num_header+b] = blocks[b].size();
+
+    std::vector<char> out( header.size() * sizeof(header_t) );
+    std::memcpy( out.data(), header.data(), out.size() );
+    for ( auto & blk : blocks ) {
+      out.insert( out.end(), blk.begin(), blk.end() );
+      std::vector<char>().swap( blk );
+    }
+    return out;
+  }
+
+  /*! *************************************************************************
+   * \brief Return the number of values in a compressed stream.
+   * \param [in] data  The compressed stream.
+   * \param [in] bytes  The size of the stream.
+   ****************************************************************************/
+  static std::size_t size( const char * data, std::size_t bytes )
+  {
+    if ( bytes < num_header*sizeof(header_t) )
+      raise_runtime_error( "Truncated lossy stream" );
+    header_t n;
+    std::memcpy( &n, data, sizeof(header_t) );
+    return n;
+  }
+
+  /*! *************************************************************************
+   * \brief Decompress an array.
+   * \param [in] data  The compressed stream.
+   * \param [in] bytes  The size of the stream.
+   * \param [out] out  Storage for the values.  It must hold size() values.
+   * \tparam T  The type of the values, which must match the compressed
+   *            ones.
+   ****************************************************************************/
+  template< typename T >
+  static void decompress( const char * data, std::size_t bytes, T * out )
+  {
+    auto n = size( data, bytes );
+    header_t value_size, num_comps;
+    double eb;
+    std::memcpy( &value_size, data + sizeof(header_t), sizeof(header_t) );
+    std::memcpy( &eb, data + 2*sizeof(header_t), sizeof(double) );
+    std::memcpy( &num_comps, data + 3*sizeof(header_t), sizeof(header_t) );
+    if ( value_size != sizeof(T) )
+      raise_runtime_error( "Lossy stream holds values of " << value_size
+        << " bytes, not " << sizeof(T) );
+    if ( num_comps < 1 ) raise_runtime_error( "Corrupt lossy stream" );
+
+    auto num_blocks = ( n + block_size - 1 ) / block_size;
+    auto header_bytes = ( num_header + num_blocks ) * sizeof(header_t);
+    if ( bytes < header_bytes ) raise_runtime_error( "Truncated lossy stream" );
+
+    // where each block starts
+    std::vector<std::size_t> offsets( num_blocks+1, header_bytes );
+    for ( std::size_t b=0; b<num_blocks; b++ ) {
+      header_t len;
+      std::memcpy(
+        &len, data + (num_header+b)*sizeof(header_t), sizeof(header_t) );
+      offsets[b+1] = offsets[b] + len;
+    }
+    if ( offsets.back() > bytes ) raise_runtime_error( "Truncated lossy stream" );
+
+    std::vector<char> failed( num_blocks, 0 );
+
+    #pragma omp parallel for
+    for ( std::size_t b=0; b<num_blocks; b++ ) {
+      auto start = b * block_size;
+      auto len = std::min( block_size, n - start );
+      try {
+        decompress_block( data + offsets[b], data + offsets[b+1], len,
+          num_comps, eb, out + start );
+      }
+      catch ( const std::exception & ) {
+        failed[b] = 1;
+      }
+    }
+    raise_block_errors( failed );
+  }
+
+  /*! *************************************************************************
+   * \brief Huffman code some symbols.
+   * \param [in] symbols  The symbols to code.
+   * \param [in] n  The number of symbols.  At most block_size.
+   * \param [in,out] out  The code is appended to this.
+   ****************************************************************************/
+  static void huffman_encode(
+    const symbol_t * symbols, std::size_t n, std::vector<char> & out );
+
+  /*! *************************************************************************
+   * \brief Decode Huffman coded symbols.
+   * \param [in] data  The start of the code.
+   * \param [in] end  The end of the stream.
+   * \param [out] symbols  Storage for the decoded symbols.
+   * \param [in] n  The number of symbols to decode.
+   * \return The end of the code.
+   ****************************************************************************/
+  static const char * huffman_decode(
+    const char * data, const char * end, symbol_t * symbols, std::size_t n );
+
+private :
+
+  //! \brief The number of stream header entries before the block sizes.
+  static constexpr std::size_t num_header = 4;
+
+  /*! *************************************************************************
+   * \brief Raise an error if any block failed.
+   *
+   * Exceptions cannot leave a parallel region, so the block loops flag the
+   * blocks that failed, and this raises once they are all done.  The 
+   * original error was already printed when it was raised.
+   *
+   * \param [in] failed  Nonzero for each block that failed.
+   ****************************************************************************/
+  static void raise_block_errors( const std::vector<char> & failed )
+  {
+    for ( std::size_t b=0; b<failed.size(); b++ )
+      if ( failed[b] ) raise_runtime_error( "Lossy block " << b << " failed" );
+  }
+
+  /*! *************************************************************************
+   * \brief Return the prediction of a value from the previous one of the
+   *        same component.
+   ****************************************************************************/
+  template< typename T >
+  static T predict( const T * recon, std::size_t i, std::size_t num_comps )
+  {
+    if ( i < num_comps ) return 0;
+    auto prev = recon[ i - num_comps ];
+    return std::isfinite(prev) ? prev : 0;
+  }
+
+  /*! *************************************************************************
+   * \brief Reconstruct a value from its prediction and quantization code.
+   ****************************************************************************/
+  template< typename T >
+  static T reconstruct( T pred, double step, std::int64_t q )
+  {
+    double delta = step * static_cast<double>(q);
+    return static_cast<T>( static_cast<double>(pred) + delta );
+  }
+
+  /*! *************************************************************************
+   * \brief Compress one block.
+   ****************************************************************************/
+  template< typename T >
+  static void compress_block(
+    const T * data, std::size_t n, std::size_t num_comps, double eb,
+    std::vector<char> & out )
+  {
+    std::vector<symbol_t> symbols( n );
+    std::vector<T> recon( n ), exact;
+
+    auto step = 2 * eb;
+
+    for ( std::size_t i=0; i<n; i++ ) {
+      auto x = data[i];
+      auto pred = predict( recon.data(), i, num_comps );
+      symbol_t sym = 0;
+      if ( std::isfinite(x) ) {
+        auto diff = static_cast<double>(x) - pred;
+        if ( eb > 0 && std::abs( diff ) < ( radius - 1 ) * step ) {
+          auto q = static_cast<std::int64_t>( std::llround( diff / step ) );
+          auto y = reconstruct( pred, step, q );
+          if ( std::abs( static_cast<double>(y) - x ) <= eb ) {
+            sym = static_cast<symbol_t>( q + radius );
+            recon[i] = y;
+          }
+        }
+        else if ( diff == 0 ) {
+          sym = static_cast<symbol_t>( radius );
+          recon[i] = pred;
+        }
+      }
+      // not predictable, so store it as is
+      if ( sym == 0 ) {
+        exact.emplace_back( x );
+        recon[i] = x;
+      }
+      symbols[i] = sym;
+    }
+
+    std::uint32_t num_exact = exact.size();
+    out.resize( sizeof(num_exact) + num_exact*sizeof(T) );
+    std::memcpy( out.data(), &num_exact, sizeof(num_exact) );
+    if ( num_exact )
+      std::memcpy(
+        out.data() + sizeof(num_exact), exact.data(), num_exact*sizeof(T) );
+
+    huffman_encode( symbols.data(), n, out );
+  }
+
+  /*! *************************************************************************
+   * \brief Decompress one block.
+   ****************************************************************************/
+  template< typename T >
+  static void decompress_block(
+    const char * data, const char * end, std::size_t n, std::size_t num_comps,
+    double eb, T * out )
+  {
+    std::uint32_t num_exact;
+    if ( end - data < static_cast<std::ptrdiff_t>( sizeof(num_exact) ) )
+      raise_runtime_error( "Truncated lossy block" );
+    std::memcpy( &num_exact, data, sizeof(num_exact) );
+    data += sizeof(num_exact);
+
+    std::vector<T> exact( num_exact );
+    if ( end - data < static_cast<std::ptrdiff_t>( num_exact*sizeof(T) ) )
+      raise_runtime_error( "Truncated lossy block" );
+    if ( num_exact ) std::memcpy( exact.data(), data, num_exact*sizeof(T) );
+    data += num_exact*sizeof(T);
+
+    std::vector<symbol_t> symbols( n );
+    huffman_decode( data, end, symbols.data(), n );
+
+    auto step = 2 * eb;
+    std::size_t next_exact = 0;
+
+    for ( std::size_t i=0; i<n; i++ ) {
+      auto sym = symbols[i];
+      if ( sym == 0 ) {
+        if ( next_exact == num_exact )
+          raise_runtime_error( "Corrupt lossy block" );
+        out[i] = exact[ next_exact++ ];
+      }
+      else {
+        auto pred = predict( out, i, num_comps );
+        out[i] = reconstruct(
+          pred, step, static_cast<std::int64_t>(sym) - radius );
+      }
+    }
+  }
+
+  //! \brief How the error bound is interpreted.
+  bound_t mode_ = bound_t::absolute;
+
+  //! \brief The error bound.
+  double bound_ = 0;
+
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Keeps track of how well each field compresses, and how fast.
+////////////////////////////////////////////////////////////////////////////////
+class lossy_stats_t {
+
+public :
+
+  //! \brief The clock used to time the compression.
+  using clock_t = std::chrono::steady_clock;
+
+  /*! *************************************************************************
+   * \brief Return the statistics of this process.
+   ****************************************************************************/
+  static lossy_stats_t & instance()
+  {
+    static lossy_stats_t stats;
+    return stats;
+  }
+
+  /*! *************************************************************************
+   * \brief Record one compression.
+   * \param [in] name  The field name.
+   * \param [in] raw_bytes  The uncompressed size.
+   * \param [in] compressed_bytes  The compressed size.
+   * \param [in] seconds  How long the compression took.
+   ****************************************************************************/
+  void record(
+    const std::string & name, std::size_t raw_bytes,
+    std::size_t compressed_bytes, double seconds )
+  {
+    auto & f = fields_[name];
+    f.count++;
+    f.raw_bytes += raw_bytes;
+    f.compressed_bytes += compressed_bytes;
+    f.seconds += seconds;
+  }
+
+  //! \brief Return true if nothing was recorded.
+  bool empty() const noexcept
+  { return fields_.empty(); }
+
+  //! \brief Forget everything recorded so far.
+  void clear()
+  { fields_.clear(); }
+
+  /*! *************************************************************************
+   * \brief Print the compression ratio and throughput of each field.
+   * \param [in,out] os  The stream to print to.
+   ****************************************************************************/
+  void report( std::ostream & os ) const
+  {
+    auto flags = os.flags();
+    os << "Lossy compression:" << std::endl;
+    os << std::setw(24) << std::left << " field" << std::right
+       << std::setw(8) << "count"
+       << std::setw(14) << "raw (MB)"
+       << std::setw(14) << "packed (MB)"
+       << std::setw(10) << "ratio"
+       << std::setw(12) << "MB/s" << std::endl;
+    for ( const auto & f : fields_ ) {
+      const auto & s = f.second;
+      auto raw_mb = s.raw_bytes / 1.e6;
+      os << " " << std::setw(23) << std::left << f.first << std::right
+         << std::setw(8) << s.count
+         << std::fixed << std::setprecision(3)
+         << std::setw(14) << raw_mb
+         << std::setw(14) << s.compressed_bytes / 1.e6
+         << std::setprecision(2)
+         << std::setw(10)
+         << static_cast<double>(s.raw_bytes) / std::max<std::size_t>( s.compressed_bytes, 1 )
+         << std::setprecision(1)
+         << std::setw(12) << ( s.seconds > 0 ? raw_mb / s.seconds : 0. )
+         << std::endl;
+    }
+    os.flags( flags );
+  }
+
+private :
+
+  //! \brief The totals for one field.
+  struct entry_t {
+    std::size_t count = 0;
+    std::size_t raw_bytes = 0;
+    std::size_t compressed_bytes = 0;
+    double seconds = 0;
+  };
+
+  //! \brief The totals of each field.
+  std::map< std::string, entry_t > fields_;
+
+};
+
+} // namespace
+} // namespace
@@ -0,0 +1,168 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Tests related to the lossy codec.
+////////////////////////////////////////////////////////////////////////////////
+
+// user includes
+#include "flecsale/io/lossy.h"
+
+// system includes
+#include<cinchtest.h>
+#include<cmath>
+#include<cstdint>
+#include<cstring>
+#include<limits>
+#include<sstream>
+#include<vector>
+
+// explicitly use some stuff
+using std::vector;
+
+using namespace flecsale::io;
+
+//! \brief A smooth signal with some noise, spanning several blocks.
+template< typename T >
+vector<T> make_signal( std::size_t n )
+{
+  vector<T> x( n );
+  for ( std::size_t i=0; i<n; i++ )
+    x[i] = 100 * std::sin( 1.e-4 * i ) + 1.e-2 * std::cos( 7. * i );
+  return x;
+}
+
+//! \brief Compress and decompress, and check the error bound.
+template< typename T >
+void check_round_trip( 
+  const lossy_codec & codec, const vector<T> & x, std::size_t num_comps = 1 )
+{
+  auto stream = codec.compress( x.data(), x.size(), num_comps );
+  ASSERT_EQ( x.size(), lossy_codec::size( stream.data(), stream.size() ) );
+
+  vector<T> y( x.size() );
+  lossy_codec::decompress( stream.data(), stream.size(), y.data() );
+
+  auto eb = codec.absolute_bound( x.data(), x.size() );
+  for ( std::size_t i=0; i<x.size(); i++ ) {
+    if ( std::isnan( x[i] ) )
+      ASSERT_TRUE( std::isnan( y[i] ) );
+    else if ( !std::isfinite( x[i] ) )
+      ASSERT_EQ( x[i], y[i] );
+    else
+      ASSERT_LE( std::abs( static_cast<double>( x[i] ) - y[i] ), eb );
+  }
+}
+
+//=============================================================================
+//! \brief Test the absolute error bound.
+//=============================================================================
+TEST(lossy, absolute) {
+
+  auto x = make_signal<double>( 3*lossy_codec::block_size + 17 );
+  lossy_codec codec( lossy_codec::bound_t::absolute, 1.e-3 );
+  check_round_trip( codec, x );
+
+  // a smooth signal compresses well
+  auto stream = codec.compress( x.data(), x.size() );
+  ASSERT_GT( x.size()*sizeof(double), 4*stream.size() );
+
+} // TEST
+
+//=============================================================================
+//! \brief Test the relative error bound, in single precision.
+//=============================================================================
+TEST(lossy, relative) {
+
+  auto x = make_signal<float>( 2*lossy_codec::block_size );
+  lossy_codec codec( lossy_codec::bound_t::relative, 1.e-5 );
+  ASSERT_NEAR( codec.absolute_bound( x.data(), x.size() ), 2.e-3, 1.e-5 );
+  check_round_trip( codec, x );
+
+} // TEST
+
+//=============================================================================
+//! \brief Test interleaved components.
+//=============================================================================
+TEST(lossy, components) {
+
+  // a ramp interleaved with a constant
+  vector<double> x( 2*lossy_codec::block_size + 3 );
+  for ( std::size_t i=0; i<x.size(); i++ ) x[i] = ( i % 2 ) ? -1. : 0.5 * i;
+
+  lossy_codec codec( lossy_codec::bound_t::absolute, 1.e-4 );
+  check_round_trip( codec, x, 2 );
+
+  // predicting each component on its own pays off
+  auto interleaved = codec.compress( x.data(), x.size(), 2 );
+  auto flat = codec.compress( x.data(), x.size() );
+  ASSERT_LT( 2*interleaved.size(), flat.size() );
+
+} // TEST
+
+//=============================================================================
+//! \brief Test that a zero bound is exact, and special values are kept.
+//=============================================================================
+TEST(lossy, exact) {
+
+  auto x = make_signal<double>( 1000 );
+  x[10] = std::numeric_limits<double>::quiet_NaN();
+  x[20] = std::numeric_limits<double>::infinity();
+  x[30] = -std::numeric_limits<double>::infinity();
+  x[40] = 1.e300;
+
+  check_round_trip( lossy_codec(), x );
+  check_round_trip( lossy_codec( lossy_codec::bound_t::absolute, 1.e-6 ), x );
+
+  // nothing at all
+  vector<double> empty;
+  check_round_trip( lossy_codec( lossy_codec::bound_t::relative, 0.1 ), empty );
+
+} // TEST
+
+//=============================================================================
+//! \brief Test that a corrupt block is reported once the others are done.
+//=============================================================================
+TEST(lossy, corrupt) {
+
+  auto x = make_signal<double>( 3*lossy_codec::block_size );
+  lossy_codec codec( lossy_codec::bound_t::absolute, 1.e-4 );
+  auto stream = codec.compress( x.data(), x.size() );
+
+  // claim the second block is shorter than it is, which cuts its code 
+  // short and shifts the start of the third
+  std::uint64_t len;
+  auto pos = 5*sizeof(len);
+  std::memcpy( &len, stream.data() + pos, sizeof(len) );
+  len /= 2;
+  std::memcpy( stream.data() + pos, &len, sizeof(len) );
+
+#ifdef ENABLE_EXCEPTIONS
+  vector<double> y( x.size() );
+  ASSERT_THROW( 
+    lossy_codec::decompress( stream.data(), stream.size(), y.data() ),
+    flecsale::utils::ExceptionRunTime );
+#endif
+
+} // TEST
+
+//=============================================================================
+//! \brief Test the statistics report.
+//=============================================================================
+TEST(lossy, stats) {
+
+  auto & stats = lossy_stats_t::instance();
+  stats.clear();
+  ASSERT_TRUE( stats.empty() );
+
+  stats.record( "density", 8000, 1000, 0.001 );
+  stats.record( "density", 8000, 1000, 0.001 );
+
+  std::stringstream ss;
+  stats.report( ss );
+  ASSERT_NE( ss.str().find( "density" ), std::string::npos );
+  ASSERT_NE( ss.str().find( "8.00" ), std::string::npos );
+
+} // TEST
@@ -0,0 +1,113 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Tests the binary writers.
+////////////////////////////////////////////////////////////////////////////////
+
+// user includes
+#include "flecsale/io/write_binary.h"
+
+// system includes
+#include<cinchtest.h>
+#include<cstdint>
+#include<cstring>
+#include<sstream>
+#include<string>
+#include<vector>
+
+// explicitly use some stuff
+using std::vector;
+
+using namespace flecsale::io;
+
+//! \brief Values that use every byte, spanning more than one write block.
+template< typename T >
+vector<T> make_values()
+{
+  auto n = write_block_size / sizeof(T) + 3;
+  vector<T> x( n );
+  for ( std::size_t i=0; i<n; i++ ) {
+    auto bits = static_cast<std::uint64_t>( i ) * 0x0101010101010101ull +
+      0x0807060504030201ull;
+    std::memcpy( &x[i], &bits, sizeof(T) );
+  }
+  return x;
+}
+
+//! \brief Return the big endian bytes of a value.
+template< typename T >
+std::string big_endian_bytes( const T & x )
+{
+  using word_t = typename detail::swap_word_t< sizeof(T) >::type;
+  word_t w;
+  std::memcpy( &w, &x, sizeof(T) );
+  std::string bytes( sizeof(T), '\0' );
+  for ( std::size_t b=0; b<sizeof(T); b++ )
+    bytes[ sizeof(T)-1-b ] = static_cast<char>( ( w >> (8*b) ) & 0xff );
+  return bytes;
+}
+
+//! \brief Write big endian, check the bytes, and swap them back.
+template< typename T >
+void check_round_trip()
+{
+  auto x = make_values<T>();
+
+  std::ostringstream os;
+  WriteBigEndianArray( os, x.data(), x.size() );
+  auto bytes = os.str();
+  ASSERT_EQ( x.size()*sizeof(T), bytes.size() );
+
+  for ( std::size_t i=0; i<x.size(); i++ )
+    ASSERT_EQ( big_endian_bytes( x[i] ), bytes.substr( i*sizeof(T), sizeof(T) ) );
+
+  // swapping the swapped values gives back the originals
+  vector<T> swapped( x.size() ), y( x.size() );
+  std::memcpy( swapped.data(), bytes.data(), bytes.size() );
+  if ( isBigEndian() ) {
+    y = swapped;
+  }
+  else {
+    std::ostringstream back;
+    WriteBinarySwapArray( back, swapped.data(), swapped.size() );
+    std::memcpy( y.data(), back.str().data(), bytes.size() );
+  }
+  ASSERT_EQ( 0, std::memcmp( x.data(), y.data(), bytes.size() ) );
+}
+
+//=============================================================================
+//! \brief Test writing 2 byte values.
+//=============================================================================
+TEST(write_binary, two_bytes) {
+  check_round_trip<std::int16_t>();
+  check_round_trip<std::uint16_t>();
+} // TEST
+
+//=============================================================================
+//! \brief Test writing 4 byte values.
+//=============================================================================
+TEST(write_binary, four_bytes) {
+  check_round_trip<int32>();
+  check_round_trip<float32>();
+} // TEST
+
+//=============================================================================
+//! \brief Test writing 8 byte values.
+//=============================================================================
+TEST(write_binary, eight_bytes) {
+  check_round_trip<int64>();
+  check_round_trip<float64>();
+} // TEST
+
+//=============================================================================
+//! \brief Test the bytes of a known value.
+//=============================================================================
+TEST(write_binary, known_bytes) {
+  std::uint32_t x = 0x01020304;
+  std::ostringstream os;
+  WriteBigEndianArray( os, &x, 1 );
+  ASSERT_EQ( std::string( "\x01\x02\x03\x04", 4 ), os.str() );
+} // TEST
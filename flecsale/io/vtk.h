@@ -15,9 +15,11 @@
  #include "flecsale/common/types.h"
 
 // system includes
+#include <cassert>
 #include <typeindex>
 #include <typeinfo>
 #include <unordered_map>
+#include <vector>
 
 namespace flecsale {
 namespace io {
@@ -132,12 +134,7 @@ public :
     // write the data
     if ( binary_ ) {
 
-      if ( isBigEndian() )
-        for (auto val : data ) 
-          WriteBinary<T>( file_, val );
-      else
-        for (auto val : data ) 
-          WriteBinarySwap<T>( file_, val );
+      WriteBigEndianArray( file_, data.data(), data.size() );
 
     }
     //--------------------------------------------------------------------------
@@ -197,9 +194,6 @@ public :
 
     auto nelem = data.size();
 
-    // check endienness, vtk needs big endian
-    auto swap = !isBigEndian();
-
     // write the number of cells ( per element: 4 points plus # of points )
     file_ << "CELLS " << nelem << " " << size << std::endl;
 
@@ -207,18 +201,14 @@ public :
     // write the data
     if ( binary_ ) {
 
-      if (swap)
-        for ( const auto & elem : data ) {
-          WriteBinarySwap<value_type>(file_, static_cast<value_type>(elem.size()) );
-          for ( auto val : elem )
-            WriteBinarySwap<value_type>(file_, val);                
-        }
-      else
-        for ( const auto & elem : data ) {
-          WriteBinary<value_type>(file_, elem.size());
-          for ( auto val : elem )
-            WriteBinary<value_type>(file_, val);                
-        }
+      // flatten everything, so it can be written in bulk
+      std::vector<value_type> buffer;
+      buffer.reserve( size );
+      for ( const auto & elem : data ) {
+        buffer.emplace_back( static_cast<value_type>(elem.size()) );
+        buffer.insert( buffer.end(), elem.begin(), elem.end() );
+      }
+      WriteBigEndianArray( file_, buffer.data(), buffer.size() );
 
     }
     //--------------------------------------------------------------------------
@@ -244,16 +234,11 @@ public :
     // write the data
     if ( binary_ ) {
 
-      if (swap) 
-        for ( const auto & elem : data )
-          WriteBinarySwap<value_type>(
-            file_, static_cast<value_type>(cell_type[cell++]) 
-          );
-      else
-        for ( const auto & elem : data )
-          WriteBinary<value_type>(
-            file_, static_cast<value_type>(cell_type[cell++])
-          );    
+      // vtk expects 32-bit cell types
+      std::vector<int32> types( nelem );
+      for ( ; cell<nelem; cell++ ) 
+        types[cell] = static_cast<int32>( cell_type[cell] );
+      WriteBigEndianArray( file_, types.data(), types.size() );
 
     } 
     //--------------------------------------------------------------------------
@@ -328,12 +313,7 @@ public :
     // write the data
     if ( binary_ ) {
 
-      if ( isBigEndian() )
-        for (auto val : data ) 
-          WriteBinary<T>( file_, val );
-      else
-        for (auto val : data ) 
-          WriteBinarySwap<T>( file_, val );    
+      WriteBigEndianArray( file_, data.data(), data.size() );
 
     }
     //--------------------------------------------------------------------------
@@ -0,0 +1,43 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+///
+/// \file
+/// \brief Functions to write vtk xml unstructured grid files.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+// user includes
+#include "vtu.h"
+
+namespace flecsale {
+namespace io {
+
+
+////////////////////////////////////////////////////////////////////////////////
+// the type map
+////////////////////////////////////////////////////////////////////////////////
+const vtu_writer::type_map_t vtu_writer::type_map = 
+  { 
+    { typeid(float),  "Float32" },
+    { typeid(double), "Float64" },
+    { typeid(std::int8_t),   "Int8" },
+    { typeid(std::uint8_t),  "UInt8" },
+    { typeid(int),    "Int32" },
+    { typeid(long),   "Int64" },
+    { typeid(long long),   "Int64" },
+    { typeid(unsigned int),  "UInt32" },
+    { typeid(unsigned long), "UInt64" },
+    { typeid(unsigned long long), "UInt64" },
+  };
+
+////////////////////////////////////////////////////////////////////////////////
+// the block sizes are odr-used by std::min, so they need a definition
+////////////////////////////////////////////////////////////////////////////////
+constexpr std::size_t vtu_writer::block_size;
+constexpr std::size_t vtu_writer::blocks_per_batch;
+
+} // namespace
+} // namespace
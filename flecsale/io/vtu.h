@@ -0,0 +1,688 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+///
+/// \file
+/// \brief Functions to write vtk xml unstructured grid files.
+///
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// user includes
+#include "lossy.h"
+#include "write_binary.h"
+#include "flecsale/utils/errors.h"
+
+#ifdef HAVE_ZLIB
+#  include <zlib.h>
+#endif
+
+#ifdef HAVE_LZ4
+#  include <lz4.h>
+#endif
+
+// system includes
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <typeindex>
+#include <type_traits>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+namespace flecsale {
+namespace io {
+
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief A writer for vtk xml unstructured grids, i.e. vtu files.
+//!
+//! Everything is stored as raw appended binary data in the native byte
+//! order, optionally compressed in independent blocks.  The blocks are
+//! compressed in parallel, a few at a time.  Since the xml header has to
+//! list where each array starts, each array is spooled to a scratch file
+//! next to the output as soon as it is encoded, and close() copies the
+//! spooled data after the header.  So only a few blocks are ever held in
+//! memory, and the caller's data can be released as soon as it has been
+//! added.
+//!
+//! Real valued fields can instead be stored with an error bounded lossy
+//! codec.  Stock vtk readers do not understand those arrays, so the
+//! flecsale_unlossy utility converts such files back to plain vtu files.
+////////////////////////////////////////////////////////////////////////////////
+class vtu_writer {
+
+public :
+
+  /*! *************************************************************************
+   * \brief A type map.
+   ****************************************************************************/
+  using type_map_t = std::unordered_map<std::type_index, std::string>;
+  static const type_map_t type_map;
+
+  /*! *************************************************************************
+   * \brief The element map.
+   ****************************************************************************/
+  enum class cell_type_t : std::uint8_t
+  {
+    triangle = 5,
+    polygon = 7,
+    quad = 9,
+    tetra = 10,
+    hexahedron = 12,
+    wedge = 13,
+    pyramid = 14,
+    polyhedron = 42
+  };
+
+  /*! *************************************************************************
+   * \brief The available compression methods.
+   ****************************************************************************/
+  enum class compression_t
+  {
+    none,
+    zlib,
+    lz4
+  };
+
+  //! \brief The number of uncompressed bytes in each compressed block.
+  static constexpr std::size_t block_size = 1 << 20;
+
+  /*! *************************************************************************
+   * \brief The compression used when none is specified.
+   * \return A reference to the setting, which can be changed.
+   ****************************************************************************/
+  static compression_t & default_compression()
+  {
+#if defined(HAVE_ZLIB)
+    static compression_t compression = compression_t::zlib;
+#elif defined(HAVE_LZ4)
+    static compression_t compression = compression_t::lz4;
+#else
+    static compression_t compression = compression_t::none;
+#endif
+    return compression;
+  }
+
+  /*! *************************************************************************
+   * \brief The compressor attribute of lossily compressed arrays.
+   ****************************************************************************/
+  static constexpr const char * lossy_compressor = "FleCSALELossyCompressor";
+
+  /*! *************************************************************************
+   * \brief Store the real valued fields added from now on with a lossy codec.
+   *
+   * Each such array is stored as the size of the lossy stream followed by
+   * the stream, regardless of the compression of the other arrays.
+   *
+   * \param [in] codec  The codec to use.
+   ****************************************************************************/
+  void set_lossy( const lossy_codec & codec )
+  {
+    lossy_ = codec;
+    use_lossy_ = true;
+  }
+
+  /*! *************************************************************************
+   * \brief Store all the fields added from now on exactly.
+   ****************************************************************************/
+  void clear_lossy()
+  { use_lossy_ = false; }
+
+  /*! *************************************************************************
+   * \brief Open a vtu file for writing.
+   * \param [in] filename The name of the file to open.
+   * \param [in] compression  The compression to use.
+   * \return 0 for success, 1 otherwise.
+   ****************************************************************************/
+  auto open(
+    const char* filename,
+    compression_t compression = default_compression() )
+  {
+#ifndef HAVE_ZLIB
+    if ( compression == compression_t::zlib )
+      raise_implemented_error( "Not built with zlib support." );
+#endif
+#ifndef HAVE_LZ4
+    if ( compression == compression_t::lz4 )
+      raise_implemented_error( "Not built with lz4 support." );
+#endif
+
+    file_name_ = filename;
+    file_.open( filename, std::ofstream::binary );
+    spool_name_ = file_name_ + ".appended";
+    spool_.open( spool_name_,
+      std::fstream::in | std::fstream::out | std::fstream::trunc |
+      std::fstream::binary );
+    compression_ = compression;
+
+    num_points_ = 0;
+    num_cells_ = 0;
+    points_.clear();
+    cells_.clear();
+    point_data_.clear();
+    cell_data_.clear();
+    appended_size_ = 0;
+
+    return !file_.good() || !spool_.good();
+  }
+
+  /*! *************************************************************************
+   * \brief Write the file, and close it.
+   * \return 0 for success, 1 otherwise.
+   ****************************************************************************/
+  auto close( void )
+  {
+    file_ << "<?xml version=\"1.0\"?>" << std::endl;
+    file_ << "<VTKFile type=\"UnstructuredGrid\"";
+    write_file_attributes( file_, true );
+    file_ << ">" << std::endl;
+    file_ << "  <UnstructuredGrid>" << std::endl;
+    file_ << "    <Piece NumberOfPoints=\"" << num_points_ << "\""
+          << " NumberOfCells=\"" << num_cells_ << "\">" << std::endl;
+
+    write_section( "PointData", point_data_ );
+    write_section( "CellData", cell_data_ );
+    write_section( "Points", points_ );
+    write_section( "Cells", cells_ );
+
+    file_ << "    </Piece>" << std::endl;
+    file_ << "  </UnstructuredGrid>" << std::endl;
+    file_ << "  <AppendedData encoding=\"raw\">" << std::endl;
+    file_ << "   _";
+
+    // copy the spooled data over, one block at a time
+    auto spool_ok = spool_.good();
+    spool_.seekg( 0 );
+    std::vector<char> buffer( std::min( block_size, appended_size_ ) );
+    for ( std::size_t pos=0; pos<appended_size_; pos+=buffer.size() ) {
+      auto len = std::min( buffer.size(), appended_size_ - pos );
+      spool_.read( buffer.data(), len );
+      file_.write( buffer.data(), len );
+    }
+    spool_ok = spool_ok && spool_.good();
+    spool_.close();
+    std::remove( spool_name_.c_str() );
+
+    file_ << std::endl;
+    file_ << "  </AppendedData>" << std::endl;
+    file_ << "</VTKFile>" << std::endl;
+
+    num_bytes_ = file_.tellp();
+    auto ierr = !file_.good() || !spool_ok;
+    file_.close();
+    return ierr;
+  }
+
+  /*! *************************************************************************
+   * \brief Abandon a file that was opened but not closed.
+   *
+   * The partial file and the spooled appended data are removed.  This does
+   * nothing if no file is open, so it is safe to call after close().
+   ****************************************************************************/
+  void abort()
+  {
+    if ( spool_.is_open() ) {
+      spool_.close();
+      std::remove( spool_name_.c_str() );
+    }
+    if ( file_.is_open() ) {
+      file_.close();
+      std::remove( file_name_.c_str() );
+    }
+  }
+
+  /*! *************************************************************************
+   * \brief The number of bytes written by the last close().
+   ****************************************************************************/
+  std::size_t num_bytes() const
+  { return num_bytes_; }
+
+  /*! *************************************************************************
+   * \brief Write node coordinates.
+   * \param [in] data  The coordinates, three per point.
+   * \param [in] npoints The number of points to write.
+   * \tparam T  The type of data.
+   * \return 0 for success, 1 otherwise.
+   ****************************************************************************/
+  template< typename T >
+  auto write_points( const T * data, std::size_t npoints )
+  {
+    num_points_ = npoints;
+    add_array( points_, "Points", data, 3*npoints, 3 );
+    return !file_.good();
+  }
+
+  /*! *************************************************************************
+   * \brief Write connectivity information, i.e. cell to vertex
+   *        connectivity.
+   *
+   * \param [in] connectivity  The vertices of each cell, one after the
+   *                           other.
+   * \param [in] offsets  The end of each cell's vertices in
+   *                      \a connectivity.
+   * \param [in] types  The type of each cell.
+   * \param [in] ncells  The number of cells.
+   * \tparam T  The type of the ids.
+   * \return 0 for success, 1 otherwise.
+   ****************************************************************************/
+  template< typename T >
+  auto write_elements(
+    const T * connectivity, const T * offsets, const cell_type_t * types,
+    std::size_t ncells )
+  {
+    num_cells_ = ncells;
+    auto size = ncells ? offsets[ncells-1] : 0;
+    add_array( cells_, "connectivity", connectivity, size, 1 );
+    add_array( cells_, "offsets", offsets, ncells, 1 );
+    add_array( cells_, "types",
+      reinterpret_cast<const std::uint8_t*>(types), ncells, 1 );
+    return !file_.good();
+  }
+
+  /*! *************************************************************************
+   * \brief Write the faces of polyhedral cells.
+   *
+   * For each cell, the face stream lists the number of faces, and then the
+   * number of vertices and vertex ids of each face.
+   *
+   * \param [in] faces  The face stream of every cell, one after the other.
+   * \param [in] offsets  The end of each cell's face stream in \a faces.
+   * \tparam T  The type of the ids.
+   * \return 0 for success, 1 otherwise.
+   ****************************************************************************/
+  template< typename T >
+  auto write_faces( const T * faces, const T * offsets )
+  {
+    auto size = num_cells_ ? offsets[num_cells_-1] : 0;
+    add_array( cells_, "faces", faces, size, 1 );
+    add_array( cells_, "faceoffsets", offsets, num_cells_, 1 );
+    return !file_.good();
+  }
+
+  /*! *************************************************************************
+   * \brief Write a field defined at points.
+   * \param [in] name  The name of the field.
+   * \param [in] data  The values, \a ncomps per point.
+   * \param [in] ncomps  The number of components.
+   * \tparam T  The type of data.
+   * \return 0 for success, 1 otherwise.
+   ****************************************************************************/
+  template< typename T >
+  auto write_point_field(
+    const char * name, const T * data, std::size_t ncomps = 1 )
+  {
+    add_field( point_data_, name, data, num_points_*ncomps, ncomps );
+    return !file_.good();
+  }
+
+  /*! *************************************************************************
+   * \brief Write a field defined at cells.
+   * \param [in] name  The name of the field.
+   * \param [in] data  The values, \a ncomps per cell.
+   * \param [in] ncomps  The number of components.
+   * \tparam T  The type of data.
+   * \return 0 for success, 1 otherwise.
+   ****************************************************************************/
+  template< typename T >
+  auto write_cell_field(
+    const char * name, const T * data, std::size_t ncomps = 1 )
+  {
+    add_field( cell_data_, name, data, num_cells_*ncomps, ncomps );
+    return !file_.good();
+  }
+
+  /*! *************************************************************************
+   * \brief Write a parallel vtu file, i.e. a pvtu file, that combines
+   *        several pieces.
+   *
+   * The pieces are assumed to have the same arrays as the last file this
+   * writer wrote.
+   *
+   * \param [in] filename The name of the file to write.
+   * \param [in] pieces  The file names of the pieces, relative to the
+   *                     directory of \a filename.
+   * \return 0 for success, 1 otherwise.
+   ****************************************************************************/
+  auto write_parallel(
+    const char * filename, const std::vector<std::string> & pieces ) const
+  {
+    std::ofstream file( filename );
+
+    auto write_schema = [&]( const char * section, const auto & arrays ) {
+      file << "    <P" << section << ">" << std::endl;
+      for ( const auto & a : arrays ) {
+        file << "      <PDataArray type=\"" << a.type << "\"";
+        if ( !a.name.empty() ) file << " Name=\"" << a.name << "\"";
+        file << " NumberOfComponents=\"" << a.num_comps << "\"/>" << std::endl;
+      }
+      file << "    </P" << section << ">" << std::endl;
+    };
+
+    file << "<?xml version=\"1.0\"?>" << std::endl;
+    file << "<VTKFile type=\"PUnstructuredGrid\"";
+    write_file_attributes( file, false );
+    file << ">" << std::endl;
+    file << "  <PUnstructuredGrid GhostLevel=\"0\">" << std::endl;
+    write_schema( "PointData", point_data_ );
+    write_schema( "CellData", cell_data_ );
+    write_schema( "Points", points_ );
+    for ( const auto & p : pieces )
+      file << "    <Piece Source=\"" << p << "\"/>" << std::endl;
+    file << "  </PUnstructuredGrid>" << std::endl;
+    file << "</VTKFile>" << std::endl;
+
+    return !file.good();
+  }
+
+  /*! *************************************************************************
+   * \brief Write a multiblock file, i.e. a vtm file, that groups several
+   *        vtu files.
+   *
+   * \param [in] filename The name of the file to write.
+   * \param [in] blocks  The file names of the blocks, relative to the
+   *                     directory of \a filename.
+   * \return 0 for success, 1 otherwise.
+   ****************************************************************************/
+  static auto write_multiblock(
+    const char * filename, const std::vector<std::string> & blocks )
+  {
+    std::ofstream file( filename );
+
+    file << "<?xml version=\"1.0\"?>" << std::endl;
+    file << "<VTKFile type=\"vtkMultiBlockDataSet\" version=\"1.0\""
+         << " byte_order=\"" << byte_order() << "\">" << std::endl;
+    file << "  <vtkMultiBlockDataSet>" << std::endl;
+    for ( std::size_t i=0; i<blocks.size(); i++ )
+      file << "    <DataSet index=\"" << i << "\" file=\"" << blocks[i]
+           << "\"/>" << std::endl;
+    file << "  </vtkMultiBlockDataSet>" << std::endl;
+    file << "</VTKFile>" << std::endl;
+
+    return !file.good();
+  }
+
+private :
+
+  //! \brief The header type preceding each array.
+  using header_t = std::uint64_t;
+
+  //! \brief Describes one array in the appended data.
+  struct array_t {
+    //! the array name
+    std::string name;
+    //! the vtk type name
+    std::string type;
+    //! the number of components
+    std::size_t num_comps;
+    //! where the data starts in the appended section
+    std::size_t offset;
+    //! true if the data is a lossy stream
+    bool lossy = false;
+  };
+
+  /*! *************************************************************************
+   * \brief The byte order name.
+   ****************************************************************************/
+  static const char * byte_order()
+  { return isBigEndian() ? "BigEndian" : "LittleEndian"; }
+
+  /*! *************************************************************************
+   * \brief Write the attributes of the VTKFile element.
+   ****************************************************************************/
+  void write_file_attributes( std::ostream & file, bool with_compressor ) const
+  {
+    file << " version=\"1.0\" byte_order=\"" << byte_order() << "\""
+         << " header_type=\"UInt64\"";
+    if ( !with_compressor ) return;
+    if ( compression_ == compression_t::zlib )
+      file << " compressor=\"vtkZLibDataCompressor\"";
+    else if ( compression_ == compression_t::lz4 )
+      file << " compressor=\"vtkLZ4DataCompressor\"";
+  }
+
+  /*! *************************************************************************
+   * \brief Write the headers of a group of arrays.
+   ****************************************************************************/
+  void write_section(
+    const char * section, const std::vector<array_t> & arrays )
+  {
+    file_ << "      <" << section << ">" << std::endl;
+    for ( const auto & a : arrays ) {
+      file_ << "        <DataArray type=\"" << a.type << "\"";
+      if ( !a.name.empty() ) file_ << " Name=\"" << a.name << "\"";
+      file_ << " NumberOfComponents=\"" << a.num_comps << "\"";
+      if ( a.lossy ) file_ << " compressor=\"" << lossy_compressor << "\"";
+      file_ << " format=\"appended\" offset=\"" << a.offset << "\"/>"
+            << std::endl;
+    }
+    file_ << "      </" << section << ">" << std::endl;
+  }
+
+  /*! *************************************************************************
+   * \brief Append an array to the appended data.
+   ****************************************************************************/
+  template< typename T >
+  void add_array(
+    std::vector<array_t> & arrays, std::string name, const T * data,
+    std::size_t size, std::size_t num_comps )
+  {
+    // the points array is the only one without a name
+    if ( &arrays == &points_ ) name.clear();
+    arrays.emplace_back(
+      array_t{ std::move(name), type_map.at( typeid(T) ), num_comps,
+        appended_size_ }
+    );
+    encode( reinterpret_cast<const char*>(data), size*sizeof(T) );
+  }
+
+  /*! *************************************************************************
+   * \brief Append a field to the appended data, lossily if asked to.
+   ****************************************************************************/
+  template< typename T >
+  void add_field(
+    std::vector<array_t> & arrays, std::string name, const T * data,
+    std::size_t size, std::size_t num_comps )
+  {
+    add_field( arrays, std::move(name), data, size, num_comps,
+      std::is_floating_point<T>{} );
+  }
+
+  /*! *************************************************************************
+   * \brief Append a field that is not real, which is always stored exactly.
+   ****************************************************************************/
+  template< typename T >
+  void add_field(
+    std::vector<array_t> & arrays, std::string name, const T * data,
+    std::size_t size, std::size_t num_comps, std::false_type )
+  {
+    add_array( arrays, std::move(name), data, size, num_comps );
+  }
+
+  /*! *************************************************************************
+   * \brief Append a real field, lossily if asked to.
+   ****************************************************************************/
+  template< typename T >
+  void add_field(
+    std::vector<array_t> & arrays, std::string name, const T * data,
+    std::size_t size, std::size_t num_comps, std::true_type )
+  {
+    if ( !use_lossy_ ) {
+      add_array( arrays, std::move(name), data, size, num_comps );
+      return;
+    }
+
+    auto start = lossy_stats_t::clock_t::now();
+    auto stream = lossy_.compress( data, size, num_comps );
+    std::chrono::duration<double> elapsed =
+      lossy_stats_t::clock_t::now() - start;
+    lossy_stats_t::instance().record(
+      name, size*sizeof(T), stream.size(), elapsed.count() );
+
+    arrays.emplace_back(
+      array_t{ std::move(name), type_map.at( typeid(T) ), num_comps,
+        appended_size_, true }
+    );
+    header_t header = stream.size();
+    append( &header, sizeof(header_t) );
+    append( stream.data(), stream.size() );
+  }
+
+  /*! *************************************************************************
+   * \brief Append raw bytes to the spooled data.
+   ****************************************************************************/
+  void append( const void * data, std::size_t bytes )
+  {
+    spool_.write( static_cast<const char*>( data ), bytes );
+    appended_size_ += bytes;
+  }
+
+  /*! *************************************************************************
+   * \brief Compress one block.
+   *
+   * This runs inside parallel loops, so it reports failures instead of
+   * raising them.
+   *
+   * \return True on success.
+   ****************************************************************************/
+  bool compress_block(
+    const char * data, std::size_t bytes, std::vector<char> & out ) const
+  {
+#ifdef HAVE_ZLIB
+    if ( compression_ == compression_t::zlib ) {
+      auto out_bytes = compressBound( bytes );
+      out.resize( out_bytes );
+      auto ierr = compress2(
+        reinterpret_cast<Bytef*>( out.data() ), &out_bytes,
+        reinterpret_cast<const Bytef*>( data ), bytes, Z_BEST_SPEED );
+      out.resize( out_bytes );
+      return ierr == Z_OK;
+    }
+#endif
+#ifdef HAVE_LZ4
+    if ( compression_ == compression_t::lz4 ) {
+      out.resize( LZ4_compressBound( bytes ) );
+      auto out_bytes = LZ4_compress_default(
+        data, out.data(), bytes, out.size() );
+      out.resize( std::max( out_bytes, 0 ) );
+      return out_bytes > 0;
+    }
+#endif
+#if !defined(HAVE_ZLIB) && !defined(HAVE_LZ4)
+    // open() only allows compression that was built in
+    (void)data; (void)bytes; (void)out;
+#endif
+    return false;
+  }
+
+  /*! *************************************************************************
+   * \brief Encode an array and add it to the appended data.
+   *
+   * Uncompressed arrays are preceded by their size.  Compressed arrays are
+   * split into blocks, preceded by the number of blocks, the block size,
+   * the size of the last block if it is partial, and the compressed size of
+   * each block.
+   ****************************************************************************/
+  void encode( const char * data, std::size_t bytes )
+  {
+    if ( compression_ == compression_t::none ) {
+      header_t header = bytes;
+      append( &header, sizeof(header_t) );
+      append( data, bytes );
+      return;
+    }
+
+    // the compressed sizes are only known once the blocks are done, so 
+    // the header is filled in afterwards
+    auto num_blocks = ( bytes + block_size - 1 ) / block_size;
+    std::vector<header_t> header( 3 + num_blocks );
+    header[0] = num_blocks;
+    header[1] = block_size;
+    header[2] = bytes % block_size;
+
+    auto header_pos = spool_.tellp();
+    append( header.data(), header.size()*sizeof(header_t) );
+
+    // compress a batch of blocks at a time, each one on its own, and spool 
+    // them before moving on
+    std::vector< std::vector<char> > blocks( 
+      std::min( num_blocks, blocks_per_batch ) );
+
+    for ( std::size_t first=0; first<num_blocks; first+=blocks.size() ) {
+
+      auto num = std::min( blocks.size(), num_blocks - first );
+      int failed = 0;
+
+      #pragma omp parallel for
+      for ( std::size_t i=0; i<num; i++ ) {
+        auto start = ( first + i ) * block_size;
+        auto len = std::min( block_size, bytes - start );
+        if ( !compress_block( data + start, len, blocks[i] ) ) {
+          #pragma omp atomic write
+          failed = 1;
+        }
+      }
+
+      if ( failed ) raise_runtime_error( "Compressing an array failed" );
+
+      for ( std::size_t i=0; i<num; i++ ) {
+        header[ 3 + first + i ] = blocks[i].size();
+        append( blocks[i].data(), blocks[i].size() );
+      }
+
+    }
+
+    // now the header can be filled in
+    spool_.seekp( header_pos );
+    spool_.write( 
+      reinterpret_cast<const char*>( header.data() ), 
+      header.size()*sizeof(header_t) );
+    spool_.seekp( 0, std::ios_base::end );
+  }
+
+  //! \brief The number of blocks compressed at once.
+  static constexpr std::size_t blocks_per_batch = 16;
+
+  //! \brief file pointer
+  std::ofstream file_;
+  std::string file_name_;
+
+  //! \brief the scratch file holding the appended data until close()
+  std::fstream spool_;
+  std::string spool_name_;
+
+  //! \brief the compression method
+  compression_t compression_ = compression_t::none;
+
+  //! \brief the lossy codec for real fields, if it is used
+  lossy_codec lossy_;
+  bool use_lossy_ = false;
+
+  //! \brief the number of points and cells
+  std::size_t num_points_ = 0;
+  std::size_t num_cells_ = 0;
+
+  //! \brief the arrays, by section
+  std::vector<array_t> points_;
+  std::vector<array_t> cells_;
+  std::vector<array_t> point_data_;
+  std::vector<array_t> cell_data_;
+
+  //! \brief the number of bytes of appended data so far
+  std::size_t appended_size_ = 0;
+
+  //! \brief the size of the last file written
+  std::size_t num_bytes_ = 0;
+
+};
+
+
+} // namespace
+} // namespace
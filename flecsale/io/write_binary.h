@@ -13,8 +13,13 @@
 #pragma once
 
 // system includes
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <fstream>
+#include <memory>
+#include <type_traits>
 
 namespace flecsale {
 namespace io {
@@ -84,7 +89,7 @@ template<>
 inline void WriteBinarySwap(std::ofstream &file, int64 buffer) 
 { 
   union temp {
-    float64  value;
+    int64    value;
     char     c[8];
   } in, out;
 
@@ -146,6 +151,100 @@ inline void WriteBinarySwap(std::ofstream &file, float64 buffer)
 ///@}
 
 
+namespace detail {
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The unsigned integer type used to swap values of a given size.
+////////////////////////////////////////////////////////////////////////////////
+///@{
+template< std::size_t N > struct swap_word_t {};
+template<> struct swap_word_t<1> { using type = std::uint8_t; };
+template<> struct swap_word_t<2> { using type = std::uint16_t; };
+template<> struct swap_word_t<4> { using type = std::uint32_t; };
+template<> struct swap_word_t<8> { using type = std::uint64_t; };
+///@}
+
+/// \brief Reverse the bytes of an unsigned integer.
+///@{
+inline std::uint8_t bswap( std::uint8_t x ) { return x; }
+inline std::uint16_t bswap( std::uint16_t x ) { return __builtin_bswap16(x); }
+inline std::uint32_t bswap( std::uint32_t x ) { return __builtin_bswap32(x); }
+inline std::uint64_t bswap( std::uint64_t x ) { return __builtin_bswap64(x); }
+///@}
+
+} // namespace detail
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The number of bytes swapped and written at a time by the array 
+///        writers.
+////////////////////////////////////////////////////////////////////////////////
+constexpr std::size_t write_block_size = 1 << 20;
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Write an array in binary to a stream, as is.
+/// \param [in,out] file  The file stream.
+/// \param [in]  data  The values to write.
+/// \param [in]  n  The number of values.
+/// \tparam T  The type of the values.
+////////////////////////////////////////////////////////////////////////////////
+template <class T> 
+inline void WriteBinaryArray(std::ostream &file, const T * data, std::size_t n) 
+{
+  file.write(reinterpret_cast<const char*>(data), n*sizeof(T));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Write an array in binary to a stream, swapping endienness.
+///
+/// The values are swapped a block at a time into an aligned buffer, which is
+/// then written in one go.  The swap loop is simple enough for the compiler
+/// to turn into vector byte shuffles.
+///
+/// \param [in,out] file  The file stream.
+/// \param [in]  data  The values to write.
+/// \param [in]  n  The number of values.
+/// \tparam T  The type of the values.
+////////////////////////////////////////////////////////////////////////////////
+template <class T> 
+inline void WriteBinarySwapArray(std::ostream &file, const T * data, std::size_t n) 
+{
+  static_assert( std::is_trivially_copyable<T>::value, 
+    "Only trivially copyable types can be written" );
+  using word_t = typename detail::swap_word_t< sizeof(T) >::type;
+
+  constexpr auto block = std::max<std::size_t>( write_block_size / sizeof(T), 1 );
+  std::unique_ptr<word_t[]> buffer( new word_t[ std::min(n, block) ] );
+
+  for ( std::size_t start=0; start<n; start+=block ) {
+    auto len = std::min( block, n - start );
+    auto src = reinterpret_cast<const char*>( data + start );
+    for ( std::size_t i=0; i<len; i++ ) {
+      word_t w;
+      std::memcpy( &w, src + i*sizeof(T), sizeof(T) );
+      buffer[i] = detail::bswap( w );
+    }
+    file.write( reinterpret_cast<const char*>(buffer.get()), len*sizeof(T) );
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Write an array in big endian binary to a stream.
+///
+/// On big endian machines, the data is written straight from \a data without
+/// any copies.
+///
+/// \param [in,out] file  The file stream.
+/// \param [in]  data  The values to write.
+/// \param [in]  n  The number of values.
+/// \tparam T  The type of the values.
+////////////////////////////////////////////////////////////////////////////////
+template <class T> 
+inline void WriteBigEndianArray(std::ostream &file, const T * data, std::size_t n) 
+{
+  if ( isBigEndian() ) WriteBinaryArray( file, data, n );
+  else                 WriteBinarySwapArray( file, data, n );
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// \brief Write string data in binary to a stream.
 /// \param [in,out] file  The file stream.
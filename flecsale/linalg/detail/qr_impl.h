@@ -11,6 +11,14 @@
 ////////////////////////////////////////////////////////////////////////////////
 #pragma once
 
+// system includes
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <vector>
+
 namespace flecsale {
 namespace linalg {
 namespace detail {
@@ -288,6 +296,183 @@ void back_solve( const MatrixViewType<T, MatArgs...> & A,
 }
 
 
+///////////////////////////////////////////////////////////////////
+/// \brief Perform one unrolled Householder step of a fixed-size QR
+///        factorization.
+///
+/// The column with the largest remaining norm is pivoted into 
+/// position `I`, and the reflector that zeros it below the diagonal
+/// is applied to the remaining columns and the right hand side.  
+/// All loop bounds are known at compile time, so the compiler is free 
+/// to fully unroll them.  Storage is row-major.
+///
+/// \param [in,out] A  The system matrix.
+/// \param [in,out] B  The right hand side vector.
+/// \param [in,out] p  The column pivots.
+///
+/// \tparam I  The step (and starting row) of the factorization.
+/// \tparam Rows,Cols  The dimensions of the system matrix.
+/// \tparam T  The value type.
+/// \tparam J  The index type.
+///////////////////////////////////////////////////////////////////
+template< 
+  std::size_t I, std::size_t Rows, std::size_t Cols, 
+  typename T, typename J
+>
+void householder_step( T * A, T * B, J * p )
+{
+
+  // the number of rows this reflector touches
+  constexpr auto nn = Rows - I;
+
+  //---------------------------------------------------------------
+  // column pivoting
+
+  auto max_loc = I;
+  auto max = static_cast<T>(0);
+
+  for ( std::size_t j = I; j < Cols; j++ ) {
+    auto norm = static_cast<T>(0);
+    for ( std::size_t i = I; i < Rows; i++ ) {
+      const auto & a = A[ i*Cols + p[j] ];
+      norm += a*a;
+    }
+    if ( norm > max ) {
+      max = norm;
+      max_loc = j;
+    }
+  }
+
+  std::swap( p[I], p[max_loc] );
+
+  //---------------------------------------------------------------
+  // build the reflector
+
+  const auto col = p[I];
+
+  auto norm = static_cast<T>(0);
+  for ( std::size_t i = I; i < Rows; i++ ) 
+    norm += A[ i*Cols + col ] * A[ i*Cols + col ];
+
+  // nothing left to eliminate in this column
+  if ( norm == 0 ) return;
+
+  T v[nn];
+  
+  v[0] = A[ I*Cols + col ] - std::sqrt(norm);
+  for ( std::size_t i = 1; i < nn; i++ ) 
+    v[i] = A[ (i+I)*Cols + col ];
+
+  norm = 0;
+  for ( std::size_t i = 0; i < nn; i++ ) 
+    norm += v[i]*v[i];
+
+  // the reflector is the identity
+  if ( norm == 0 ) return;
+
+  auto inv_norm = 1 / std::sqrt(norm);
+  for ( std::size_t i = 0; i < nn; i++ ) 
+    v[i] *= inv_norm;
+
+  //---------------------------------------------------------------
+  // apply the reflector, (I - 2 v v^T), as a rank-one update 
+
+  // Columns that have already been processed are zero below row I,
+  // so only the remaining ones need to be updated.
+  for ( std::size_t k = I; k < Cols; k++ ) {
+    const auto pk = p[k];
+    auto sum = static_cast<T>(0);
+    for ( std::size_t i = 0; i < nn; i++ ) 
+      sum += v[i] * A[ (i+I)*Cols + pk ];
+    sum *= 2;
+    for ( std::size_t i = 0; i < nn; i++ ) 
+      A[ (i+I)*Cols + pk ] -= sum * v[i];
+  }
+
+  auto sum = static_cast<T>(0);
+  for ( std::size_t i = 0; i < nn; i++ ) 
+    sum += v[i] * B[ i+I ];
+  sum *= 2;
+  for ( std::size_t i = 0; i < nn; i++ ) 
+    B[ i+I ] -= sum * v[i];
+
+}
+
+///////////////////////////////////////////////////////////////////
+/// \brief Expand all the Householder steps of a fixed-size QR 
+///        factorization.
+///
+/// \param [in,out] A  The system matrix.
+/// \param [in,out] B  The right hand side vector.
+/// \param [in,out] p  The column pivots.
+///
+/// \tparam Rows,Cols  The dimensions of the system matrix.
+/// \tparam T  The value type.
+/// \tparam J  The index type.
+/// \tparam Is  The sequence of steps.
+///////////////////////////////////////////////////////////////////
+template< 
+  std::size_t Rows, std::size_t Cols, 
+  typename T, typename J, std::size_t... Is
+>
+void householder_steps( T * A, T * B, J * p, std::index_sequence<Is...> )
+{
+  int unused[] = { 0, ( householder_step<Is, Rows, Cols>( A, B, p ), 0 )... };
+  (void)unused;
+}
+
+///////////////////////////////////////////////////////////////////
+/// \brief Apply back substitution to get the solution of a 
+///        fixed-size system.
+///
+/// \param [in] A  The factored system matrix.
+/// \param [in,out] B  On entry, the transformed right hand side.  
+///                    On exit, the first `Cols` entries contain the
+///                    solution vector.
+/// \param [in] p  The column pivots.
+///
+/// \tparam Rows,Cols  The dimensions of the system matrix.
+/// \tparam T  The value type.
+/// \tparam J  The index type.
+///////////////////////////////////////////////////////////////////
+template< std::size_t Rows, std::size_t Cols, typename T, typename J >
+void back_solve( const T * A, T * B, const J * p )
+{
+
+  // get epsilon
+  constexpr auto eps = std::numeric_limits<T>::epsilon();
+
+  // Find the first non-zero row from the bottom and start solving from here.
+  std::size_t bottom = 0;
+  for ( std::size_t i = Rows; i-- > 0; ) {
+    if ( std::abs( A[ i*Cols + p[Cols-1] ] ) > eps ) {
+      bottom = i;
+      break;
+    }
+  }
+    
+  bottom = std::min( bottom, Cols-1 );
+
+  // unresolved unknowns are set to zero
+  T x[Cols];
+  for ( std::size_t i = 0; i < Cols; i++ ) x[i] = 0;
+
+  // Standard back solving routine starting at the first non-zero diagonal.
+  for ( std::size_t i = bottom+1; i-- > 0; ) {
+        
+    auto sum = static_cast<T>(0);
+    for ( std::size_t j = Cols; j-- > i+1; ) 
+      sum += x[ p[j] ] * A[ i*Cols + p[j] ];
+      
+    const auto & diag = A[ i*Cols + p[i] ];
+    if ( std::abs(diag) > eps )
+      x[ p[i] ] = (B[i] - sum) / diag;
+  }
+
+  for ( std::size_t i = 0; i < Cols; i++ ) B[i] = x[i];
+
+}
+
 } // namespace
 } // namespace
 } // namespace
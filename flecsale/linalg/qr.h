@@ -16,6 +16,13 @@
 
 #include "types.h"
 
+#include "flecsale/math/matrix.h"
+#include "flecsale/utils/errors.h"
+
+// system includes
+#include <numeric>
+#include <vector>
+
 namespace flecsale {
 namespace linalg {
 
@@ -94,6 +101,99 @@ void qr (
 }
 
 
+///////////////////////////////////////////////////////////////////
+/// \brief Computes the solution to a small, fixed-size, real linear 
+/// least squares problem using a QR-based routine.
+///
+/// Solves for `x` in `A x = B`.  This version works directly on 
+/// contiguous, row-major storage, performs no heap allocations, and
+/// fully expands the Householder steps at compile time.  It is meant
+/// for the many tiny systems that get solved inside mesh loops; use
+/// the view-based version for large systems.
+///
+/// \param [in,out] A  The `Rows x Cols` system matrix.  On exit, it 
+///                    is overwritten by the factorization.
+/// \param [in,out] B  On entry, the right hand side vector of length
+///                    `Rows`.  On exit, the first `Cols` entries 
+///                    contain the solution vector.
+///
+/// \tparam Rows,Cols  The dimensions of the system matrix.
+/// \tparam T  The value type.
+///////////////////////////////////////////////////////////////////
+template< std::size_t Rows, std::size_t Cols, typename T >
+void qr( T * A, T * B )
+{
+
+  static_assert( Cols > 0, "System matrix must have at least one column" );
+  static_assert( Rows >= Cols, "System must not be under-determined" );
+
+  // Initial permutation vector.
+  std::size_t jpvt[Cols];
+  std::iota( jpvt, jpvt+Cols, static_cast<std::size_t>(0) );
+  
+  // Apply rotators to make R and Q'*b 
+  detail::householder_steps<Rows, Cols>( 
+    A, B, jpvt, std::make_index_sequence<Cols>() 
+  );
+
+  // Back solve Rx = Q'*b 
+  detail::back_solve<Rows, Cols>( A, B, jpvt );
+}
+
+///////////////////////////////////////////////////////////////////
+/// \brief Computes the solution to a small, fixed-size, real linear 
+/// least squares problem using a QR-based routine.
+///
+/// \param [in,out] A  The system matrix.  On exit, it is 
+///                    overwritten by the factorization.
+/// \param [in,out] B  On entry, the right hand side vector.  On 
+///                    exit, the first `Cols` entries contain the
+///                    solution vector.
+///
+/// \tparam T  The value type.
+/// \tparam Rows,Cols  The dimensions of the system matrix.
+/// \tparam C  The vector type.
+///////////////////////////////////////////////////////////////////
+template< 
+  typename T, std::size_t Rows, std::size_t Cols,
+  template<typename, std::size_t> class C
+>
+void qr( math::matrix<T, Rows, Cols> & A, C<T, Rows> & B )
+{
+  qr<Rows, Cols>( A.data(), B.data() );
+}
+
+
+///////////////////////////////////////////////////////////////////
+/// \brief Solve many independent, fixed-size, real linear least
+/// squares problems using a QR-based routine.
+///
+/// The systems are laid out contiguously, i.e. system `i` uses
+/// `A[i*Rows*Cols, (i+1)*Rows*Cols)` stored row-major, and 
+/// `B[i*Rows, (i+1)*Rows)`.
+///
+/// \param [in,out] A  The system matrices.
+/// \param [in,out] B  On entry, the right hand side vectors.  On 
+///                    exit, the first `Cols` entries of each one
+///                    contain the solution vector.
+/// \param [in] num_systems  The number of systems to solve.
+///
+/// \tparam Rows,Cols  The dimensions of each system matrix.
+/// \tparam T  The value type.
+/// \tparam U  The counter type.
+///////////////////////////////////////////////////////////////////
+template< std::size_t Rows, std::size_t Cols, typename T, typename U >
+void qr_batched( T * A, T * B, U num_systems )
+{
+  constexpr auto a_stride = Rows * Cols;
+  constexpr auto b_stride = Rows;
+
+  #pragma omp parallel for
+  for ( U i = 0; i < num_systems; i++ )
+    qr<Rows, Cols>( A + i*a_stride, B + i*b_stride );
+}
+
+
 } // namespace
 } // namespace
 
@@ -0,0 +1,131 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+///////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Tests related to the qr solvers.
+///////////////////////////////////////////////////////////////////////////////
+
+// user includes
+#include "flecsale/common/types.h"
+#include "flecsale/linalg/qr.h"
+#include "flecsale/math/matrix.h"
+#include "flecsale/math/vector.h"
+
+// system includes
+#include <cinchtest.h>
+#include <iostream>
+#include <vector>
+
+// explicitly use some stuff
+using namespace flecsale;
+
+using real_t = common::real_t;
+
+//! \brief the constrained system used for testing
+//!
+//! This has the same saddle-point structure as the nodal solver systems
+//! with symmetry constraints.
+const real_t constrained_system[5*5] = {
+  4.0, 1.0, 0.5, 1.0, 0.0,
+  1.0, 3.0, 0.2, 0.0, 1.0,
+  0.5, 0.2, 2.0, 0.0, 0.0,
+  1.0, 0.0, 0.0, 0.0, 0.0,
+  0.0, 1.0, 0.0, 0.0, 0.0
+};
+
+//! \brief the exact solution to the system
+const real_t constrained_solution[5] = { 0.0, 0.0, 1.5, -0.75, -0.3 };
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Test the fixed-size solver against the runtime one.
+///////////////////////////////////////////////////////////////////////////////
+TEST(qr, fixed) {
+
+  // build the right hand side from the exact solution
+  real_t rhs[5] = {0};
+  for ( int i=0; i<5; i++ )
+    for ( int j=0; j<5; j++ )
+      rhs[i] += constrained_system[i*5+j] * constrained_solution[j];
+
+  // the runtime version
+  std::vector<real_t> A( constrained_system, constrained_system+25 );
+  std::vector<real_t> b( rhs, rhs+5 );
+  auto A_view = utils::make_array_view( A, 5, 5 );
+  auto b_view = utils::make_array_view( b );
+  linalg::qr( A_view, b_view );
+
+  // the raw storage version
+  real_t A_raw[25], b_raw[5];
+  std::copy( constrained_system, constrained_system+25, A_raw );
+  std::copy( rhs, rhs+5, b_raw );
+  linalg::qr<5,5>( A_raw, b_raw );
+
+  // the matrix version
+  math::matrix<real_t,5,5> A_mat;
+  math::vector<real_t,5> b_vec;
+  std::copy( constrained_system, constrained_system+25, A_mat.begin() );
+  std::copy( rhs, rhs+5, b_vec.begin() );
+  linalg::qr( A_mat, b_vec );
+
+  for ( int i=0; i<5; i++ ) {
+    ASSERT_NEAR( b[i], constrained_solution[i], common::test_tolerance );
+    ASSERT_NEAR( b_raw[i], constrained_solution[i], common::test_tolerance );
+    ASSERT_EQ( b_vec[i], b_raw[i] );
+  }
+
+} // TEST
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Test the fixed-size solver on an over-determined system.
+///////////////////////////////////////////////////////////////////////////////
+TEST(qr, least_squares) {
+
+  // fit a line through points that lie on it exactly
+  real_t A[4*2] = { 
+    1.0, 0.0, 
+    1.0, 1.0, 
+    1.0, 2.0, 
+    1.0, 3.0 
+  };
+  real_t b[4] = { 1.0, 3.0, 5.0, 7.0 };
+
+  linalg::qr<4,2>( A, b );
+
+  ASSERT_NEAR( b[0], 1.0, common::test_tolerance );
+  ASSERT_NEAR( b[1], 2.0, common::test_tolerance );
+
+} // TEST
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Test the batched solver.
+///////////////////////////////////////////////////////////////////////////////
+TEST(qr, batched) {
+
+  constexpr int num_systems = 10;
+
+  std::vector<real_t> A, b;
+  A.reserve( num_systems*25 );
+  b.reserve( num_systems*5 );
+
+  // scale each system and its solution differently
+  for ( int n=0; n<num_systems; n++ ) {
+    real_t fact = n+1;
+    for ( int i=0; i<25; i++ ) A.emplace_back( fact * constrained_system[i] );
+    for ( int i=0; i<5; i++ ) {
+      real_t sum = 0;
+      for ( int j=0; j<5; j++ )
+        sum += constrained_system[i*5+j] * constrained_solution[j];
+      b.emplace_back( fact * fact * sum );
+    }
+  }
+
+  linalg::qr_batched<5,5>( A.data(), b.data(), num_systems );
+
+  for ( int n=0; n<num_systems; n++ ) 
+    for ( int i=0; i<5; i++ ) 
+      ASSERT_NEAR( b[n*5+i], (n+1)*constrained_solution[i], 
+        10*(n+1)*common::test_tolerance );
+
+} // TEST
@@ -0,0 +1,221 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Provides a batched solver for many small symmetric systems.
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// user includes
+#include "flecsale/math/detail/batched_solve_impl.h"
+#include "flecsale/math/matrix.h"
+
+// system includes
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+namespace flecsale {
+namespace math {
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief A batch of small, independent, symmetric linear systems.
+//!
+//! The systems are stored in structure-of-arrays layout, i.e. there is one
+//! contiguous array for each unique matrix entry and each vector component.
+//! This lets the closed-form solve vectorize across systems.  The upper
+//! triangle of each matrix is stored row by row.
+//!
+//! \tparam T  The value type.
+//! \tparam D  The dimension of the systems, either 2 or 3.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T, std::size_t D >
+class symmetric_system_batch {
+
+  static_assert( D==2 || D==3, "Only 2x2 and 3x3 systems are supported" );
+
+public:
+
+  //! \brief The value type.
+  using value_type = T;
+
+  //! \brief The size type.
+  using size_type = std::size_t;
+
+  //! \brief The number of unique entries in each matrix.
+  static constexpr size_type num_entries = D*(D+1)/2;
+
+  //! \brief Default constructor.
+  symmetric_system_batch() = default;
+
+  //! \brief Constructor with a number of systems.
+  //! \param [in] n  The number of systems.
+  explicit symmetric_system_batch( size_type n )
+  { resize(n); }
+
+  //! \brief Change the number of systems.
+  //! \param [in] n  The number of systems.
+  void resize( size_type n )
+  {
+    for ( auto & a : a_ ) a.resize( n );
+    for ( auto & b : b_ ) b.resize( n );
+    for ( auto & x : x_ ) x.resize( n );
+    singular_.resize( n );
+  }
+
+  //! \brief Return the number of systems.
+  size_type size() const
+  { return singular_.size(); }
+
+  //! \brief Return the storage index of entry (i,j).
+  static constexpr size_type entry( size_type i, size_type j )
+  {
+    return i <= j ?
+      i*D - (i*(i-1))/2 + (j-i) :
+      j*D - (j*(j-1))/2 + (i-j);
+  }
+
+  //! \brief Set one system.
+  //! \param [in] n  The system to set.
+  //! \param [in] A  The matrix.  Only the upper triangle is used.
+  //! \param [in] b  The right hand side.
+  template< template<typename, std::size_t> class C >
+  void set( size_type n, const matrix<T,D,D> & A, const C<T,D> & b )
+  {
+    for ( size_type i=0; i<D; i++ ) {
+      for ( size_type j=i; j<D; j++ )
+        a_[ entry(i,j) ][n] = A(i,j);
+      b_[i][n] = b[i];
+    }
+  }
+
+  //! \brief Set one system to the identity with a zero right hand side.
+  //! \param [in] n  The system to set.
+  //! \remark This is useful for lanes that should be skipped.
+  void set_identity( size_type n )
+  {
+    for ( size_type i=0; i<D; i++ ) {
+      for ( size_type j=i; j<D; j++ )
+        a_[ entry(i,j) ][n] = (i==j) ? 1 : 0;
+      b_[i][n] = 0;
+    }
+  }
+
+  //! \brief Get the solution of one system.
+  //! \param [in] n  The system to access.
+  //! \param [out] x  The solution.
+  template< template<typename, std::size_t> class C >
+  void get_solution( size_type n, C<T,D> & x ) const
+  {
+    for ( size_type i=0; i<D; i++ ) x[i] = x_[i][n];
+  }
+
+  //! \brief Return true if the system was flagged as near-singular.
+  //! \param [in] n  The system to access.
+  bool is_singular( size_type n ) const
+  { return singular_[n]; }
+
+  //! \brief Direct access to the arrays.
+  //! @{
+  T * matrix_data( size_type i, size_type j )
+  { return a_[ entry(i,j) ].data(); }
+  T * rhs_data( size_type i )
+  { return b_[i].data(); }
+  const T * solution_data( size_type i ) const
+  { return x_[i].data(); }
+  //! @}
+
+  //! \brief Solve all the systems.
+  //!
+  //! \param [in] tolerance  The relative tolerance used to flag
+  //!   near-singular systems.  Systems whose determinant is smaller than
+  //!   this fraction of the product of the matrix row norms are flagged
+  //!   and get a zero solution.
+  //! \return The number of near-singular systems.
+  size_type solve(
+    T tolerance = 100*std::numeric_limits<T>::epsilon() )
+  {
+    std::array< T*, num_entries > a;
+    std::array< T*, D > b;
+    std::array< T*, D > x;
+    for ( size_type i=0; i<num_entries; i++ ) a[i] = a_[i].data();
+    for ( size_type i=0; i<D; i++ ) {
+      b[i] = b_[i].data();
+      x[i] = x_[i].data();
+    }
+
+    auto n = size();
+    auto flags = singular_.data();
+
+    // split the batch into contiguous blocks so that each thread gets
+    // vectorizable ranges
+    auto num_blocks = ( n + block_size - 1 ) / block_size;
+
+    #pragma omp parallel for
+    for ( size_type blk=0; blk<num_blocks; blk++ ) {
+      auto first = blk * block_size;
+      auto last = std::min( first + block_size, n );
+      detail::symmetric_solver<D>::solve(
+        a.data(), b.data(), x.data(), flags, first, last, tolerance
+      );
+    }
+
+    return std::accumulate( singular_.begin(), singular_.end(), size_type(0) );
+  }
+
+private:
+
+  //! \brief The number of systems handled by each vectorized sweep.
+  static constexpr size_type block_size = 256;
+
+  //! \brief The matrix entries.
+  std::array< std::vector<T>, num_entries > a_;
+  //! \brief The right hand sides.
+  std::array< std::vector<T>, D > b_;
+  //! \brief The solutions.
+  std::array< std::vector<T>, D > x_;
+  //! \brief Near-singular flags.
+  std::vector<unsigned char> singular_;
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Solve many small symmetric systems at once.
+//!
+//! \param [in] A  The system matrices.
+//! \param [in] b  The right hand sides.
+//! \param [out] x  The solutions.
+//! \param [out] singular  Set to true for each near-singular system.
+//! \param [in] n  The number of systems.
+//! \param [in] tolerance  The relative singularity tolerance.
+//! \return The number of near-singular systems.
+//!
+//! \tparam T  The base value type.
+//! \tparam D  The matrix/array dimension.
+////////////////////////////////////////////////////////////////////////////////
+template <
+  typename T, std::size_t D,
+  template<typename, std::size_t> class C
+>
+std::size_t batched_solve(
+  const matrix<T, D, D> * A, const C<T,D> * b, C<T,D> * x,
+  bool * singular, std::size_t n,
+  T tolerance = 100*std::numeric_limits<T>::epsilon() )
+{
+  symmetric_system_batch<T,D> batch(n);
+  for ( std::size_t i=0; i<n; i++ ) batch.set( i, A[i], b[i] );
+  auto num_singular = batch.solve( tolerance );
+  for ( std::size_t i=0; i<n; i++ ) {
+    batch.get_solution( i, x[i] );
+    singular[i] = batch.is_singular(i);
+  }
+  return num_singular;
+}
+
+} // namespace
+} // namespace
@@ -0,0 +1,162 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief The closed-form kernels used by the batched small-matrix solvers.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// system includes
+#include <cmath>
+#include <cstddef>
+
+namespace flecsale {
+namespace math {
+namespace detail {
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Closed-form solvers for symmetric systems stored in SoA layout.
+//!
+//! Each kernel loops over the lanes of the batch without any data dependent
+//! branches, so the loops can be vectorized.  Lanes whose determinant is
+//! small relative to the magnitude of the matrix entries are flagged as
+//! near-singular, and their solution is set to zero.
+//!
+//! \tparam D  The dimension of the systems.
+////////////////////////////////////////////////////////////////////////////////
+template< std::size_t D >
+struct symmetric_solver;
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Specialization for 2x2 systems.
+//!
+//! The entries are ordered (0,0), (0,1), (1,1).
+////////////////////////////////////////////////////////////////////////////////
+template<>
+struct symmetric_solver<2>
+{
+
+  //! \brief Solve each lane of the batch.
+  //! \param [in] a  The unique matrix entries, one array per entry.
+  //! \param [in] b  The right hand sides, one array per component.
+  //! \param [out] x  The solutions, one array per component.
+  //! \param [out] singular  Flags indicating near-singular lanes.
+  //! \param [in] first,last  The range of lanes to solve.
+  //! \param [in] tolerance  The relative singularity tolerance.
+  template< typename T, typename U >
+  static void solve(
+    T * const * a, T * const * b, T * const * x, unsigned char * singular,
+    U first, U last, T tolerance )
+  {
+    const T * a11 = a[0];
+    const T * a12 = a[1];
+    const T * a22 = a[2];
+    const T * b1 = b[0];
+    const T * b2 = b[1];
+    T * x1 = x[0];
+    T * x2 = x[1];
+
+    #pragma omp simd
+    for ( U i = first; i < last; i++ ) {
+      // the determinant, ordered like math::inverse
+      auto denom = a11[i]*a22[i] - a12[i]*a12[i];
+      // a bound on the size of the determinant
+      auto scale =
+        ( std::abs(a11[i]) + std::abs(a12[i]) ) *
+        ( std::abs(a12[i]) + std::abs(a22[i]) );
+      // flag and guard the bad lanes
+      auto bad = !( std::abs(denom) > tolerance * scale );
+      singular[i] = bad;
+      auto safe = bad ? static_cast<T>(1) : denom;
+      auto zero = bad ? static_cast<T>(0) : static_cast<T>(1);
+      // the inverse
+      auto i11 =  a22[i] / safe;
+      auto i12 = -a12[i] / safe;
+      auto i22 =  a11[i] / safe;
+      // the solution
+      x1[i] = zero * ( i11*b1[i] + i12*b2[i] );
+      x2[i] = zero * ( i12*b1[i] + i22*b2[i] );
+    }
+  }
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Specialization for 3x3 systems.
+//!
+//! The entries are ordered (0,0), (0,1), (0,2), (1,1), (1,2), (2,2).
+////////////////////////////////////////////////////////////////////////////////
+template<>
+struct symmetric_solver<3>
+{
+
+  //! \brief Solve each lane of the batch.
+  //! \param [in] a  The unique matrix entries, one array per entry.
+  //! \param [in] b  The right hand sides, one array per component.
+  //! \param [out] x  The solutions, one array per component.
+  //! \param [out] singular  Flags indicating near-singular lanes.
+  //! \param [in] first,last  The range of lanes to solve.
+  //! \param [in] tolerance  The relative singularity tolerance.
+  template< typename T, typename U >
+  static void solve(
+    T * const * a, T * const * b, T * const * x, unsigned char * singular,
+    U first, U last, T tolerance )
+  {
+    const T * a11 = a[0];
+    const T * a12 = a[1];
+    const T * a13 = a[2];
+    const T * a22 = a[3];
+    const T * a23 = a[4];
+    const T * a33 = a[5];
+    const T * b1 = b[0];
+    const T * b2 = b[1];
+    const T * b3 = b[2];
+    T * x1 = x[0];
+    T * x2 = x[1];
+    T * x3 = x[2];
+
+    #pragma omp simd
+    for ( U i = first; i < last; i++ ) {
+      // the cofactors, ordered like math::inverse
+      auto c11 = a22[i]*a33[i] - a23[i]*a23[i];
+      auto c12 = a13[i]*a23[i] - a33[i]*a12[i];
+      auto c13 = a12[i]*a23[i] - a22[i]*a13[i];
+      auto c22 = a11[i]*a33[i] - a13[i]*a13[i];
+      auto c23 = a13[i]*a12[i] - a23[i]*a11[i];
+      auto c33 = a11[i]*a22[i] - a12[i]*a12[i];
+      // the determinant
+      auto denom =
+        a11[i]*a22[i]*a33[i] + a12[i]*a23[i]*a13[i] + a13[i]*a12[i]*a23[i] -
+        a13[i]*a22[i]*a13[i] - a23[i]*a23[i]*a11[i] - a33[i]*a12[i]*a12[i];
+      // a bound on the size of the determinant
+      auto scale =
+        ( std::abs(a11[i]) + std::abs(a12[i]) + std::abs(a13[i]) ) *
+        ( std::abs(a12[i]) + std::abs(a22[i]) + std::abs(a23[i]) ) *
+        ( std::abs(a13[i]) + std::abs(a23[i]) + std::abs(a33[i]) );
+      // flag and guard the bad lanes
+      auto bad = !( std::abs(denom) > tolerance * scale );
+      singular[i] = bad;
+      auto safe = bad ? static_cast<T>(1) : denom;
+      auto zero = bad ? static_cast<T>(0) : static_cast<T>(1);
+      // the inverse
+      auto i11 = c11 / safe;
+      auto i12 = c12 / safe;
+      auto i13 = c13 / safe;
+      auto i22 = c22 / safe;
+      auto i23 = c23 / safe;
+      auto i33 = c33 / safe;
+      // the solution
+      x1[i] = zero * ( i11*b1[i] + i12*b2[i] + i13*b3[i] );
+      x2[i] = zero * ( i12*b1[i] + i22*b2[i] + i23*b3[i] );
+      x3[i] = zero * ( i13*b1[i] + i23*b2[i] + i33*b3[i] );
+    }
+  }
+
+};
+
+} // namespace detail
+} // namespace math
+} // namespace flecsale
@@ -0,0 +1,120 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+///////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Tests related to the batched small-matrix solvers.
+///////////////////////////////////////////////////////////////////////////////
+
+// user includes
+#include "flecsale/common/types.h"
+#include "flecsale/math/batched_solve.h"
+#include "flecsale/math/general.h"
+#include "flecsale/math/matrix.h"
+#include "flecsale/math/vector.h"
+
+// system includes
+#include <cinchtest.h>
+#include <cmath>
+#include <vector>
+
+// explicitly use some stuff
+using namespace flecsale;
+using namespace flecsale::math;
+
+using real_t = common::real_t;
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Build a symmetric, diagonally dominant test matrix.
+///////////////////////////////////////////////////////////////////////////////
+template< std::size_t D >
+matrix<real_t,D,D> make_matrix( std::size_t n )
+{
+  matrix<real_t,D,D> A;
+  for ( std::size_t i=0; i<D; i++ )
+    for ( std::size_t j=i; j<D; j++ ) {
+      A(i,j) = std::sin( static_cast<real_t>( n + 3*i + 5*j ) );
+      A(j,i) = A(i,j);
+    }
+  for ( std::size_t i=0; i<D; i++ )
+    A(i,i) += D + 1;
+  return A;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Compare the batched solver against the general solver.
+///////////////////////////////////////////////////////////////////////////////
+template< std::size_t D >
+void compare_with_solve()
+{
+  constexpr std::size_t num_systems = 1000;
+
+  symmetric_system_batch<real_t,D> batch( num_systems );
+  std::vector< vector<real_t,D> > ans( num_systems );
+
+  for ( std::size_t n=0; n<num_systems; n++ ) {
+    auto A = make_matrix<D>(n);
+    vector<real_t,D> b;
+    for ( std::size_t i=0; i<D; i++ ) b[i] = std::cos( n + i );
+    batch.set( n, A, b );
+    ans[n] = solve( A, b );
+  }
+
+  ASSERT_EQ( 0u, batch.solve() );
+
+  for ( std::size_t n=0; n<num_systems; n++ ) {
+    vector<real_t,D> x;
+    batch.get_solution( n, x );
+    ASSERT_FALSE( batch.is_singular(n) );
+    for ( std::size_t i=0; i<D; i++ )
+      ASSERT_NEAR( ans[n][i], x[i], common::test_tolerance );
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Test the 2x2 and 3x3 solves.
+///////////////////////////////////////////////////////////////////////////////
+TEST(batched_solve, symmetric_2d) {
+  compare_with_solve<2>();
+}
+
+TEST(batched_solve, symmetric_3d) {
+  compare_with_solve<3>();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Test that singular systems get flagged.
+///////////////////////////////////////////////////////////////////////////////
+TEST(batched_solve, singular) {
+
+  using matrix_t = matrix<real_t,3,3>;
+  using vector_t = vector<real_t,3>;
+
+  std::vector<matrix_t> A = {
+    make_matrix<3>(0),
+    matrix_t{ 1.0, 2.0, 3.0,
+              2.0, 4.0, 6.0,
+              3.0, 6.0, 9.0 },
+    matrix_t( 0.0 )
+  };
+  std::vector<vector_t> b( A.size(), vector_t(1.0) );
+  std::vector<vector_t> x( A.size() );
+  bool singular[3];
+
+  auto num_singular =
+    batched_solve( A.data(), b.data(), x.data(), singular, A.size() );
+
+  ASSERT_EQ( 2u, num_singular );
+  ASSERT_FALSE( singular[0] );
+  ASSERT_TRUE( singular[1] );
+  ASSERT_TRUE( singular[2] );
+
+  auto ans = solve( A[0], b[0] );
+  for ( int i=0; i<3; i++ ) {
+    ASSERT_NEAR( ans[i], x[0][i], common::test_tolerance );
+    ASSERT_EQ( 0, x[1][i] );
+    ASSERT_EQ( 0, x[2][i] );
+  }
+
+}
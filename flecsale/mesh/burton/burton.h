@@ -11,6 +11,14 @@
 // user includes
 #include "flecsi/io/io.h"
 #include "flecsale/mesh/burton/burton_mesh.h"
+#include "flecsale/utils/mpi_utils.h"
+#include "flecsale/utils/string_utils.h"
+
+// system includes
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
 
 
 
@@ -74,5 +82,62 @@ using flecsi::io::write_mesh;
 //! \brief bring write/read mesh into the flecsale::mesh namespace
 using flecsi::io::read_mesh;
 
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Write a mesh that may be one part of a distributed mesh.
+//!
+//! Each process writes its own part.  Exodus files follow the Nemesis naming
+//! convention, i.e. name.<num_parts>.<part>, so the whole set can be opened
+//! at once and merged with flecsale_epu.  A pvtu file is written by the 
+//! first process, and lists one vtu file per process, named name_<part>.vtu.
+//! Any other format gets the part number inserted before the extension.
+//!
+//! \param [in] name  The file name.
+//! \param [in] mesh  The mesh to write.
+//! \return the status of the write
+////////////////////////////////////////////////////////////////////////////////
+template< typename M >
+int write_mesh_part( const std::string & name, M & mesh )
+{
+  auto ext = utils::file_extension( name );
+
+  if ( ext == "pvtu" ) {
+    auto rank = mesh.is_distributed() ? utils::comm_rank() : 0;
+    auto num_ranks = mesh.is_distributed() ? utils::comm_size() : 1;
+    auto base = name.substr( 0, name.size() - ext.size() - 1 );
+    auto piece_name = [&]( int r ) 
+    { return base + "_" + std::to_string(r) + ".vtu"; };
+    // the writer remembers the arrays of the piece, which are the same 
+    // everywhere.  The pieces are written the way the pvtu file asks for.
+    const auto & format = mesh.output_profile().get( name );
+    io::vtu_writer writer;
+    auto status = mesh.is_distributed() ?
+      burton::write_vtu( 
+        piece_name(rank), mesh, burton::owned_cells(mesh), format, writer ) :
+      burton::write_vtu( piece_name(rank), mesh, mesh.cells(), format, writer );
+    if ( status || rank != 0 ) return status;
+    std::vector<std::string> pieces;
+    for ( int r=0; r<num_ranks; r++ ) 
+      pieces.emplace_back( utils::basename( piece_name(r) ) );
+    return writer.write_parallel( name.c_str(), pieces );
+  }
+
+  if ( !mesh.is_distributed() ) return write_mesh( name, mesh );
+
+  auto rank = utils::comm_rank();
+  auto num_ranks = utils::comm_size();
+
+  if ( ext == "exo" || ext == "g" ) {
+    auto width = std::to_string( num_ranks-1 ).size();
+    std::stringstream ss;
+    ss << name << "." << num_ranks << "." 
+       << std::setw( width ) << std::setfill( '0' ) << rank;
+    burton::burton_io_exodus_t< M::num_dimensions > io;
+    return io.write( ss.str(), mesh );
+  }
+
+  auto base = name.substr( 0, name.size() - ext.size() );
+  return write_mesh( base + std::to_string(rank) + "." + ext, mesh );
+}
+
 }
 }
@@ -14,7 +14,7 @@
 #include "flecsale/geom/point.h"
 #include "flecsale/geom/shapes/geometric_shapes.h"
 #include "flecsale/math/vector.h"
-#include "flecsale/utils/fixed_vector.h"
+#include "flecsale/utils/bitmask_set.h"
 #include "flecsi/utils/bitfield.h"
 #include "flecsi/data/data.h"
 
@@ -47,6 +47,14 @@ struct burton_config_t {
   //! A type used for loop indexing.
   using counter_t = long long;
 
+  //! \brief The type of the ids local to this process.
+  //! \remark Only the id lists cached by the burton mesh use it.  The
+  //!   adjacency stored by flecsi keeps flecsi's own id type.
+  using local_id_t = common::local_index_t;
+
+  //! The type of the ids that are unique across processes.
+  using global_id_t = common::global_index_t;
+
   //! The type for floating-point values.
   using real_t = common::real_t;
 
@@ -67,7 +75,13 @@ struct burton_config_t {
 
   // the tags type
   using tag_t = uint8_t;
-  using tag_list_t = utils::fixed_vector< tag_t, N*N >;
+
+  //! \brief The number of 64 bit words in each entity's tag set.  This
+  //!   limits the number of boundaries that can be installed.
+  static constexpr std::size_t num_tag_words = 1;
+
+  //! \brief The tags of an entity, one bit per tag.
+  using tag_list_t = utils::bitmask_set< tag_t, num_tag_words >;
 
   //! \brief the shape type
   using shape_t = geom::shapes::geometric_shapes_t;
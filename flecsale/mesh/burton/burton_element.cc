@@ -92,7 +92,7 @@ bool burton_2d_edge_t::is_boundary() const
 void burton_2d_edge_t::tag(const burton_2d_edge_t::tag_t & tag)
 {
   auto flags = flecsi_get_accessor(*mesh_, mesh, face_tags, tag_list_t, dense, 0);
-  flags[mesh_entity_base_t<num_domains>::template id<0>()].push_back( tag );
+  flags[mesh_entity_base_t<num_domains>::template id<0>()].insert( tag );
 }
 
 //! get boundary tags
@@ -102,6 +102,12 @@ const burton_2d_edge_t::tag_list_t & burton_2d_edge_t::tags() const
   return flags[mesh_entity_base_t<num_domains>::template id<0>()];
 }
 
+//! check for a boundary tag
+bool burton_2d_edge_t::has_tag(const burton_2d_edge_t::tag_t & tag) const
+{
+  return tags().count( tag );
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // 3d - edge
 ////////////////////////////////////////////////////////////////////////////////
@@ -147,7 +153,7 @@ bool burton_3d_edge_t::is_boundary() const
 void burton_3d_edge_t::tag(const burton_3d_edge_t::tag_t & tag)
 {
   auto flags = flecsi_get_accessor(*mesh_, mesh, edge_tags, tag_list_t, dense, 0);
-  flags[mesh_entity_base_t<num_domains>::template id<0>()].push_back( tag );
+  flags[mesh_entity_base_t<num_domains>::template id<0>()].insert( tag );
 }
 
 const burton_3d_edge_t::tag_list_t & burton_3d_edge_t::tags() const
@@ -156,6 +162,11 @@ const burton_3d_edge_t::tag_list_t & burton_3d_edge_t::tags() const
   return flags[mesh_entity_base_t<num_domains>::template id<0>()];
 }
 
+bool burton_3d_edge_t::has_tag(const burton_3d_edge_t::tag_t & tag) const
+{
+  return tags().count( tag );
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // 2d - Planar Cell
 ////////////////////////////////////////////////////////////////////////////////
@@ -271,7 +282,7 @@ bool burton_3d_face_t::is_boundary() const
 void burton_3d_face_t::tag(const burton_3d_face_t::tag_t & tag)
 {
   auto flags = flecsi_get_accessor(*mesh_, mesh, face_tags, tag_list_t, dense, 0);
-  flags[mesh_entity_base_t<num_domains>::template id<0>()].push_back( tag );
+  flags[mesh_entity_base_t<num_domains>::template id<0>()].insert( tag );
 }
 
 const burton_3d_face_t::tag_list_t & burton_3d_face_t::tags() const
@@ -280,6 +291,11 @@ const burton_3d_face_t::tag_list_t & burton_3d_face_t::tags() const
   return flags[mesh_entity_base_t<num_domains>::template id<0>()];
 }
 
+bool burton_3d_face_t::has_tag(const burton_3d_face_t::tag_t & tag) const
+{
+  return tags().count( tag );
+}
+
 
 ////////////////////////////////////////////////////////////////////////////////
 // 3d - Cell
@@ -137,7 +137,7 @@ struct burton_element_t<2,1> :
   //! tag entity
   void tag(const tag_t & tag);
   //! does entity have a tag
-  bool has_tag(const tag_t & tag);
+  bool has_tag(const tag_t & tag) const;
 
   //! \brief reset the mesh pointer
   void reset(mesh_topology_base_t & mesh) 
@@ -244,7 +244,7 @@ struct burton_element_t<3,1> :
   //! tag entity
   void tag(const tag_t & tag);
   //! does entity have a tag
-  bool has_tag(const tag_t & tag);
+  bool has_tag(const tag_t & tag) const;
 
   //! \brief reset the mesh pointer
   void reset(mesh_topology_base_t & mesh) 
@@ -555,7 +555,7 @@ struct burton_element_t<3,2>
   //! tag entity
   void tag(const tag_t & tag);
   //! does entity have a tag
-  bool has_tag(const tag_t & tag);
+  bool has_tag(const tag_t & tag) const;
 
   //! the list of actual coordinates
   point_list_t coordinates( bool reverse = false ) const;
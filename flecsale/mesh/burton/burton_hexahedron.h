@@ -11,6 +11,7 @@
 
 // user includes
 #include "flecsale/geom/shapes/hexahedron.h"
+#include "flecsale/mesh/connectivity.h"
 #include "flecsale/mesh/burton/burton_element.h"
 
 
@@ -58,6 +59,37 @@ public:
   shape_t type() const override 
   { return geom::shapes::hexahedron::shape; };
 
+  //----------------------------------------------------------------------------
+  //! \brief The local vertices of the edges (dim=1) and faces (dim=2).
+  //----------------------------------------------------------------------------
+  static const local_entities_t & local_entities( size_t dim )
+  {
+    static const local_entities_t edges = {
+      // bottom
+      {0, 1}, {1, 2}, {2, 3}, {3, 0},
+      // top
+      {4, 5}, {5, 6}, {6, 7}, {7, 4},
+      // vertical ones
+      {0, 4}, {1, 5}, {2, 6}, {3, 7}
+    };
+    static const local_entities_t faces = {
+      {3, 2, 1, 0}, // bottom
+      {5, 6, 7, 4}, // top
+      {1, 5, 4, 0}, // front
+      {2, 6, 5, 1}, // right
+      {3, 7, 6, 2}, // back
+      {0, 4, 7, 3}  // left
+    };
+    switch (dim) {
+    case (1):
+      return edges;
+    case (2):
+      return faces;
+    default:
+      raise_runtime_error("Unknown entity type");
+    }
+  }
+
   //----------------------------------------------------------------------------
   //! \brief create_entities function for burton_hexahedron_cell_t.
   //----------------------------------------------------------------------------
@@ -66,102 +98,10 @@ public:
     const connectivity_t& conn,
     id_t * entities ) override
   {
-
     auto v = conn.get_entity_vec( cell, vertex_t::dimension );
-
     assert( v.size() == 8 );
-    
-    switch (dim) {
-
-      //------------------------------------------------------------------------
-      // Edges
-    case (1): 
-      // bottom
-      entities[0] = v[0];
-      entities[1] = v[1];
-
-      entities[2] = v[1];
-      entities[3] = v[2];
-
-      entities[4] = v[2];
-      entities[5] = v[3];
-
-      entities[6] = v[3];
-      entities[7] = v[0];
-
-      // top
-      entities[8] = v[4];
-      entities[9] = v[5];
-
-      entities[10] = v[5];
-      entities[11] = v[6];
-
-      entities[12] = v[6];
-      entities[13] = v[7];
-
-      entities[14] = v[7];
-      entities[15] = v[4];
-
-      // vertical ones
-      entities[16] = v[0];
-      entities[17] = v[4];
-
-      entities[18] = v[1];
-      entities[19] = v[5];
-
-      entities[20] = v[2];
-      entities[21] = v[6];
-
-      entities[22] = v[3];
-      entities[23] = v[7];
-
-      return {2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2};
-
-      //------------------------------------------------------------------------
-      // Faces
-    case (2): 
-      // bottom
-      entities[0]  = v[3];
-      entities[1]  = v[2];
-      entities[2]  = v[1];
-      entities[3]  = v[0];
-      // top
-      entities[4]  = v[5];
-      entities[5]  = v[6];
-      entities[6]  = v[7];
-      entities[7]  = v[4];
-      // front
-      entities[8]  = v[1];
-      entities[9]  = v[5];
-      entities[10] = v[4];
-      entities[11] = v[0];
-      // right
-      entities[12] = v[2];
-      entities[13] = v[6];
-      entities[14] = v[5];
-      entities[15] = v[1];
-      // back
-      entities[16] = v[3];
-      entities[17] = v[7];
-      entities[18] = v[6];
-      entities[19] = v[2];
-      // left
-      entities[20] = v[0];
-      entities[21] = v[4];
-      entities[22] = v[7];
-      entities[23] = v[3];
-
-      return {4, 4, 4, 4, 4, 4};
-      
-      //------------------------------------------------------------------------
-      // Failure      
-    default: 
-      raise_runtime_error("Unknown entity type");
-
-    } // switch
-
-
-  }
+    return local_entities( dim ).fill( v, entities );
+  } // create_entities
 
   //----------------------------------------------------------------------------
   //! \brief create_bound_entities function for burton_hexahedron_cell_t.
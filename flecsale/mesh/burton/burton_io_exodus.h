@@ -12,6 +12,8 @@
 // user includes
 #include "flecsi/io/io_base.h"
 #include "flecsale/mesh/burton/burton_mesh.h"
+#include "flecsale/mesh/output_profile.h"
+#include "flecsale/utils/mpi_utils.h"
 
 
 #ifdef HAVE_EXODUS
@@ -19,7 +21,12 @@
 #endif
 
 // system includes
+#include <algorithm>
 #include <cstring>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <type_traits>
 
 // Paraview has a problem with regions in nfaced data.  Uncomment the next
 // line, or compile with -dPARAVIEW_EXODUS_3D_REGION_BUGFIX to outout exodus
@@ -61,6 +68,26 @@ public:
   using  ex_real_t  = real_t;
   using  ex_index_t = int;
 
+  //============================================================================
+  //! \brief The entities of one kind that are written to a file.
+  //============================================================================
+  struct file_ids_t {
+    //! the local id of each entity in the file, in file order
+    std::vector<counter_t> local;
+    //! the 1-based file id of each local entity, or 0 if it is not written
+    std::vector<ex_index_t> file;
+
+    //! \brief Start with no entities out of a total of n.
+    explicit file_ids_t( size_t n ) : file( n, 0 ) {}
+
+    //! \brief Append a local entity to the file.
+    void add( counter_t i )
+    {
+      local.emplace_back( i );
+      file[i] = local.size();
+    }
+  };
+
 
 #ifdef HAVE_EXODUS
 
@@ -68,9 +95,14 @@ public:
   //! \brief open the file for reading or writing
   //! \param [in] name  The name of the file to open.
   //! \param [in] mode  The mode to open the file in.
+  //! \param [in] precision  The precision of the real values stored in a 
+  //!                        new file.  Exodus converts them on the way out.
   //! \return The exodus handle for the open file.
   //============================================================================
-  auto open( const std::string &name, std::ios_base::openmode mode ) 
+  auto open( 
+    const std::string &name, 
+    std::ios_base::openmode mode,
+    output_precision_t precision = output_precision_t::float64 ) 
   {
    
 
@@ -100,7 +132,8 @@ public:
     {
       
       // size of floating point to be stored in file.
-      int IO_word_size = sizeof(ex_real_t);
+      int IO_word_size = ( precision == output_precision_t::float32 ) ?
+        sizeof(float) : sizeof(ex_real_t);
 
       // determine the file creation mode
       int cmode = EX_CLOBBER;
@@ -128,23 +161,27 @@ public:
 
   //============================================================================
   //! \brief write the coordinates of the mesh to file.
+  //! \param [in] m  The mesh to write.
+  //! \param [in] nodes  The vertices written to the file.
   //! \return the status of the file
   //============================================================================
-  auto write_point_coords( mesh_t & m ) 
+  auto write_point_coords( mesh_t & m, const file_ids_t & nodes ) 
   { 
     
     // mesh statistics
     constexpr auto num_dims  = mesh_t::num_dimensions;
-    auto num_nodes = m.num_vertices();
+    auto num_nodes = nodes.local.size();
 
     // storage for coordinates
     std::vector<ex_real_t> coord(num_nodes * num_dims);    
 
     // copy the coordinates
-    for (auto v : m.vertices()) {
-      auto & coords = v->coordinates();
+    auto vs = m.vertices();
+    #pragma omp parallel for
+    for ( counter_t j=0; j<num_nodes; j++ ) {
+      auto & coords = vs[ nodes.local[j] ]->coordinates();
       for ( int i=0; i<num_dims; i++ ) 
-        coord[ i*num_nodes + v.id() ] = coords[i];
+        coord[ i*num_nodes + j ] = coords[i];
     } // for
 
     // write the coordinates to the file
@@ -205,21 +242,355 @@ public:
     
 
 
+  //============================================================================
+  //! \brief Collect the cells written to each element block.
+  //!
+  //! There is one block per region.  Only the owned cells of a distributed
+  //! mesh are written, since the ghosts belong to some other file.  The
+  //! blocks of regions that are not selected are left empty, so that block
+  //! ids still match region ids.
+  //!
+  //! \param [in] m  The mesh to write.
+  //! \param [in] format  Selects the regions to write.
+  //! \return The cells in each block.
+  //============================================================================
+  auto output_blocks( mesh_t & m, const output_format_t & format ) 
+  {
+    using cell_list_t = decltype( m.owned_region_cells(0) );
+
+    auto num_regions = m.regions().size();
+    std::vector< cell_list_t > blocks( num_regions );
+    for ( size_t r=0; r<num_regions; r++ )
+      if ( format.writes_region( r ) )
+        blocks[r] = m.owned_region_cells( r );
+
+    return blocks;
+  }
+
+  //============================================================================
+  //! \brief Collect the vertices written to a file.
+  //!
+  //! A serial mesh writes all of its vertices.  A distributed mesh writes its
+  //! owned vertices, followed by the ghosts that the written cells use.  The
+  //! other ghosts belong to cells in some other file only.
+  //!
+  //! \param [in] m  The mesh to write.
+  //! \param [in] blocks  The cells in each element block.
+  //! \return The written vertices.
+  //============================================================================
+  template< typename B >
+  auto output_nodes( mesh_t & m, const B & blocks )
+  {
+    auto num_verts = m.num_vertices();
+    auto num_owned = m.num_owned_vertices();
+
+    file_ids_t nodes( num_verts );
+    for ( counter_t i=0; i<num_owned; i++ ) nodes.add( i );
+    if ( num_owned == num_verts ) return nodes;
+
+    std::vector<bool> used( num_verts, false );
+    for ( const auto & blk : blocks )
+      for ( auto c : blk )
+        for ( auto v : m.vertices(c) ) used[ v.id() ] = true;
+    for ( counter_t i=num_owned; i<num_verts; i++ )
+      if ( used[i] ) nodes.add( i );
+
+    return nodes;
+  }
+
+  //============================================================================
+  //! \brief Collect the faces of the written cells.
+  //! \param [in] m  The mesh to write.
+  //! \param [in] blocks  The cells in each element block.
+  //! \return The written faces, in local order.
+  //============================================================================
+  template< typename B >
+  auto output_faces( mesh_t & m, const B & blocks )
+  {
+    auto num_faces = m.num_faces();
+
+    std::vector<bool> used( num_faces, false );
+    for ( const auto & blk : blocks )
+      for ( auto c : blk )
+        for ( auto f : m.faces(c) ) used[ f.id() ] = true;
+
+    file_ids_t faces( num_faces );
+    for ( counter_t i=0; i<num_faces; i++ )
+      if ( used[i] ) faces.add( i );
+
+    return faces;
+  }
+
+  //============================================================================
+  //! \brief Return the exodus side of an element that a face lies on.
+  //! \param [in] m  The mesh being written.
+  //! \param [in] c  The element.
+  //! \param [in] f  The face.
+  //! \param [in] pos  The position of the face in the faces of the element.
+  //! \return The 1-based side id.
+  //============================================================================
+  template< typename C, typename F >
+  static ex_index_t element_side( mesh_t & m, C c, F f, size_t pos )
+  {
+    return element_side( m, c, f, pos, std::integral_constant<size_t,N>{} );
+  }
+
+  //! \brief Polygons are written by node, and side i runs from node i to
+  //!        node i+1.
+  template< typename C, typename F >
+  static ex_index_t element_side( 
+    mesh_t & m, C c, F f, size_t, std::integral_constant<size_t,2> )
+  {
+    auto verts = m.vertices(c);
+    auto fverts = m.vertices(f);
+    auto a = fverts[0].id();
+    auto b = fverts[1].id();
+    size_t n = verts.size();
+    for ( size_t i=0; i<n; i++ ) {
+      auto v0 = verts[i].id();
+      auto v1 = verts[ (i+1) % n ].id();
+      if ( ( v0 == a && v1 == b ) || ( v0 == b && v1 == a ) ) return i+1;
+    }
+    raise_runtime_error( "Face is not an edge of its cell" );
+    return 0;
+  }
+
+  //! \brief Polyhedra are written by face, so the sides are the faces.
+  template< typename C, typename F >
+  static ex_index_t element_side( 
+    mesh_t &, C, F, size_t pos, std::integral_constant<size_t,3> )
+  {
+    return pos+1;
+  }
+
+  //============================================================================
+  //! \brief Write the global id maps and the Nemesis load balance 
+  //!        information of a distributed mesh.
+  //!
+  //! This lets readers stitch the files of all the processes back together.
+  //! Owned nodes are border nodes if a cell owned by another process uses
+  //! them, and internal nodes otherwise.  The written ghosts are external 
+  //! nodes.  Elements are border elements if they use a border or external
+  //! node.  Each node communication map lists the nodes shared with one
+  //! process, and each element communication map lists the element sides 
+  //! that face the cells of one process.  Nothing is written unless the 
+  //! mesh is distributed.
+  //!
+  //! \param [in] m  The mesh to write.
+  //! \param [in] nodes  The vertices written to the file.
+  //! \param [in] blocks  The cells in each element block.
+  //! \return the status of the file
+  //============================================================================
+  template< typename B >
+  auto write_parallel_info( 
+    mesh_t & m, const file_ids_t & nodes, const B & blocks ) 
+  {
+    if ( !m.is_distributed() ) return 0;
+
+    const auto & layout = m.ownership();
+    auto rank = utils::comm_rank();
+    auto num_ranks = utils::comm_size();
+
+    auto num_nodes = nodes.local.size();
+    auto num_owned_nodes = m.num_owned_vertices();
+    auto num_elem_blk = blocks.size();
+
+    //--------------------------------------------------------------------------
+    // global id maps ( exodus uses 1 indexed arrays )
+
+    std::vector<ex_index_t> node_map( num_nodes );
+    for ( size_t i=0; i<num_nodes; i++ )
+      node_map[i] = layout.vertex_global_ids[ nodes.local[i] ] + 1;
+
+    auto status = ex_put_id_map( exoid_, EX_NODE_MAP, node_map.data() );
+    assert(status == 0);
+
+    // the elements are numbered block by block.  Also remember where each 
+    // cell ends up.
+    std::vector<ex_index_t> elem_map, file_elem( m.num_cells(), 0 );
+    for ( const auto & blk : blocks )
+      for ( auto c : blk ) {
+        elem_map.emplace_back( layout.cell_global_ids[ c.id() ] + 1 );
+        file_elem[ c.id() ] = elem_map.size();
+      }
+
+    status = ex_put_id_map( exoid_, EX_ELEM_MAP, elem_map.data() );
+    assert(status == 0);
+
+    //--------------------------------------------------------------------------
+    // global sizes
+
+    char file_type[] = "p";
+    status = ex_put_init_info( exoid_, num_ranks, 1, file_type );
+    assert(status == 0);
+
+    std::vector<size_t> global_counts( num_elem_blk+2 );
+    global_counts[0] = num_owned_nodes;
+    global_counts[1] = elem_map.size();
+    for ( size_t b=0; b<num_elem_blk; b++ ) 
+      global_counts[b+2] = blocks[b].size();
+    utils::global_sum( global_counts.data(), global_counts.size() );
+
+    status = ex_put_init_global( 
+      exoid_, global_counts[0], global_counts[1], num_elem_blk, 0, 0 );
+    assert(status == 0);
+
+    std::vector<ex_index_t> blk_ids( num_elem_blk ), blk_counts( num_elem_blk );
+    for ( size_t b=0; b<num_elem_blk; b++ ) {
+      blk_ids[b] = b+1;
+      blk_counts[b] = global_counts[b+2];
+    }
+    status = ex_put_eb_info_global( exoid_, blk_ids.data(), blk_counts.data() );
+    assert(status == 0);
+
+    //--------------------------------------------------------------------------
+    // the nodes shared with each process
+
+    // the owner of each ghost
+    std::vector<int> cell_rank( m.num_cells(), rank );
+    for ( const auto & n : layout.cells.neighbors() )
+      for ( auto i : n.recv ) cell_rank[i] = n.rank;
+
+    std::vector<int> vertex_rank( m.num_vertices(), rank );
+    for ( const auto & n : layout.vertices.neighbors() )
+      for ( auto i : n.recv ) vertex_rank[i] = n.rank;
+
+    // An owned vertex is shared with the owners of the cells around it.
+    // The owner of a vertex holds all of those cells, so the other process 
+    // writes the vertex as an external node exactly when it is listed here.
+    std::map< int, std::vector<ex_index_t> > shared_nodes;
+    auto cs = m.cells();
+    for ( const auto & n : layout.cells.neighbors() )
+      for ( auto i : n.recv )
+        for ( auto v : m.vertices( cs[i] ) )
+          if ( v.id() < num_owned_nodes )
+            shared_nodes[ n.rank ].emplace_back( nodes.file[ v.id() ] );
+
+    // the ghosts are shared with their owners
+    for ( size_t i=num_owned_nodes; i<num_nodes; i++ )
+      shared_nodes[ vertex_rank[ nodes.local[i] ] ].emplace_back( i+1 );
+
+    std::vector<bool> is_shared( num_nodes+1, false );
+    for ( auto & entry : shared_nodes ) {
+      auto & list = entry.second;
+      std::sort( list.begin(), list.end() );
+      list.erase( std::unique( list.begin(), list.end() ), list.end() );
+      for ( auto i : list ) is_shared[i] = true;
+    }
+
+    //--------------------------------------------------------------------------
+    // the element sides facing the cells of each process
+
+    std::map< int, std::pair< std::vector<ex_index_t>, std::vector<ex_index_t> > > 
+      shared_sides;
+    for ( const auto & blk : blocks )
+      for ( auto c : blk ) {
+        auto faces = m.faces(c);
+        for ( size_t i=0; i<faces.size(); i++ )
+          for ( auto other : m.cells( faces[i] ) ) {
+            auto r = cell_rank[ other.id() ];
+            if ( r == rank ) continue;
+            auto & sides = shared_sides[r];
+            sides.first.emplace_back( file_elem[ c.id() ] );
+            sides.second.emplace_back( element_side( m, c, faces[i], i ) );
+          }
+      }
+
+    //--------------------------------------------------------------------------
+    // classify the nodes and elements
+
+    std::vector<ex_index_t> node_int, node_bor, node_ext;
+    for ( size_t i=1; i<=num_owned_nodes; i++ ) {
+      if ( is_shared[i] ) node_bor.emplace_back( i );
+      else                node_int.emplace_back( i );
+    }
+    for ( size_t i=num_owned_nodes+1; i<=num_nodes; i++ ) 
+      node_ext.emplace_back( i );
+
+    std::vector<ex_index_t> elem_int, elem_bor;
+    for ( const auto & blk : blocks )
+      for ( auto c : blk ) {
+        auto verts = m.vertices(c);
+        auto border = std::any_of( verts.begin(), verts.end(),
+          [&]( auto v ) { return is_shared[ nodes.file[ v.id() ] ]; } );
+        ( border ? elem_bor : elem_int ).emplace_back( file_elem[ c.id() ] );
+      }
+
+    //--------------------------------------------------------------------------
+    // now write it all
+
+    std::vector<ex_index_t> node_cmap_ids, node_cmap_counts;
+    for ( const auto & entry : shared_nodes ) {
+      node_cmap_ids.emplace_back( entry.first + 1 );
+      node_cmap_counts.emplace_back( entry.second.size() );
+    }
+
+    std::vector<ex_index_t> elem_cmap_ids, elem_cmap_counts;
+    for ( const auto & entry : shared_sides ) {
+      elem_cmap_ids.emplace_back( entry.first + 1 );
+      elem_cmap_counts.emplace_back( entry.second.first.size() );
+    }
+
+    status = ex_put_loadbal_param( 
+      exoid_, node_int.size(), node_bor.size(), node_ext.size(), 
+      elem_int.size(), elem_bor.size(), node_cmap_ids.size(), 
+      elem_cmap_ids.size(), rank 
+    );
+    assert(status == 0);
+
+    status = ex_put_processor_node_maps( 
+      exoid_, node_int.data(), node_bor.data(), node_ext.data(), rank );
+    assert(status == 0);
+
+    status = ex_put_processor_elem_maps( 
+      exoid_, elem_int.data(), elem_bor.data(), rank );
+    assert(status == 0);
+
+    status = ex_put_cmap_params( 
+      exoid_, node_cmap_ids.data(), node_cmap_counts.data(), 
+      elem_cmap_ids.data(), elem_cmap_counts.data(), rank );
+    assert(status == 0);
+
+    for ( const auto & entry : shared_nodes ) {
+      const auto & list = entry.second;
+      std::vector<ex_index_t> procs( list.size(), entry.first );
+      status = ex_put_node_cmap( 
+        exoid_, entry.first+1, list.data(), procs.data(), rank );
+      assert(status == 0);
+    }
+
+    for ( const auto & entry : shared_sides ) {
+      const auto & sides = entry.second;
+      std::vector<ex_index_t> procs( sides.first.size(), entry.first );
+      status = ex_put_elem_cmap( 
+        exoid_, entry.first+1, sides.first.data(), sides.second.data(),
+        procs.data(), rank );
+      assert(status == 0);
+    }
+
+    return status;
+  }
+
   //============================================================================
   //! \brief write field data to the file
   //! \param [in] m  The mesh to extract field data from.
+  //! \param [in] nodes  The vertices written to the file.
+  //! \param [in] blocks  The cells in each element block.
+  //! \param [in] format  Selects the fields to write.
   //! \return the status of the file
   //============================================================================
-  auto write_fields( mesh_t & m ) 
+  template< typename B >
+  auto write_fields( 
+    mesh_t & m, const file_ids_t & nodes, const B & blocks, 
+    const output_format_t & format ) 
   { 
 
     int status;
 
     // mesh statistics
     constexpr auto num_dims  = mesh_t::num_dimensions;
-    auto num_nodes = m.num_vertices();
-    auto num_elem = m.num_cells();
-    auto num_elem_blk = m.num_regions();
+    auto num_nodes = nodes.local.size();
+    auto num_elem_blk = blocks.size();
 
     //--------------------------------------------------------------------------
     // initial setup
@@ -246,19 +617,19 @@ public:
     int num_nf = 0;
 
     // real scalars persistent at vertices
-    auto rspav = flecsi_get_accessors_all(
+    auto rspav = format.select_fields( flecsi_get_accessors_all(
       m, real_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
-    );
+    ) );
     num_nf += rspav.size();
     // int scalars persistent at vertices
-    auto ispav = flecsi_get_accessors_all(
+    auto ispav = format.select_fields( flecsi_get_accessors_all(
       m, integer_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
-    );
+    ) );
     num_nf += ispav.size();
     // real vectors persistent at vertices
-    auto rvpav = flecsi_get_accessors_all(
+    auto rvpav = format.select_fields( flecsi_get_accessors_all(
       m, vector_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
-    );
+    ) );
     num_nf += num_dims*rvpav.size();
 
     // variable extension for vectors
@@ -301,20 +672,24 @@ public:
     inum = 1;
 
     // node field buffer
+    auto vs = m.vertices();
     for(auto sf: rspav) {
-      for(auto v: m.vertices()) tmp[v.id()] = sf[v];
+      #pragma omp parallel for
+      for(counter_t i=0; i<num_nodes; ++i) tmp[i] = sf[vs[nodes.local[i]]];
       status = ex_put_nodal_var(exoid_, time_step, inum++, num_nodes, tmp.data());
       assert(status == 0);
     } // for
     for(auto sf: ispav) {
       // cast int fields to real_t
-      for(auto v: m.vertices()) tmp[v.id()] = (real_t)sf[v];
+      #pragma omp parallel for
+      for(counter_t i=0; i<num_nodes; ++i) tmp[i] = (real_t)sf[vs[nodes.local[i]]];
       status = ex_put_nodal_var(exoid_, time_step, inum++, num_nodes, tmp.data());
       assert(status == 0);
     } // for
     for(auto vf: rvpav) {
       for(int d=0; d < num_dims; ++d) {
-        for(auto v: m.vertices()) tmp[v.id()] = vf[v][d];
+        #pragma omp parallel for
+        for(counter_t i=0; i<num_nodes; ++i) tmp[i] = vf[vs[nodes.local[i]]][d];
         status = ex_put_nodal_var(exoid_, time_step, inum++, num_nodes, tmp.data());
         assert(status == 0);
       } // for
@@ -325,9 +700,6 @@ public:
     // element fields
     //--------------------------------------------------------------------------
 
-    // get the regions
-    auto region_cells = m.regions();
-
     //--------------------------------------------------------------------------
     // element field data headers
 
@@ -335,19 +707,19 @@ public:
     int num_ef = 0;
 
     // real scalars persistent at cells
-    auto rspac = flecsi_get_accessors_all(
+    auto rspac = format.select_fields( flecsi_get_accessors_all(
       m, real_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
-    );
+    ) );
     num_ef += rspac.size();
     // int scalars persistent at cells
-    auto ispac = flecsi_get_accessors_all(
+    auto ispac = format.select_fields( flecsi_get_accessors_all(
       m, integer_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
-    );
+    ) );
     num_ef += ispac.size();
     // real vectors persistent at cells
-    auto rvpac = flecsi_get_accessors_all(
+    auto rvpac = format.select_fields( flecsi_get_accessors_all(
       m, vector_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
-    );
+    ) );
     num_ef += num_dims*rvpac.size();
 
     // put the number of element fields
@@ -388,8 +760,8 @@ public:
       auto elem_blk_id = iblk+1;
 
       // get the elements in this block
-      const auto & elem_this_blk = region_cells[iblk];
-      auto num_elem_this_blk = elem_this_blk.size();
+      const auto & elem_this_blk = blocks[iblk];
+      counter_t num_elem_this_blk = elem_this_blk.size();
   
       // resize temp data
       tmp.clear();
@@ -400,22 +772,25 @@ public:
 
       // element field buffer
       for(auto sf: rspac) {
-        size_t cid = 0;
-        for(auto c: elem_this_blk) tmp[cid++] = sf[c];
+        #pragma omp parallel for
+        for(counter_t i=0; i<num_elem_this_blk; ++i) 
+          tmp[i] = sf[elem_this_blk[i]];
         status = ex_put_elem_var(exoid_, time_step, inum++, elem_blk_id, num_elem_this_blk, tmp.data());
         assert(status == 0);
       } // for
       for(auto sf: ispac) {
         // cast int fields to real_t
-        size_t cid = 0;
-        for(auto c: elem_this_blk) tmp[cid++] = (real_t)sf[c];
+        #pragma omp parallel for
+        for(counter_t i=0; i<num_elem_this_blk; ++i) 
+          tmp[i] = (real_t)sf[elem_this_blk[i]];
         status = ex_put_elem_var(exoid_, time_step, inum++, elem_blk_id, num_elem_this_blk, tmp.data());
         assert(status == 0);
       } // for
       for(auto vf: rvpac) {
         for(int d=0; d < num_dims; ++d) {
-          size_t cid = 0;
-          for(auto c: elem_this_blk) tmp[cid++] = vf[c][d];
+          #pragma omp parallel for
+          for(counter_t i=0; i<num_elem_this_blk; ++i) 
+            tmp[i] = vf[elem_this_blk[i]][d];
           status = ex_put_elem_var(exoid_, time_step, inum++, elem_blk_id, num_elem_this_blk, tmp.data());
           assert(status == 0);
         } // for
@@ -627,8 +1002,7 @@ public:
     m.init();
 
     // override the region ids
-    m.set_regions( region_ids.data() );
-    m.set_num_regions( num_elem_blk );
+    m.set_regions( region_ids.data(), num_elem_blk );
 
     // creating fields from an exodus file will be problematic since the type
     // information on the file has been thrown away. For example, an int field
@@ -679,14 +1053,22 @@ public:
     // initial setup
     //--------------------------------------------------------------------------
 
-    auto exoid = open( name, std::ios_base::out );
+    // what to write
+    const auto & format = m.output_profile().get( name );
+
+    auto exoid = open( name, std::ios_base::out, format.precision );
     assert(exoid >= 0);
 
+    // the cells written to each block, and the vertices they use
+    auto blocks = output_blocks( m, format );
+    auto nodes = output_nodes( m, blocks );
+
     // get the general statistics
     constexpr auto num_dims = mesh_t::num_dimensions;
-    auto num_nodes = m.num_vertices();
-    auto num_elem = m.num_cells();
-    auto num_elem_blk = m.num_regions();
+    auto num_nodes = nodes.local.size();
+    auto num_elem_blk = blocks.size();
+    size_t num_elem = 0;
+    for ( const auto & blk : blocks ) num_elem += blk.size();
     auto num_node_sets = 0;
     auto num_side_sets = 0;
 
@@ -695,11 +1077,15 @@ public:
                               num_nodes, num_elem, num_elem_blk, num_node_sets, num_side_sets);
     assert(status == 0);
 
+    // the parallel layout, if any
+    status = write_parallel_info( m, nodes, blocks );
+    assert( status == 0 );
+
     //--------------------------------------------------------------------------
     // Point Coordinates
     //--------------------------------------------------------------------------
     
-    status = write_point_coords( m );
+    status = write_point_coords( m, nodes );
     assert( status == 0 );
 
 
@@ -707,10 +1093,6 @@ public:
     // Block connectivity
     //--------------------------------------------------------------------------
 
-    // get the regions
-    auto region_cells = m.regions();
-
-
     // loop over element blocks
     for ( int iblk=0; iblk<num_elem_blk; iblk++ ) {
 
@@ -718,7 +1100,7 @@ public:
       auto elem_blk_id = iblk+1;
 
       // get the elements in this block
-      const auto & elem_this_blk = region_cells[iblk];
+      const auto & elem_this_blk = blocks[iblk];
       auto num_elem_this_blk = elem_this_blk.size();
             
       // count how many vertices there are in this block
@@ -748,7 +1130,7 @@ public:
         auto verts = m.vertices(c);
         elem_node_counts[f++] = verts.size();
         for (auto v : verts)
-          elem_nodes[i++] = v.id() + 1; // 1-based ids      
+          elem_nodes[i++] = nodes.file[ v.id() ]; // 1-based ids      
       }
        
 
@@ -769,7 +1151,7 @@ public:
     //--------------------------------------------------------------------------
     // write field data
     //--------------------------------------------------------------------------
-    status = write_fields( m );
+    status = write_fields( m, nodes, blocks, format );
     assert( status == 0 );
 
 
@@ -1071,8 +1453,7 @@ public:
 #ifndef PARAVIEW_EXODUS_3D_REGION_BUGFIX
 
     // override the region ids
-    m.set_regions( region_ids.data() );
-    m.set_num_regions( num_elem_blk );
+    m.set_regions( region_ids.data(), num_elem_blk );
 
 #endif
 
@@ -1136,16 +1517,25 @@ public:
     // initial setup
     //--------------------------------------------------------------------------
 
-    auto exoid = open( name, std::ios_base::out );
+    // what to write
+    const auto & format = m.output_profile().get( name );
+
+    auto exoid = open( name, std::ios_base::out, format.precision );
     assert(exoid >= 0);
 
 
+    // the cells written to each block, and the vertices and faces they use
+    auto blocks = output_blocks( m, format );
+    auto nodes = output_nodes( m, blocks );
+    auto faces = output_faces( m, blocks );
+
     // get the general statistics
     constexpr auto num_dims = mesh_t::num_dimensions;
-    auto num_nodes = m.num_vertices();
-    auto num_faces = m.num_faces();
-    auto num_elem = m.num_cells();
-    auto num_elem_blk = m.num_regions();
+    auto num_nodes = nodes.local.size();
+    auto num_faces = faces.local.size();
+    auto num_elem_blk = blocks.size();
+    size_t num_elem = 0;
+    for ( const auto & blk : blocks ) num_elem += blk.size();
 
     // set exodus parameters
     ex_init_params exopar;
@@ -1170,11 +1560,15 @@ public:
     auto status = ex_put_init_ext( exoid, &exopar );
     assert(status == 0);
 
+    // the parallel layout, if any
+    status = write_parallel_info( m, nodes, blocks );
+    assert( status == 0 );
+
     //--------------------------------------------------------------------------
     // Point Coordinates
     //--------------------------------------------------------------------------
     
-    status = write_point_coords( m );
+    status = write_point_coords( m, nodes );
     assert( status == 0 );
 
 
@@ -1187,15 +1581,15 @@ public:
       // set the block header
       auto face_blk_id = num_elem_blk + 1; // don't collide
       
-      // put all faces in one block
-      auto faces_this_blk = m.faces();
-      auto num_faces_this_blk = faces_this_blk.size();
+      // put all the written faces in one block
+      auto fs = m.faces();
+      auto num_faces_this_blk = faces.local.size();
 
       // count how many vertices and faces there are in this block
       // double count face nodes
       auto num_nodes_this_blk = 0;
-      for ( auto f : faces_this_blk )
-        num_nodes_this_blk += m.vertices(f).size();
+      for ( auto i : faces.local )
+        num_nodes_this_blk += m.vertices( fs[i] ).size();
       
       // set the block header
       auto num_attr_per_face = 0;
@@ -1219,13 +1613,13 @@ public:
 
       size_t e = 0, i = 0;
       // for each face, get nodes
-      for ( auto f : faces_this_blk ) {
+      for ( auto f : faces.local ) {
         // node count
-        auto verts = m.vertices(f);
+        auto verts = m.vertices( fs[f] );
         face_node_counts[e++] = verts.size();
         // vertex ids
         for (auto v : verts )
-          face_nodes[i++] = v.id() + 1; // 1-based ids      
+          face_nodes[i++] = nodes.file[ v.id() ]; // 1-based ids      
       }
        
       // write connectivity
@@ -1247,9 +1641,6 @@ public:
     // Element Block connectivity
     //--------------------------------------------------------------------------
 
-    // get the regions
-    auto region_cells = m.regions();
-
     // loop over element blocks
     for ( int iblk=0; iblk<num_elem_blk; iblk++ ) {
 
@@ -1257,7 +1648,7 @@ public:
       auto elem_blk_id = iblk+1;
 
       // get the elements in this block
-      const auto & elem_this_blk = region_cells[iblk];
+      const auto & elem_this_blk = blocks[iblk];
       auto num_elem_this_blk = elem_this_blk.size();
 
       // count how many faces there are in this block
@@ -1290,12 +1681,12 @@ public:
       size_t e = 0, i = 0;
       for ( auto c : elem_this_blk ) {
         // get faces of this element
-        auto faces = m.faces(c);
+        auto elem_faces_this = m.faces(c);
         // face count
-        elem_face_counts[e++] = faces.size();
+        elem_face_counts[e++] = elem_faces_this.size();
         // for each element face, get ids
-        for ( auto f : faces ) 
-          elem_faces[i++] = f.id() + 1; // 1-based ids      
+        for ( auto f : elem_faces_this ) 
+          elem_faces[i++] = faces.file[ f.id() ]; // 1-based ids      
       }
        
       // write connectivity
@@ -1316,7 +1707,7 @@ public:
     //--------------------------------------------------------------------------
     // write field data
     //--------------------------------------------------------------------------
-    status = write_fields( m );
+    status = write_fields( m, nodes, blocks, format );
     assert( status == 0 );
 
 
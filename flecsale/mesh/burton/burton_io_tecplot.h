@@ -12,8 +12,10 @@
 // user includes
 #include "flecsi/io/io_base.h"
 #include "flecsale/mesh/burton/burton_mesh.h"
+#include "flecsale/mesh/output_profile.h"
 #include "flecsale/utils/errors.h"
 #include "flecsale/utils/string_utils.h"
+#include "flecsale/utils/type_traits.h"
 
 #ifdef HAVE_TECIO
 #  include <TECIO.h>
@@ -22,6 +24,7 @@
 // system includes
 #include <cstring>
 #include <fstream>
+#include <limits>
 
 namespace flecsale {
 namespace mesh {
@@ -78,59 +81,63 @@ public:
   //============================================================================
   struct tec_zone_map_t {
 
+    //! \brief marks regions that are not written
+    static constexpr auto no_zone = std::numeric_limits<size_t>::max();
+
     //--------------------------------------------------------------------------
     //! \brief constructor
+    //! \param [in] m  The mesh to write.
+    //! \param [in] region_list  The regions that get written, one per zone.
     //--------------------------------------------------------------------------
     template< typename T >
     tec_zone_map_t( mesh_t & m, const T & region_list ) : 
       mesh(m),
       num_zones( region_list.size() ), 
-      elem_zone_map( num_zones ),
-      region_map( num_zones )
+      elem_zone_map( m.regions().size() ),
+      region_map( m.regions().size(), no_zone )
     {
-      std::vector< size_t > local_elem_id( num_zones, 0 );
-
-      // determine a local cell zone ordering
-      for ( auto c : m.cells() ) {
-        auto cell_id = c.id();
-        auto reg_id = c->region();
-        elem_zone_map[reg_id][cell_id] = local_elem_id[reg_id]++;
-      }
-
-      // check the sums
-      size_t sum = 0;
-      for ( auto reg : elem_zone_map ) sum += reg.size();
-      assert( sum == m.cells().size() );
-
       // create a region map
       for ( counter_t i=0; i<num_zones; i++ )
         region_map[ region_list[i] ] = i;
+
+      // determine a local cell zone ordering
+      const auto & region_cells = m.regions();
+      for ( counter_t i=0; i<num_zones; i++ ) {
+        auto reg_id = region_list[i];
+        size_t local_elem_id = 0;
+        for ( auto cell_id : region_cells[reg_id] )
+          elem_zone_map[reg_id][cell_id] = local_elem_id++;
+      }
     }
       
 
     //--------------------------------------------------------------------------
     //! \brief create a region map
+    //!
+    //! Faces shared with a region that is not written are treated like 
+    //! boundary faces.
+    //!
+    //! \param [in] this_region  The region id of the zone.
+    //! \param [in] elem_this_zone  The ids of the cells of the zone.
     //--------------------------------------------------------------------------
     template< typename T >
-    void build_face_map( size_t zone_id, const T & elem_this_zone ) {
-
-      // this region id
-      auto this_region = zone_id;
+    void build_face_map( size_t this_region, const T & elem_this_zone ) {
 
-      // all the faces of the mesh
+      // all the cells and faces of the mesh
+      auto all_cells = mesh.cells();
       auto faces = mesh.faces();
 
       // count how many faces there are in this block
       num_faces_this_zone = 0;
       for ( auto c : elem_this_zone ) 
-        num_faces_this_zone += mesh.faces(c).size();
+        num_faces_this_zone += mesh.faces(all_cells[c]).size();
       
       // create a face map
       std::vector< size_t > faces_this_zone; 
       faces_this_zone.reserve( num_faces_this_zone );
       
       for ( auto c : elem_this_zone ) 
-        for ( auto f : mesh.faces( c ) )
+        for ( auto f : mesh.faces( all_cells[c] ) )
           faces_this_zone.emplace_back( f.id() );
       
       // sort, then delete duplicate entries
@@ -177,32 +184,32 @@ public:
         face_cell_right[f] = 0;
         // always has left cell
         auto left_cell = cells[0];
-        auto left_region = region_map[ left_cell->region() ];
+        auto left_region = left_cell->region();
         // left cell is local
         if ( left_region == this_region )
           face_cell_left[f] = elem_zone_map[ this_region ].at( left_cell.id() ) + 1;
         // left cell is on another zone
-        else {
+        else if ( region_map[ left_region ] != no_zone ) {
           face_cell_left[f] = - (++num_face_conn);
           face_conn_counts.emplace_back( 1 );
           face_conn_elems.emplace_back( 
             elem_zone_map[ left_region ].at( left_cell.id() ) + 1 );
-          face_conn_zones.emplace_back( left_region + 1 );
+          face_conn_zones.emplace_back( region_map[ left_region ] + 1 );
         }         
         // boundary faces don't have right cell
         if ( cells.size() > 1 ) {
           auto right_cell = cells[1];
-          auto right_region = region_map[ right_cell->region() ];
+          auto right_region = right_cell->region();
           // right cell is local
           if ( right_region == this_region ) 
             face_cell_right[f] = elem_zone_map[ this_region ].at( right_cell.id() ) + 1;
           // right cell is on another zone
-          else {
+          else if ( region_map[ right_region ] != no_zone ) {
             face_cell_right[f] = - (++num_face_conn);
             face_conn_counts.emplace_back( 1 );
             face_conn_elems.emplace_back( 
               elem_zone_map[ right_region ].at( right_cell.id() ) + 1 );
-            face_conn_zones.emplace_back( right_region + 1 );
+            face_conn_zones.emplace_back( region_map[ right_region ] + 1 );
           }
         }
         // incrememnt 
@@ -239,7 +246,7 @@ public:
     std::vector<tec_int_t> face_conn_zones;
     //! @}
     
-    //! \brief  storage for the zone-to-element mapping
+    //! \brief  storage for the zone-to-element mapping, by region id
     std::vector< 
       std::map< size_t, size_t > 
     > elem_zone_map;
@@ -317,6 +324,10 @@ struct burton_io_tecplot_ascii_t :
 
     std::cout << "Writing mesh to: " << name << std::endl;
 
+    // what to write.  The values are printed with the stream's default 
+    // precision, so there is nothing to down-convert.
+    const auto & format = m.output_profile().get( name );
+
     // open the file for writing
     std::ofstream ofs( name.c_str() );
     assert( ofs.good() && "error opening file" );
@@ -350,19 +361,19 @@ struct burton_io_tecplot_ascii_t :
     // number of nodal fields
     int num_nf = 0;
     // real scalars persistent at vertices
-    auto rspav = flecsi_get_accessors_all(
+    auto rspav = format.select_fields( flecsi_get_accessors_all(
       m, real_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
-    );
+    ) );
     num_nf += rspav.size();
     // int scalars persistent at vertices
-    auto ispav = flecsi_get_accessors_all(
+    auto ispav = format.select_fields( flecsi_get_accessors_all(
       m, integer_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
-    );
+    ) );
     num_nf += ispav.size();
     // real vectors persistent at vertices
-    auto rvpav = flecsi_get_accessors_all(
+    auto rvpav = format.select_fields( flecsi_get_accessors_all(
       m, vector_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
-    );
+    ) );
     num_nf += num_dims*rvpav.size();
 
     // fill node variable names array
@@ -390,19 +401,19 @@ struct burton_io_tecplot_ascii_t :
     // number of element fields
     int num_ef = 0;
     // real scalars persistent at cells
-    auto rspac = flecsi_get_accessors_all(
+    auto rspac = format.select_fields( flecsi_get_accessors_all(
       m, real_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
-    );
+    ) );
     num_ef += rspac.size();
     // int scalars persistent at cells
-    auto ispac = flecsi_get_accessors_all(
+    auto ispac = format.select_fields( flecsi_get_accessors_all(
       m, integer_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
-    );
+    ) );
     num_ef += ispac.size();
     // real vectors persistent at cells
-    auto rvpac = flecsi_get_accessors_all(
+    auto rvpac = format.select_fields( flecsi_get_accessors_all(
       m, vector_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
-    );
+    ) );
     num_ef += num_dims*rvpac.size();
 
 
@@ -441,15 +452,15 @@ struct burton_io_tecplot_ascii_t :
     // Element-Zone connectivity
     //--------------------------------------------------------------------------
 
-    auto num_zones = m.num_regions();
-   
-    // get the regions
-    auto region_cells = m.regions();
+    // get the cells of each region
+    const auto & region_cells = m.regions();
 
-    // get the list of different region ids
-    vector< size_t > region_list( num_zones );
-    for ( auto i=0; i<num_zones; i++ ) 
-      region_list[i] = region_cells[i].front()->region();
+    // get the list of different region ids that are written
+    vector< size_t > region_list;
+    for ( size_t i=0; i<region_cells.size(); i++ )
+      if ( !region_cells[i].empty() && format.writes_region( i ) )
+        region_list.emplace_back( i );
+    auto num_zones = region_list.size();
     
     // create a region map
     tec_zone_map_t mapping( m, region_list );
@@ -458,12 +469,12 @@ struct burton_io_tecplot_ascii_t :
     // Loop over Regions
     //--------------------------------------------------------------------------
   
-    for ( int izn=0; izn<num_zones; izn++ ) {
+    for ( size_t izn=0; izn<num_zones; izn++ ) {
 
       // get the elements in this block
-      const auto & elem_this_zone = region_cells[izn];
+      auto region_id = region_list[izn];
+      const auto & elem_this_zone = region_cells[ region_id ];
       auto num_elem_this_zone = elem_this_zone.size();
-      auto region_id = elem_this_zone.front()->region();
 
       //------------------------------------------------------------------------
       // face/edge connectivity
@@ -687,19 +698,30 @@ struct burton_io_tecplot_binary_t :
     tec_int_t Debug     = 0; // Set to 0 for no debugging or 1 to debug
     tec_int_t FileType  = 0; // 0=Tecplot binary (.plt) 1=Tecplot subzone (.szplt)
 
+    // what to write
+    const auto & format = m.output_profile().get( name );
+
     tec_int_t VIsDouble; // 0=Single 1=Double
-    if ( std::is_same_v<tec_real_t, float> )
+    if ( utils::is_same_v<tec_real_t, float> || format.is_single_precision() )
       VIsDouble = 0;
-    else if ( std::is_same_v<tec_real_t, double> )
+    else if ( utils::is_same_v<tec_real_t, double> )
       VIsDouble = 1;
     else
       raise_implemented_error( "Can only output to tecplot with floats or doubls" );
 
+    // hand the values to tecio, down-converting them if they are stored with
+    // more precision than the file has
+    vector<float> single_vals;
+    auto write_data = [&]( tec_int_t num, vector<tec_real_t> & vals ) {
+      if ( VIsDouble || utils::is_same_v<tec_real_t, float> )
+        return TECDAT112( &num, vals.data(), &VIsDouble );
+      single_vals.assign( vals.begin(), vals.end() );
+      return TECDAT112( &num, single_vals.data(), &VIsDouble );
+    };
+
     // get the general statistics
     tec_int_t num_dims  = m.num_dimensions;
     tec_int_t num_nodes = m.num_vertices();
-    tec_int_t num_elem  = m.num_cells();
-    tec_int_t num_zones = m.num_regions();
 
     // set the time
     double soln_time = m.time();
@@ -730,17 +752,17 @@ struct burton_io_tecplot_binary_t :
     // nodal field data
 
     // real scalars persistent at vertices
-    auto rspav = flecsi_get_accessors_all(
+    auto rspav = format.select_fields( flecsi_get_accessors_all(
       m, real_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
-    );
+    ) );
     // int scalars persistent at vertices
-    auto ispav = flecsi_get_accessors_all(
+    auto ispav = format.select_fields( flecsi_get_accessors_all(
       m, integer_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
-    );
+    ) );
     // real vectors persistent at vertices
-    auto rvpav = flecsi_get_accessors_all(
+    auto rvpav = format.select_fields( flecsi_get_accessors_all(
       m, vector_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
-    );
+    ) );
 
     // fill node variable names array
     for(auto sf: rspav) {
@@ -764,17 +786,17 @@ struct burton_io_tecplot_binary_t :
     // element field data
 
     // real scalars persistent at cells
-    auto rspac = flecsi_get_accessors_all(
+    auto rspac = format.select_fields( flecsi_get_accessors_all(
       m, real_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
-    );
+    ) );
     // int scalars persistent at cells
-    auto ispac = flecsi_get_accessors_all(
+    auto ispac = format.select_fields( flecsi_get_accessors_all(
       m, integer_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
-    );
+    ) );
     // real vectors persistent at cells
-    auto rvpac = flecsi_get_accessors_all(
+    auto rvpac = format.select_fields( flecsi_get_accessors_all(
       m, vector_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
-    );
+    ) );
 
 
     // fill element variable names array
@@ -835,13 +857,15 @@ struct burton_io_tecplot_binary_t :
     // Element-Zone connectivity
     //--------------------------------------------------------------------------
 
-    // get the regions
-    auto region_cells = m.regions();
+    // get the cells of each region
+    const auto & region_cells = m.regions();
 
-    // get the list of different region ids
-    vector< size_t > region_list( num_zones );
-    for ( auto i=0; i<num_zones; i++ ) 
-      region_list[i] = region_cells[i].front()->region();
+    // get the list of different region ids that are written
+    vector< size_t > region_list;
+    for ( size_t i=0; i<region_cells.size(); i++ )
+      if ( !region_cells[i].empty() && format.writes_region( i ) )
+        region_list.emplace_back( i );
+    tec_int_t num_zones = region_list.size();
 
     // create a region map
     tec_zone_map_t mapping( m, region_list );
@@ -853,14 +877,14 @@ struct burton_io_tecplot_binary_t :
     for ( counter_t izn=0; izn<num_zones; izn++ ) {
 
       // get the elements in this block
-      const auto & elem_this_zone = region_cells[izn];
+      auto region_id = region_list[izn];
+      const auto & elem_this_zone = region_cells[ region_id ];
       tec_int_t num_elem_this_zone = elem_this_zone.size();
-      auto region_id = elem_this_zone.front()->region();
 
       //------------------------------------------------------------------------
       // face/edge connectivity
       
-      mapping.build_face_map( izn, elem_this_zone );
+      mapping.build_face_map( region_id, elem_this_zone );
 
       //------------------------------------------------------------------------
       // Create ZONE header
@@ -943,7 +967,7 @@ struct burton_io_tecplot_binary_t :
           // get the coordinates from the mesh.
           for (auto v : m.vertices()) vals[v.id()] = v->coordinates()[d];
           // write the coordinates to the file
-          status = TECDAT112( &num_nodes, vals.data(), &VIsDouble );
+          status = write_data( num_nodes, vals );
           assert( status == 0 && "error with TECDAT" );
         }        
 
@@ -954,21 +978,21 @@ struct burton_io_tecplot_binary_t :
         for(auto sf: rspav) {
           vector<tec_real_t> vals( num_nodes );
           for(auto v: m.vertices()) vals[v.id()] = sf[v];
-          status = TECDAT112( &num_nodes, vals.data(), &VIsDouble );
+          status = write_data( num_nodes, vals );
           assert( status == 0 && "error with TECDAT" );
         } // for
         for(auto sf: ispav) {
           // cast int fields to real_t
           vector<tec_real_t> vals( num_nodes );
           for(auto v: m.vertices()) vals[v.id()] = (tec_real_t)sf[v];
-          status = TECDAT112( &num_nodes, vals.data(), &VIsDouble );
+          status = write_data( num_nodes, vals );
           assert( status == 0 && "error with TECDAT" );
         } // for
         for(auto vf: rvpav) {
           for(int d=0; d < num_dims; ++d) {
             vector<tec_real_t> vals( num_nodes );
             for(auto v: m.vertices()) vals[v.id()] = vf[v][d];
-            status = TECDAT112( &num_nodes, vals.data(), &VIsDouble );
+            status = write_data( num_nodes, vals );
             assert( status == 0 && "error with TECDAT" );
           } // for
         } // for
@@ -984,7 +1008,7 @@ struct burton_io_tecplot_binary_t :
         size_t cid = 0;
         vector<tec_real_t> vals( num_elem_this_zone );
         for(auto c: elem_this_zone) vals[cid++] = sf[c];
-        status = TECDAT112( &num_elem_this_zone, vals.data(), &VIsDouble );
+        status = write_data( num_elem_this_zone, vals );
         assert( status == 0 && "error with TECDAT" );
       } // for
       for(auto sf: ispac) {
@@ -992,7 +1016,7 @@ struct burton_io_tecplot_binary_t :
         size_t cid = 0;
         vector<tec_real_t> vals( num_elem_this_zone );
         for(auto c: elem_this_zone) vals[cid++] = (tec_real_t)sf[c];
-        status = TECDAT112( &num_elem_this_zone, vals.data(), &VIsDouble );
+        status = write_data( num_elem_this_zone, vals );
         assert( status == 0 && "error with TECDAT" );
       } // for
       for(auto vf: rvpac) {
@@ -1000,7 +1024,7 @@ struct burton_io_tecplot_binary_t :
           size_t cid = 0;
           vector<tec_real_t> vals( num_elem_this_zone );
           for(auto c: elem_this_zone) vals[cid++] = vf[c][d];
-          status = TECDAT112( &num_elem_this_zone, vals.data(), &VIsDouble );
+          status = write_data( num_elem_this_zone, vals );
           assert( status == 0 && "error with TECDAT" );
         } // for
       } // for
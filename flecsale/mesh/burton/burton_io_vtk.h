@@ -5,15 +5,17 @@
 ////////////////////////////////////////////////////////////////////////////////
 /// \file
 /// \brief This file defines the vtk reader and writer.  
-/// \details There are two versions, one uses the vtk library and the other
-///          uses a native reader.
+/// \details Files are always written with the native writer.  Reading
+///          requires the vtk library.
 ////////////////////////////////////////////////////////////////////////////////
 
 #pragma once
 
 // user includes
 #include "flecsi/io/io_base.h"
+#include "flecsale/io/vtk.h"
 #include "flecsale/mesh/burton/burton_mesh.h"
+#include "flecsale/mesh/output_profile.h"
 #include "flecsale/mesh/vtk_utils.h"
 #include "flecsale/utils/errors.h"
 
@@ -26,7 +28,6 @@
 
 #ifdef HAVE_VTK
 #  include <vtkUnstructuredGridReader.h>
-#  include <vtkUnstructuredGridWriter.h>
 #endif
 
 
@@ -36,8 +37,11 @@
 #endif
 
 // system includes
+#include <algorithm>
 #include <cstring>
 #include <fstream>
+#include <numeric>
+#include <vector>
 
 
 namespace flecsale {
@@ -60,87 +64,22 @@ public:
   //! Default constructor
   burton_io_vtk_t() {}
 
-#if HAVE_VTK
-
-
   //============================================================================
   //! \brief Implementation of vtk mesh write for burton specialization.
   //!
-  //! \param[in] name Write burton mesh \e m to \e name.
-  //! \param[in] m Burton mesh to write to \e name.
-  //!
-  //! \return error code. 0 on success.
-  //!
-  //! FIXME: should allow for const mesh_t &
-  //!
-  //! \remark this uses in vtk library writer
-  //============================================================================
-  int write( const std::string &name, mesh_t &m, bool binary ) override
-  {
-
-    std::cout << "Writing mesh to: " << name << std::endl;
-
-    // convert to vtk
-    auto ug = to_vtk( m );
-
-    // write to file
-    auto writer = vtkSmartPointer<vtkUnstructuredGridWriter>::New();
-    writer->SetFileName( name.c_str() );
-    writer->SetInputDataObject( ug );
-    if ( binary ) writer->SetFileTypeToBinary();
-    else          writer->SetFileTypeToASCII();
-
-    writer->Write();
-
-    return 0;
-
-
-  }
-
-
-  //============================================================================
-  //! \brief Implementation of vtk mesh read for burton specialization.
-  //!
-  //! \param[in] name Read burton mesh \e m to \e name.
-  //! \param[in] m Burton mesh to Read to \e name.
-  //!
-  //! \return error code. 0 on success.
-  //!
-  //! \remark this uses in vtk library reader
-  //============================================================================
-  int read( const std::string &name, mesh_t &m) override
-  {
-
-    std::cout << "Reading mesh from: " << name << std::endl;
-
-
-    // Read solution
-    auto reader = vtkSmartPointer<vtkUnstructuredGridReader>::New();
-    reader->SetFileName( name.c_str() );
-    reader->Update();
-    auto ug = reader->GetOutput();
-    
-    // convert vtk solution to a mesh
-    m = to_mesh<mesh_t>( ug );
-
-    return 0;
-
-  };
-
-
-#else
-
-  //============================================================================
-  //! \brief Implementation of vtk mesh write for burton specialization.
+  //! Only the fields, regions and precision selected by the mesh's output
+  //! profile are written.  Only the vertices of the written cells are 
+  //! output.
   //!
   //! \param[in] name Write burton mesh \e m to \e name.
   //! \param[in] m Burton mesh to write to \e name.
+  //! \param[in] binary  If true, write a binary file.
   //!
   //! \return vtk error code. 0 on success.
   //!
   //! FIXME: should allow for const mesh_t &
   //! 
-  //! \remark this uses in house vtk writer
+  //! \remark this uses the in house vtk writer, with or without vtk
   //============================================================================
   int write( const std::string &name, mesh_t &m, bool binary ) override
   {
@@ -159,19 +98,37 @@ public:
     using integer_t= typename mesh_t::integer_t;
     using vector_t = typename mesh_t::vector_t;
 
+    // legacy vtk files always store 32-bit ids
+    using    id_t  = int;
+
 
     // a lambda function for validating strings
     auto validate_string = []( auto && str ) {
       return std::forward<decltype(str)>(str);
     };
 
+    // what to write
+    const auto & format = m.output_profile().get( name );
+    auto cells = format.select_cells( m.cells() );
+
     // get the general statistics
     constexpr auto num_dims  = mesh_t::num_dimensions;
-    auto num_nodes = m.num_vertices();
-    auto num_elem  = m.num_cells();
-
-    // set the time
-    auto soln_time = m.time();
+    auto num_elem  = cells.size();
+
+    // figure out which vertices are needed, keeping their order
+    vector<char> used( m.num_vertices(), 0 );
+    for ( auto c : cells )
+      for ( auto v : m.vertices( c ) ) used[ v.id() ] = 1;
+
+    vector<id_t> vertex_map( m.num_vertices(), -1 );
+    vector<size_t> points;
+    points.reserve( m.num_vertices() );
+    for ( size_t i=0; i<used.size(); i++ )
+      if ( used[i] ) {
+        vertex_map[i] = points.size();
+        points.emplace_back( i );
+      }
+    auto num_nodes = points.size();
 
     //--------------------------------------------------------------------------
     // WRITE HEADERS
@@ -200,9 +157,10 @@ public:
     vector<real_t> vals( num_nodes * 3 );
 
     // get the coordinates from the mesh. unstructured always 3d
-    for (auto v : m.vertices()) {
-      const auto & coord = v->coordinates();
-      auto base = 3*v.id();
+    auto vs = m.vertices();
+    for ( size_t j=0; j<num_nodes; j++ ) {
+      const auto & coord = vs[ points[j] ]->coordinates();
+      auto base = 3*j;
       for ( int i=0; i<num_dims; i++ ) vals[ base + i ] = coord[i];
       for ( int i=num_dims; i<3; i++ ) vals[ base + i ] = 0.0;
     } // for
@@ -214,31 +172,28 @@ public:
     //----------------------------------------------------------------------------
     // ellement connectivity
     
-    vector< vector<vtkIdType> > elem_conn( num_elem );
+    vector< vector<id_t> > elem_conn( num_elem );
     vector< vtk_writer::cell_type_t > elem_types( num_elem );
 
     // element definitions
     if ( N ==2 ) {
 
-      for (auto c : m.cells()) {
-        auto cid = c.id();
-        auto elem_verts = m.vertices(c);
+      for ( size_t cid=0; cid<num_elem; cid++ ) {
+        auto elem_verts = m.vertices( cells[cid] );
         auto num_nodes_per_elem = elem_verts.size();
         elem_conn[cid].resize( num_nodes_per_elem );
         size_t vid = 0;
-        for (auto v : elem_verts) elem_conn[cid][vid++] = v.id();
+        for (auto v : elem_verts) elem_conn[cid][vid++] = vertex_map[ v.id() ];
         elem_types[cid] = vtk_writer::cell_type_t::polygon;
       } // for
 
     }
     else if ( N == 3 ) {
 
-      for (auto c : m.cells()) {
-        auto cid = c.id();
+      for ( size_t cid=0; cid<num_elem; cid++ ) {
+        auto c = cells[cid];
         // get the element verts and faces
-        auto elem_verts = m.vertices(c);
         auto elem_faces = m.faces(c);
-        auto num_elem_verts = elem_verts.size();
         auto num_elem_faces = elem_faces.size();
         // get the total number of vertices
         auto tot_verts = std::accumulate( 
@@ -255,10 +210,10 @@ public:
           auto face_verts = m.vertices(f);
           auto num_face_verts = face_verts.size();
           // copy the face vert ids
-          vector< size_t > face_vert_ids( num_face_verts );
+          vector< id_t > face_vert_ids( num_face_verts );
           std::transform( 
             face_verts.begin(), face_verts.end(), face_vert_ids.begin(),
-            [](auto && v) { return v.id(); } 
+            [&](auto && v) { return vertex_map[ v.id() ]; } 
           );
           // check the direction of the vertices
           if ( face_elems[0] != c ) 
@@ -281,6 +236,20 @@ public:
     status = writer.write_elements( elem_conn, elem_types.data() );
     assert( status == 0 && "error with element conn" );
 
+    //----------------------------------------------------------------------------
+    // field data
+
+    // real values are down-converted to single precision if asked to
+    vector<float> fvals;
+    auto write_reals = [&]( const auto & label, const auto & data, 
+      std::size_t ncomps ) 
+    {
+      if ( !format.is_single_precision() ) 
+        return writer.write_field( label.c_str(), data, ncomps );
+      fvals.assign( data.begin(), data.end() );
+      return writer.write_field( label.c_str(), fvals, ncomps );
+    };
+
     //----------------------------------------------------------------------------
     // nodal field data
 
@@ -291,23 +260,23 @@ public:
     vector<integer_t> ivals( num_nodes );
 
     // real scalars persistent at vertices
-    auto rspav = flecsi_get_accessors_all(
+    auto rspav = format.select_fields( flecsi_get_accessors_all(
       m, real_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
-    );
+    ) );
     for(auto sf: rspav) {
       auto label = validate_string( sf.label() );
-      for(auto v: m.vertices()) vals[v.id()] = sf[v];
-      status = writer.write_field( label.c_str(), vals );
+      for ( size_t j=0; j<num_nodes; j++ ) vals[j] = sf[ vs[ points[j] ] ];
+      status = write_reals( label, vals, 1 );
       assert( status == 0 && "error with point data" );
     } // for
 
     // int scalars persistent at vertices
-    auto ispav = flecsi_get_accessors_all(
+    auto ispav = format.select_fields( flecsi_get_accessors_all(
       m, integer_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
-    );
+    ) );
     for(auto sf: ispav) {
       auto label = validate_string( sf.label() );
-      for(auto v: m.vertices()) ivals[v.id()] = sf[v];
+      for ( size_t j=0; j<num_nodes; j++ ) ivals[j] = sf[ vs[ points[j] ] ];
       status = writer.write_field( label.c_str(), ivals );
       assert( status == 0 && "error with point data" );
     } // for
@@ -315,17 +284,17 @@ public:
     vals.resize( num_nodes * num_dims );
 
     // real vectors persistent at vertices
-    auto rvpav = flecsi_get_accessors_all(
+    auto rvpav = format.select_fields( flecsi_get_accessors_all(
       m, vector_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
-    );
+    ) );
     for(auto vf: rvpav) {
       auto label = validate_string( vf.label() );
-      for(auto v: m.vertices()) {
-        const auto & vec = vf[v];
+      for ( size_t j=0; j<num_nodes; j++ ) {
+        const auto & vec = vf[ vs[ points[j] ] ];
         for ( int i=0; i<num_dims; i++ ) 
-          vals[ num_dims*v.id() + i ] = vec[i];
+          vals[ num_dims*j + i ] = vec[i];
       } // for
-      status = writer.write_field( label.c_str(), vals, num_dims );
+      status = write_reals( label, vals, num_dims );
       assert( status == 0 && "error with cell data" );
     } // for
 
@@ -342,23 +311,23 @@ public:
     // element field data
 
     // real scalars persistent at cells
-    auto rspac = flecsi_get_accessors_all(
+    auto rspac = format.select_fields( flecsi_get_accessors_all(
       m, real_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
-    );
+    ) );
     for(auto sf: rspac) {
       auto label = validate_string( sf.label() );
-      for(auto c: m.cells()) vals[c.id()] = sf[c];
-      status = writer.write_field( label.c_str(), vals );
+      for ( size_t j=0; j<num_elem; j++ ) vals[j] = sf[ cells[j] ];
+      status = write_reals( label, vals, 1 );
       assert( status == 0 && "error with cell data" );
     } // for
 
     // int scalars persistent at cells
-    auto ispac = flecsi_get_accessors_all(
+    auto ispac = format.select_fields( flecsi_get_accessors_all(
       m, integer_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
-    );
+    ) );
     for(auto sf: ispac) {
       auto label = validate_string( sf.label() );
-      for(auto c: m.cells()) ivals[c.id()] = sf[c];
+      for ( size_t j=0; j<num_elem; j++ ) ivals[j] = sf[ cells[j] ];
       status = writer.write_field( label.c_str(), ivals );
       assert( status == 0 && "error with cell data" );
     } // for
@@ -366,17 +335,17 @@ public:
     vals.resize( num_elem * num_dims );
 
     // real vectors persistent at cells
-    auto rvpac = flecsi_get_accessors_all(
+    auto rvpac = format.select_fields( flecsi_get_accessors_all(
       m, vector_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
-    );
+    ) );
     for(auto vf: rvpac) {
       auto label = validate_string( vf.label() );
-      for(auto c: m.cells()) {
-        const auto & vec = vf[c];
+      for ( size_t j=0; j<num_elem; j++ ) {
+        const auto & vec = vf[ cells[j] ];
         for ( int i=0; i<num_dims; i++ ) 
-          vals[ num_dims*c.id() + i ] = vec[i];
+          vals[ num_dims*j + i ] = vec[i];
       } // for
-      status = writer.write_field( label.c_str(), vals, num_dims );
+      status = write_reals( label, vals, num_dims );
       assert( status == 0 && "error with cell data" );
     } // for
 
@@ -399,17 +368,38 @@ public:
   //! \param[in] name Read burton mesh \e m to \e name.
   //! \param[in] m Burton mesh to Read to \e name.
   //!
-  //! \return vtk error code. 0 on success.
+  //! \return error code. 0 on success.
   //!
-  //! \remark no read support using in house vtk writer
+  //! \remark this uses in vtk library reader
   //============================================================================
   int read( const std::string &name, mesh_t &m) override
   {
+
+#ifdef HAVE_VTK
+
+    std::cout << "Reading mesh from: " << name << std::endl;
+
+
+    // Read solution
+    auto reader = vtkSmartPointer<vtkUnstructuredGridReader>::New();
+    reader->SetFileName( name.c_str() );
+    reader->Update();
+    auto ug = reader->GetOutput();
+    
+    // convert vtk solution to a mesh
+    m = to_mesh<mesh_t>( ug );
+
+    return 0;
+
+#else
+
     raise_implemented_error( "No vtk read functionality has been implemented" );
-  };
 
 #endif // HAVE_VTK
 
+  };
+
+
   //============================================================================
   //! \brief Implementation of vtk mesh write for burton specialization.
   //!
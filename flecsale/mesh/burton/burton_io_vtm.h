@@ -11,11 +11,14 @@
 
 // user includes
 #include "flecsi/io/io_base.h"
+#include "flecsale/io/vtu.h"
+#include "flecsale/mesh/burton/burton_io_vtu.h"
 #include "flecsale/mesh/burton/burton_mesh.h"
 #ifdef HAVE_VTK
 #include "flecsale/mesh/vtk_utils.h"
 #endif
 #include "flecsale/utils/errors.h"
+#include "flecsale/utils/string_utils.h"
 
 // vtk doesnt like double-precision
 #ifdef DOUBLE_PRECISION
@@ -38,6 +41,8 @@
 // system includes
 #include <cstring>
 #include <fstream>
+#include <string>
+#include <vector>
 
 
 namespace flecsale {
@@ -67,243 +72,40 @@ public:
   int write( const std::string &name, burton_mesh_2d_t &m ) override
   {
 
-#ifdef HAVE_VTK
-
     std::cout << "Writing mesh to: " << name << std::endl;
 
     // alias some types
     using std::string;
     using std::vector;
 
-    using   mesh_t = burton_mesh_2d_t;
-    using   size_t = typename mesh_t::size_t;
-    using   real_t = typename mesh_t::real_t;
-    using integer_t= typename mesh_t::integer_t;
-    using vector_t = typename mesh_t::vector_t;
-    using vertex_t = typename mesh_t::vertex_t;
-
-
-    // a lambda function for validating strings
-    auto validate_string = []( auto && str ) {
-      return std::forward<decltype(str)>(str);
-    };
-
     //--------------------------------------------------------------------------
     // Write Blocks
     //--------------------------------------------------------------------------
 
-    // get the regions
-    auto region_cells = m.regions();
-    auto num_regions = m.num_regions();
-
-    // vtkMultiBlockDataSet respresents multi-block datasets. See
-    // the class documentation for more information.
-    auto mb = vtkSmartPointer<vtkMultiBlockDataSet>::New();
-    
-    for ( int iblk=0; iblk<num_regions; iblk++ ) {
-
-      // creat unstructured grid
-      auto ug = vtkSmartPointer<vtkUnstructuredGrid>::New();
-
-      //------------------------------------------------------------------------
-      // Connectivity
-
-      // the cells for this bloci
-      const auto & cells_this_block = region_cells[iblk];
-      auto num_cells_this_block = cells_this_block.size();
-
-      // get points for this block
-      std::unordered_map< vertex_t*, size_t > points_this_block;
-      for ( auto c : cells_this_block )
-        for ( auto v : m.vertices(c) ) {
-          auto id = points_this_block.size();;
-          points_this_block.emplace( std::make_pair( v, id ) );
-        }
-      auto num_vertices = points_this_block.size(); 
-
-      // create point storage
-      auto points = vtkPoints::New();
-      points->SetNumberOfPoints( num_vertices );
-      
-      // now create the vtk points, and create local ids
-      for ( auto v : points_this_block ) {
-        auto id =  v.second;
-        auto coord = v.first->coordinates();
-        real_t x[3] = {0, 0, 0};
-        std::copy( coord.begin(), coord.end(), x );
-        points->SetPoint( id, x );
-      }
-
-      // transfer the points
-      ug->SetPoints(points);
-      points->Delete();
-
-      // create the cells
-      for ( auto c : cells_this_block ) {
-        // get the vertices in this cell
-        auto vs = m.vertices(c);
-        auto n = vs.size();
-        // copy them to the vtk type
-        std::vector< vtkIdType > ids(n);
-        std::transform( vs.begin(), vs.end(), ids.begin(),
-          [&](auto && v) { return points_this_block.at(v); } );
-        // set the cell vertices
-        ug->InsertNextCell(VTK_POLYGON, n, ids.data());
-      }
+    // each region goes in its own vtu file, next to the vtm file.  Only
+    // owned cells are written.
+    auto num_regions = m.regions().size();
 
-      //------------------------------------------------------------------------
-      // nodal field data
-
-      // get the point data object
-      auto pd = ug->GetPointData();
+    auto ext = utils::file_extension( name );
+    auto base = name.substr( 0, name.size() - ext.size() - 1 );
 
-      // real scalars persistent at vertices
-      auto rvals = vtk_array_t<real_t>::type::New();
-      rvals->SetNumberOfValues( num_vertices );
-      
-      auto rspav = flecsi_get_accessors_all(
-        m, real_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
-      );
-      for(auto sf: rspav) {
-        auto label = validate_string( sf.label() );      
-        rvals->SetName( label.c_str() );
-        auto vid = 0;
-        for(auto v : points_this_block) rvals->SetValue( vid++, sf[v.first] );
-        pd->AddArray( rvals );
-      } // for
+    // regions that are filtered out get no block at all
+    const auto & format = m.output_profile().get( name );
 
-      rvals->Delete();
-
-      // int scalars persistent at vertices
-      auto ivals = vtk_array_t<integer_t>::type::New();
-      ivals->SetNumberOfValues( num_vertices );
-
-      auto ispav = flecsi_get_accessors_all(
-        m, integer_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
-      );
-      for(auto sf: ispav) {
-        auto label = validate_string( sf.label() );
-        ivals->SetName( label.c_str() );
-        auto vid = 0;
-        for(auto v: points_this_block) ivals->SetValue( vid++, sf[v.first] );
-        pd->AddArray( ivals );
-      } // for
-    
-      ivals->Delete();
-
-      // real vectors persistent at vertices
-      auto vvals = vtk_array_t<real_t>::type::New();
-      vvals->SetNumberOfComponents( 3 ); // always 3d
-      vvals->SetNumberOfTuples( num_vertices );
-
-      auto rvpav = flecsi_get_accessors_all(
-        m, vector_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
-      );
-      for(auto vf: rvpav) {
-        auto label = validate_string( vf.label() );
-        vvals->SetName( label.c_str() );
-        auto vid = 0;
-        for(auto v: points_this_block) {
-          real_t to_vals[3] = {0, 0, 0};
-          auto & from_vals = vf[v.first];
-          std::copy( from_vals.begin(), from_vals.end(), to_vals );
-          vvals->SetTuple( vid++, to_vals );
-        } // for
-        pd->AddArray( vvals );
-      } // for
-
-      vvals->Delete();
-
-
-      //------------------------------------------------------------------------
-      // cell field data header
-
-      // get the point data object
-      auto cd = ug->GetCellData();
-
-      // real scalars persistent at cells
-      rvals = vtk_array_t<real_t>::type::New();
-      rvals->SetNumberOfValues( num_cells_this_block );
-
-      auto rspac = flecsi_get_accessors_all(
-        m, real_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
-      );
-      for(auto sf: rspac) {
-        auto label = validate_string( sf.label() );      
-        rvals->SetName( label.c_str() );
-        size_t cid = 0;
-        for(auto c: cells_this_block) rvals->SetValue( cid++, sf[c] );
-        cd->AddArray( rvals );
-      } // for
-
-      rvals->Delete();
-
-      // int scalars persistent at cells
-      ivals = vtk_array_t<integer_t>::type::New();
-      ivals->SetNumberOfValues( num_cells_this_block );
-
-      auto ispac = flecsi_get_accessors_all(
-        m, integer_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
-      );
-      for(auto sf: ispac) {
-        auto label = validate_string( sf.label() );
-        ivals->SetName( label.c_str() );
-        size_t cid = 0;
-        for(auto c: cells_this_block) ivals->SetValue( cid++, sf[c] );
-        cd->AddArray( ivals );
-      } // for
-    
-      ivals->Delete();
-
-      // real vectors persistent at cells
-      vvals = vtk_array_t<real_t>::type::New();
-      vvals->SetNumberOfComponents( 3 ); // always 3d
-      vvals->SetNumberOfTuples( num_cells_this_block );
-
-      auto rvpac = flecsi_get_accessors_all(
-        m, vector_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
-      );
-      for(auto vf: rvpac) {
-        auto label = validate_string( vf.label() );
-        vvals->SetName( label.c_str() );
-        size_t cid = 0;
-        for(auto c: cells_this_block) {
-          real_t to_vals[3] = {0, 0, 0};
-          auto & from_vals = vf[c];
-          std::copy( from_vals.begin(), from_vals.end(), to_vals );
-          vvals->SetTuple( cid++, to_vals );
-        } // for
-        cd->AddArray( vvals );
-      } // for
-
-      vvals->Delete();
-
-      //------------------------------------------------------------------------
-      // Finalize block
-
-      // Add the structured grid to the multi-block dataset
-      mb->SetBlock(iblk, ug);
+    vector<string> blocks;
+    io::vtu_writer writer;
     
+    for ( size_t iblk=0; iblk<num_regions; iblk++ ) {
+      if ( !format.writes_region( iblk ) ) continue;
+      auto block_name = base + "_" + std::to_string(iblk) + ".vtu";
+      auto status = write_vtu( 
+        block_name, m, m.owned_region_cells(iblk), format, writer );
+      if ( status ) return status;
+      blocks.emplace_back( utils::basename( block_name ) );
     } // block
 
-    // write to file
-    auto writer = vtkSmartPointer<vtkXMLMultiBlockDataWriter>::New();
-    writer->SetFileName( name.c_str() );
-    writer->SetInputDataObject( mb );
-
-    writer->Write();
-
-    return 0;
-
-#else
-
-    std::cerr << "FLECSI not build with vtk support." << std::endl;
-    std::exit(1);
-
-    return -1;
-
-#endif
-
+    // now the file that ties them together
+    return io::vtu_writer::write_multiblock( name.c_str(), blocks );
 
   }
 
@@ -530,9 +332,7 @@ public:
     m.init();
 
     // override the region ids
-    for ( auto c : m.cells() )
-      c->region() = region_ids[c.id()];
-    m.set_num_regions( num_blocks );
+    m.set_regions( region_ids.data(), num_blocks );
 
     //--------------------------------------------------------------------------
     // Clean up
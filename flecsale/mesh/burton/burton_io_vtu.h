@@ -12,7 +12,9 @@
 
 // user includes
 #include "flecsi/io/io_base.h"
+#include "flecsale/io/vtu.h"
 #include "flecsale/mesh/burton/burton_mesh.h"
+#include "flecsale/mesh/output_profile.h"
 #ifdef HAVE_VTK
 #include "flecsale/mesh/vtk_utils.h"
 #endif
@@ -38,11 +40,343 @@
 // system includes
 #include <cstring>
 #include <fstream>
+#include <numeric>
+#include <type_traits>
+#include <vector>
 
 namespace flecsale {
 namespace mesh {
 namespace burton {
 
+namespace detail {
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Hand a field to a vtu writer as it is.
+//! \param [in,out] writer  The writer to use.
+//! \param [in] label  The field name.
+//! \param [in] data  The values.
+//! \param [in] num_comps  The number of components.
+//! \param [in] points_data  True for point fields, false for cell fields.
+//! \return 0 on success.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+auto put_vtu_field(
+  io::vtu_writer & writer, const std::string & label, const T * data,
+  std::size_t num_comps, bool points_data )
+{
+  return points_data ?
+    writer.write_point_field( label.c_str(), data, num_comps ) :
+    writer.write_cell_field( label.c_str(), data, num_comps );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Hand a non-real field to a vtu writer, which is never converted.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+auto put_vtu_field(
+  io::vtu_writer & writer, const std::string & label, const T * data,
+  std::size_t, std::size_t num_comps, bool points_data,
+  const output_format_t &, std::false_type )
+{
+  return put_vtu_field( writer, label, data, num_comps, points_data );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Hand a real field to a vtu writer, down-converting it to single
+//!        precision if the format asks for it.
+//! \param [in] size  The number of values.
+//! \param [in] format  The output format.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+auto put_vtu_field(
+  io::vtu_writer & writer, const std::string & label, const T * data,
+  std::size_t size, std::size_t num_comps, bool points_data,
+  const output_format_t & format, std::true_type )
+{
+  if ( !format.is_single_precision() )
+    return put_vtu_field( writer, label, data, num_comps, points_data );
+  std::vector<float> tmp( size );
+  #pragma omp parallel for
+  for ( std::size_t i=0; i<size; i++ ) tmp[i] = data[i];
+  return put_vtu_field( writer, label, tmp.data(), num_comps, points_data );
+}
+
+} // namespace detail
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Write some of the cells of a mesh to a vtu file.
+//!
+//! Only the cells of the regions selected by the output format, and their
+//! vertices, are written.  Real fields are stored lossily if the format has
+//! an error bound.  If all the cells are written, in order, the 
+//! fields are handed to the writer without copying them.
+//!
+//! \param [in] name  The name of the file to write.
+//! \param [in] m  The mesh to write.
+//! \param [in] cell_list  The cells to write.
+//! \param [in] format  Selects the fields, regions, precision and error 
+//!                     bound.
+//! \param [in,out] writer  The writer to use.  It knows what was written 
+//!                         afterwards.  On failure, the partial file and 
+//!                         its spooled data are removed.
+//! \tparam M  The mesh type.
+//! \tparam C  The cell collection type.
+//! \return 0 on success.
+////////////////////////////////////////////////////////////////////////////////
+template< typename M, typename C >
+int write_vtu(
+  const std::string & name, M & m, const C & cell_list, 
+  const output_format_t & format, io::vtu_writer & writer )
+{
+
+  // alias some types
+  using std::vector;
+  using io::vtu_writer;
+
+  using   real_t = typename M::real_t;
+  using integer_t= typename M::integer_t;
+  using vector_t = typename M::vector_t;
+  using    id_t  = long;
+
+  constexpr auto num_dims = M::num_dimensions;
+  auto cells = format.select_cells( cell_list );
+  auto num_cells = cells.size();
+  auto vs = m.vertices();
+
+  //----------------------------------------------------------------------------
+  // figure out which vertices are needed, keeping their order
+
+  vector<char> used( m.num_vertices(), 0 );
+  #pragma omp parallel for
+  for ( std::size_t i=0; i<num_cells; i++ )
+    for ( auto v : m.vertices( cells[i] ) ) used[ v.id() ] = 1;
+
+  vector<id_t> vertex_map( m.num_vertices(), -1 );
+  vector<std::size_t> points;
+  points.reserve( m.num_vertices() );
+  for ( std::size_t i=0; i<used.size(); i++ )
+    if ( used[i] ) {
+      vertex_map[i] = points.size();
+      points.emplace_back( i );
+    }
+  auto num_points = points.size();
+
+  auto all_points = ( num_points == m.num_vertices() );
+  auto all_cells = ( num_cells == m.num_cells() );
+
+  //----------------------------------------------------------------------------
+  // open the file
+
+  // whether this fails or throws, nothing is left half written
+  struct abort_guard_t {
+    vtu_writer & writer;
+    ~abort_guard_t() { writer.abort(); }
+  } guard{ writer };
+
+  auto status = writer.open( name.c_str() );
+  if ( status ) return status;
+
+  if ( format.is_lossy() )
+    writer.set_lossy( io::lossy_codec( 
+      format.relative_error ? 
+      io::lossy_codec::bound_t::relative : io::lossy_codec::bound_t::absolute,
+      format.error_bound ) );
+  else
+    writer.clear_lossy();
+
+  //----------------------------------------------------------------------------
+  // coordinates, always 3d
+
+  {
+    vector<real_t> coords( 3*num_points, 0 );
+    #pragma omp parallel for
+    for ( std::size_t i=0; i<num_points; i++ ) {
+      const auto & x = vs[ points[i] ]->coordinates();
+      for ( int d=0; d<num_dims; d++ ) coords[ 3*i + d ] = x[d];
+    }
+    status = writer.write_points( coords.data(), num_points );
+    if ( status ) return status;
+  }
+
+  //----------------------------------------------------------------------------
+  // connectivity
+
+  {
+    // count first, so each cell can be filled in parallel
+    vector<id_t> offsets( num_cells ), face_offsets;
+    #pragma omp parallel for
+    for ( std::size_t i=0; i<num_cells; i++ )
+      offsets[i] = m.vertices( cells[i] ).size();
+    std::partial_sum( offsets.begin(), offsets.end(), offsets.begin() );
+
+    if ( num_dims == 3 ) {
+      face_offsets.resize( num_cells );
+      #pragma omp parallel for
+      for ( std::size_t i=0; i<num_cells; i++ ) {
+        id_t n = 1;
+        for ( auto f : m.faces( cells[i] ) ) n += m.vertices(f).size() + 1;
+        face_offsets[i] = n;
+      }
+      std::partial_sum( 
+        face_offsets.begin(), face_offsets.end(), face_offsets.begin() );
+    }
+
+    vector<id_t> conn( num_cells ? offsets.back() : 0 );
+    vector<id_t> faces( face_offsets.empty() ? 0 : face_offsets.back() );
+    vector<vtu_writer::cell_type_t> types( num_cells,
+      num_dims == 3 ? 
+      vtu_writer::cell_type_t::polyhedron : vtu_writer::cell_type_t::polygon );
+
+    #pragma omp parallel for
+    for ( std::size_t i=0; i<num_cells; i++ ) {
+      auto c = cells[i];
+      auto pos = i ? offsets[i-1] : 0;
+      for ( auto v : m.vertices(c) ) conn[ pos++ ] = vertex_map[ v.id() ];
+      if ( num_dims != 3 ) continue;
+      // the face stream lists the faces, each with its vertices ordered
+      // outward from the cell
+      pos = i ? face_offsets[i-1] : 0;
+      auto cell_faces = m.faces(c);
+      faces[ pos++ ] = cell_faces.size();
+      for ( auto f : cell_faces ) {
+        auto face_verts = m.vertices(f);
+        auto n = face_verts.size();
+        faces[ pos++ ] = n;
+        auto flip = ( m.cells(f)[0] != c );
+        for ( std::size_t j=0; j<n; j++ ) {
+          auto v = face_verts[ flip ? n-1-j : j ];
+          faces[ pos++ ] = vertex_map[ v.id() ];
+        }
+      }
+    }
+
+    status = writer.write_elements( 
+      conn.data(), offsets.data(), types.data(), num_cells );
+    if ( status ) return status;
+
+    if ( num_dims == 3 ) {
+      status = writer.write_faces( faces.data(), face_offsets.data() );
+      if ( status ) return status;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  // field data
+
+  // hand the values to the writer, down-converting reals to single 
+  // precision if asked to
+  auto put_field = [&]( const std::string & label, const auto * data,
+    std::size_t size, std::size_t num_comps, bool points_data )
+  {
+    using value_t = std::decay_t< decltype( *data ) >;
+    return detail::put_vtu_field( 
+      writer, label, data, size, num_comps, points_data, format,
+      std::is_floating_point<value_t>{} );
+  };
+
+  // gather a field into contiguous storage, unless it already is
+  auto write_field = [&]( auto & f, auto num, auto && entity, bool contiguous,
+    bool points_data ) 
+  {
+    using value_t = std::decay_t< decltype( f[ entity(0) ] ) >;
+    vector<value_t> tmp;
+    const value_t * data = num ? &f[ entity(0) ] : nullptr;
+    if ( !contiguous ) {
+      tmp.resize( num );
+      #pragma omp parallel for
+      for ( std::size_t i=0; i<num; i++ ) tmp[i] = f[ entity(i) ];
+      data = tmp.data();
+    }
+    return put_field( f.label(), data, num, 1, points_data );
+  };
+
+  // vectors are stored as their components, and padded to 3d like the
+  // coordinates
+  auto write_vector_field = [&]( auto & f, auto num, auto && entity,
+    bool contiguous, bool points_data ) 
+  {
+    constexpr std::size_t num_comps = ( num_dims == 2 ) ? 3 : num_dims;
+    vector<real_t> tmp;
+    const real_t * data = num ? &f[ entity(0) ][0] : nullptr;
+    if ( !contiguous || num_comps != num_dims ) {
+      tmp.assign( num*num_comps, 0 );
+      #pragma omp parallel for
+      for ( std::size_t i=0; i<num; i++ ) {
+        const auto & vec = f[ entity(i) ];
+        for ( int d=0; d<num_dims; d++ ) tmp[ num_comps*i + d ] = vec[d];
+      }
+      data = tmp.data();
+    }
+    return put_field( f.label(), data, num*num_comps, num_comps, points_data );
+  };
+
+  auto point_at = [&]( std::size_t i ) { return vs[ points[i] ]; };
+  auto cell_at = [&]( std::size_t i ) { return cells[i]; };
+
+  // persistent at vertices
+  auto rspav = format.select_fields( flecsi_get_accessors_all(
+    m, real_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
+  ) );
+  for(auto sf: rspav) 
+    status |= write_field( sf, num_points, point_at, all_points, true );
+
+  auto ispav = format.select_fields( flecsi_get_accessors_all(
+    m, integer_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
+  ) );
+  for(auto sf: ispav) 
+    status |= write_field( sf, num_points, point_at, all_points, true );
+
+  auto rvpav = format.select_fields( flecsi_get_accessors_all(
+    m, vector_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
+  ) );
+  for(auto vf: rvpav) 
+    status |= write_vector_field( vf, num_points, point_at, all_points, true );
+
+  // persistent at cells
+  auto rspac = format.select_fields( flecsi_get_accessors_all(
+    m, real_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
+  ) );
+  for(auto sf: rspac) 
+    status |= write_field( sf, num_cells, cell_at, all_cells, false );
+
+  auto ispac = format.select_fields( flecsi_get_accessors_all(
+    m, integer_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
+  ) );
+  for(auto sf: ispac) 
+    status |= write_field( sf, num_cells, cell_at, all_cells, false );
+
+  auto rvpac = format.select_fields( flecsi_get_accessors_all(
+    m, vector_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
+  ) );
+  for(auto vf: rvpac) 
+    status |= write_vector_field( vf, num_cells, cell_at, all_cells, false );
+
+  if ( status ) return status;
+
+  //----------------------------------------------------------------------------
+  // write it all out
+
+  return writer.close();
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Return the cells a process writes, i.e. the ones it owns.
+//! \param [in] m  The mesh.
+//! \return The list of cells.
+////////////////////////////////////////////////////////////////////////////////
+template< typename M >
+auto owned_cells( M & m )
+{
+  auto cs = m.cells();
+  using cell_handle_t = std::decay_t< decltype( cs[0] ) >;
+  std::vector<cell_handle_t> owned;
+  auto n = m.num_owned_cells();
+  owned.reserve( n );
+  for ( std::size_t i=0; i<n; i++ ) owned.emplace_back( cs[i] );
+  return owned;
+}
+
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -68,34 +402,23 @@ public:
   //! \return vtu error code. 0 on success.
   //!
   //! FIXME: should allow for const mesh_t &
+  //!
+  //! \remark this uses the in house writer, which compresses the data with
+  //!         io::vtu_writer::default_compression()
   //============================================================================
   int write( const std::string &name, mesh_t &m ) override
   {
 
-#ifdef HAVE_VTK
-
     std::cout << "Writing mesh to: " << name << std::endl;
 
-    // convert to vtk
-    auto ug = to_vtk( m );
-
-    // write to file
-    auto writer = vtkSmartPointer<vtkXMLUnstructuredGridWriter>::New();
-    writer->SetFileName( name.c_str() );
-    writer->SetInputDataObject( ug );
-
-    writer->Write();
-
-    return 0;
-
-#else
-
-    raise_implemented_error( "FLECSI not build with vtk support." );
-
-    return -1;
-
-#endif
-
+    // the native writer does not need vtk.  Distributed meshes only write
+    // the cells they own.
+    const auto & format = m.output_profile().get( name );
+    io::vtu_writer writer;
+    if ( m.is_distributed() ) 
+      return write_vtu( name, m, owned_cells(m), format, writer );
+    else
+      return write_vtu( name, m, m.cells(), format, writer );
 
   } // io_vtu_t::write
 
@@ -11,12 +11,19 @@
 // user includes
 #include "flecsale/mesh/burton/burton_mesh_topology.h"
 #include "flecsale/mesh/burton/burton_types.h"
+#include "flecsale/mesh/connectivity.h"
+#include "flecsale/mesh/halo.h"
+#include "flecsale/mesh/output_profile.h"
 #include "flecsale/utils/errors.h"
+#include "flecsale/utils/radix_sort.h"
 
 #include "flecsi/data/data.h"
 #include "flecsi/execution/task.h"
 
 // system includes
+#include <algorithm>
+#include <limits>
+#include <map>
 #include <set>
 #include <string>
 #include <sstream>
@@ -41,6 +48,48 @@ enum index_spaces_t : size_t {
   wedges,
 };
 
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The optional parts of the mesh, only built when required.
+///
+/// Cells, faces and their geometry, which is all a face-based solver needs,
+/// are always built.  So are edges, since flecsi derives them along with
+/// the faces.
+////////////////////////////////////////////////////////////////////////////////
+enum requirements_t : unsigned {
+  require_none          = 0,
+  //! edge midpoints
+  require_edge_geometry = 1 << 0,
+  //! corners and wedges, with the wedge facet geometry and edge midpoints
+  require_corners       = 1 << 1,
+  require_all           = require_edge_geometry | require_corners
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief How thoroughly is_valid() checks the mesh.
+////////////////////////////////////////////////////////////////////////////////
+enum validation_t : unsigned {
+  //! no checks at all
+  validate_none,
+  //! only check that the face normals point out of their first cell
+  validate_quick,
+  //! also check the corner and wedge connectivity and orientation, when the
+  //! mesh has corners
+  validate_full
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Convert a name, i.e. "none", "quick" or "full", to a validation
+///   level.
+////////////////////////////////////////////////////////////////////////////////
+inline validation_t to_validation( const std::string & name )
+{
+  if ( name == "none" ) return validate_none;
+  else if ( name == "quick" ) return validate_quick;
+  else if ( name == "full" ) return validate_full;
+  raise_runtime_error( "Unknown validation level \"" << name << "\"" );
+  return validate_full;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// \brief Attributes for flecsi.
 ////////////////////////////////////////////////////////////////////////////////
@@ -96,6 +145,12 @@ public:
   //! The type used for loop indexing
   using counter_t = typename config_t::counter_t;
 
+  //! The type of the ids local to this process.
+  using local_id_t = typename config_t::local_id_t;
+
+  //! The type of the ids that are unique across processes.
+  using global_id_t = typename config_t::global_id_t;
+
   //! Point data type.
   using point_t = typename config_t::point_t;
 
@@ -141,38 +196,54 @@ public:
   burton_mesh_t & operator=(const burton_mesh_t &) = default;
 
   //! \brief Copy constructor
+  //!
+  //! The faces and edges are copied straight from the source, in the same
+  //! order, instead of being found again from the cells.  The geometry, tags
+  //! and regions are copied in bulk rather than recomputed.
   burton_mesh_t(const burton_mesh_t &src) {
 
     std::vector<vertex_t*> vs;
+    std::vector<cell_t*> cs;
 
     init_parameters( src.num_vertices() );
 
+    // build the same parts as the source
+    requirements_ = src.requirements_;
+
     // create vertices
+    vs.reserve( src.num_vertices() );
     for ( auto v : src.vertices() ) {
       auto vert = create_vertex( v->coordinates() );
       vs.emplace_back( std::move(vert) );
     }
 
     // create cells
+    cs.reserve( src.num_cells() );
+    std::vector<vertex_t*> elem_vs;
     for ( auto c : src.cells() ) {
-      auto verts = src.vertices( c );
-      auto n = verts.size();
-      std::vector<vertex_t*> elem_vs( n );
-      for ( auto i=0; i<n; i++ ) elem_vs[i] = vs[ verts[i].id() ];
-        create_cell( elem_vs );   
+      elem_vs.clear();
+      for ( auto v : src.vertices( c ) ) elem_vs.emplace_back( vs[ v.id() ] );
+      cs.emplace_back( create_cell( elem_vs ) );
     } // for
 
-    // initialize everything
-    init();
+    // the faces, and edges in 3d, keep their ids
+    copy_sub_entities_<face_t>( src, vs, cs );
+    if ( num_dimensions == 3 ) copy_sub_entities_<edge_t>( src, vs, cs );
 
-    // get the source cells
-    auto src_cells = src.cells();
+    // initialize everything but the geometry, then copy it and the rest of
+    // the state over
+    init_state_();
+    copy_state_( src );
+
+    // the entities were created in the same order, so the ownership and 
+    // sweep lists carry over
+    ownership_ = src.ownership_;
+    cell_sweeps_ = src.cell_sweeps_;
+    face_sweeps_ = src.face_sweeps_;
+    vertex_sweeps_ = src.vertex_sweeps_;
 
-    // override the region ids
-    auto num_reg = src.num_regions();
-    for ( auto c : cells() ) 
-      c->region() = src_cells[c.id()]->region();
-    set_num_regions( num_reg );
+    // and it gets written the same way
+    output_profile_ = src.output_profile_;
   }
 
   //! \brief allow move construction
@@ -183,6 +254,20 @@ public:
   {
     // call the base type operator to move the data
     base_t::operator=(std::move(other));
+    // move the cached sets and the parallel layout
+    face_sets_ = std::move( other.face_sets_ );
+    edge_sets_ = std::move( other.edge_sets_ );
+    vert_sets_ = std::move( other.vert_sets_ );
+    boundary_vertices_ = std::move( other.boundary_vertices_ );
+    boundary_edges_ = std::move( other.boundary_edges_ );
+    boundary_faces_ = std::move( other.boundary_faces_ );
+    region_cells_ = std::move( other.region_cells_ );
+    ownership_ = std::move( other.ownership_ );
+    requirements_ = other.requirements_;
+    output_profile_ = std::move( other.output_profile_ );
+    cell_sweeps_ = std::move( other.cell_sweeps_ );
+    face_sweeps_ = std::move( other.face_sweeps_ );
+    vertex_sweeps_ = std::move( other.vertex_sweeps_ );
     // reset each entity mesh pointer
     for ( auto v : vertices() ) v->reset( *this );
     for ( auto e : edges() ) e->reset( *this );
@@ -384,16 +469,11 @@ public:
       );
   }
 
-  //! \brief Return boundary  vertices in the burton mesh.
-  //! \return Return all boundary vertices in the burton mesh as a sequence for 
-  //!         use, e.g., in range based for loops.
-  decltype(auto) boundary_vertices() const
+  //! \brief Return the ids of the vertices on the domain boundary.
+  //! \remark The ids are sorted and built once by init().
+  const auto & boundary_vertices() const noexcept
   { 
-    auto verts = vertices();
-    auto bnd_verts = verts.filter(
-      [](auto v){ return v->is_boundary(); }
-    );
-    return bnd_verts;
+    return boundary_vertices_;
   }
 
 
@@ -453,16 +533,11 @@ public:
     return base_t::template entity_ids<edge_t::dimension, edge_t::domain>(e);
   }
 
-  //! \brief Return boundary edges in the burton mesh.
-  //! \return Return all boundary vertices in the burton mesh as a sequence for 
-  //!         use, e.g., in range based for loops.
-  decltype(auto) boundary_edges() const
+  //! \brief Return the ids of the edges on the domain boundary.
+  //! \remark The ids are sorted and built once by init().
+  const auto & boundary_edges() const noexcept
   { 
-    auto es = edges();
-    auto bnd_es = es.filter(
-      [](auto e){ return e->is_boundary(); }
-    );
-    return bnd_es;
+    return boundary_edges_;
   }
 
   //============================================================================
@@ -493,6 +568,14 @@ public:
     return base_t::template entities<face_t::dimension, face_t::domain>();
   }
 
+  //! \brief Return the ids of the faces on the domain boundary.
+  //! \remark The ids are sorted and built once by init(), so they can be
+  //!   shared out among threads.
+  const auto & boundary_faces() const noexcept
+  { 
+    return boundary_faces_;
+  }
+
   //! \brief Return faces associated with entity instance of type \e E.
   //!
   //! \tparam E entity type of instance to return faces for.
@@ -860,37 +943,265 @@ public:
 
   //! \brief set the number of regions in the burton mesh.
   //! \param [in]  n  The number of regions in the burton mesh.
+  //! \remark This also rebuilds the cells of each region, so call it after
+  //!   changing the region of any cell directly.
   void set_num_regions(size_t n)
   {
     auto n_acc = flecsi_get_accessor(*this, mesh, num_regions, size_t, global, 0 ) ;
     *n_acc = n;
+    build_region_sets_();
   }
 
 
-  //! \brief Return the number of regions in the burton mesh.
-  //! \param [in]  n  The number of regions in the burton mesh.
+  //! \brief Set the region of each cell.
+  //! \param [in]  region_ids  The region of each cell.
   template< typename T >
   void set_regions(T * region_ids)
   {
     for ( auto c : cells() )
       c->region() = region_ids[c.id()];
+    build_region_sets_();
   }
 
-  //! \brief Return all cells in the regions mesh.
+  //! \brief Set the region of each cell, and the number of regions.
+  //! \param [in]  region_ids  The region of each cell.
+  //! \param [in]  n  The number of regions in the burton mesh.
+  //! \remark The cells of each region are only rebuilt once.
+  template< typename T >
+  void set_regions(T * region_ids, size_t n)
+  {
+    auto n_acc = flecsi_get_accessor(*this, mesh, num_regions, size_t, global, 0 ) ;
+    *n_acc = n;
+    set_regions( region_ids );
+  }
+
+  //! \brief Return the ids of the cells in each region.
   //!
-  //! \return Return all cells in the burton mesh as a sequence for use, e.g.,
-  //!   in range based for loops.
-  decltype(auto) regions()
+  //! \return One sorted list of cell ids per region.  Regions without any
+  //!   cells have empty lists.
+  const auto & regions() const noexcept
+  {
+    return region_cells_;
+  }
+
+  //! \brief Return the ids of the cells in one region.
+  //! \param [in]  r  The region to look up.
+  const auto & region_cells( size_t r ) const
   {
-    // get the number of regions
-    auto n = num_regions();
-    // get the cells
+    return region_cells_.at( r );
+  }
+
+  //! \brief Return the owned cells of one region.
+  //! \param [in]  r  The region to look up.
+  //! \remark The owned cells come first, so they start the region's list.
+  auto owned_region_cells( size_t r )
+  {
+    const auto & ids = region_cells( r );
+    auto last = std::lower_bound( ids.begin(), ids.end(), num_owned_cells() );
     auto cs = cells();
+    std::vector< std::decay_t< decltype( cs[0] ) > > owned;
+    owned.reserve( last - ids.begin() );
+    for ( auto it = ids.begin(); it != last; ++it ) owned.emplace_back( cs[*it] );
+    return owned;
+  }
 
-    // now filter out the cells of each region
-    auto region_cells = cs.bin( [](const auto & c){ return c->region(); } );
+  //============================================================================
+  // Parallel Layout Interface
+  //============================================================================
+
+  //! \brief Return true if this mesh is one part of a distributed mesh.
+  bool is_distributed() const noexcept
+  {
+    return !ownership_.cell_global_ids.empty();
+  }
+
+  //! \brief Return the number of cells owned by this process.
+  //! \remark The owned cells always come first.
+  size_t num_owned_cells() const
+  {
+    return is_distributed() ? ownership_.num_owned_cells : num_cells();
+  }
+
+  //! \brief Return the number of vertices owned by this process.
+  //! \remark The owned vertices always come first.
+  size_t num_owned_vertices() const
+  {
+    return is_distributed() ? ownership_.num_owned_vertices : num_vertices();
+  }
+
+  //! \brief Return the global id of a cell.
+  //! \param [in] c  The cell to look up.
+  template< typename C >
+  global_id_t cell_global_id( C && c ) const
+  {
+    return is_distributed() ? ownership_.cell_global_ids[ c.id() ] : c.id();
+  }
+
+  //! \brief Return the parallel layout of the mesh.
+  const auto & ownership() const noexcept
+  {
+    return ownership_;
+  }
+
+  //! \brief Set the parallel layout of the mesh.
+  //! \param [in] ownership  The description of the owned and ghost entities.
+  void set_ownership( ownership_t ownership )
+  {
+    ownership_ = std::move( ownership );
+    build_sweep_lists_();
+  }
+
+  //============================================================================
+  // Requirements Interface
+  //============================================================================
 
-    return region_cells;
+  //! \brief The parts that new meshes build, see attributes::requirements_t.
+  //!
+  //! Meshes are built in many places, e.g. by the readers and the
+  //! factories, so a solver sets this once before making its mesh.  It
+  //! defaults to building everything.
+  static unsigned & default_requirements() noexcept
+  {
+    static unsigned requirements = attributes::require_all;
+    return requirements;
+  }
+
+  //! \brief The optional parts built by init().
+  unsigned requirements() const noexcept
+  {
+    return requirements_;
+  }
+
+  //! \brief Set the optional parts to build, before init() is called.
+  //! \param [in] requirements  A combination of attributes::requirements_t.
+  void set_requirements( unsigned requirements ) noexcept
+  {
+    requirements_ = requirements;
+  }
+
+  //! \brief Return true if all of the given parts are built.
+  //! \param [in] requirements  A combination of attributes::requirements_t.
+  bool is_required( unsigned requirements ) const noexcept
+  {
+    return ( requirements_ & requirements ) == requirements;
+  }
+
+  //! \brief Return true if the corners and wedges are built.
+  bool has_corners() const noexcept
+  {
+    return is_required( attributes::require_corners );
+  }
+
+  //============================================================================
+  // Output Interface
+  //============================================================================
+
+  //! \brief Return what the writers put in each kind of output file.
+  const auto & output_profile() const noexcept
+  {
+    return output_profile_;
+  }
+
+  //! \brief Set what the writers put in each kind of output file.
+  //! \param [in] profile  The output formats, by file extension.
+  void set_output_profile( output_profile_t profile )
+  {
+    output_profile_ = std::move( profile );
+  }
+
+  //! \brief Store the partition each cell belongs to, and flag it for 
+  //!        output.
+  //! \param [in] parts  The partition of each cell.
+  template< typename P >
+  void set_cell_partition( const P & parts )
+  {
+    auto partition = flecsi_get_accessor(*this, mesh, partition, integer_t, dense, 0);
+    partition.attributes().set( attributes::persistent );
+    for ( auto c : cells() )
+      partition[c] = parts[ c.id() ];
+  }
+
+  //! \brief Return the owned cells whose vertices are all owned.
+  //! \remark These don't need any ghost vertex or corner data.  The halo
+  //!   lists split entities by the ghosts, not by the domain boundary.
+  const auto & halo_interior_cells() const noexcept
+  { return cell_sweeps_.interior; }
+
+  //! \brief Return the owned cells that have a ghost vertex.
+  const auto & halo_boundary_cells() const noexcept
+  { return cell_sweeps_.boundary; }
+
+  //! \brief Return the faces whose cells are all owned.
+  //! \remark These don't need any ghost cell data.
+  const auto & halo_interior_faces() const noexcept
+  { return face_sweeps_.interior; }
+
+  //! \brief Return the faces between an owned and a ghost cell.
+  //! \remark Faces only touching ghost cells appear in neither list, since
+  //!   nothing owned depends on them.
+  const auto & halo_boundary_faces() const noexcept
+  { return face_sweeps_.boundary; }
+
+  //! \brief Return the owned vertices whose cells are all owned.
+  //! \remark These don't need any ghost cell data.
+  const auto & halo_interior_vertices() const noexcept
+  { return vertex_sweeps_.interior; }
+
+  //! \brief Return the owned vertices that touch a ghost cell.
+  const auto & halo_boundary_vertices() const noexcept
+  { return vertex_sweeps_.boundary; }
+
+  //! \brief Update the ghost cells of a cell field with their owners' values.
+  //! \param [in,out] values  The accessor to the cell field.
+  template< typename A >
+  void exchange_cells( A & values )
+  {
+    ownership_.cells.exchange( values, cells() );
+  }
+
+  //! \brief Update the ghost vertices of a vertex field with their owners' 
+  //!        values.
+  //! \param [in,out] values  The accessor to the vertex field.
+  template< typename A >
+  void exchange_vertices( A & values )
+  {
+    ownership_.vertices.exchange( values, vertices() );
+  }
+
+  //! \brief Update the ghost corners of a corner field with their owners' 
+  //!        values.
+  //! \param [in,out] values  The accessor to the corner field.
+  template< typename A >
+  void exchange_corners( A & values )
+  {
+    ownership_.corners.exchange( values, corners() );
+  }
+
+  //! \brief Start updating the ghost cells of a cell field.
+  //! \param [in,out] pending  The exchange to add the field to.
+  //! \param [in,out] values  The accessor to the cell field.
+  template< typename A >
+  void begin_exchange_cells( halo_exchange_t & pending, A & values )
+  {
+    pending.add( ownership_.cells, values, cells() );
+  }
+
+  //! \brief Start updating the ghost vertices of a vertex field.
+  //! \param [in,out] pending  The exchange to add the field to.
+  //! \param [in,out] values  The accessor to the vertex field.
+  template< typename A >
+  void begin_exchange_vertices( halo_exchange_t & pending, A & values )
+  {
+    pending.add( ownership_.vertices, values, vertices() );
+  }
+
+  //! \brief Start updating the ghost corners of a corner field.
+  //! \param [in,out] pending  The exchange to add the field to.
+  //! \param [in,out] values  The accessor to the corner field.
+  template< typename A >
+  void begin_exchange_corners( halo_exchange_t & pending, A & values )
+  {
+    pending.add( ownership_.corners, values, corners() );
   }
 
   //============================================================================
@@ -1030,10 +1341,32 @@ public:
   //! \brief Initialize the burton mesh.
   //!---------------------------------------------------------------------------
   void init()
+  {
+
+    build_connectivity_();
+
+    init_state_();
+
+    // update the geometry
+    update_geometry();
+
+    // everything is owned until told otherwise
+    build_sweep_lists_();
+
+  }
+
+  //!---------------------------------------------------------------------------
+  //! \brief Initialize everything but the geometry and parallel layout,
+  //!   once all the entities exist.
+  //!---------------------------------------------------------------------------
+  void init_state_()
   {
 
     base_t::template init<0>();
-    base_t::template init_bindings<1>();
+
+    // the corners and wedges live in the dual domain
+    if ( is_required( attributes::require_corners ) )
+      base_t::template init_bindings<1>();
 
     //mesh_.dump();
 
@@ -1063,13 +1396,16 @@ public:
     flecsi_register_data(*this, mesh, face_normal, vector_t, dense, 1, attributes::faces);
     flecsi_register_data(*this, mesh, face_midpoint, vector_t, dense, 1, attributes::faces);
 
-    // register edge data
-    flecsi_register_data(*this, mesh, edge_midpoint, vector_t, dense, 1, attributes::edges);
+    // register edge data, which the wedges need too
+    if ( has_edge_geometry_() )
+      flecsi_register_data(*this, mesh, edge_midpoint, vector_t, dense, 1, attributes::edges);
     
     // register wedge data
-    flecsi_register_data(*this, mesh, wedge_facet_area, real_t, dense, 1, attributes::wedges);
-    flecsi_register_data(*this, mesh, wedge_facet_normal, vector_t, dense, 1, attributes::wedges);
-    flecsi_register_data(*this, mesh, wedge_facet_centroid, vector_t, dense, 1, attributes::wedges);
+    if ( is_required( attributes::require_corners ) ) {
+      flecsi_register_data(*this, mesh, wedge_facet_area, real_t, dense, 1, attributes::wedges);
+      flecsi_register_data(*this, mesh, wedge_facet_normal, vector_t, dense, 1, attributes::wedges);
+      flecsi_register_data(*this, mesh, wedge_facet_centroid, vector_t, dense, 1, attributes::wedges);
+    }
     
     // register time state
     flecsi_register_data(*this, mesh, time, real_t, global, 1 );
@@ -1093,23 +1429,38 @@ public:
     flecsi_register_data(*this, mesh, face_tags, tag_list_t, dense, 1, attributes::faces);
     flecsi_register_data(*this, mesh, cell_tags, tag_list_t, dense, 1, attributes::cells);
 
+    // find the boundary faces, i.e. the ones with only one cell
+    auto fs = faces();
+    boundary_faces_ = utils::select_indices<local_id_t>( fs.size(),
+      [&]( auto i ) { return fs[i]->is_boundary(); } );
+
     // now set the boundary flags.
-    for ( auto f : faces() ) {
-      // if there is only one cell, it is a boundary
-      if ( f->is_boundary() ) {
-        // point flags
-        auto ps = vertices(f);
-        for ( auto p : ps ) 
-          point_flags[ p ].setbit( bits::boundary );
-        // edge flags are only for 3d
-        if ( num_dimensions == 3 ) {
-          auto es = edges(f);
-          for ( auto e : es ) 
-            edge_flags[e].setbit( bits::boundary );
-        } // dims
-      } // is_boundary
+    for ( auto i : boundary_faces_ ) {
+      auto f = fs[i];
+      // point flags
+      auto ps = vertices(f);
+      for ( auto p : ps ) 
+        point_flags[ p ].setbit( bits::boundary );
+      // edge flags are only for 3d
+      if ( num_dimensions == 3 ) {
+        auto es = edges(f);
+        for ( auto e : es ) 
+          edge_flags[e].setbit( bits::boundary );
+      } // dims
     } // for
 
+    // and collect the flagged vertices and edges
+    auto vs = vertices();
+    boundary_vertices_ = utils::select_indices<local_id_t>( vs.size(),
+      [&]( auto i ) { return point_flags[ vs[i] ].bitset( bits::boundary ); } );
+    if ( num_dimensions == 3 ) {
+      auto es = edges();
+      boundary_edges_ = utils::select_indices<local_id_t>( es.size(),
+        [&]( auto i ) { return edge_flags[ es[i] ].bitset( bits::boundary ); } );
+    }
+    else
+      boundary_edges_ = boundary_faces_;
+
     // identify the cell regions
     flecsi_register_data(*this, mesh, cell_region, size_t, dense, 1, attributes::cells);
     flecsi_register_data(*this, mesh, num_regions, size_t, global, 1);
@@ -1122,16 +1473,30 @@ public:
     for ( auto c : cells() )
       cell_region[c] = 0;
 
-    // update the geometry
-    update_geometry();
+    build_region_sets_();
+
+    // the partition each cell belongs to, only plotted once it is set
+    flecsi_register_data(*this, mesh, partition, integer_t, dense, 1, attributes::cells);
+    auto partition = flecsi_get_accessor(*this, mesh, partition, integer_t, dense, 0);
+    for ( auto c : cells() )
+      partition[c] = 0;
 
   }
 
 
   //!---------------------------------------------------------------------------
   //! \brief Check the burton mesh.
+  //!
+  //! The checks are done in parallel, and only the entities that fail are
+  //! revisited to report what is wrong with them.
+  //!
+  //! \param [in] level  How thoroughly to check, see attributes::validation_t.
+  //! \param [in] raise_on_error  If true, raise an error on failure instead of
+  //!   printing it.
+  //! \return True if the mesh is valid.
   //!---------------------------------------------------------------------------
-  bool is_valid( bool raise_on_error = true )
+  bool is_valid( 
+    attributes::validation_t level, bool raise_on_error = true )
   {
     // some includes
     using math::dot_product;
@@ -1146,195 +1511,59 @@ public:
           std::cerr << msg.rdbuf() << std::endl;
         return false;
       };
+
+    if ( level == attributes::validate_none ) return true;
     
     // we use a stringstream to construct messages and pass them 
     // simultanesously
     std::stringstream ss;
 
-
     //--------------------------------------------------------------------------
     // make sure face normal points out from first cell
-    bool bad_face = false;
     auto fs = faces();
-    auto num_faces = fs.size();
-    
-    #pragma omp parallel for reduction( || : bad_face )
-    for( counter_t fid=0; fid<num_faces; ++fid ) {
-      auto f = fs[fid];
-      auto n = f->normal();
-      auto fx = f->midpoint();
-      auto c = cells(f).front();
-      auto cx = c->midpoint();
-      auto delta = fx - cx;
-      auto dot = dot_product( n, delta );      
-      if ( dot < 0 ) {
-        bad_face = bad_face || true;
-        #pragma omp critical
-        {
-          ss << "Face " << f.id() << " has opposite normal" << std::endl;
-        }
-      }
-    } 
-
-    if ( bad_face ) return raise_or_return( ss );
-
-
-    //--------------------------------------------------------------------------
-    // check all the corners and wedges
-    bool bad_corner = false;
-    auto cnrs = corners();
-    auto num_corners = cnrs.size();
-
-    //#omp parallel for reduction( || : bad_corner )
-    for( counter_t cnid=0; cnid<num_corners; ++cnid ) {
+    auto face_norm = flecsi_get_accessor(*this, mesh, face_normal, vector_t, dense, 0);
+    auto face_midp = flecsi_get_accessor(*this, mesh, face_midpoint, vector_t, dense, 0); 
 
-      auto cn = cnrs[cnid];
-      auto cs = cells(cn);
-      auto fs = faces(cn);
-      auto es = edges(cn);
-      auto vs = vertices(cn);
-      auto ws = wedges(cn);
+    auto bad_faces = utils::select_indices( fs.size(),
+      [&]( auto i ) {
+        auto f = fs[i];
+        auto c = cells(f).front();
+        auto delta = face_midp[f] - c->midpoint();
+        return dot_product( face_norm[f], delta ) < 0;
+      } );
 
-      if ( cs.size() != 1 ) {
-        #pragma omp critical
-        ss << "Corner " << cn.id() << " has " << cs.size() << "/=1 cells" 
-           << std::endl;
-      }
+    for ( auto i : bad_faces )
+      ss << "Face " << i << " has opposite normal" << std::endl;
 
-      if ( fs.size() != num_dimensions ) {
-        #pragma omp critical
-        {
-          ss << "Corner " << cn.id() << " has " << fs.size() << "/=" 
-             << num_dimensions << " faces" << std::endl;
-        }
-      }
+    if ( !bad_faces.empty() ) return raise_or_return( ss );
 
-      if ( es.size() != num_dimensions ) {
-        #pragma omp critical
-        {
-          ss << "Corner " << cn.id() << " has " << es.size() << "/=" 
-             << num_dimensions << " edges" << std::endl;
-        }
-      }
+    if ( level == attributes::validate_quick ) return true;
 
-      if ( vs.size() != 1 ) {
-        #pragma omp critical
-        {
-          ss << "Corner " << cn.id() << " has " << vs.size() << "/=1 vertices"
-             << std::endl;
-        }
-      }
+    //--------------------------------------------------------------------------
+    // check all the corners and wedges, if there are any
+    if ( !has_corners() ) return true;
 
-      auto cl = cs.front();
-      auto vt = vs.front();
-      
-      if ( ws.size() % 2 != 0 ) {
-        #pragma omp critical
-        {
-          ss << "Corner " << cn.id() << " has " << ws.size() << "%2/=0 wedges"
-             << std::endl;
-        }
-      }
+    auto cnrs = corners();
+    auto wedge_norm = flecsi_get_accessor(*this, mesh, wedge_facet_normal, vector_t, dense, 0);
+    auto bad_corners = utils::select_indices( cnrs.size(),
+      [&]( auto i ) { return !check_corner_( cnrs[i], wedge_norm ); } );
 
-      for ( auto wg = ws.begin(); wg != ws.end();  ) 
-        for ( auto i=0; i<2 && wg != ws.end(); i++, ++wg)
-        {
-          auto cls = cells( *wg );
-          auto fs = faces( *wg );
-          auto es = edges( *wg );
-          auto vs = vertices( *wg );
-          auto cns = corners( *wg );
-          if ( cls.size() != 1 ) {
-            #pragma omp critical
-            {          
-              ss << "Wedge " << (*wg).id() << " has " << cls.size() 
-                 << "/=1 cells" << std::endl;
-            }
-          }
-          if ( fs.size() != 1 ) {
-            #pragma omp critical 
-            {           
-              ss << "Wedge " << (*wg).id() << " has " << fs.size() 
-                 << "/=1 faces" << std::endl;
-            }
-          }
-          if ( es.size() != 1 ) {
-            #pragma omp critical 
-            {
-              ss << "Wedge " << (*wg).id() << " has " << es.size() 
-                 << "/=1 edges" << std::endl;
-            }
-          }
-          if ( vs.size() != 1 ) {
-            #pragma omp critical
-            {
-              ss << "Wedge " << (*wg).id() << " has " << vs.size() 
-                 << "/=1 vertices" << std::endl;
-            }
-          }
-          if ( cns.size() != 1 ) {
-            #pragma omp critical
-            {
-              ss << "Wedge " << (*wg).id() << " has " << cns.size() 
-                 << "/=1 corners" << std::endl;
-            }
-          }
-          auto vert = vs.front();
-          auto cell = cls.front();
-          auto corn = cns.front();
-          if ( vert != vt ) {
-            #pragma omp critical
-            {
-              ss << "Wedge " << (*wg).id() << " has incorrect vertex " 
-                 << vert.id() << "!=" << vt.id() << std::endl;
-            }
-          }
-          if ( cell != cl ) {
-            #pragma omp critical
-            {
-              ss << "Wedge " << (*wg).id() << " has incorrect cell " 
-                 << cell.id() << "!=" << cl.id() << std::endl;
-            }
-          }
-          if ( corn != cn ) {
-            #pragma omp critical
-            {
-              ss << "Wedge " << (*wg).id() << " has incorrect corner " 
-                 << corn.id() << "!=" << cn.id() << std::endl;
-            }
-          }
-          auto fc = fs.front();            
-          auto fx = fc->midpoint();
-          auto cx = cl->midpoint();
-          auto delta = fx - cx;
-          real_t dot;
-          if ( i == 0 ) {
-            auto n = (*wg)->facet_normal_right();
-            dot = dot_product( n, delta );
-          }
-          else {
-            auto n = (*wg)->facet_normal_left();
-            dot = dot_product( n, delta );
-          }
-          if ( dot < 0 ) {
-            #pragma omp critical
-            {
-              ss << "Wedge " << (*wg).id() << " has opposite normal" 
-                 << std::endl;
-            }
-          }
-        } // wedges
-      
-    } // corners
-
-
-    if ( bad_corner ) return raise_or_return( ss );
+    for ( auto i : bad_corners ) check_corner_( cnrs[i], wedge_norm, &ss );
 
+    if ( !bad_corners.empty() ) return raise_or_return( ss );
 
     return true;
 
   }
 
+  //! \brief Check the burton mesh thoroughly.
+  //! \param [in] raise_on_error  If true, raise an error on failure instead of
+  //!   printing it.
+  bool is_valid( bool raise_on_error = true )
+  {
+    return is_valid( attributes::validate_full, raise_on_error );
+  }
+
   //!---------------------------------------------------------------------------
   //! \brief Compute the goemetry.
   //!---------------------------------------------------------------------------
@@ -1343,12 +1572,8 @@ public:
     // get the mesh info
     auto cs = cells();
     auto fs = faces();
-    auto es = edges();  
-    auto cnrs = corners();
     auto num_cells = cs.size();
     auto num_faces = fs.size();
-    auto num_edges = es.size();
-    auto num_corners = cnrs.size();
 
     // get all the data now so we can put everything in one parallel region
     auto cell_center = flecsi_get_accessor(*this, mesh, cell_centroid, vector_t, dense, 0);
@@ -1359,12 +1584,6 @@ public:
     auto face_norm = flecsi_get_accessor(*this, mesh, face_normal, vector_t, dense, 0);
     auto face_midp = flecsi_get_accessor(*this, mesh, face_midpoint, vector_t, dense, 0); 
 
-    auto edge_midp = flecsi_get_accessor(*this, mesh, edge_midpoint, vector_t, dense, 0); 
-
-    auto wedge_facet_normal = flecsi_get_accessor(*this, mesh, wedge_facet_normal, vector_t, dense, 0);
-    auto wedge_facet_area = flecsi_get_accessor(*this, mesh, wedge_facet_area, real_t, dense, 0);
-    auto wedge_facet_centroid = flecsi_get_accessor(*this, mesh, wedge_facet_centroid, vector_t, dense, 0); 
-
     //--------------------------------------------------------------------------
     // compute cell parameters
 
@@ -1382,7 +1601,7 @@ public:
       //--------------------------------------------------------------------------
       // compute face parameters
 
-      #pragma omp for nowait
+      #pragma omp for
       for ( counter_t i=0; i<num_faces; i++ ) {
         auto f = fs[i];
         face_area[f] = f->area();
@@ -1390,64 +1609,95 @@ public:
         face_midp[f] = f->midpoint();
       } 
 
-      //--------------------------------------------------------------------------
-      // compute edge parameters
+    } // end omp parallel
 
-      #pragma omp for
-      for ( counter_t i=0; i<num_edges; i++ ) {
-        auto e = es[i];
-        edge_midp[e] = e->midpoint();
-      } 
+    // the rest is optional
+    if ( has_edge_geometry_() ) update_edge_geometry_();
 
-      //--------------------------------------------------------------------------
-      // compute wedge parameters
+  }
 
-      #pragma omp for
-      for ( counter_t i=0; i<num_corners; ++i ) {
-        auto cn = cnrs[i];
-        auto ws = wedges(cn);
-        // both wedges SHOULD have the same vertex
-        const auto & v = vertices(cn).front()->coordinates();
-        // first compute the normals
-        for ( auto wit = ws.begin(); wit != ws.end(); ++wit ) 
+  //! \brief Update the edge midpoints, and the wedge geometry if required.
+  void update_edge_geometry_()
+  {
+    // get the mesh info
+    auto es = edges();  
+    auto num_edges = es.size();
+
+    auto face_midp = flecsi_get_accessor(*this, mesh, face_midpoint, vector_t, dense, 0); 
+    auto edge_midp = flecsi_get_accessor(*this, mesh, edge_midpoint, vector_t, dense, 0); 
+
+    //--------------------------------------------------------------------------
+    // compute edge parameters
+
+    #pragma omp parallel for
+    for ( counter_t i=0; i<num_edges; i++ ) {
+      auto e = es[i];
+      edge_midp[e] = e->midpoint();
+    } 
+
+    if ( !is_required( attributes::require_corners ) ) return;
+
+    auto cnrs = corners();
+    auto num_corners = cnrs.size();
+
+    auto wedge_facet_normal = flecsi_get_accessor(*this, mesh, wedge_facet_normal, vector_t, dense, 0);
+    auto wedge_facet_area = flecsi_get_accessor(*this, mesh, wedge_facet_area, real_t, dense, 0);
+    auto wedge_facet_centroid = flecsi_get_accessor(*this, mesh, wedge_facet_centroid, vector_t, dense, 0); 
+
+    //--------------------------------------------------------------------------
+    // compute wedge parameters
+
+    #pragma omp parallel for
+    for ( counter_t i=0; i<num_corners; ++i ) {
+      auto cn = cnrs[i];
+      auto ws = wedges(cn);
+      // both wedges SHOULD have the same vertex
+      const auto & v = vertices(cn).front()->coordinates();
+      // first compute the normals
+      for ( auto wit = ws.begin(); wit != ws.end(); ++wit ) 
+      {
+        // get the first wedge normal
         {
-          // get the first wedge normal
-          {
-            const auto & e = edge_midp[ edges(*wit).front() ];
-            const auto & f = face_midp[ faces(*wit).front() ];
-            wedge_facet_normal[*wit] = wedge_t::facet_normal_right( v, e, f );
-          }
-          // move to next wedge
-          ++wit;
-          assert( wit != ws.end() );
-          // get the second wedge normal
-          {
-            const auto & e = edge_midp[ edges(*wit).front() ];
-            const auto & f = face_midp[ faces(*wit).front() ];
-            wedge_facet_normal[*wit] = wedge_t::facet_normal_left( v, e, f );
-          }
+          const auto & e = edge_midp[ edges(*wit).front() ];
+          const auto & f = face_midp[ faces(*wit).front() ];
+          wedge_facet_normal[*wit] = wedge_t::facet_normal_right( v, e, f );
         }
-        // now normalize the normals and compute other quantities
-        for ( auto w : ws) {
-          wedge_facet_area[w] = abs( wedge_facet_normal[w] );
-          wedge_facet_normal[w] /= wedge_facet_area[w];
-          wedge_facet_centroid[w] = w->facet_centroid();
+        // move to next wedge
+        ++wit;
+        assert( wit != ws.end() );
+        // get the second wedge normal
+        {
+          const auto & e = edge_midp[ edges(*wit).front() ];
+          const auto & f = face_midp[ faces(*wit).front() ];
+          wedge_facet_normal[*wit] = wedge_t::facet_normal_left( v, e, f );
         }
       }
-
-    } // end omp parallel
+      // now normalize the normals and compute other quantities
+      for ( auto w : ws) {
+        wedge_facet_area[w] = abs( wedge_facet_normal[w] );
+        wedge_facet_normal[w] /= wedge_facet_area[w];
+        wedge_facet_centroid[w] = w->facet_centroid();
+      }
+    }
 
   }
 
 
   //============================================================================
   //! \brief Install a boundary and tag the relatex entities.
+  //!
+  //! Each entity keeps its tags as a bitmask, so at most
+  //! tag_list_t::capacity() boundaries can be installed.
   //============================================================================
   template< typename P >
   tag_t install_boundary( P && p ) 
   {
     // increment the boundary face storage
     auto this_bnd = face_sets_.size();
+    if ( this_bnd >= tag_list_t::capacity() )
+      raise_runtime_error(
+        "Too many boundaries, at most " << tag_list_t::capacity() <<
+        " can be tagged" );
     auto num_bnd = this_bnd + 1;
     face_sets_.resize( num_bnd );
     edge_sets_.resize( num_bnd );
@@ -1457,21 +1707,23 @@ public:
     auto & this_bnd_edges = edge_sets_[ this_bnd ];
     auto & this_bnd_verts = vert_sets_[ this_bnd ];
 
-    // add the face tags and collect the attached edge and vertices
+    // add the face tags and collect the attached edge and vertices.  The
+    // predicate may not be thread safe, e.g. a lua function, so this stays
+    // serial
     for ( auto f : faces() )
       if ( p( f ) ) {
         // tag the face
         f->tag( this_bnd );
-        this_bnd_faces.emplace_back( f );
+        this_bnd_faces.emplace_back( f.id() );
         // tag the vertices
         auto vs = vertices( f );
         this_bnd_verts.reserve( this_bnd_verts.size() + vs.size() );
-        for ( auto v : vs ) this_bnd_verts.emplace_back( v );
+        for ( auto v : vs ) this_bnd_verts.emplace_back( v.id() );
         // tag edges in 3d
         if ( num_dimensions == 3 ) {
           auto es = edges( f );
           this_bnd_edges.reserve( this_bnd_edges.size() + es.size() );
-          for ( auto e : es ) this_bnd_edges.emplace_back( e );
+          for ( auto e : es ) this_bnd_edges.emplace_back( e.id() );
         } // dims
       }
 
@@ -1489,27 +1741,48 @@ public:
     );
 
     // add the edge tags
-    for ( auto e : this_bnd_edges ) e->tag( this_bnd );
+    auto es = edges();
+    for ( auto e : this_bnd_edges ) es[e]->tag( this_bnd );
     // add the vertex tags
-    for ( auto v : this_bnd_verts ) v->tag( this_bnd );
+    auto vs = vertices();
+    for ( auto v : this_bnd_verts ) vs[v]->tag( this_bnd );
 
-    // if it's two dimensions, copy the face list into the edge list
-    // if ( num_dimensions == 2 )
-    //   this_bnd_edges.assign( this_bnd_faces.begin(), this_bnd_faces.end() );
+    // if it's two dimensions, the faces are the edges
+    if ( num_dimensions == 2 ) this_bnd_edges = this_bnd_faces;
 
     return this_bnd;
   }
 
   //============================================================================
   //! \brief Get the set of tagged vertices associated with a specific id
-  //! \praram [in] id  The tag to lookup.
-  //! \return The set of tagged vertices.
+  //! \param [in] id  The tag to lookup.
+  //! \return The sorted ids of the tagged vertices.
   //============================================================================
   const auto & tagged_vertices( tag_t id ) const noexcept
   {
     return vert_sets_[ id ];
   }
 
+  //============================================================================
+  //! \brief Get the set of tagged edges associated with a specific id
+  //! \param [in] id  The tag to lookup.
+  //! \return The sorted ids of the tagged edges.
+  //============================================================================
+  const auto & tagged_edges( tag_t id ) const noexcept
+  {
+    return edge_sets_[ id ];
+  }
+
+  //============================================================================
+  //! \brief Get the set of tagged faces associated with a specific id
+  //! \param [in] id  The tag to lookup.
+  //! \return The sorted ids of the tagged faces.
+  //============================================================================
+  const auto & tagged_faces( tag_t id ) const noexcept
+  {
+    return face_sets_[ id ];
+  }
+
   //============================================================================
   // Operators
   //============================================================================
@@ -1526,6 +1799,451 @@ public:
 
  private:
 
+  //! \brief Check the connectivity and orientation of a corner and its
+  //!   wedges.
+  //! \param [in] cn  The corner to check.
+  //! \param [in] wedge_norm  The wedge facet normals.
+  //! \param [in,out] msg  If given, what is wrong gets written to it.
+  //! \return True if the corner is valid.
+  template< typename C, typename N >
+  bool check_corner_( 
+    C && cn, const N & wedge_norm, std::ostream * msg = nullptr )
+  {
+    using math::dot_product;
+
+    bool ok = true;
+    auto error = [&]() -> std::ostream & {
+      ok = false;
+      return msg ? *msg : null_stream_();
+    };
+
+    auto cs = cells(cn);
+    auto fs = faces(cn);
+    auto es = edges(cn);
+    auto vs = vertices(cn);
+    auto ws = wedges(cn);
+
+    if ( cs.size() != 1 )
+      error() << "Corner " << cn.id() << " has " << cs.size() << "/=1 cells" 
+              << std::endl;
+
+    if ( fs.size() != num_dimensions )
+      error() << "Corner " << cn.id() << " has " << fs.size() << "/=" 
+              << num_dimensions << " faces" << std::endl;
+
+    if ( es.size() != num_dimensions )
+      error() << "Corner " << cn.id() << " has " << es.size() << "/=" 
+              << num_dimensions << " edges" << std::endl;
+
+    if ( vs.size() != 1 )
+      error() << "Corner " << cn.id() << " has " << vs.size() << "/=1 vertices"
+              << std::endl;
+
+    // nothing else can be checked without a cell and vertex
+    if ( cs.size() == 0 || vs.size() == 0 ) return ok;
+
+    auto cl = cs.front();
+    auto vt = vs.front();
+    
+    if ( ws.size() % 2 != 0 )
+      error() << "Corner " << cn.id() << " has " << ws.size() << "%2/=0 wedges"
+              << std::endl;
+
+    for ( auto wg = ws.begin(); wg != ws.end();  ) 
+      for ( auto i=0; i<2 && wg != ws.end(); i++, ++wg)
+      {
+        auto cls = cells( *wg );
+        auto fs = faces( *wg );
+        auto es = edges( *wg );
+        auto vs = vertices( *wg );
+        auto cns = corners( *wg );
+        if ( cls.size() != 1 )
+          error() << "Wedge " << (*wg).id() << " has " << cls.size() 
+                  << "/=1 cells" << std::endl;
+        if ( fs.size() != 1 )
+          error() << "Wedge " << (*wg).id() << " has " << fs.size() 
+                  << "/=1 faces" << std::endl;
+        if ( es.size() != 1 )
+          error() << "Wedge " << (*wg).id() << " has " << es.size() 
+                  << "/=1 edges" << std::endl;
+        if ( vs.size() != 1 )
+          error() << "Wedge " << (*wg).id() << " has " << vs.size() 
+                  << "/=1 vertices" << std::endl;
+        if ( cns.size() != 1 )
+          error() << "Wedge " << (*wg).id() << " has " << cns.size() 
+                  << "/=1 corners" << std::endl;
+        if ( cls.size() == 0 || fs.size() == 0 || vs.size() == 0 || 
+             cns.size() == 0 )
+          continue;
+        auto vert = vs.front();
+        auto cell = cls.front();
+        auto corn = cns.front();
+        if ( vert != vt )
+          error() << "Wedge " << (*wg).id() << " has incorrect vertex " 
+                  << vert.id() << "!=" << vt.id() << std::endl;
+        if ( cell != cl )
+          error() << "Wedge " << (*wg).id() << " has incorrect cell " 
+                  << cell.id() << "!=" << cl.id() << std::endl;
+        if ( corn != cn )
+          error() << "Wedge " << (*wg).id() << " has incorrect corner " 
+                  << corn.id() << "!=" << cn.id() << std::endl;
+        // check the stored normals, since those are what the solvers use
+        auto fc = fs.front();            
+        auto fx = fc->midpoint();
+        auto cx = cl->midpoint();
+        auto delta = fx - cx;
+        if ( dot_product( wedge_norm[*wg], delta ) < 0 )
+          error() << "Wedge " << (*wg).id() << " has opposite normal" 
+                  << std::endl;
+      } // wedges
+
+    return ok;
+  }
+
+  //! \brief A stream that discards everything written to it.
+  static std::ostream & null_stream_()
+  {
+    thread_local std::ostream os( nullptr );
+    return os;
+  }
+
+  //! \brief Collect the cells of each region.
+  //!
+  //! Each block of cells counts its regions in parallel.  The counts are
+  //! laid out region by region, so scanning them gives every block its
+  //! place in each region's list, and the blocks fill them in parallel.
+  void build_region_sets_()
+  {
+    using utils::parallel_block_size;
+
+    auto cs = cells();
+    auto num_cells = cs.size();
+    auto num_blocks = ( num_cells + parallel_block_size - 1 ) / parallel_block_size;
+
+    size_t max_region = 0;
+    #pragma omp parallel for reduction(max:max_region)
+    for ( size_t i=0; i<num_cells; i++ )
+      max_region = std::max<size_t>( max_region, cs[i]->region() );
+
+    auto n = num_cells > 0 ? max_region + 1 : 0;
+    auto nr = std::max( n, num_regions() );
+
+    // the count of region r in block b goes in entry r*num_blocks + b + 1
+    std::vector<size_t> offsets( nr*num_blocks + 1, 0 );
+    #pragma omp parallel for
+    for ( size_t b=0; b<num_blocks; b++ ) {
+      auto first = b * parallel_block_size;
+      auto last = std::min( first + parallel_block_size, num_cells );
+      for ( auto i=first; i<last; i++ ) {
+        size_t r = cs[i]->region();
+        offsets[ r*num_blocks + b + 1 ]++;
+      }
+    }
+    utils::counts_to_offsets( offsets );
+
+    // the blocks go in order, so the lists come out sorted
+    std::vector<local_id_t> sorted( num_cells );
+    #pragma omp parallel for
+    for ( size_t b=0; b<num_blocks; b++ ) {
+      auto first = b * parallel_block_size;
+      auto last = std::min( first + parallel_block_size, num_cells );
+      for ( auto i=first; i<last; i++ ) {
+        size_t r = cs[i]->region();
+        sorted[ offsets[ r*num_blocks + b ]++ ] = i;
+      }
+    }
+
+    // the fill moved each offset to the end of its block's slot
+    auto region_end = [&]( size_t r ) -> size_t
+    { return num_blocks > 0 ? offsets[ (r+1)*num_blocks - 1 ] : 0; };
+
+    region_cells_.resize( nr );
+    #pragma omp parallel for
+    for ( size_t r=0; r<nr; r++ ) {
+      auto first = r > 0 ? region_end( r-1 ) : 0;
+      region_cells_[r].assign(
+        sorted.begin() + first, sorted.begin() + region_end( r ) );
+    }
+  }
+
+  //! \brief Split the owned entities by whether they touch any ghosts.
+  void build_sweep_lists_()
+  {
+    auto num_own_cells = num_owned_cells();
+    auto num_own_verts = num_owned_vertices();
+
+    auto is_owned_cell = [=]( const auto & c ) { return c.id() < num_own_cells; };
+    auto is_owned_vert = [=]( const auto & v ) { return v.id() < num_own_verts; };
+
+    auto all_of = []( auto && list, auto && pred ) {
+      return std::all_of( list.begin(), list.end(), pred );
+    };
+    auto any_of = []( auto && list, auto && pred ) {
+      return std::any_of( list.begin(), list.end(), pred );
+    };
+
+    cell_sweeps_ = sweep_lists_t();
+    auto cs = cells();
+    for ( size_t i=0; i<num_own_cells; i++ ) {
+      auto & list = all_of( vertices(cs[i]), is_owned_vert ) ?
+        cell_sweeps_.interior : cell_sweeps_.boundary;
+      list.emplace_back( i );
+    }
+
+    face_sweeps_ = sweep_lists_t();
+    for ( auto f : faces() ) {
+      auto fcs = cells(f);
+      if ( all_of( fcs, is_owned_cell ) )
+        face_sweeps_.interior.emplace_back( f.id() );
+      else if ( any_of( fcs, is_owned_cell ) )
+        face_sweeps_.boundary.emplace_back( f.id() );
+    }
+
+    vertex_sweeps_ = sweep_lists_t();
+    auto vs = vertices();
+    for ( size_t i=0; i<num_own_verts; i++ ) {
+      auto & list = all_of( cells(vs[i]), is_owned_cell ) ?
+        vertex_sweeps_.interior : vertex_sweeps_.boundary;
+      list.emplace_back( i );
+    }
+  }
+
+  //! \brief Return true if the edge midpoints are needed.
+  bool has_edge_geometry_() const noexcept
+  {
+    return requirements_ & 
+      ( attributes::require_edge_geometry | attributes::require_corners );
+  }
+
+  //! \brief Build the cell faces, and edges in 3d, in bulk.
+  //!
+  //! The candidate sub-entities of all cells are deduplicated in parallel
+  //! by build_sub_entities, and handed to flecsi the same way as the faces
+  //! of cells built from faces.  They are numbered and oriented just like
+  //! flecsi would have, since both use the same local tables.  Meshes
+  //! that already have faces are left to flecsi.
+  void build_connectivity_()
+  {
+    if ( num_faces() > 0 ) return;
+
+    std::vector<vertex_t*> vs;
+    for ( auto v : vertices() ) vs.emplace_back( v );
+
+    std::vector<cell_t*> cs;
+    std::vector<size_t> cell_vertex_offsets = {0};
+    std::vector<local_id_t> cell_vertices;
+    for ( auto c : cells() ) {
+      cs.emplace_back( c );
+      for ( auto v : vertices(c) ) cell_vertices.emplace_back( v.id() );
+      cell_vertex_offsets.emplace_back( cell_vertices.size() );
+    }
+    if ( cs.empty() ) return;
+
+    check_local_ids_( vs.size() );
+    check_local_ids_( cs.size() );
+
+    auto num_cell_verts = [&]( auto c )
+    { return cell_vertex_offsets[c+1] - cell_vertex_offsets[c]; };
+
+    if ( num_dimensions == 2 ) {
+      // polygons are bounded by the edges between consecutive vertices
+      std::map< size_t, local_entities_t > rings;
+      for ( size_t c=0; c<cs.size(); c++ ) {
+        auto n = num_cell_verts(c);
+        if ( !rings.count(n) ) rings[n] = local_entities_t::ring(n);
+      }
+      auto faces = build_sub_entities( vs.size(), cell_vertex_offsets,
+        cell_vertices, [&]( auto c ) -> const local_entities_t &
+        { return rings.at( num_cell_verts(c) ); } );
+      seed_sub_entities_<face_t>( faces, vs, cs );
+    }
+    else {
+      // the cells are tetrahedra or hexahedra, see create_3d_element_from_verts_
+      for ( size_t dim : {face_t::dimension, edge_t::dimension} ) {
+        auto ents = build_sub_entities( vs.size(), cell_vertex_offsets,
+          cell_vertices, [&]( auto c ) -> const local_entities_t &
+          {
+            return num_cell_verts(c) == 4 ?
+              burton_tetrahedron_t::local_entities( dim ) :
+              burton_hexahedron_t::local_entities( dim );
+          } );
+        if ( dim == face_t::dimension )
+          seed_sub_entities_<face_t>( ents, vs, cs );
+        else
+          seed_sub_entities_<edge_t>( ents, vs, cs );
+      }
+    }
+  }
+
+  //! \brief Make sure there are few enough entities for the local ids.
+  //! \param[in] n  The number of entities.
+  static void check_local_ids_( size_t n )
+  {
+    if ( n > std::numeric_limits<local_id_t>::max() )
+      raise_runtime_error( 
+        n << " entities are too many for " << 8*sizeof(local_id_t) <<
+        " bit local ids, partition the mesh further" );
+  }
+
+  //! \brief Create the sub-entities built by build_connectivity_.
+  //! \param[in] ents  The sub-entities.
+  //! \param[in] vs  The vertices.
+  //! \param[in] cs  The cells.
+  template< typename E >
+  void seed_sub_entities_(
+    const sub_entities_t & ents,
+    const std::vector<vertex_t*> & vs,
+    const std::vector<cell_t*> & cs )
+  {
+    check_local_ids_( ents.size() );
+
+    std::vector<E*> es( ents.size() );
+    std::vector<vertex_t*> evs;
+    for ( size_t i=0; i<ents.size(); i++ ) {
+      evs.clear();
+      for ( auto j=ents.vertex_offsets[i]; j<ents.vertex_offsets[i+1]; j++ )
+        evs.emplace_back( vs[ ents.vertices[j] ] );
+      auto e = static_cast<E*>(
+        types_t::template create_entity<E::domain, E::dimension>(
+          this, evs.size() ) );
+      base_t::template add_entity<E::dimension, E::domain>( e );
+      base_t::template init_entity<E::domain, E::dimension, vertex_t::dimension>( e, evs );
+      es[i] = e;
+    }
+
+    std::vector<E*> ces;
+    for ( size_t c=0; c<cs.size(); c++ ) {
+      ces.clear();
+      for ( auto j=ents.cell_offsets[c]; j<ents.cell_offsets[c+1]; j++ )
+        ces.emplace_back( es[ ents.cell_entities[j] ] );
+      base_t::template init_entity<cell_t::domain, cell_t::dimension, E::dimension>( cs[c], ces );
+    }
+  }
+
+  //! \brief Copy the sub-entities of type \e E, and which cells they bound,
+  //!   from a mesh with the same vertices and cells.
+  //! \param[in] src  The mesh to copy from.
+  //! \param[in] vs  The vertices.
+  //! \param[in] cs  The cells.
+  template< typename E >
+  void copy_sub_entities_(
+    const burton_mesh_t & src,
+    const std::vector<vertex_t*> & vs,
+    const std::vector<cell_t*> & cs )
+  {
+    using utils::counts_to_offsets;
+
+    auto src_ents = src.base_t::template entities<E::dimension, E::domain>();
+    auto src_cells = src.cells();
+    auto num_ents = src_ents.size();
+    auto num_cells = src_cells.size();
+
+    // the sub-entities of a source cell
+    auto cell_ents = [&]( auto c ) {
+      return src.base_t::template 
+        entities<E::dimension, cell_t::domain, E::domain>( 
+          src_cells[c].entity() );
+    };
+
+    sub_entities_t ents;
+
+    ents.vertex_offsets.resize( num_ents+1 );
+    #pragma omp parallel for
+    for ( size_t i=0; i<num_ents; i++ )
+      ents.vertex_offsets[i+1] = src.vertices( src_ents[i] ).size();
+    counts_to_offsets( ents.vertex_offsets );
+
+    ents.vertices.resize( ents.vertex_offsets.back() );
+    #pragma omp parallel for
+    for ( size_t i=0; i<num_ents; i++ ) {
+      auto pos = ents.vertex_offsets[i];
+      for ( auto v : src.vertices( src_ents[i] ) ) ents.vertices[pos++] = v.id();
+    }
+
+    ents.cell_offsets.resize( num_cells+1 );
+    #pragma omp parallel for
+    for ( size_t c=0; c<num_cells; c++ )
+      ents.cell_offsets[c+1] = cell_ents(c).size();
+    counts_to_offsets( ents.cell_offsets );
+
+    ents.cell_entities.resize( ents.cell_offsets.back() );
+    #pragma omp parallel for
+    for ( size_t c=0; c<num_cells; c++ ) {
+      auto pos = ents.cell_offsets[c];
+      for ( auto e : cell_ents(c) ) ents.cell_entities[pos++] = e.id();
+    }
+
+    seed_sub_entities_<E>( ents, vs, cs );
+  }
+
+  //! \brief Copy the geometry, tags and regions from a mesh with the same
+  //!   entities.
+  //! \param[in] src  The mesh to copy from.
+  void copy_state_( const burton_mesh_t & src )
+  {
+    auto copy = []( auto && to, auto && from, size_t n ) 
+    {
+      #pragma omp parallel for
+      for ( size_t i=0; i<n; i++ ) to[i] = from[i];
+    };
+
+    // the geometry
+    auto nc = num_cells();
+    copy( cell_volumes(), src.cell_volumes(), nc );
+    copy( cell_centroids(), src.cell_centroids(), nc );
+    copy( cell_min_lengths(), src.cell_min_lengths(), nc );
+
+    auto nf = num_faces();
+    copy( face_areas(), src.face_areas(), nf );
+    copy( face_normals(), src.face_normals(), nf );
+    copy( 
+      flecsi_get_accessor(*this, mesh, face_midpoint, vector_t, dense, 0),
+      flecsi_get_accessor(src, mesh, face_midpoint, vector_t, dense, 0),
+      nf );
+
+    if ( has_edge_geometry_() )
+      copy( 
+        flecsi_get_accessor(*this, mesh, edge_midpoint, vector_t, dense, 0),
+        flecsi_get_accessor(src, mesh, edge_midpoint, vector_t, dense, 0),
+        num_edges() );
+
+    if ( is_required( attributes::require_corners ) ) {
+      auto nw = num_wedges();
+      copy( wedge_facet_normals(), src.wedge_facet_normals(), nw );
+      copy( wedge_facet_centroids(), src.wedge_facet_centroids(), nw );
+      copy( wedge_facet_areas(), src.wedge_facet_areas(), nw );
+    }
+
+    // the boundary tags
+    copy( 
+      flecsi_get_accessor(*this, mesh, node_tags, tag_list_t, dense, 0),
+      flecsi_get_accessor(src, mesh, node_tags, tag_list_t, dense, 0),
+      num_vertices() );
+    copy( 
+      flecsi_get_accessor(*this, mesh, edge_tags, tag_list_t, dense, 0),
+      flecsi_get_accessor(src, mesh, edge_tags, tag_list_t, dense, 0),
+      num_edges() );
+    copy( 
+      flecsi_get_accessor(*this, mesh, face_tags, tag_list_t, dense, 0),
+      flecsi_get_accessor(src, mesh, face_tags, tag_list_t, dense, 0),
+      nf );
+    copy( 
+      flecsi_get_accessor(*this, mesh, cell_tags, tag_list_t, dense, 0),
+      flecsi_get_accessor(src, mesh, cell_tags, tag_list_t, dense, 0),
+      nc );
+    face_sets_ = src.face_sets_;
+    edge_sets_ = src.edge_sets_;
+    vert_sets_ = src.vert_sets_;
+
+    // the regions
+    copy( 
+      flecsi_get_accessor(*this, mesh, cell_region, size_t, dense, 0),
+      flecsi_get_accessor(src, mesh, cell_region, size_t, dense, 0),
+      nc );
+    *flecsi_get_accessor(*this, mesh, num_regions, size_t, global, 0) = 
+      src.num_regions();
+    region_cells_ = src.region_cells_;
+  }
 
   //! \brief Create a cell in the burton mesh.
   //! \param[in] verts The vertices defining the cell.
@@ -1610,11 +2328,37 @@ public:
   // Private Data 
   //============================================================================
 
-  //! \brief Tagged sets 
+  //! \brief Tagged sets, as sorted ids
+  //@ {
+  std::vector< std::vector<local_id_t> > face_sets_;
+  std::vector< std::vector<local_id_t> > edge_sets_;
+  std::vector< std::vector<local_id_t> > vert_sets_;
+  //@ }
+
+  //! \brief The sorted ids of the entities on the domain boundary.
+  //@ {
+  std::vector<local_id_t> boundary_vertices_;
+  std::vector<local_id_t> boundary_edges_;
+  std::vector<local_id_t> boundary_faces_;
+  //@ }
+
+  //! \brief The sorted ids of the cells in each region.
+  std::vector< std::vector<local_id_t> > region_cells_;
+
+  //! \brief The parallel layout, empty unless the mesh is distributed.
+  ownership_t ownership_;
+
+  //! \brief What gets written to each kind of output file.
+  output_profile_t output_profile_;
+
+  //! \brief The optional parts that get built.
+  unsigned requirements_ = default_requirements();
+
+  //! \brief The owned entities, split by whether they touch any ghosts.
   //@ {
-  std::vector< std::vector<face_t*> >   face_sets_;
-  std::vector< std::vector<edge_t*> >   edge_sets_;
-  std::vector< std::vector<vertex_t*> > vert_sets_;
+  sweep_lists_t cell_sweeps_;
+  sweep_lists_t face_sweeps_;
+  sweep_lists_t vertex_sweeps_;
   //@ }
 
 
@@ -12,6 +12,7 @@
 
 // user includes
 #include "flecsale/geom/shapes/tetrahedron.h"
+#include "flecsale/mesh/connectivity.h"
 #include "flecsale/mesh/burton/burton_element.h"
 
 
@@ -59,6 +60,30 @@ public:
   shape_t type() const override 
   { return geom::shapes::tetrahedron::shape; };
 
+  //----------------------------------------------------------------------------
+  //! \brief The local vertices of the edges (dim=1) and faces (dim=2).
+  //----------------------------------------------------------------------------
+  static const local_entities_t & local_entities( size_t dim )
+  {
+    static const local_entities_t edges = {
+      // bottom
+      {0, 1}, {1, 2}, {2, 0},
+      // top
+      {0, 3}, {1, 3}, {2, 3}
+    };
+    static const local_entities_t faces = {
+      {0, 1, 3}, {1, 2, 3}, {2, 0, 3}, {0, 2, 1}
+    };
+    switch (dim) {
+    case (1):
+      return edges;
+    case (2):
+      return faces;
+    default:
+      raise_runtime_error("Unknown entity type");
+    }
+  }
+
   //----------------------------------------------------------------------------
   //! \brief create_entities function for burton_tetrahedron_cell_t.
   //----------------------------------------------------------------------------
@@ -67,68 +92,9 @@ public:
     const connectivity_t& conn,
     id_t * entities ) override
   {
-
     auto v = conn.get_entity_vec( cell, vertex_t::dimension );
-
     assert( v.size() == 4 );
-
-    switch (dim) {
-      
-      //------------------------------------------------------------------------
-      // Edges
-    case (1): 
-      // bottom
-      entities[0] = v[0];
-      entities[1] = v[1];
-
-      entities[2] = v[1];
-      entities[3] = v[2];
-
-      entities[4] = v[2];
-      entities[5] = v[0];
-
-      // top
-      entities[6] = v[0];
-      entities[7] = v[3];
-
-      entities[8] = v[1];
-      entities[9] = v[3];
-
-      entities[10] = v[2];
-      entities[11] = v[3];
-
-      return {2, 2, 2, 2, 2, 2};
-
-      //------------------------------------------------------------------------
-      // Faces
-    case (2): 
-
-      entities[0]  = v[0];
-      entities[1]  = v[1];
-      entities[2]  = v[3];
-
-      entities[3]  = v[1];
-      entities[4]  = v[2];
-      entities[5]  = v[3];
-
-      entities[6]  = v[2];
-      entities[7]  = v[0];
-      entities[8]  = v[3];
-
-      entities[9]  = v[0];
-      entities[10] = v[2];
-      entities[11] = v[1];
-
-      return {3, 3, 3, 3};
-      
-      //------------------------------------------------------------------------
-      // Failure      
-    default: 
-      raise_runtime_error("Unknown entity type");
-
-    } // switch
-
-
+    return local_entities( dim ).fill( v, entities );
   } // create_entities
 
   //----------------------------------------------------------------------------
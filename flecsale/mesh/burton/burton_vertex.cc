@@ -38,13 +38,13 @@ bool burton_3d_vertex_t::is_boundary() const
 void burton_2d_vertex_t::tag(const burton_2d_vertex_t::tag_t & tag)
 {
   auto flags = flecsi_get_accessor(*mesh_, mesh, node_tags, tag_list_t, dense, 0);
-  flags[mesh_entity_base_t<num_domains>::template id<0>()].push_back( tag );
+  flags[mesh_entity_base_t<num_domains>::template id<0>()].insert( tag );
 }
 
 void burton_3d_vertex_t::tag(const burton_3d_vertex_t::tag_t & tag)
 {
   auto flags = flecsi_get_accessor(*mesh_, mesh, node_tags, tag_list_t, dense, 0);
-  flags[mesh_entity_base_t<num_domains>::template id<0>()].push_back( tag );
+  flags[mesh_entity_base_t<num_domains>::template id<0>()].insert( tag );
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -62,6 +62,19 @@ const burton_3d_vertex_t::tag_list_t &  burton_3d_vertex_t::tags() const
   return flags[mesh_entity_base_t<num_domains>::template id<0>()];
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// check for a boundary tag
+////////////////////////////////////////////////////////////////////////////////
+bool burton_2d_vertex_t::has_tag(const burton_2d_vertex_t::tag_t & tag) const
+{
+  return tags().count( tag );
+}
+
+bool burton_3d_vertex_t::has_tag(const burton_3d_vertex_t::tag_t & tag) const
+{
+  return tags().count( tag );
+}
+
 } // namespace burton
 } // namespace mesh
 } // namespace flecsale
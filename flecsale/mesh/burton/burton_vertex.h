@@ -109,7 +109,7 @@ public:
   //! tag entity
   void tag(const tag_t & tag);
   //! does entity have a tag
-  bool has_tag(const tag_t & tag);
+  bool has_tag(const tag_t & tag) const;
 
 
   //! \brief reset the mesh pointer
@@ -214,7 +214,7 @@ public:
   //! tag entity
   void tag(const tag_t & tag);
   //! does entity have a tag
-  bool has_tag(const tag_t & tag);
+  bool has_tag(const tag_t & tag) const;
 
   //! \brief reset the mesh pointer
   void reset(mesh_topology_base_t & mesh) 
@@ -12,9 +12,13 @@
 // user includes
 #include "burton_3d_test.h"
 
+// system includes
+#include <algorithm>
+
 // using statements
 using std::cout;
 using std::endl;
+using std::vector;
 
 ////////////////////////////////////////////////////////////////////////////////
 //! \brief dump the mesh to std out
@@ -410,3 +414,276 @@ TEST_F(burton_3d, normals) {
   }
 
 } // TEST_F
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief test the cached boundary, region and tagged subsets
+////////////////////////////////////////////////////////////////////////////////
+TEST_F(burton_3d, subsets) {
+
+  // the boundary sets match the flags
+  vector<mesh_t::local_id_t> expected;
+  for ( auto v : mesh_.vertices() )
+    if ( v->is_boundary() ) expected.emplace_back( v.id() );
+  ASSERT_FALSE( expected.empty() );
+  ASSERT_EQ( expected, mesh_.boundary_vertices() );
+
+  expected.clear();
+  for ( auto e : mesh_.edges() )
+    if ( e->is_boundary() ) expected.emplace_back( e.id() );
+  ASSERT_EQ( expected, mesh_.boundary_edges() );
+
+  expected.clear();
+  for ( auto f : mesh_.faces() )
+    if ( f->is_boundary() ) expected.emplace_back( f.id() );
+  ASSERT_EQ( expected, mesh_.boundary_faces() );
+
+  // everything starts in one region
+  ASSERT_EQ( 1, mesh_.regions().size() );
+  ASSERT_EQ( mesh_.num_cells(), mesh_.region_cells(0).size() );
+
+  // split the cells in half, leaving the middle region empty
+  vector<size_t> region_ids( mesh_.num_cells() );
+  for ( auto c : mesh_.cells() )
+    region_ids[ c.id() ] = c->centroid()[0] < length_x / 2 ? 0 : 2;
+  mesh_.set_regions( region_ids.data() );
+  mesh_.set_num_regions( 3 );
+
+  ASSERT_EQ( 3, mesh_.regions().size() );
+  ASSERT_TRUE( mesh_.region_cells(1).empty() );
+  for ( size_t r : {0, 2} ) {
+    expected.clear();
+    for ( auto c : mesh_.cells() )
+      if ( region_ids[ c.id() ] == r ) expected.emplace_back( c.id() );
+    ASSERT_FALSE( expected.empty() );
+    ASSERT_EQ( expected, mesh_.region_cells(r) );
+  }
+
+  // tag the faces on the x=0 plane
+  auto tag = mesh_.install_boundary(
+    []( auto f ) { return f->is_boundary() && f->centroid()[0] == 0; } );
+
+  const auto & tagged_faces = mesh_.tagged_faces( tag );
+  ASSERT_EQ( num_cells_y*num_cells_z, tagged_faces.size() );
+  ASSERT_TRUE( std::is_sorted( tagged_faces.begin(), tagged_faces.end() ) );
+
+  auto fs = mesh_.faces();
+  for ( auto f : tagged_faces ) ASSERT_TRUE( fs[f]->has_tag( tag ) );
+
+  auto vs = mesh_.vertices();
+  const auto & tagged_verts = mesh_.tagged_vertices( tag );
+  ASSERT_EQ( (num_cells_y+1)*(num_cells_z+1), tagged_verts.size() );
+  for ( auto v : tagged_verts ) {
+    ASSERT_EQ( 0, vs[v]->coordinates()[0] );
+    ASSERT_TRUE( vs[v]->has_tag( tag ) );
+  }
+
+  const auto & tagged_edges = mesh_.tagged_edges( tag );
+  ASSERT_EQ( 
+    num_cells_y*(num_cells_z+1) + (num_cells_y+1)*num_cells_z,
+    tagged_edges.size() );
+
+  // the vertices on the x=0, y=0 line get both tags, in order
+  auto other_tag = mesh_.install_boundary(
+    []( auto f ) { return f->is_boundary() && f->centroid()[1] == 0; } );
+  for ( auto v : mesh_.vertices() ) {
+    const auto & x = v->coordinates();
+    std::size_t num_tags = ( x[0] == 0 ) + ( x[1] == 0 );
+    ASSERT_EQ( num_tags, v->tags().size() );
+    if ( num_tags == 2 )
+      ASSERT_EQ( vector<int>({tag, other_tag}),
+        vector<int>( v->tags().begin(), v->tags().end() ) );
+  }
+
+} // TEST_F
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief test that flecsi keeps the faces and edges seeded in bulk
+//!
+//! The cells of a box are built from their vertices, so their faces and edges
+//! are made by build_sub_entities and handed to flecsi before it initializes
+//! the rest.  Flecsi has to use them as they are, with the same ids and
+//! orientations, instead of discovering its own.
+////////////////////////////////////////////////////////////////////////////////
+TEST_F(burton_3d, seeded_connectivity) {
+
+  using flecsale::mesh::burton::burton_hexahedron_t;
+  using index_t = flecsale::mesh::sub_entities_t::index_t;
+
+  auto mesh = flecsale::mesh::box<mesh_t>( 3, 2, 2, 0, 0, 0, 3, 2, 2 );
+  ASSERT_TRUE( mesh.is_valid( false ) );
+
+  // what build_connectivity_ seeded flecsi with
+  vector<size_t> cell_vertex_offsets = {0};
+  vector<index_t> cell_vertices;
+  for ( auto c : mesh.cells() ) {
+    for ( auto v : mesh.vertices(c) ) cell_vertices.emplace_back( v.id() );
+    cell_vertex_offsets.emplace_back( cell_vertices.size() );
+  }
+
+  auto build = [&]( size_t dim ) {
+    return flecsale::mesh::build_sub_entities( mesh.num_vertices(),
+      cell_vertex_offsets, cell_vertices,
+      [&]( auto ) -> const auto &
+      { return burton_hexahedron_t::local_entities( dim ); } );
+  };
+
+  // the vertices of each sub-entity, in order
+  auto check_vertices = [&]( const auto & ents, auto && entities ) {
+    ASSERT_EQ( ents.size(), entities.size() );
+    for ( auto e : entities ) {
+      vector<index_t> verts;
+      for ( auto v : mesh.vertices(e) ) verts.emplace_back( v.id() );
+      ASSERT_EQ(
+        vector<index_t>(
+          ents.vertices.begin() + ents.vertex_offsets[e.id()],
+          ents.vertices.begin() + ents.vertex_offsets[e.id()+1] ),
+        verts );
+    }
+  };
+
+  // the sub-entities of each cell, in local order
+  auto check_cells = [&]( const auto & ents, auto && cell_entities ) {
+    for ( auto c : mesh.cells() ) {
+      vector<index_t> ids;
+      for ( auto e : cell_entities(c) ) ids.emplace_back( e.id() );
+      ASSERT_EQ(
+        vector<index_t>(
+          ents.cell_entities.begin() + ents.cell_offsets[c.id()],
+          ents.cell_entities.begin() + ents.cell_offsets[c.id()+1] ),
+        ids );
+    }
+  };
+
+  auto faces = build( mesh_t::face_t::dimension );
+  check_vertices( faces, mesh.faces() );
+  check_cells( faces, [&]( auto c ) { return mesh.faces(c); } );
+
+  // flecsi works out the cells of each face from the seeded faces
+  for ( auto f : mesh.faces() ) {
+    vector<index_t> ids;
+    for ( auto c : mesh.cells(f) ) ids.emplace_back( c.id() );
+    std::sort( ids.begin(), ids.end() );
+    ASSERT_EQ(
+      vector<index_t>(
+        faces.entity_cells.begin() + faces.entity_cell_offsets[f.id()],
+        faces.entity_cells.begin() + faces.entity_cell_offsets[f.id()+1] ),
+      ids );
+  }
+
+  auto edges = build( edge_t::dimension );
+  check_vertices( edges, mesh.edges() );
+  check_cells( edges, [&]( auto c ) { return mesh.edges(c); } );
+
+} // TEST_F
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief test the validation levels
+////////////////////////////////////////////////////////////////////////////////
+TEST_F(burton_3d, validation) {
+
+  namespace attributes = flecsale::mesh::burton::attributes;
+
+  ASSERT_EQ( attributes::validate_none, attributes::to_validation("none") );
+  ASSERT_EQ( attributes::validate_quick, attributes::to_validation("quick") );
+  ASSERT_EQ( attributes::validate_full, attributes::to_validation("full") );
+#ifdef ENABLE_EXCEPTIONS
+  ASSERT_THROW( attributes::to_validation("most"),
+    flecsale::utils::ExceptionRunTime );
+#endif
+
+  ASSERT_TRUE( mesh_.is_valid( attributes::validate_none, false ) );
+  ASSERT_TRUE( mesh_.is_valid( attributes::validate_quick, false ) );
+  ASSERT_TRUE( mesh_.is_valid( attributes::validate_full, false ) );
+  ASSERT_TRUE( mesh_.is_valid( false ) );
+
+  // a flipped face normal is caught by the quick checks
+  auto face_normals = mesh_.face_normals();
+  auto f = mesh_.faces().front();
+  face_normals[f] = -face_normals[f];
+  ASSERT_TRUE( mesh_.is_valid( attributes::validate_none, false ) );
+  ASSERT_FALSE( mesh_.is_valid( attributes::validate_quick, false ) );
+  ASSERT_FALSE( mesh_.is_valid( attributes::validate_full, false ) );
+#ifdef ENABLE_EXCEPTIONS
+  ASSERT_THROW( mesh_.is_valid( attributes::validate_quick ),
+    flecsale::utils::ExceptionRunTime );
+#endif
+  face_normals[f] = -face_normals[f];
+  ASSERT_TRUE( mesh_.is_valid( attributes::validate_full, false ) );
+
+  // a flipped wedge normal is only caught by the full checks
+  auto wedge_normals = mesh_.wedge_facet_normals();
+  auto w = mesh_.wedges().back();
+  wedge_normals[w] = -wedge_normals[w];
+  ASSERT_TRUE( mesh_.is_valid( attributes::validate_none, false ) );
+  ASSERT_TRUE( mesh_.is_valid( attributes::validate_quick, false ) );
+  ASSERT_FALSE( mesh_.is_valid( attributes::validate_full, false ) );
+  ASSERT_FALSE( mesh_.is_valid( false ) );
+  wedge_normals[w] = -wedge_normals[w];
+  ASSERT_TRUE( mesh_.is_valid( attributes::validate_full, false ) );
+
+} // TEST_F
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief test that copies match the original
+////////////////////////////////////////////////////////////////////////////////
+TEST_F(burton_3d, copy) {
+
+  // give the mesh some state that is not the default
+  vector<size_t> region_ids( mesh_.num_cells() );
+  for ( auto c : mesh_.cells() )
+    region_ids[ c.id() ] = c->centroid()[1] < length_y / 2 ? 0 : 1;
+  mesh_.set_regions( region_ids.data(), 2 );
+
+  auto tag = mesh_.install_boundary(
+    []( auto f ) { return f->is_boundary() && f->centroid()[2] == 0; } );
+
+  mesh_t mesh_copy( mesh_ );
+  ASSERT_TRUE( mesh_copy.is_valid( false ) );
+
+  // the entities come in the same order
+  ASSERT_EQ( mesh_.num_vertices(), mesh_copy.num_vertices() );
+  ASSERT_EQ( mesh_.num_edges(), mesh_copy.num_edges() );
+  ASSERT_EQ( mesh_.num_faces(), mesh_copy.num_faces() );
+  ASSERT_EQ( mesh_.num_cells(), mesh_copy.num_cells() );
+  ASSERT_EQ( mesh_.num_corners(), mesh_copy.num_corners() );
+  ASSERT_EQ( mesh_.num_wedges(), mesh_copy.num_wedges() );
+
+  auto ids = []( auto && list ) {
+    vector<size_t> res;
+    for ( auto e : list ) res.emplace_back( e.id() );
+    return res;
+  };
+
+  auto fs = mesh_.faces();
+  auto copy_fs = mesh_copy.faces();
+  for ( size_t i=0; i<fs.size(); i++ ) {
+    ASSERT_EQ( ids( mesh_.vertices(fs[i]) ), 
+      ids( mesh_copy.vertices(copy_fs[i]) ) );
+    ASSERT_EQ( ids( mesh_.cells(fs[i]) ), ids( mesh_copy.cells(copy_fs[i]) ) );
+  }
+
+  auto cs = mesh_.cells();
+  auto copy_cs = mesh_copy.cells();
+  for ( size_t i=0; i<cs.size(); i++ ) {
+    ASSERT_EQ( ids( mesh_.edges(cs[i]) ), ids( mesh_copy.edges(copy_cs[i]) ) );
+    ASSERT_EQ( ids( mesh_.corners(cs[i]) ), 
+      ids( mesh_copy.corners(copy_cs[i]) ) );
+  }
+
+  // the geometry is the same as recomputing it
+  auto volumes = mesh_copy.cell_volumes();
+  for ( size_t i=0; i<cs.size(); i++ )
+    ASSERT_EQ( copy_cs[i]->volume(), volumes[ copy_cs[i] ] );
+
+  auto areas = mesh_copy.face_areas();
+  for ( size_t i=0; i<fs.size(); i++ )
+    ASSERT_EQ( copy_fs[i]->area(), areas[ copy_fs[i] ] );
+
+  // and so are the regions and tags
+  ASSERT_EQ( mesh_.regions(), mesh_copy.regions() );
+  ASSERT_EQ( mesh_.tagged_faces( tag ), mesh_copy.tagged_faces( tag ) );
+  ASSERT_EQ( mesh_.tagged_vertices( tag ), mesh_copy.tagged_vertices( tag ) );
+  for ( auto f : mesh_copy.tagged_faces( tag ) )
+    ASSERT_TRUE( copy_fs[f]->has_tag( tag ) );
+  
+} // TEST_F
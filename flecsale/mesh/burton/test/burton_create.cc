@@ -13,6 +13,9 @@
 // test include
 #include "burton_create_test.h"
 
+// user includes
+#include "flecsale/mesh/factory.h"
+
 
 // some general using statements
 using std::endl;
@@ -481,3 +484,53 @@ TEST_F( burton_create, faces ) {
 
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Make sure only the required parts of the mesh are built.
+////////////////////////////////////////////////////////////////////////////////
+TEST( burton_create, requirements ) {
+
+  namespace attributes = flecsale::mesh::burton::attributes;
+  auto make_box = []() 
+  { return flecsale::mesh::box<mesh_3d_t>( 4, 3, 2, 0, 0, 0, 1, 1, 1 ); };
+
+  // puts the default requirements back, even if an assertion bails out
+  struct requirements_guard_t {
+    unsigned saved = mesh_3d_t::default_requirements();
+    ~requirements_guard_t() { mesh_3d_t::default_requirements() = saved; }
+  };
+
+  // cells and faces only
+  auto lean = [&]() {
+    requirements_guard_t guard;
+    mesh_3d_t::default_requirements() = attributes::require_none;
+    return make_box();
+  }();
+
+  ASSERT_FALSE( lean.is_required( attributes::require_corners ) );
+  ASSERT_EQ( 0u, lean.num_corners() );
+  ASSERT_EQ( 0u, lean.num_wedges() );
+  ASSERT_TRUE( lean.is_valid(false) );
+
+  // everything
+  auto full = make_box();
+  ASSERT_TRUE( full.is_required( attributes::require_all ) );
+  ASSERT_EQ( 8*full.num_cells(), full.num_corners() );
+
+  // the topology and geometry that is there does not change
+  ASSERT_EQ( full.num_cells(), lean.num_cells() );
+  ASSERT_EQ( full.num_faces(), lean.num_faces() );
+  ASSERT_EQ( full.num_edges(), lean.num_edges() );
+
+  auto lean_areas = lean.face_areas();
+  auto full_areas = full.face_areas();
+  auto lean_faces = lean.faces();
+  auto full_faces = full.faces();
+  for ( std::size_t i=0; i<full.num_faces(); i++ )
+    ASSERT_EQ( full_areas[ full_faces[i] ], lean_areas[ lean_faces[i] ] );
+
+  // copies keep the requirements of their source
+  mesh_3d_t copy( lean );
+  ASSERT_EQ( lean.requirements(), copy.requirements() );
+  ASSERT_EQ( 0u, copy.num_corners() );
+
+}
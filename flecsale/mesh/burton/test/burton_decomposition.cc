@@ -0,0 +1,242 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Tests the splitting of a burton mesh among several processes.
+////////////////////////////////////////////////////////////////////////////////
+
+// user includes
+#include "burton_test_base.h"
+#include "flecsale/mesh/decomposition.h"
+#include "flecsale/mesh/factory.h"
+
+// system includes
+#include <algorithm>
+#include <vector>
+
+// explicitly use some stuff
+using flecsale::mesh::halo_t;
+using flecsale::mesh::ownership_t;
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Check that two processes agree on what they exchange.
+//!
+//! \param [in] a,b  The halos on each process.
+//! \param [in] rank_a,rank_b  The ranks of each process.
+//! \param [in] gids_a,gids_b  The global ids of the entities on each process.
+////////////////////////////////////////////////////////////////////////////////
+void check_matching(
+  const halo_t & a, const halo_t & b, int rank_a, int rank_b,
+  const std::vector<flecsale::common::global_index_t> & gids_a,
+  const std::vector<flecsale::common::global_index_t> & gids_b )
+{
+  auto find = []( const halo_t & h, int rank ) {
+    return std::find_if( h.neighbors().begin(), h.neighbors().end(),
+      [=]( const auto & n ) { return n.rank == rank; } );
+  };
+
+  auto na = find( a, rank_b );
+  auto nb = find( b, rank_a );
+  ASSERT_NE( a.neighbors().end(), na );
+  ASSERT_NE( b.neighbors().end(), nb );
+
+  // what a sends, b receives in the same order
+  ASSERT_EQ( na->send.size(), nb->recv.size() );
+  for ( std::size_t i=0; i<na->send.size(); i++ )
+    ASSERT_EQ( gids_a[ na->send[i] ], gids_b[ nb->recv[i] ] );
+
+  // and the other way around
+  ASSERT_EQ( na->recv.size(), nb->send.size() );
+  for ( std::size_t i=0; i<na->recv.size(); i++ )
+    ASSERT_EQ( gids_a[ na->recv[i] ], gids_b[ nb->send[i] ] );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Split a 2d box into four parts.
+////////////////////////////////////////////////////////////////////////////////
+TEST(burton_decomposition, box_2d) {
+
+  constexpr int num_parts = 4;
+
+  auto mesh = flecsale::mesh::box<mesh_2d_t>( 10, 10, 0, 0, 1, 1 );
+  auto owner = flecsale::mesh::block_partition( mesh.num_cells(), num_parts );
+
+  ASSERT_EQ( mesh.num_cells(), owner.size() );
+  ASSERT_EQ( 0, owner.front() );
+  ASSERT_EQ( num_parts-1, owner.back() );
+  ASSERT_TRUE( std::is_sorted( owner.begin(), owner.end() ) );
+
+  // extract each part
+  std::vector< ownership_t > parts;
+  std::vector< std::size_t > num_corners;
+  std::size_t num_owned_cells = 0;
+  std::size_t num_owned_verts = 0;
+
+  for ( int r=0; r<num_parts; r++ ) {
+    auto local = flecsale::mesh::decompose( mesh, owner, r );
+    ASSERT_TRUE( local.is_valid(false) );
+    ASSERT_TRUE( local.is_distributed() );
+    num_owned_cells += local.num_owned_cells();
+    num_owned_verts += local.num_owned_vertices();
+    num_corners.emplace_back( local.num_corners() );
+    parts.emplace_back( local.ownership() );
+
+    // the owned cells come first, and match the partition
+    const auto & layout = parts.back();
+    ASSERT_EQ( local.num_cells(), layout.cell_global_ids.size() );
+    ASSERT_EQ( local.num_vertices(), layout.vertex_global_ids.size() );
+    for ( std::size_t i=0; i<layout.cell_global_ids.size(); i++ ) {
+      auto gid = layout.cell_global_ids[i];
+      if ( i < layout.num_owned_cells ) ASSERT_EQ( r, owner[gid] );
+      else                              ASSERT_NE( r, owner[gid] );
+    }
+
+    // every ghost cell is received exactly once
+    std::size_t num_recv = 0;
+    for ( const auto & n : layout.cells.neighbors() )
+      num_recv += n.recv.size();
+    ASSERT_EQ( local.num_cells() - local.num_owned_cells(), num_recv );
+
+    num_recv = 0;
+    for ( const auto & n : layout.vertices.neighbors() )
+      num_recv += n.recv.size();
+    ASSERT_EQ( local.num_vertices() - local.num_owned_vertices(), num_recv );
+
+    // the sweeps cover the owned entities, and only the boundary ones touch
+    // ghosts
+    ASSERT_EQ( local.num_owned_cells(),
+      local.halo_interior_cells().size() + local.halo_boundary_cells().size() );
+    ASSERT_EQ( local.num_owned_vertices(),
+      local.halo_interior_vertices().size() +
+      local.halo_boundary_vertices().size() );
+    ASSERT_FALSE( local.halo_boundary_cells().empty() );
+    ASSERT_FALSE( local.halo_boundary_faces().empty() );
+    ASSERT_FALSE( local.halo_boundary_vertices().empty() );
+
+    auto cs = local.cells();
+    auto fs = local.faces();
+    auto vs = local.vertices();
+    for ( auto i : local.halo_interior_cells() )
+      for ( auto v : local.vertices( cs[i] ) )
+        ASSERT_LT( v.id(), local.num_owned_vertices() );
+    for ( auto i : local.halo_interior_faces() )
+      for ( auto c : local.cells( fs[i] ) )
+        ASSERT_LT( c.id(), local.num_owned_cells() );
+    for ( auto i : local.halo_boundary_faces() ) {
+      auto fcs = local.cells( fs[i] );
+      ASSERT_EQ( 2, fcs.size() );
+      ASSERT_NE( fcs[0].id() < local.num_owned_cells(),
+                 fcs[1].id() < local.num_owned_cells() );
+    }
+    for ( auto i : local.halo_interior_vertices() )
+      for ( auto c : local.cells( vs[i] ) )
+        ASSERT_LT( c.id(), local.num_owned_cells() );
+  }
+
+  // without a decomposition, everything is interior
+  ASSERT_EQ( mesh.num_cells(), mesh.halo_interior_cells().size() );
+  ASSERT_EQ( mesh.num_faces(), mesh.halo_interior_faces().size() );
+  ASSERT_EQ( mesh.num_vertices(), mesh.halo_interior_vertices().size() );
+  ASSERT_TRUE( mesh.halo_boundary_cells().empty() );
+  ASSERT_TRUE( mesh.halo_boundary_faces().empty() );
+  ASSERT_TRUE( mesh.halo_boundary_vertices().empty() );
+
+  // each entity is owned exactly once
+  ASSERT_EQ( mesh.num_cells(), num_owned_cells );
+  ASSERT_EQ( mesh.num_vertices(), num_owned_verts );
+
+  // the neighbors agree on what is exchanged
+  for ( int r=0; r<num_parts; r++ ) {
+    for ( const auto & n : parts[r].cells.neighbors() )
+      check_matching(
+        parts[r].cells, parts[n.rank].cells, r, n.rank,
+        parts[r].cell_global_ids, parts[n.rank].cell_global_ids );
+    for ( const auto & n : parts[r].vertices.neighbors() )
+      check_matching(
+        parts[r].vertices, parts[n.rank].vertices, r, n.rank,
+        parts[r].vertex_global_ids, parts[n.rank].vertex_global_ids );
+    // the corner lists only need to agree in size
+    for ( const auto & n : parts[r].corners.neighbors() ) {
+      const auto & other = parts[n.rank].corners.neighbors();
+      auto it = std::find_if( other.begin(), other.end(),
+        [=]( const auto & m ) { return m.rank == r; } );
+      ASSERT_NE( other.end(), it );
+      ASSERT_EQ( n.send.size(), it->recv.size() );
+      ASSERT_EQ( n.recv.size(), it->send.size() );
+      for ( auto i : n.send ) ASSERT_LT( i, num_corners[r] );
+      for ( auto i : n.recv ) ASSERT_LT( i, num_corners[r] );
+    }
+  }
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Split a 2d box built without corners.
+////////////////////////////////////////////////////////////////////////////////
+TEST(burton_decomposition, box_2d_no_corners) {
+
+  namespace attributes = flecsale::mesh::burton::attributes;
+
+  constexpr int num_parts = 4;
+
+  auto full = flecsale::mesh::box<mesh_2d_t>( 10, 10, 0, 0, 1, 1 );
+  auto owner = flecsale::mesh::block_partition( full.num_cells(), num_parts );
+
+  std::vector< ownership_t > expected;
+  for ( int r=0; r<num_parts; r++ )
+    expected.emplace_back(
+      flecsale::mesh::decompose( full, owner, r ).ownership() );
+
+  // the meshes made by decompose use the same requirements
+  auto requirements = mesh_2d_t::default_requirements();
+  mesh_2d_t::default_requirements() = attributes::require_none;
+
+  auto mesh = flecsale::mesh::box<mesh_2d_t>( 10, 10, 0, 0, 1, 1 );
+
+  std::vector< ownership_t > parts;
+  std::vector< std::size_t > num_corners;
+  for ( int r=0; r<num_parts; r++ ) {
+    auto local = flecsale::mesh::decompose( mesh, owner, r );
+    ASSERT_TRUE( local.is_valid(false) );
+    ASSERT_FALSE( local.has_corners() );
+    num_corners.emplace_back( local.num_corners() );
+    parts.emplace_back( local.ownership() );
+  }
+
+  mesh_2d_t::default_requirements() = requirements;
+
+  ASSERT_FALSE( mesh.has_corners() );
+  ASSERT_EQ( 0u, mesh.num_corners() );
+
+  // corner weights fall back to the cell vertices
+  ASSERT_EQ( flecsale::mesh::corner_weights( full ),
+    flecsale::mesh::corner_weights( mesh ) );
+
+  auto check_same = []( const halo_t & a, const halo_t & b ) {
+    ASSERT_EQ( a.neighbors().size(), b.neighbors().size() );
+    for ( std::size_t i=0; i<a.neighbors().size(); i++ ) {
+      ASSERT_EQ( a.neighbors()[i].rank, b.neighbors()[i].rank );
+      ASSERT_EQ( a.neighbors()[i].send, b.neighbors()[i].send );
+      ASSERT_EQ( a.neighbors()[i].recv, b.neighbors()[i].recv );
+    }
+  };
+
+  // the cells and vertices are split just like with corners, but there is
+  // no corner halo
+  for ( int r=0; r<num_parts; r++ ) {
+    const auto & a = parts[r];
+    const auto & b = expected[r];
+    ASSERT_EQ( 0u, num_corners[r] );
+    ASSERT_TRUE( a.corners.neighbors().empty() );
+    ASSERT_FALSE( b.corners.neighbors().empty() );
+    ASSERT_EQ( b.num_owned_cells, a.num_owned_cells );
+    ASSERT_EQ( b.num_owned_vertices, a.num_owned_vertices );
+    ASSERT_EQ( b.cell_global_ids, a.cell_global_ids );
+    ASSERT_EQ( b.vertex_global_ids, a.vertex_global_ids );
+    check_same( b.cells, a.cells );
+    check_same( b.vertices, a.vertices );
+  }
+
+}
@@ -0,0 +1,210 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Tests the distribution of a burton mesh among MPI processes.
+////////////////////////////////////////////////////////////////////////////////
+
+// user includes
+#include "burton_test_base.h"
+#include "flecsale/mesh/decomposition.h"
+#include "flecsale/mesh/factory.h"
+
+// system includes
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <numeric>
+#include <string>
+#include <vector>
+
+// explicitly use some stuff
+using flecsale::common::global_index_t;
+using flecsale::mesh::halo_t;
+using flecsale::mesh::write_mesh_part;
+using flecsale::utils::comm_rank;
+using flecsale::utils::comm_size;
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Check that two halos are the same.
+////////////////////////////////////////////////////////////////////////////////
+void check_same( const halo_t & a, const halo_t & b )
+{
+  ASSERT_EQ( a.neighbors().size(), b.neighbors().size() );
+  for ( std::size_t i=0; i<a.neighbors().size(); i++ ) {
+    ASSERT_EQ( a.neighbors()[i].rank, b.neighbors()[i].rank );
+    ASSERT_EQ( a.neighbors()[i].send, b.neighbors()[i].send );
+    ASSERT_EQ( a.neighbors()[i].recv, b.neighbors()[i].recv );
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Check that a halo delivers the owners' values to the ghosts.
+//! \param [in] halo  The halo to check.
+//! \param [in] gids  The global id of each local entity.
+//! \param [in] num_owned  The number of owned entities.
+////////////////////////////////////////////////////////////////////////////////
+void check_exchange(
+  const halo_t & halo, const std::vector<global_index_t> & gids,
+  std::size_t num_owned )
+{
+  auto n = gids.size();
+  std::vector<std::size_t> ids( n );
+  std::iota( ids.begin(), ids.end(), 0 );
+
+  // only the owned entities know their global ids
+  std::vector<global_index_t> values(
+    n, std::numeric_limits<global_index_t>::max() );
+  std::copy( gids.begin(), gids.begin() + num_owned, values.begin() );
+
+  halo.exchange( values, ids );
+  ASSERT_EQ( gids, values );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Distribute a 2d box, and compare it with the serial decomposition.
+////////////////////////////////////////////////////////////////////////////////
+TEST(burton_distribute, box_2d) {
+
+  auto rank = comm_rank();
+  auto num_ranks = comm_size();
+  ASSERT_GT( num_ranks, 1 );
+
+  // what each process should end up with, worked out from the whole mesh
+  auto global = flecsale::mesh::box<mesh_2d_t>( 20, 20, 0, 0, 1, 1 );
+  auto owner = flecsale::mesh::partition( global, num_ranks );
+  auto expected = flecsale::mesh::decompose( global, owner, rank );
+
+  // only the first process builds the mesh it hands out
+  auto mesh = rank == 0 ?
+    flecsale::mesh::box<mesh_2d_t>( 20, 20, 0, 0, 1, 1 ) : mesh_2d_t();
+  flecsale::mesh::distribute( mesh );
+
+  ASSERT_TRUE( mesh.is_valid(false) );
+  ASSERT_EQ( expected.num_cells(), mesh.num_cells() );
+  ASSERT_EQ( expected.num_vertices(), mesh.num_vertices() );
+  ASSERT_EQ( expected.num_corners(), mesh.num_corners() );
+
+  const auto & a = mesh.ownership();
+  const auto & b = expected.ownership();
+  ASSERT_EQ( b.num_owned_cells, a.num_owned_cells );
+  ASSERT_EQ( b.num_owned_vertices, a.num_owned_vertices );
+  ASSERT_EQ( b.cell_global_ids, a.cell_global_ids );
+  ASSERT_EQ( b.vertex_global_ids, a.vertex_global_ids );
+  check_same( b.cells, a.cells );
+  check_same( b.vertices, a.vertices );
+  check_same( b.corners, a.corners );
+
+  auto vs = mesh.vertices();
+  auto expected_vs = expected.vertices();
+  for ( std::size_t i=0; i<vs.size(); i++ )
+    ASSERT_EQ( expected_vs[i]->coordinates(), vs[i]->coordinates() );
+
+  // the ghosts get their owners' values
+  check_exchange( a.cells, a.cell_global_ids, a.num_owned_cells );
+  check_exchange( a.vertices, a.vertex_global_ids, a.num_owned_vertices );
+
+}
+
+// the merge tool is only built with exodus
+#ifdef FLECSALE_EPU
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Return the sorted coordinates of a list of points.
+//!
+//! A merged file orders its entities differently than a serial one, so the
+//! meshes are compared through these.  The points are sorted on rounded
+//! coordinates, so round-off cannot change their order.
+//!
+//! \param [in] points  The points to sort.
+////////////////////////////////////////////////////////////////////////////////
+template< typename P >
+auto sorted_points( std::vector<P> points )
+{
+  auto key = []( const P & p ) {
+    std::vector<long> k( p.size() );
+    for ( std::size_t d=0; d<k.size(); d++ ) k[d] = std::lround( p[d] * 1.e8 );
+    return k;
+  };
+  std::sort( points.begin(), points.end(), 
+    [&]( const P & a, const P & b ) { return key(a) < key(b); } );
+  return points;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Check that two meshes have the same vertices and cells.
+//! \param [in] a,b  The meshes to compare.
+////////////////////////////////////////////////////////////////////////////////
+template< typename M >
+void check_same_geometry( const M & a, const M & b )
+{
+  using point_t = typename M::point_t;
+
+  ASSERT_EQ( a.num_vertices(), b.num_vertices() );
+  ASSERT_EQ( a.num_cells(), b.num_cells() );
+
+  std::vector<point_t> va, vb, ca, cb;
+  for ( auto v : a.vertices() ) va.emplace_back( v->coordinates() );
+  for ( auto v : b.vertices() ) vb.emplace_back( v->coordinates() );
+  for ( auto c : a.cells() ) ca.emplace_back( c->centroid() );
+  for ( auto c : b.cells() ) cb.emplace_back( c->centroid() );
+
+  va = sorted_points( va );
+  vb = sorted_points( vb );
+  for ( std::size_t i=0; i<va.size(); i++ )
+    ASSERT_EQ( va[i], vb[i] );
+
+  ca = sorted_points( ca );
+  cb = sorted_points( cb );
+  for ( std::size_t i=0; i<ca.size(); i++ )
+    for ( std::size_t d=0; d<ca[i].size(); d++ )
+      ASSERT_NEAR( ca[i][d], cb[i][d], TEST_TOLERANCE );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Write a distributed box in parts, merge them, and compare the 
+//!        result with the serial output.
+////////////////////////////////////////////////////////////////////////////////
+TEST(burton_distribute, exodus_parts_2d) {
+
+  auto rank = comm_rank();
+  auto num_ranks = comm_size();
+  ASSERT_GT( num_ranks, 1 );
+
+  const std::string serial_name = "burton_distribute.exodus_parts_2d.serial.exo";
+  const std::string parts_name = "burton_distribute.exodus_parts_2d.exo";
+  const std::string merged_name = "burton_distribute.exodus_parts_2d.merged.exo";
+
+  // the first process builds the mesh, and writes it whole
+  auto mesh = rank == 0 ?
+    flecsale::mesh::box<mesh_2d_t>( 20, 20, 0, 0, 1, 1 ) : mesh_2d_t();
+  if ( rank == 0 ) 
+    ASSERT_FALSE( write_mesh( serial_name, mesh ) );
+
+  // then every process writes its own part
+  flecsale::mesh::distribute( mesh );
+  auto status = write_mesh_part( parts_name, mesh );
+
+  // wait for all the parts, and make sure they all made it
+  ASSERT_EQ( 0, flecsale::utils::global_sum( status ) );
+
+  if ( rank != 0 ) return;
+
+  // merge the parts
+  auto cmd = std::string( FLECSALE_EPU ) + " -p " + std::to_string( num_ranks ) 
+    + " -o " + merged_name + " " + parts_name;
+  ASSERT_EQ( 0, std::system( cmd.c_str() ) );
+
+  // and compare the two
+  mesh_2d_t serial, merged;
+  ASSERT_FALSE( read_mesh( serial_name, serial ) );
+  ASSERT_FALSE( read_mesh( merged_name, merged ) );
+  ASSERT_TRUE( merged.is_valid(false) );
+  check_same_geometry( serial, merged );
+
+}
+
+#endif // FLECSALE_EPU
@@ -12,6 +12,17 @@
 
 // user includes
 #include "burton_io_test.h"
+#include "flecsale/mesh/factory.h"
+
+// system includes
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
 
 
 // Below tests need exodus to read the file
@@ -317,3 +328,383 @@ TEST_F(burton_io, read_write_vtm_2d) {
 } // TEST_F
 
 #endif // HAVE_VTK
+
+
+// The native vtu writer needs nothing else
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief A vtu file written by the native writer, read back.
+////////////////////////////////////////////////////////////////////////////////
+struct vtu_file_t {
+
+  //! \brief the header type preceding each array
+  using header_t = std::uint64_t;
+
+  //! \brief the xml, up to the appended data
+  string xml;
+  //! \brief the appended data
+  string appended;
+
+  //! \brief Read a file, and split it into the xml and the appended data.
+  explicit vtu_file_t( const string & name )
+  {
+    std::ifstream file( name, std::ios::binary );
+    string contents( 
+      (std::istreambuf_iterator<char>( file )), 
+      std::istreambuf_iterator<char>() );
+    string start = "<AppendedData encoding=\"raw\">\n   _";
+    string end = "\n  </AppendedData>";
+    auto begin = contents.find( start );
+    auto last = contents.rfind( end );
+    if ( begin == string::npos || last == string::npos ) return;
+    xml = contents.substr( 0, begin );
+    begin += start.size();
+    appended = contents.substr( begin, last - begin );
+  }
+
+  //! \brief Return the value of an attribute of the first matching element.
+  //! \param [in] element  The start of the element, e.g. "<Piece".
+  //! \param [in] attr  The attribute name.
+  string attribute( const string & element, const string & attr ) const
+  {
+    auto pos = xml.find( element );
+    if ( pos == string::npos ) return {};
+    auto stop = xml.find( '>', pos );
+    auto key = " " + attr + "=\"";
+    pos = xml.find( key, pos );
+    if ( pos == string::npos || pos > stop ) return {};
+    pos += key.size();
+    return xml.substr( pos, xml.find( '"', pos ) - pos );
+  }
+
+  //! \brief Return the name and type of each array in a section.
+  //! \param [in] section  The section, e.g. "PointData".
+  std::vector< std::pair<string, string> > arrays( const string & section ) const
+  {
+    std::vector< std::pair<string, string> > list;
+    auto pos = xml.find( "<" + section + ">" );
+    auto stop = xml.find( "</" + section + ">", pos );
+    if ( pos == string::npos || stop == string::npos ) return list;
+    auto value = []( const string & element, const string & attr ) {
+      auto key = " " + attr + "=\"";
+      auto start = element.find( key );
+      if ( start == string::npos ) return string();
+      start += key.size();
+      return element.substr( start, element.find( '"', start ) - start );
+    };
+    for ( pos = xml.find( "<DataArray", pos ); pos < stop; 
+          pos = xml.find( "<DataArray", pos+1 ) ) {
+      auto element = xml.substr( pos, xml.find( '>', pos ) - pos );
+      list.emplace_back( value( element, "Name" ), value( element, "type" ) );
+    }
+    return list;
+  }
+
+  //! \brief Return the offset of each array, and whether it is lossy, in 
+  //!        increasing order.
+  std::vector< std::pair<std::size_t, bool> > offsets() const
+  {
+    std::vector< std::pair<std::size_t, bool> > list;
+    string key = " offset=\"";
+    for ( auto pos = xml.find( "<DataArray" ); pos != string::npos; 
+          pos = xml.find( "<DataArray", pos+1 ) ) {
+      auto element = xml.substr( pos, xml.find( '>', pos ) - pos );
+      auto start = element.find( key ) + key.size();
+      list.emplace_back( 
+        std::stoul( element.substr( start ) ),
+        element.find( "FleCSALELossyCompressor" ) != string::npos );
+    }
+    std::sort( list.begin(), list.end() );
+    return list;
+  }
+
+  //! \brief Read the i-th header word of the array at an offset.
+  header_t header( std::size_t offset, std::size_t i ) const
+  {
+    header_t h;
+    std::memcpy( &h, appended.data() + offset + i*sizeof(header_t), sizeof(h) );
+    return h;
+  }
+
+  //! \brief Return the number of encoded bytes of the array at an offset.
+  std::size_t encoded_size( std::size_t offset, bool compressed ) const
+  {
+    if ( !compressed ) return sizeof(header_t) + header( offset, 0 );
+    auto num_blocks = header( offset, 0 );
+    std::size_t bytes = ( 3 + num_blocks ) * sizeof(header_t);
+    for ( std::size_t b=0; b<num_blocks; b++ ) bytes += header( offset, 3+b );
+    return bytes;
+  }
+
+  //! \brief Return the bytes of the array at an offset, inflating them if 
+  //!        the file is compressed.
+  //! \return The bytes, or nothing if they could not be inflated.
+  string inflate( std::size_t offset ) const
+  {
+    auto compressor = attribute( "<VTKFile", "compressor" );
+    if ( compressor.empty() )
+      return appended.substr( offset + sizeof(header_t), header( offset, 0 ) );
+
+    auto num_blocks = header( offset, 0 );
+    auto block_size = header( offset, 1 );
+    auto last_size = header( offset, 2 );
+    auto pos = offset + ( 3 + num_blocks ) * sizeof(header_t);
+
+    string bytes;
+    for ( std::size_t b=0; b<num_blocks; b++ ) {
+      auto in_bytes = header( offset, 3+b );
+      auto out_bytes = ( b+1 == num_blocks && last_size ) ? 
+        last_size : block_size;
+      string block( out_bytes, '\0' );
+      auto ok = false;
+#ifdef HAVE_ZLIB
+      if ( compressor == "vtkZLibDataCompressor" ) {
+        uLongf n = out_bytes;
+        ok = uncompress( 
+          reinterpret_cast<Bytef*>( &block[0] ), &n,
+          reinterpret_cast<const Bytef*>( appended.data() + pos ), 
+          in_bytes ) == Z_OK && n == out_bytes;
+      }
+#endif
+#ifdef HAVE_LZ4
+      if ( compressor == "vtkLZ4DataCompressor" )
+        ok = LZ4_decompress_safe( 
+          appended.data() + pos, &block[0], in_bytes, out_bytes ) == 
+          static_cast<int>( out_bytes );
+#endif
+      if ( !ok ) return {};
+      bytes += block;
+      pos += in_bytes;
+    }
+    return bytes;
+  }
+
+  //! \brief Decode an array that was not stored lossily.
+  //! \param [in] name  The array name, or an empty name for the points.
+  template< typename T >
+  std::vector<T> decode( const string & name ) const
+  {
+    auto element = name.empty() ? 
+      string( "<DataArray type" ) : "Name=\"" + name + "\"";
+    // the points array is the only one without a name
+    auto pos = name.empty() ? xml.find( "<Points>" ) : 0;
+    pos = xml.find( element, pos );
+    if ( pos == string::npos ) return {};
+    string key = " offset=\"";
+    pos = xml.find( key, pos ) + key.size();
+    auto offset = std::stoul( xml.substr( pos ) );
+    auto bytes = inflate( offset );
+    std::vector<T> values( bytes.size() / sizeof(T) );
+    std::memcpy( values.data(), bytes.data(), values.size() * sizeof(T) );
+    return values;
+  }
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Restores the default vtu compression when it goes out of scope, 
+//!        so a failed test does not change it for the others.
+////////////////////////////////////////////////////////////////////////////////
+struct compression_guard_t {
+  using vtu_writer = flecsale::io::vtu_writer;
+  vtu_writer::compression_t saved = vtu_writer::default_compression();
+  ~compression_guard_t() { vtu_writer::default_compression() = saved; }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Check the header and the array offsets of a vtu file.
+//! \param [in] file  The file read back.
+//! \param [in] m  The mesh written to it.
+//! \param [in] compressed  True if the file should be compressed.
+////////////////////////////////////////////////////////////////////////////////
+template< typename M >
+void check_vtu_layout( const vtu_file_t & file, const M & m, bool compressed )
+{
+  ASSERT_FALSE( file.xml.empty() );
+  EXPECT_EQ( "UnstructuredGrid", file.attribute( "<VTKFile", "type" ) );
+  EXPECT_EQ( "UInt64", file.attribute( "<VTKFile", "header_type" ) );
+  EXPECT_EQ( compressed, !file.attribute( "<VTKFile", "compressor" ).empty() );
+  EXPECT_EQ( std::to_string( m.num_vertices() ),
+    file.attribute( "<Piece", "NumberOfPoints" ) );
+  EXPECT_EQ( std::to_string( m.num_cells() ),
+    file.attribute( "<Piece", "NumberOfCells" ) );
+
+  // the arrays are packed one after the other, and fill the appended data.
+  // Lossy arrays are never compressed again.
+  auto offsets = file.offsets();
+  ASSERT_FALSE( offsets.empty() );
+  EXPECT_EQ( 0u, offsets.front().first );
+  offsets.emplace_back( file.appended.size(), false );
+  for ( std::size_t i=0; i+1<offsets.size(); i++ ) {
+    auto offset = offsets[i].first;
+    auto lossy = offsets[i].second;
+    ASSERT_EQ( offsets[i+1].first - offset, 
+      file.encoded_size( offset, compressed && !lossy ) );
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Check the arrays decoded from a vtu file.
+//! \param [in] file  The file read back.
+//! \param [in] m  The mesh written to it, with the data from create_data().
+////////////////////////////////////////////////////////////////////////////////
+template< typename M >
+void check_vtu_data( const vtu_file_t & file, M & m )
+{
+  using real_t = typename M::real_t;
+  constexpr auto num_dims = M::num_dimensions;
+
+  // the points are always 3d
+  auto points = file.decode<real_t>( "" );
+  ASSERT_EQ( 3*m.num_vertices(), points.size() );
+  for ( auto v : m.vertices() )
+    for ( std::size_t d=0; d<num_dims; d++ )
+      ASSERT_EQ( v->coordinates()[d], points[ 3*v.id() + d ] );
+
+  auto pressure = file.decode<real_t>( "pressure" );
+  ASSERT_EQ( m.num_cells(), pressure.size() );
+  for ( auto c : m.cells() )
+    ASSERT_EQ( static_cast<real_t>( c.id() ), pressure[ c.id() ] );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief test writing a 2d mesh with the native vtu writer
+////////////////////////////////////////////////////////////////////////////////
+TEST_F(burton_io, write_vtu_2d) {
+  auto m = flecsale::mesh::box<mesh_2d_t>( 10, 10, 0, 0, 1, 1 );
+  create_data(m);
+  using flecsale::io::vtu_writer;
+  compression_guard_t guard;
+  auto & compression = vtu_writer::default_compression();
+  // uncompressed
+  compression = vtu_writer::compression_t::none;
+  ASSERT_FALSE(write_mesh(output_prefix()+"-raw.vtu", m));
+  ASSERT_FALSE(flecsale::mesh::write_mesh_part(output_prefix()+"-raw.pvtu", m));
+  ASSERT_FALSE(write_mesh(output_prefix()+"-raw.vtm", m));
+  vtu_file_t raw( output_prefix()+"-raw.vtu" );
+  check_vtu_layout( raw, m, false );
+  check_vtu_data( raw, m );
+  // and with each compression that was built in
+#ifdef HAVE_ZLIB
+  compression = vtu_writer::compression_t::zlib;
+  ASSERT_FALSE(write_mesh(output_prefix()+"-zlib.vtu", m));
+  vtu_file_t zlib( output_prefix()+"-zlib.vtu" );
+  EXPECT_EQ( "vtkZLibDataCompressor", zlib.attribute( "<VTKFile", "compressor" ) );
+  check_vtu_layout( zlib, m, true );
+  check_vtu_data( zlib, m );
+#endif
+#ifdef HAVE_LZ4
+  compression = vtu_writer::compression_t::lz4;
+  ASSERT_FALSE(write_mesh(output_prefix()+"-lz4.vtu", m));
+  vtu_file_t lz4( output_prefix()+"-lz4.vtu" );
+  EXPECT_EQ( "vtkLZ4DataCompressor", lz4.attribute( "<VTKFile", "compressor" ) );
+  check_vtu_layout( lz4, m, true );
+  check_vtu_data( lz4, m );
+#endif
+} // TEST_F
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief test writing a 3d mesh with the native vtu writer
+////////////////////////////////////////////////////////////////////////////////
+TEST_F(burton_io, write_vtu_3d) {
+  auto m = flecsale::mesh::box<mesh_3d_t>( 5, 5, 5, 0, 0, 0, 1, 1, 1 );
+  create_data(m);
+  using flecsale::io::vtu_writer;
+  compression_guard_t guard;
+  auto & compression = vtu_writer::default_compression();
+  // with the default compression
+  ASSERT_FALSE(write_mesh(output_prefix()+".vtu", m));
+  ASSERT_FALSE(flecsale::mesh::write_mesh_part(output_prefix()+".pvtu", m));
+  vtu_file_t file( output_prefix()+".vtu" );
+  check_vtu_layout( file, m, guard.saved != vtu_writer::compression_t::none );
+  check_vtu_data( file, m );
+  // and uncompressed
+  compression = vtu_writer::compression_t::none;
+  ASSERT_FALSE(write_mesh(output_prefix()+"-raw.vtu", m));
+  vtu_file_t raw( output_prefix()+"-raw.vtu" );
+  check_vtu_layout( raw, m, false );
+  check_vtu_data( raw, m );
+} // TEST_F
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief test that an abandoned vtu file leaves nothing behind
+////////////////////////////////////////////////////////////////////////////////
+TEST_F(burton_io, abort_vtu) {
+  auto exists = []( const string & name ) {
+    return std::ifstream( name ).good();
+  };
+  auto name = output_prefix()+".vtu";
+  flecsale::io::vtu_writer writer;
+  ASSERT_FALSE( writer.open( name.c_str() ) );
+  double coords[3] = { 0, 0, 0 };
+  ASSERT_FALSE( writer.write_points( coords, 1 ) );
+  ASSERT_TRUE( exists( name ) );
+  ASSERT_TRUE( exists( name+".appended" ) );
+  writer.abort();
+  EXPECT_FALSE( exists( name ) );
+  EXPECT_FALSE( exists( name+".appended" ) );
+  // and it does nothing once the file is closed
+  ASSERT_FALSE( writer.open( name.c_str() ) );
+  ASSERT_FALSE( writer.write_points( coords, 1 ) );
+  ASSERT_FALSE( writer.close() );
+  writer.abort();
+  EXPECT_TRUE( exists( name ) );
+  EXPECT_FALSE( exists( name+".appended" ) );
+} // TEST_F
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief test writing a subset of the data in single precision
+////////////////////////////////////////////////////////////////////////////////
+TEST_F(burton_io, write_output_profile_2d) {
+  auto m = flecsale::mesh::box<mesh_2d_t>( 20, 20, 0, 0, 1, 1 );
+  create_data(m);
+  // the size of a file
+  auto file_size = []( const string & name ) {
+    std::ifstream file( name, std::ios::binary | std::ios::ate );
+    return static_cast<std::size_t>( file.tellg() );
+  };
+  // everything at full precision
+  using flecsale::io::vtu_writer;
+  compression_guard_t guard;
+  vtu_writer::default_compression() = vtu_writer::compression_t::none;
+  auto full_name = output_prefix()+"-full.vtu";
+  ASSERT_FALSE(write_mesh(full_name, m));
+  // only the velocity, in single precision
+  flecsale::mesh::output_profile_t profile;
+  profile["vtu"].fields = { "velocity" };
+  profile["vtu"].precision = flecsale::mesh::output_precision_t::float32;
+  profile["vtk"].precision = flecsale::mesh::output_precision_t::float32;
+  // no regions at all
+  profile["vtm"].set_regions( {} );
+  m.set_output_profile( profile );
+  auto reduced_name = output_prefix()+"-reduced.vtu";
+  ASSERT_FALSE(write_mesh(reduced_name, m));
+  ASSERT_FALSE(write_mesh(output_prefix()+"-reduced.vtk", m));
+  ASSERT_FALSE(write_mesh(output_prefix()+"-reduced.vtm", m));
+  // the coordinates are left alone, but the rest shrinks
+  EXPECT_LT( file_size(reduced_name), file_size(full_name) );
+  // only the velocity is written, in single precision
+  vtu_file_t reduced( reduced_name );
+  using array_list_t = std::vector< std::pair<string, string> >;
+  EXPECT_EQ( array_list_t( { {"velocity", "Float32"} } ), 
+    reduced.arrays( "PointData" ) );
+  EXPECT_EQ( array_list_t(), reduced.arrays( "CellData" ) );
+  // but the coordinates keep the precision of the mesh
+  auto points = reduced.arrays( "Points" );
+  ASSERT_EQ( 1u, points.size() );
+  EXPECT_EQ( sizeof(mesh_2d_t::real_t) == 8 ? "Float64" : "Float32", 
+    points[0].second );
+  // and the multiblock file has no blocks
+  std::ifstream vtm( output_prefix()+"-reduced.vtm" );
+  string vtm_contents( 
+    (std::istreambuf_iterator<char>( vtm )), std::istreambuf_iterator<char>() );
+  EXPECT_NE( string::npos, vtm_contents.find( "<vtkMultiBlockDataSet>" ) );
+  EXPECT_EQ( string::npos, vtm_contents.find( "<DataSet" ) );
+  EXPECT_FALSE( std::ifstream( output_prefix()+"-reduced_0.vtu" ).good() );
+  // and the profile follows copies of the mesh
+  mesh_2d_t copy( m );
+  EXPECT_EQ( flecsale::mesh::output_precision_t::float32, 
+    copy.output_profile().get(reduced_name).precision );
+  EXPECT_EQ( flecsale::mesh::output_precision_t::float64, 
+    copy.output_profile().get(output_prefix()+".exo").precision );
+} // TEST_F
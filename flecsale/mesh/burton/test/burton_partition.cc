@@ -0,0 +1,85 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Tests the partitioning of burton meshes.
+////////////////////////////////////////////////////////////////////////////////
+
+// user includes
+#include "burton_test_base.h"
+#include "flecsale/mesh/factory.h"
+#include "flecsale/mesh/partition.h"
+
+// system includes
+#include <algorithm>
+#include <vector>
+
+// explicitly use some stuff
+using flecsale::mesh::partition_method_t;
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Partition a mesh with every method, and compare the results.
+//!
+//! \param [in] mesh  The mesh to partition.
+//! \param [in] num_parts  The number of parts.
+//! \param [in] weights  The weight of each cell.
+////////////////////////////////////////////////////////////////////////////////
+template< typename M >
+void check_partitions(
+  M & mesh, int num_parts, const std::vector<std::size_t> & weights = {} )
+{
+  auto graph = flecsale::mesh::dual_graph( mesh, weights );
+  ASSERT_EQ( mesh.num_cells(), graph.size() );
+
+  auto block = flecsale::mesh::partition(
+    mesh, num_parts, partition_method_t::block, weights );
+  auto block_quality =
+    flecsale::mesh::evaluate_partition( graph, block, num_parts );
+
+  for ( auto method :
+    { partition_method_t::geometric, partition_method_t::multilevel } )
+  {
+    auto owner = flecsale::mesh::partition( mesh, num_parts, method, weights );
+    ASSERT_EQ( mesh.num_cells(), owner.size() );
+
+    // every part gets something
+    for ( int p=0; p<num_parts; p++ )
+      ASSERT_NE( owner.end(), std::find( owner.begin(), owner.end(), p ) );
+
+    // the parts are balanced, and cut less than the naive blocks
+    auto quality = flecsale::mesh::evaluate_partition( graph, owner, num_parts );
+    ASSERT_GE( quality.imbalance, 1.0 ) << "method " << static_cast<int>(method);
+    ASSERT_LE( quality.imbalance, 1.05 ) << "method " << static_cast<int>(method);
+    ASSERT_GT( quality.edge_cut, 0u ) << "method " << static_cast<int>(method);
+    ASSERT_LT( quality.edge_cut, block_quality.edge_cut ) 
+      << "method " << static_cast<int>(method);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Partition a 2d box.
+////////////////////////////////////////////////////////////////////////////////
+TEST_F(burton_test_base, partition_2d) {
+
+  auto mesh = flecsale::mesh::box<mesh_2d_t>( 32, 32, 0, 0, 1, 1 );
+  check_partitions( mesh, 4 );
+  check_partitions( mesh, 7, flecsale::mesh::corner_weights(mesh) );
+
+  // the partition can be plotted
+  auto owner = flecsale::mesh::partition( mesh, 4 );
+  mesh.set_cell_partition( owner );
+  ASSERT_FALSE( write_mesh( output_prefix()+".exo", mesh ) );
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Partition a 3d box.
+////////////////////////////////////////////////////////////////////////////////
+TEST_F(burton_test_base, partition_3d) {
+
+  auto mesh = flecsale::mesh::box<mesh_3d_t>( 12, 12, 12, 0, 0, 0, 1, 1, 1 );
+  check_partitions( mesh, 8 );
+
+}
@@ -0,0 +1,313 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Bulk construction of the sub-entities of a list of cells.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// user includes
+#include "flecsale/common/types.h"
+#include "flecsale/utils/radix_sort.h"
+
+// system includes
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <numeric>
+#include <vector>
+
+namespace flecsale {
+namespace mesh {
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief The sub-entities of a reference element.
+//!
+//! Each sub-entity is a list of local vertex indices, in the order that sets
+//! its orientation.
+////////////////////////////////////////////////////////////////////////////////
+class local_entities_t {
+public:
+
+  //! \brief Default constructor, for no sub-entities.
+  local_entities_t() = default;
+
+  //! \brief Construct from a list of local vertex lists.
+  local_entities_t(
+    std::initializer_list< std::initializer_list<std::size_t> > entities )
+  {
+    for ( const auto & e : entities ) {
+      indices_.insert( indices_.end(), e.begin(), e.end() );
+      offsets_.emplace_back( indices_.size() );
+    }
+  }
+
+  //! \brief The edges of an n-sided polygon, i.e. each vertex to the next.
+  static local_entities_t ring( std::size_t n )
+  {
+    local_entities_t ents;
+    for ( std::size_t i=0; i<n; i++ ) {
+      ents.indices_.emplace_back( i );
+      ents.indices_.emplace_back( (i+1) % n );
+      ents.offsets_.emplace_back( ents.indices_.size() );
+    }
+    return ents;
+  }
+
+  //! \brief The number of sub-entities.
+  std::size_t size() const { return offsets_.size() - 1; }
+
+  //! \brief The number of vertices of sub-entity i.
+  std::size_t num_vertices( std::size_t i ) const
+  { return offsets_[i+1] - offsets_[i]; }
+
+  //! \brief The local vertices of sub-entity i.
+  const std::size_t * vertices( std::size_t i ) const
+  { return indices_.data() + offsets_[i]; }
+
+  //! \brief Fill in the sub-entities of a cell, flecsi create_entities style.
+  //! \param [in] verts  The cell vertices.
+  //! \param [out] entities  The vertices of each sub-entity, one after the
+  //!   other.
+  //! \return The number of vertices in each sub-entity.
+  template< typename V, typename T >
+  std::vector<std::size_t> fill( const V & verts, T * entities ) const
+  {
+    for ( std::size_t i=0; i<indices_.size(); i++ )
+      entities[i] = verts[ indices_[i] ];
+    std::vector<std::size_t> counts( size() );
+    for ( std::size_t i=0; i<counts.size(); i++ ) counts[i] = num_vertices(i);
+    return counts;
+  }
+
+private:
+
+  //! \brief The offsets into the indices.
+  std::vector<std::size_t> offsets_ = {0};
+  //! \brief The local vertices of each sub-entity.
+  std::vector<std::size_t> indices_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief The unique sub-entities of a list of cells, and their adjacency.
+//!
+//! All lists are compressed rows, i.e. the entries of item i are stored from
+//! offsets[i] to offsets[i+1].  The ids themselves are 32 bit, which halves
+//! the memory they take, but the offsets can go past that.
+////////////////////////////////////////////////////////////////////////////////
+struct sub_entities_t {
+
+  //! \brief The type of the vertex, cell and sub-entity ids.
+  using index_t = common::local_index_t;
+
+  //! \brief The vertices of each sub-entity.
+  std::vector<std::size_t> vertex_offsets = {0};
+  //! \copydoc vertex_offsets
+  std::vector<index_t> vertices;
+
+  //! \brief The sub-entities of each cell, in local order.
+  std::vector<std::size_t> cell_offsets = {0};
+  //! \copydoc cell_offsets
+  std::vector<index_t> cell_entities;
+
+  //! \brief The cells of each sub-entity, in increasing order.
+  std::vector<std::size_t> entity_cell_offsets = {0};
+  //! \copydoc entity_cell_offsets
+  std::vector<index_t> entity_cells;
+
+  //! \brief The number of sub-entities.
+  std::size_t size() const { return vertex_offsets.size() - 1; }
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Build the unique sub-entities of a list of cells.
+//!
+//! Every cell emits all of its candidate sub-entities at once.  Each
+//! candidate is keyed by its two smallest vertices and radix sorted, then
+//! the few candidates sharing a key are sorted by their full vertex sets, so
+//! that duplicates end up next to each other.  Ids are then assigned in bulk.
+//! All of this is done in parallel.
+//!
+//! The result is the same as visiting the cells in order and numbering each
+//! sub-entity when it is first seen: sub-entities are numbered in order of
+//! their first appearance, and keep the orientation of that first cell.
+//!
+//! \param [in] num_vertices  The number of vertices.
+//! \param [in] cell_vertex_offsets,cell_vertices  The vertices of each cell.
+//! \param [in] local_entities  Called as local_entities(c) to get the
+//!   local_entities_t of cell c.
+//! \return The sub-entities.
+////////////////////////////////////////////////////////////////////////////////
+template< typename F >
+sub_entities_t build_sub_entities(
+  std::size_t num_vertices,
+  const std::vector<std::size_t> & cell_vertex_offsets,
+  const std::vector<sub_entities_t::index_t> & cell_vertices,
+  F && local_entities )
+{
+  using utils::counts_to_offsets;
+  using index_t = sub_entities_t::index_t;
+
+  auto num_cells = cell_vertex_offsets.size() - 1;
+
+  sub_entities_t ents;
+
+  //----------------------------------------------------------------------------
+  // Emit the candidates
+  //----------------------------------------------------------------------------
+
+  auto & cand_offsets = ents.cell_offsets;
+  cand_offsets.resize( num_cells+1 );
+
+  #pragma omp parallel for
+  for ( std::size_t c=0; c<num_cells; c++ )
+    cand_offsets[c+1] = local_entities(c).size();
+  counts_to_offsets( cand_offsets );
+
+  auto num_cands = cand_offsets.back();
+
+  std::vector<std::size_t> cand_vertex_offsets( num_cands+1 );
+
+  #pragma omp parallel for
+  for ( std::size_t c=0; c<num_cells; c++ ) {
+    const auto & local = local_entities(c);
+    for ( std::size_t i=0; i<local.size(); i++ )
+      cand_vertex_offsets[ cand_offsets[c] + i + 1 ] = local.num_vertices(i);
+  }
+  counts_to_offsets( cand_vertex_offsets );
+
+  // the sorted vertices of each candidate
+  std::vector<index_t> cand_sorted( cand_vertex_offsets.back() );
+  std::vector<index_t> cand_cell( num_cands );
+  std::vector<std::uint64_t> keys( num_cands );
+
+  // the vertex ids are 32 bit, so the two smallest always fit in the key
+  #pragma omp parallel for
+  for ( std::size_t c=0; c<num_cells; c++ ) {
+    const auto & local = local_entities(c);
+    auto cverts = cell_vertices.data() + cell_vertex_offsets[c];
+    for ( std::size_t i=0; i<local.size(); i++ ) {
+      auto cand = cand_offsets[c] + i;
+      auto n = local.num_vertices(i);
+      auto lverts = local.vertices(i);
+      auto sorted = cand_sorted.data() + cand_vertex_offsets[cand];
+      for ( std::size_t j=0; j<n; j++ ) sorted[j] = cverts[ lverts[j] ];
+      std::sort( sorted, sorted + n );
+      keys[cand] = ( n < 2 ) ?
+        sorted[0] : std::uint64_t(sorted[0]) * num_vertices + sorted[1];
+      cand_cell[cand] = c;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  // Bring duplicates together
+  //----------------------------------------------------------------------------
+
+  // the sort is stable, so equal keys stay in candidate order
+  std::vector<std::size_t> order( num_cands );
+  std::iota( order.begin(), order.end(), 0 );
+  utils::radix_sort_by_key( keys, order );
+
+  auto sorted_less = [&]( auto a, auto b )
+  {
+    auto sorted = cand_sorted.data();
+    return std::lexicographical_compare(
+      sorted + cand_vertex_offsets[a], sorted + cand_vertex_offsets[a+1],
+      sorted + cand_vertex_offsets[b], sorted + cand_vertex_offsets[b+1] );
+  };
+
+  auto runs = utils::select_indices( num_cands,
+    [&]( auto i ) { return i == 0 || keys[i] != keys[i-1]; } );
+  runs.emplace_back( num_cands );
+
+  #pragma omp parallel for schedule(dynamic, 1024)
+  for ( std::size_t r=0; r<runs.size()-1; r++ )
+    if ( runs[r+1] - runs[r] > 2 ||
+        ( runs[r+1] - runs[r] == 2 &&
+          sorted_less( order[runs[r]+1], order[runs[r]] ) ) )
+      std::stable_sort(
+        order.begin() + runs[r], order.begin() + runs[r+1], sorted_less );
+
+  // the first candidate of each group of duplicates
+  auto groups = utils::select_indices( num_cands,
+    [&]( auto i ) {
+      return i == 0 || keys[i] != keys[i-1] ||
+        sorted_less( order[i-1], order[i] );
+    } );
+  groups.emplace_back( num_cands );
+  auto num_ents = groups.size() - 1;
+
+  //----------------------------------------------------------------------------
+  // Number the sub-entities in order of first appearance
+  //----------------------------------------------------------------------------
+
+  std::vector<unsigned char> is_first( num_cands, 0 );
+  #pragma omp parallel for
+  for ( std::size_t g=0; g<num_ents; g++ ) is_first[ order[groups[g]] ] = 1;
+
+  auto firsts = utils::select_indices( num_cands,
+    [&]( auto i ) { return is_first[i]; } );
+
+  // the sub-entity of each candidate
+  auto & cand_entity = ents.cell_entities;
+  cand_entity.resize( num_cands );
+  #pragma omp parallel for
+  for ( std::size_t e=0; e<num_ents; e++ ) cand_entity[ firsts[e] ] = e;
+
+  ents.entity_cell_offsets.resize( num_ents+1 );
+  #pragma omp parallel for
+  for ( std::size_t g=0; g<num_ents; g++ ) {
+    auto e = cand_entity[ order[groups[g]] ];
+    for ( auto i=groups[g]+1; i<groups[g+1]; i++ )
+      cand_entity[ order[i] ] = e;
+    ents.entity_cell_offsets[e+1] = groups[g+1] - groups[g];
+  }
+  counts_to_offsets( ents.entity_cell_offsets );
+
+  //----------------------------------------------------------------------------
+  // Fill in the adjacency
+  //----------------------------------------------------------------------------
+
+  ents.entity_cells.resize( num_cands );
+  #pragma omp parallel for
+  for ( std::size_t g=0; g<num_ents; g++ ) {
+    auto e = cand_entity[ order[groups[g]] ];
+    auto pos = ents.entity_cell_offsets[e];
+    for ( auto i=groups[g]; i<groups[g+1]; i++ )
+      ents.entity_cells[pos++] = cand_cell[ order[i] ];
+  }
+
+  ents.vertex_offsets.resize( num_ents+1 );
+  #pragma omp parallel for
+  for ( std::size_t e=0; e<num_ents; e++ ) {
+    auto cand = firsts[e];
+    ents.vertex_offsets[e+1] =
+      cand_vertex_offsets[cand+1] - cand_vertex_offsets[cand];
+  }
+  counts_to_offsets( ents.vertex_offsets );
+
+  // the first candidate sets the orientation
+  ents.vertices.resize( ents.vertex_offsets.back() );
+  #pragma omp parallel for
+  for ( std::size_t e=0; e<num_ents; e++ ) {
+    auto cand = firsts[e];
+    auto c = cand_cell[cand];
+    const auto & local = local_entities(c);
+    auto i = cand - cand_offsets[c];
+    auto cverts = cell_vertices.data() + cell_vertex_offsets[c];
+    auto lverts = local.vertices(i);
+    auto verts = ents.vertices.data() + ents.vertex_offsets[e];
+    for ( std::size_t j=0; j<local.num_vertices(i); j++ )
+      verts[j] = cverts[ lverts[j] ];
+  }
+
+  return ents;
+}
+
+} // namespace mesh
+} // namespace flecsale
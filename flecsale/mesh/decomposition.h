@@ -0,0 +1,571 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Tools for splitting a mesh up among several processes.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// user includes
+#include "flecsale/mesh/halo.h"
+#include "flecsale/mesh/partition.h"
+#include "flecsale/utils/errors.h"
+#include "flecsale/utils/mpi_utils.h"
+
+// system includes
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace flecsale {
+namespace mesh {
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief The part of a mesh held by one process.
+//!
+//! This is everything a process needs to build its local mesh and halos,
+//! without ever seeing the rest of the global mesh.  The local cells and
+//! vertices list the owned ones first, and each group is in the order of
+//! the global ids.
+//!
+//! \tparam M  The mesh type.
+////////////////////////////////////////////////////////////////////////////////
+template< typename M >
+struct mesh_part_t {
+
+  //! \brief The type of the local and global ids.
+  using index_t = halo_t::index_t;
+  using global_id_t = typename M::global_id_t;
+
+  //! \brief The number of owned cells and vertices.
+  std::size_t num_owned_cells = 0;
+  std::size_t num_owned_vertices = 0;
+
+  //! \brief The number of regions in the global mesh.
+  std::size_t num_regions = 1;
+
+  //! \brief The global id of each local cell and vertex.
+  std::vector<global_id_t> cell_global_ids;
+  std::vector<global_id_t> vertex_global_ids;
+
+  //! \brief The coordinates of each local vertex, one after the other.
+  std::vector<typename M::real_t> coordinates;
+
+  //! \brief The local vertices of each local cell.
+  std::vector<std::size_t> cell_vertex_offsets = {0};
+  //! \copydoc cell_vertex_offsets
+  std::vector<index_t> cell_vertices;
+
+  //! \brief The region of each local cell.
+  std::vector<std::size_t> cell_regions;
+
+  //! \brief The owner of each local cell.
+  std::vector<int> cell_owners;
+  //! \brief All the processes holding each local cell.
+  std::vector<std::size_t> cell_rank_offsets = {0};
+  //! \copydoc cell_rank_offsets
+  std::vector<int> cell_ranks;
+
+  //! \brief The owner of each local vertex.
+  std::vector<int> vertex_owners;
+  //! \brief All the processes holding each local vertex.
+  std::vector<std::size_t> vertex_rank_offsets = {0};
+  //! \copydoc vertex_rank_offsets
+  std::vector<int> vertex_ranks;
+
+  //! \brief Apply a function to each list, always in the same order.
+  template< typename F >
+  void for_each_list( F && f )
+  {
+    f( cell_global_ids );
+    f( vertex_global_ids );
+    f( coordinates );
+    f( cell_vertex_offsets );
+    f( cell_vertices );
+    f( cell_regions );
+    f( cell_owners );
+    f( cell_rank_offsets );
+    f( cell_ranks );
+    f( vertex_owners );
+    f( vertex_rank_offsets );
+    f( vertex_ranks );
+  }
+
+};
+
+namespace detail {
+
+//! \brief Sort a list and remove any duplicates.
+template< typename T >
+void sort_unique( std::vector<T> & list )
+{
+  std::sort( list.begin(), list.end() );
+  list.erase( std::unique( list.begin(), list.end() ), list.end() );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Which processes hold each entity of the global mesh.
+////////////////////////////////////////////////////////////////////////////////
+struct holders_t {
+
+  //! \brief The type of the ids.
+  using index_t = halo_t::index_t;
+
+  //! \brief The vertices of each cell.
+  std::vector< std::vector<index_t> > cell_verts;
+  //! \brief The owner of each vertex.
+  std::vector<int> vertex_owner;
+  //! \brief The processes holding each cell.
+  std::vector< std::vector<int> > cell_ranks;
+  //! \brief The processes holding each vertex.
+  std::vector< std::vector<int> > vertex_ranks;
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Figure out which processes hold each entity of the global mesh.
+//!
+//! A cell is held by every process that owns a cell sharing one of its
+//! vertices, and a vertex by every process holding one of its cells.  Each
+//! vertex is owned by the owner of the lowest numbered cell containing it.
+//!
+//! \param [in] mesh  The global mesh.
+//! \param [in] cell_owner  The process owning each cell.
+////////////////////////////////////////////////////////////////////////////////
+template< typename M >
+holders_t find_holders( M & mesh, const std::vector<int> & cell_owner )
+{
+  using index_t = holders_t::index_t;
+
+  auto cs = mesh.cells();
+  auto num_cells = cs.size();
+  auto num_verts = mesh.num_vertices();
+
+  if ( cell_owner.size() != num_cells )
+    raise_runtime_error( "The partition does not match the mesh" );
+
+  holders_t h;
+
+  // the vertices of each cell
+  h.cell_verts.resize( num_cells );
+  for ( index_t i=0; i<num_cells; i++ )
+    for ( auto v : mesh.vertices( cs[i] ) )
+      h.cell_verts[i].emplace_back( v.id() );
+
+  // the vertex owners, and the owners of all the cells around each vertex
+  h.vertex_owner.assign( num_verts, -1 );
+  std::vector< std::vector<int> > vertex_owners( num_verts );
+  for ( index_t i=0; i<num_cells; i++ )
+    for ( auto v : h.cell_verts[i] ) {
+      if ( h.vertex_owner[v] < 0 ) h.vertex_owner[v] = cell_owner[i];
+      vertex_owners[v].emplace_back( cell_owner[i] );
+    }
+  for ( auto & r : vertex_owners ) sort_unique( r );
+
+  // a cell is held by every process that owns a cell sharing one of its
+  // vertices
+  h.cell_ranks.resize( num_cells );
+  for ( index_t i=0; i<num_cells; i++ ) {
+    auto & r = h.cell_ranks[i];
+    for ( auto v : h.cell_verts[i] )
+      r.insert( r.end(), vertex_owners[v].begin(), vertex_owners[v].end() );
+    sort_unique( r );
+  }
+
+  // a vertex is held by every process holding one of its cells
+  h.vertex_ranks.resize( num_verts );
+  for ( index_t i=0; i<num_cells; i++ )
+    for ( auto v : h.cell_verts[i] )
+      h.vertex_ranks[v].insert(
+        h.vertex_ranks[v].end(), h.cell_ranks[i].begin(), h.cell_ranks[i].end()
+      );
+  for ( auto & r : h.vertex_ranks ) sort_unique( r );
+
+  return h;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Cut one process's part out of the global mesh.
+//!
+//! \param [in] mesh  The global mesh.
+//! \param [in] cell_owner  The process owning each cell.
+//! \param [in] h  The processes holding each entity, see find_holders().
+//! \param [in] held_cells  The cells held by the process, in increasing
+//!   order.
+//! \param [in] rank  The process to extract the part for.
+////////////////////////////////////////////////////////////////////////////////
+template< typename M >
+mesh_part_t<M> extract_part(
+  M & mesh,
+  const std::vector<int> & cell_owner,
+  const holders_t & h,
+  const std::vector<holders_t::index_t> & held_cells,
+  int rank )
+{
+  using index_t = holders_t::index_t;
+
+  constexpr auto num_dims = M::num_dimensions;
+
+  auto cs = mesh.cells();
+  auto vs = mesh.vertices();
+
+  mesh_part_t<M> part;
+  part.num_regions = mesh.num_regions();
+
+  // the owned cells come first
+  auto & local_cells = part.cell_global_ids;
+  for ( auto c : held_cells )
+    if ( cell_owner[c] == rank ) local_cells.emplace_back( c );
+  part.num_owned_cells = local_cells.size();
+  for ( auto c : held_cells )
+    if ( cell_owner[c] != rank ) local_cells.emplace_back( c );
+
+  // the vertices are the ones of the held cells, owned ones first
+  std::vector<index_t> sorted_verts;
+  for ( auto c : held_cells )
+    sorted_verts.insert(
+      sorted_verts.end(), h.cell_verts[c].begin(), h.cell_verts[c].end()
+    );
+  sort_unique( sorted_verts );
+
+  auto num_local_verts = sorted_verts.size();
+  std::vector<index_t> sorted_to_local( num_local_verts );
+  auto & local_verts = part.vertex_global_ids;
+  local_verts.reserve( num_local_verts );
+  for ( index_t i=0; i<num_local_verts; i++ )
+    if ( h.vertex_owner[ sorted_verts[i] ] == rank ) {
+      sorted_to_local[i] = local_verts.size();
+      local_verts.emplace_back( sorted_verts[i] );
+    }
+  part.num_owned_vertices = local_verts.size();
+  for ( index_t i=0; i<num_local_verts; i++ )
+    if ( h.vertex_owner[ sorted_verts[i] ] != rank ) {
+      sorted_to_local[i] = local_verts.size();
+      local_verts.emplace_back( sorted_verts[i] );
+    }
+
+  auto local_vertex = [&]( auto v ) {
+    auto it = std::lower_bound( sorted_verts.begin(), sorted_verts.end(), v );
+    return sorted_to_local[ it - sorted_verts.begin() ];
+  };
+
+  // the cells
+  for ( auto c : local_cells ) {
+    for ( auto v : h.cell_verts[c] )
+      part.cell_vertices.emplace_back( local_vertex(v) );
+    part.cell_vertex_offsets.emplace_back( part.cell_vertices.size() );
+    part.cell_regions.emplace_back( cs[c]->region() );
+    part.cell_owners.emplace_back( cell_owner[c] );
+    part.cell_ranks.insert(
+      part.cell_ranks.end(), h.cell_ranks[c].begin(), h.cell_ranks[c].end()
+    );
+    part.cell_rank_offsets.emplace_back( part.cell_ranks.size() );
+  }
+
+  // the vertices
+  part.coordinates.reserve( num_dims * num_local_verts );
+  for ( auto v : local_verts ) {
+    const auto & x = vs[v]->coordinates();
+    for ( std::size_t d=0; d<num_dims; d++ ) part.coordinates.emplace_back( x[d] );
+    part.vertex_owners.emplace_back( h.vertex_owner[v] );
+    part.vertex_ranks.insert(
+      part.vertex_ranks.end(), h.vertex_ranks[v].begin(), h.vertex_ranks[v].end()
+    );
+    part.vertex_rank_offsets.emplace_back( part.vertex_ranks.size() );
+  }
+
+  return part;
+}
+
+//! \brief Send a mesh part to another process.
+template< typename M >
+void send_part( mesh_part_t<M> & part, int dest )
+{
+  std::vector<std::size_t> sizes =
+    { part.num_owned_cells, part.num_owned_vertices, part.num_regions };
+  utils::send_list( sizes, dest );
+  part.for_each_list( [&]( auto & list ) { utils::send_list( list, dest ); } );
+}
+
+//! \brief Receive a mesh part sent with send_part().
+template< typename M >
+void recv_part( mesh_part_t<M> & part, int source )
+{
+  std::vector<std::size_t> sizes;
+  utils::recv_list( sizes, source );
+  part.num_owned_cells = sizes[0];
+  part.num_owned_vertices = sizes[1];
+  part.num_regions = sizes[2];
+  part.for_each_list( [&]( auto & list ) { utils::recv_list( list, source ); } );
+}
+
+} // namespace detail
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Build the local mesh of one process from its part.
+//!
+//! The halos are built from the owners and holders of the local entities
+//! alone.  Each side lists the shared entities in the order of their global
+//! ids, so both ends of every halo agree without any communication.  The
+//! part each local cell belongs to is stored on the mesh for plotting.
+//!
+//! \remark Like the mesh copy constructor, cells are rebuilt from their
+//!   vertices, so polyhedra are not supported.
+//!
+//! \param [in] part  The part of the mesh held by this process.
+//! \param [in] rank  This process.
+//! \return The local mesh.
+////////////////////////////////////////////////////////////////////////////////
+template< typename M >
+M make_local_mesh( const mesh_part_t<M> & part, int rank )
+{
+
+  using vertex_t = typename M::vertex_t;
+  using point_t = typename M::point_t;
+  using index_t = halo_t::index_t;
+  using global_id_t = typename M::global_id_t;
+
+  constexpr auto num_dims = M::num_dimensions;
+
+  const auto & local_cells = part.cell_global_ids;
+  const auto & local_verts = part.vertex_global_ids;
+  auto num_cells = local_cells.size();
+  auto num_verts = local_verts.size();
+
+  //----------------------------------------------------------------------------
+  // build the local mesh
+
+  M local;
+
+  local.init_parameters( num_verts );
+
+  std::vector<vertex_t*> new_verts;
+  new_verts.reserve( num_verts );
+  for ( index_t i=0; i<num_verts; i++ ) {
+    point_t x;
+    for ( std::size_t d=0; d<num_dims; d++ ) x[d] = part.coordinates[ i*num_dims + d ];
+    new_verts.emplace_back( local.create_vertex( x ) );
+  }
+
+  for ( index_t i=0; i<num_cells; i++ ) {
+    std::vector<vertex_t*> elem_vs;
+    auto first = part.cell_vertex_offsets[i];
+    auto last = part.cell_vertex_offsets[i+1];
+    elem_vs.reserve( last - first );
+    for ( auto j=first; j<last; j++ )
+      elem_vs.emplace_back( new_verts[ part.cell_vertices[j] ] );
+    local.create_cell( elem_vs );
+  }
+
+  local.init();
+
+  // copy the region ids
+  auto local_cs = local.cells();
+  for ( index_t i=0; i<num_cells; i++ )
+    local_cs[i]->region() = part.cell_regions[i];
+  local.set_num_regions( part.num_regions );
+
+  //----------------------------------------------------------------------------
+  // build the halos
+
+  ownership_t ownership;
+  ownership.num_owned_cells = part.num_owned_cells;
+  ownership.num_owned_vertices = part.num_owned_vertices;
+  ownership.cell_global_ids = local_cells;
+  ownership.vertex_global_ids = local_verts;
+
+  // the lists for each neighbor, sorted by rank
+  using lists_t = std::map< int, std::pair< std::vector<index_t>, std::vector<index_t> > >;
+
+  auto make_halo = []( lists_t & lists ) {
+    halo_t halo;
+    for ( auto & l : lists )
+      halo.add_neighbor(
+        l.first, std::move(l.second.first), std::move(l.second.second)
+      );
+    return halo;
+  };
+
+  // the local entities, in the order of their global ids
+  auto by_global_id = []( const auto & ids ) {
+    std::vector<index_t> order( ids.size() );
+    std::iota( order.begin(), order.end(), 0 );
+    std::sort( order.begin(), order.end(),
+      [&]( auto a, auto b ) { return ids[a] < ids[b]; } );
+    return order;
+  };
+
+  // shared entities go from their owner to all the other processes holding
+  // them
+  auto make_lists = [&](
+    const auto & ids, const auto & owners, const auto & rank_offsets,
+    const auto & ranks )
+  {
+    lists_t lists;
+    for ( auto i : by_global_id( ids ) ) {
+      if ( owners[i] == rank ) {
+        for ( auto j=rank_offsets[i]; j<rank_offsets[i+1]; j++ )
+          if ( ranks[j] != rank ) lists[ ranks[j] ].first.emplace_back( i );
+      }
+      else
+        lists[ owners[i] ].second.emplace_back( i );
+    }
+    return lists;
+  };
+
+  auto cell_lists = make_lists(
+    local_cells, part.cell_owners, part.cell_rank_offsets, part.cell_ranks );
+  ownership.cells = make_halo( cell_lists );
+
+  auto vert_lists = make_lists(
+    local_verts, part.vertex_owners, part.vertex_rank_offsets,
+    part.vertex_ranks );
+  ownership.vertices = make_halo( vert_lists );
+
+  // corners belong to the owner of their vertex.  Order them by the global
+  // ids of their vertex and cell.  Meshes built without corners get no
+  // corner halo.
+  if ( local.has_corners() ) {
+    using corner_key_t = std::tuple< global_id_t, global_id_t, index_t >;
+    std::map< int, std::pair< std::vector<corner_key_t>, std::vector<corner_key_t> > >
+      corner_keys;
+    for ( index_t i=0; i<num_cells; i++ ) {
+      auto c = local_cells[i];
+      for ( auto cn : local.corners( local_cs[i] ) ) {
+        auto lv = local.vertices(cn).front().id();
+        auto key = std::make_tuple(
+          local_verts[lv], c, static_cast<index_t>( cn.id() ) );
+        if ( part.vertex_owners[lv] == rank ) {
+          for ( auto j=part.cell_rank_offsets[i]; j<part.cell_rank_offsets[i+1]; j++ )
+            if ( part.cell_ranks[j] != rank )
+              corner_keys[ part.cell_ranks[j] ].first.emplace_back( key );
+        }
+        else
+          corner_keys[ part.vertex_owners[lv] ].second.emplace_back( key );
+      }
+    }
+
+    lists_t corner_lists;
+    for ( auto & k : corner_keys ) {
+      auto & send_keys = k.second.first;
+      auto & recv_keys = k.second.second;
+      std::sort( send_keys.begin(), send_keys.end() );
+      std::sort( recv_keys.begin(), recv_keys.end() );
+      auto & lists = corner_lists[ k.first ];
+      for ( const auto & key : send_keys ) lists.first.emplace_back( std::get<2>(key) );
+      for ( const auto & key : recv_keys ) lists.second.emplace_back( std::get<2>(key) );
+    }
+    ownership.corners = make_halo( corner_lists );
+  }
+
+  //----------------------------------------------------------------------------
+  // done
+
+  local.set_ownership( std::move(ownership) );
+  local.set_cell_partition( part.cell_owners );
+
+  return local;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Extract the part of a mesh held by one process.
+//!
+//! The local mesh holds the owned cells, plus one layer of ghost cells that
+//! share a vertex with an owned cell.  This is enough for every vertex of
+//! an owned cell to see all of its surrounding cells.  Each vertex is owned
+//! by the owner of the lowest numbered cell containing it.  Owned entities
+//! are numbered first, in the order of their global ids.
+//!
+//! This works on a single process, e.g. to check a partition.  Use
+//! distribute() to split a mesh among the processes.
+//!
+//! \param [in] mesh  The global mesh.
+//! \param [in] cell_owner  The process owning each cell.
+//! \param [in] rank  The process to extract the mesh for.
+//! \return The local mesh.
+////////////////////////////////////////////////////////////////////////////////
+template< typename M >
+M decompose( M & mesh, const std::vector<int> & cell_owner, int rank )
+{
+  auto h = detail::find_holders( mesh, cell_owner );
+
+  std::vector<halo_t::index_t> held_cells;
+  for ( halo_t::index_t i=0; i<cell_owner.size(); i++ )
+    if ( std::binary_search( h.cell_ranks[i].begin(), h.cell_ranks[i].end(), rank ) )
+      held_cells.emplace_back( i );
+
+  return make_local_mesh(
+    detail::extract_part( mesh, cell_owner, h, held_cells, rank ), rank );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Replace a global mesh with this process's part of it.
+//!
+//! Only the first process needs the global mesh; the meshes passed in on
+//! the others are ignored, and can be empty.  The first process partitions
+//! the mesh and reports the quality of the partition.  It then cuts out
+//! each process's part and sends it over, one at a time, so no other
+//! process ever holds more than its own part.
+//!
+//! Nothing happens unless there is more than one process.
+//!
+//! \param [in,out] mesh  On entry the global mesh, on exit the local one.
+//! \param [in] method  The partitioning method.
+//! \param [in] weights  The weight of each cell, see partition().
+////////////////////////////////////////////////////////////////////////////////
+template< typename M >
+void distribute(
+  M & mesh,
+  partition_method_t method = partition_method_t::multilevel,
+  const std::vector<std::size_t> & weights = {} )
+{
+  using index_t = halo_t::index_t;
+
+  auto num_ranks = utils::comm_size();
+  if ( num_ranks < 2 ) return;
+
+  auto rank = utils::comm_rank();
+
+  mesh_part_t<M> part;
+
+  if ( rank == 0 ) {
+
+    auto owner = partition( mesh, num_ranks, method, weights );
+
+    auto quality = evaluate_partition(
+      dual_graph( mesh, weights ), owner, num_ranks
+    );
+    std::cout << "Partitioned " << mesh.num_cells() << " cells into "
+      << num_ranks << " parts: " << quality << std::endl;
+
+    auto h = detail::find_holders( mesh, owner );
+
+    // bucket the cells by the processes holding them
+    std::vector< std::vector<index_t> > held_cells( num_ranks );
+    for ( index_t i=0; i<owner.size(); i++ )
+      for ( auto q : h.cell_ranks[i] ) held_cells[q].emplace_back( i );
+
+    for ( int q=1; q<num_ranks; q++ ) {
+      auto other = detail::extract_part( mesh, owner, h, held_cells[q], q );
+      detail::send_part( other, q );
+      std::vector<index_t>().swap( held_cells[q] );
+    }
+
+    part = detail::extract_part( mesh, owner, h, held_cells[0], 0 );
+
+  }
+  else
+    detail::recv_part( part, 0 );
+
+  mesh = make_local_mesh( part, rank );
+}
+
+} // namespace
+} // namespace
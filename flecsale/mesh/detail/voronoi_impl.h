@@ -95,7 +95,7 @@ void extract_boundaries(
   auto num_points = mesh.num_vertices();
 
   // how many boundary points are there
-  auto bnd_points = mesh.boundary_vertices();
+  const auto & bnd_points = mesh.boundary_vertices();
   auto num_bnd_points = bnd_points.size();
 
   // create storage for generators
@@ -103,7 +103,8 @@ void extract_boundaries(
   std::map<size_t, size_t>  point_to_bnd_point_id;
 
   // now set the actual generators 
-  auto xp = mesh.vertices()[0]->coordinates();
+  auto vs = mesh.vertices();
+  auto xp = vs[0]->coordinates();
 
 
   // create storage for the min and max boundary points
@@ -114,9 +115,9 @@ void extract_boundaries(
   size_t bid = 0;
   for ( auto v : bnd_points ) {
     // keep track of the index mapping
-    point_to_bnd_point_id[v.id()] = bid;
+    point_to_bnd_point_id[v] = bid;
     // get coordinates
-    auto xp = v->coordinates();
+    auto xp = vs[v]->coordinates();
     // copy coordinates and keep track of min and maxes
     min_point = min( min_point, xp );
     max_point = max( max_point, xp );
@@ -126,20 +127,21 @@ void extract_boundaries(
 
 
   // how many boundary edges are there
-  auto bnd_edges = mesh.boundary_edges();
+  const auto & bnd_edges = mesh.boundary_edges();
   auto num_bnd_edges = bnd_edges.size();
 
   // create storage for edges
   std::vector< std::pair<size_t,size_t> > bnd_edge_points(num_bnd_edges);
 
   // now find the actual edges
+  auto es = mesh.edges();
   bid = 0;
   for ( auto e : bnd_edges ) {
     // Get the two points.  The ordering is consisten because the
     // edge is oriented so the first side is on the inside, and the
     // other is on the outside of the domain.  Ande p1 is p1 for the
     // first side.
-    auto points = mesh.vertices(e);
+    auto points = mesh.vertices(es[e]);
     // the side ordering of points is supposed to be consistent
     bnd_edge_points[bid++] =
       std::make_pair( point_to_bnd_point_id[ points.front().id()  ],
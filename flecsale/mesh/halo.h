@@ -0,0 +1,275 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Describes which entities a process shares with its neighbors, and
+///        how to exchange data for them.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// user includes
+#include "flecsale/common/types.h"
+#include "flecsale/utils/mpi_utils.h"
+
+// system includes
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace flecsale {
+namespace mesh {
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief The communication pattern for one kind of entity.
+//!
+//! For each neighboring process, there is a list of local entities whose
+//! values are sent to it, and a list of local entities whose values are
+//! received from it.  Both sides order the lists the same way, so the i-th
+//! value sent by one side lands in the i-th received entity on the other.
+////////////////////////////////////////////////////////////////////////////////
+class halo_t {
+public:
+
+  //! \brief The local index type.
+  using index_t = common::local_index_t;
+
+  //! \brief The entities shared with one neighbor.
+  struct neighbor_t {
+    //! the rank of the neighbor
+    int rank;
+    //! the local entities whose values are sent to the neighbor
+    std::vector<index_t> send;
+    //! the local entities whose values are received from the neighbor
+    std::vector<index_t> recv;
+  };
+
+  //! \brief Add a neighbor.
+  //! \param [in] rank  The rank of the neighbor.
+  //! \param [in] send  The local entities to send to it.
+  //! \param [in] recv  The local entities to receive from it.
+  void add_neighbor(
+    int rank, std::vector<index_t> send, std::vector<index_t> recv )
+  {
+    neighbors_.emplace_back(
+      neighbor_t{ rank, std::move(send), std::move(recv) }
+    );
+  }
+
+  //! \brief Return the list of neighbors.
+  const auto & neighbors() const noexcept
+  { return neighbors_; }
+
+  //! \brief Return true if nothing is shared.
+  bool empty() const noexcept
+  { return neighbors_.empty(); }
+
+  //! \brief Update the received entities with their owners' values.
+  //!
+  //! \param [in,out] values  The accessor holding the data.
+  //! \param [in] entities  The entities the local indices refer to.
+  //! \tparam A  The accessor type.
+  //! \tparam E  The entity collection type.
+  template< typename A, typename E >
+  void exchange( A & values, const E & entities ) const;
+
+private:
+
+  //! \brief The neighbors, in order of increasing rank.
+  std::vector< neighbor_t > neighbors_;
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief A set of halo exchanges that are in flight.
+//!
+//! Adding a field posts its non-blocking sends and receives right away.
+//! The received values are only unpacked by wait(), so work that does not
+//! touch the ghosts can be done in between.  The accessors and entity
+//! collections are copied, so they must be lightweight handles to their
+//! data, and that data must stay valid until then.
+////////////////////////////////////////////////////////////////////////////////
+class halo_exchange_t {
+public:
+
+  //! \brief Default constructor.
+  halo_exchange_t() = default;
+
+  //! \brief Pending exchanges can't be copied.
+  halo_exchange_t( const halo_exchange_t & ) = delete;
+  halo_exchange_t & operator=( const halo_exchange_t & ) = delete;
+
+  //! \brief Destructor.  Completes anything still in flight.
+  ~halo_exchange_t()
+  { wait(); }
+
+  //! \brief Start exchanging one field.
+  //!
+  //! \param [in] halo  The communication pattern.
+  //! \param [in,out] values  The accessor holding the data.
+  //! \param [in] entities  The entities the local indices refer to.
+  //! \tparam A  The accessor type.
+  //! \tparam E  The entity collection type.
+  template< typename A, typename E >
+  void add( const halo_t & halo, A & values, const E & entities )
+  {
+    if ( halo.empty() ) return;
+
+#ifdef HAVE_MPI
+
+    using value_t = std::decay_t< decltype( values[ entities[0] ] ) >;
+    static_assert( std::is_trivially_copyable<value_t>::value,
+      "Only trivially copyable types can be exchanged" );
+
+    for ( const auto & neigh : halo.neighbors() ) {
+
+      // post the receive
+      auto recv_bytes = neigh.recv.size() * sizeof(value_t);
+      buffers_.emplace_back( new char[ recv_bytes ] );
+      auto recv_buf = buffers_.back().get();
+      requests_.emplace_back();
+      MPI_Irecv(
+        recv_buf, static_cast<int>( recv_bytes ), MPI_BYTE, neigh.rank, 
+        utils::mpi_tag, MPI_COMM_WORLD, &requests_.back()
+      );
+
+      // pack and send the outgoing data
+      auto send_bytes = neigh.send.size() * sizeof(value_t);
+      buffers_.emplace_back( new char[ send_bytes ] );
+      auto send_buf = reinterpret_cast<value_t*>( buffers_.back().get() );
+      for ( std::size_t j=0; j<neigh.send.size(); j++ )
+        send_buf[j] = values[ entities[ neigh.send[j] ] ];
+      requests_.emplace_back();
+      MPI_Isend(
+        send_buf, static_cast<int>( send_bytes ), MPI_BYTE, neigh.rank, 
+        utils::mpi_tag, MPI_COMM_WORLD, &requests_.back()
+      );
+
+      // the received data gets unpacked once everything is done
+      const auto * recv = &neigh.recv;
+      unpack_.emplace_back( 
+        [values, entities, recv, recv_buf]() mutable {
+          auto data = reinterpret_cast<const value_t*>( recv_buf );
+          for ( std::size_t j=0; j<recv->size(); j++ )
+            values[ entities[ (*recv)[j] ] ] = data[j];
+        }
+      );
+
+    }
+
+#else
+
+    raise_runtime_error( "exchanging halos requires MPI" );
+
+#endif // HAVE_MPI
+
+  }
+
+  //! \brief Complete all the exchanges, and unpack the received values.
+  void wait()
+  {
+#ifdef HAVE_MPI
+    if ( !requests_.empty() )
+      MPI_Waitall(
+        static_cast<int>( requests_.size() ), requests_.data(),
+        MPI_STATUSES_IGNORE
+      );
+    requests_.clear();
+#endif
+    for ( auto & unpack : unpack_ ) unpack();
+    unpack_.clear();
+    buffers_.clear();
+  }
+
+private:
+
+#ifdef HAVE_MPI
+  //! \brief The outstanding requests.
+  std::vector< MPI_Request > requests_;
+#endif
+  //! \brief The message buffers.  They don't move once posted.
+  std::vector< std::unique_ptr<char[]> > buffers_;
+  //! \brief The work left to do once the messages arrive.
+  std::vector< std::function<void()> > unpack_;
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Out-of-line definitions
+////////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+//! \brief Refers to some values without copying them.
+template< typename A >
+struct values_ref_t {
+  A * values;
+  template< typename I >
+  decltype(auto) operator[]( I && i ) const
+  { return (*values)[ std::forward<I>(i) ]; }
+};
+
+} // namespace detail
+
+template< typename A, typename E >
+void halo_t::exchange( A & values, const E & entities ) const
+{
+  // the values are alive until the exchange is done, so any kind of 
+  // container can be updated in place
+  detail::values_ref_t<A> ref{ &values };
+  halo_exchange_t pending;
+  pending.add( *this, ref, entities );
+  pending.wait();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief The owned entities of one kind, split by whether they need ghost
+//!        values.
+//!
+//! The interior entities can be processed while a halo exchange is in 
+//! flight.  The rest have to wait for it to complete.
+////////////////////////////////////////////////////////////////////////////////
+struct sweep_lists_t {
+  //! \brief The local ids of the entities that only touch owned entities.
+  std::vector<common::local_index_t> interior;
+  //! \brief The local ids of the owned entities that touch ghosts.
+  std::vector<common::local_index_t> boundary;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Describes the part of a distributed mesh held by one process.
+//!
+//! The owned entities always come first in their index space, so the owned
+//! cells are cells [0, num_owned_cells), and likewise for vertices.  The
+//! remaining entities are ghosts, which are copies of entities owned by
+//! another process.
+////////////////////////////////////////////////////////////////////////////////
+struct ownership_t {
+
+  //! \brief The global id of each local cell.
+  std::vector<common::global_index_t> cell_global_ids;
+  //! \brief The global id of each local vertex.
+  std::vector<common::global_index_t> vertex_global_ids;
+
+  //! \brief The number of owned cells.
+  std::size_t num_owned_cells = 0;
+  //! \brief The number of owned vertices.
+  std::size_t num_owned_vertices = 0;
+
+  //! \brief The cell halo.  Ghost cells are received from their owner.
+  halo_t cells;
+  //! \brief The vertex halo.  Ghost vertices are received from their owner.
+  halo_t vertices;
+  //! \brief The corner halo.  Each corner is owned by the owner of its
+  //! vertex, which is the only process that can compute its nodal forces.
+  halo_t corners;
+
+};
+
+} // namespace
+} // namespace
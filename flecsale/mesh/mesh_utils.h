@@ -10,74 +10,82 @@
 #pragma once
 
 // user includes
-#ifdef HAVE_OPENSSL
-#  include <flecsi/utils/checksum.h>
-#endif
+#include "flecsale/utils/checksum.h"
 
 // system includes
 #include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace flecsale {
 namespace mesh {
 
 ////////////////////////////////////////////////////////////////////////////////
-//! \brief Output the checksums of solution quantities.
+//! \brief Compute the checksums of the coordinates and solution quantities.
+//!
+//! Each field is hashed straight from its storage, in parallel, and vector
+//! components are hashed on their own.  The checksums do not depend on the
+//! number of threads, so they can be compared from step to step, or from
+//! run to run, as a cheap integrity check.
 //!
 //! \param [in] mesh the mesh object
-//! \return 0 for success
+//! \return The name and checksum of each quantity.  Empty if not built with
+//!         OpenSSL.
 ////////////////////////////////////////////////////////////////////////////////
 template< typename T >
-int checksum( T & mesh ) 
+auto checksums( T & mesh ) 
 {
 
+  std::vector< std::pair<std::string, utils::checksum_t> > sums;
+
 #ifdef HAVE_OPENSSL
 
   using mesh_t = T;
-  using counter_t = typename mesh_t::counter_t;
   using integer_t = typename mesh_t::integer_t;
   using real_t = typename mesh_t::real_t;
   using vector_t = typename mesh_t::vector_t; 
 
   constexpr auto num_dims = mesh_t::num_dimensions;
 
+  // variable extension for vectors
+  const std::string var_ext[3] = { "_x", "_y", "_z" };
+
   //----------------------------------------------------------------------------
   // create some lambda functions
-  auto checksum = []( auto && vs, auto && f )
+
+  // scalars are hashed in place
+  auto scalar_checksum = [&]( auto && ents, auto && f )
   {
-    using field_type = std::decay_t< decltype( f[0] ) >;
-    auto num_verts = vs.size();
-    std::vector< field_type > vals(num_verts);
-    #pragma omp parallel for
-    for ( counter_t i=0; i<num_verts; ++i ) vals[i] = f[vs[i]];
-    flecsi::utils::checksum_t cs;
-    flecsi::utils::checksum(vals.data(), num_verts, cs);
-    return cs;
+    auto num_ents = ents.size();
+    const auto * data = num_ents ? &f[ ents[0] ] : nullptr;
+    sums.emplace_back( f.label(), utils::tree_checksum( data, num_ents ) );
   };
 
-  // variable extension for vectors
-  std::string var_ext[3];
-  var_ext[0] = "_x"; var_ext[1] = "_y";  var_ext[2] = "_z";
-
-  std::cout << std::string(65, '=') << std::endl;
-  std::cout << std::left << std::setw(32) << "Field Name"  << " " 
-            << std::setw(32) << std::left << "Checksum" << std::endl;
-  std::cout << std::string(65, '-') << std::endl;
+  // so are the components of vectors, one at a time
+  auto vector_checksum = [&]( auto && ents, auto && f )
+  {
+    auto num_ents = ents.size();
+    const real_t * data = num_ents ? &f[ ents[0] ][0] : nullptr;
+    constexpr auto stride = sizeof(vector_t) / sizeof(real_t);
+    for ( int d=0; d<num_dims; ++d )
+      sums.emplace_back( 
+        f.label() + var_ext[d],
+        utils::tree_checksum( num_ents ? data + d : data, num_ents, stride )
+      );
+  };
 
   //----------------------------------------------------------------------------
   // Checksum for Coordinates
   auto verts = mesh.vertices();
   auto num_verts = verts.size();
 
-  // get the coordinates from the mesh.
+  // the coordinates live in the vertices
   for(int d=0; d < num_dims; ++d) {
-    std::vector< real_t > vals(num_verts);
-    #pragma omp parallel for
-    for ( counter_t i=0; i<num_verts; ++i ) vals[i] = verts[i]->coordinates()[d];
-    flecsi::utils::checksum_t cs;
-    flecsi::utils::checksum(vals.data(), num_verts, cs);
-    std::cout << std::left << std::setw(32) << "node_coordinates"+var_ext[d] 
-              << " " << std::setw(32) << cs.strvalue << std::endl;
-
+    auto cs = utils::tree_checksum<real_t>( 
+      num_verts, [&]( auto i ) { return verts[i]->coordinates()[d]; } );
+    sums.emplace_back( "node_coordinates"+var_ext[d], cs );
   } // for
 
   //----------------------------------------------------------------------------
@@ -87,34 +95,19 @@ int checksum( T & mesh )
   auto rspav = flecsi_get_accessors_all(
     mesh, real_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
   );
-  for(auto sf: rspav) {
-    auto cs = checksum( verts, sf );
-    std::cout << std::left << std::setw(32) << sf.label() << " " 
-              << std::setw(32) << cs.strvalue << std::endl;
-  }
+  for(auto sf: rspav) scalar_checksum( verts, sf );
 
   // int scalars persistent at vertices
   auto ispav = flecsi_get_accessors_all(
     mesh, integer_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
   );
-  for(auto sf: ispav) {
-    auto cs = checksum( verts, sf );
-    std::cout << std::left << std::setw(32) << sf.label() << " " 
-              << std::setw(32) << cs.strvalue << std::endl;
-  }
+  for(auto sf: ispav) scalar_checksum( verts, sf );
 
   // real vectors persistent at vertices
   auto rvpav = flecsi_get_accessors_all(
     mesh, vector_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
   );
-  for(auto vf: rvpav) {
-    for(int d=0; d < num_dims; ++d) {
-      auto cs = checksum( verts, vf );
-      std::cout << std::left << std::setw(32) << vf.label()+var_ext[d] 
-                << " " << std::setw(32) << cs.strvalue << std::endl;
-    } // for
-  } // for
-
+  for(auto vf: rvpav) vector_checksum( verts, vf );
 
   //----------------------------------------------------------------------------
   // Checksum Cell Solution Quantities
@@ -124,36 +117,52 @@ int checksum( T & mesh )
   auto rspac = flecsi_get_accessors_all(
     mesh, real_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
   );
-  for(auto sf: rspac) {
-    auto cs = checksum( cels, sf );
-    std::cout << std::left << std::setw(32) << sf.label() << " " 
-              << std::setw(32) << cs.strvalue << std::endl;
-  }
+  for(auto sf: rspac) scalar_checksum( cels, sf );
+
   // int scalars persistent at cells
   auto ispac = flecsi_get_accessors_all(
     mesh, integer_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
   );
-  for(auto sf: ispac) {
-    auto cs = checksum( cels, sf );
-    std::cout << std::left << std::setw(32) << sf.label() << " " 
-              << std::setw(32) << cs.strvalue << std::endl;
-  }
+  for(auto sf: ispac) scalar_checksum( cels, sf );
+
   // real vectors persistent at cells
   auto rvpac = flecsi_get_accessors_all(
     mesh, vector_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
   );
-  for(auto vf: rvpac) {
-    for(int d=0; d < num_dims; ++d) {
-      auto cs = checksum( cels, vf );
-      std::cout << std::left << std::setw(32) << vf.label()+var_ext[d] << " " 
-                << std::setw(32) << cs.strvalue << std::endl;
-    } // for
-  } // for
+  for(auto vf: rvpac) vector_checksum( cels, vf );
+
+#endif // HAVE_OPENSSL
+
+  return sums;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Output the checksums of solution quantities.
+//!
+//! \param [in] mesh the mesh object
+//! \return 0 for success
+//! \see checksums
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+int checksum( T & mesh ) 
+{
+
+#ifdef HAVE_OPENSSL
+
+  auto sums = checksums( mesh );
 
   std::cout << std::string(65, '=') << std::endl;
+  std::cout << std::left << std::setw(32) << "Field Name"  << " " 
+            << std::setw(32) << std::left << "Checksum" << std::endl;
+  std::cout << std::string(65, '-') << std::endl;
 
+  for ( const auto & cs : sums )
+    std::cout << std::left << std::setw(32) << cs.first << " " 
+              << std::setw(32) << cs.second.strvalue() << std::endl;
+
+  std::cout << std::string(65, '=') << std::endl;
 
-#endif // ENABLE_OPENSSL
+#endif // HAVE_OPENSSL
 
   return 0;
 }
@@ -0,0 +1,194 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Describes what the mesh writers put in each output file.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// user includes
+#include "flecsale/utils/errors.h"
+#include "flecsale/utils/string_utils.h"
+
+// system includes
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace flecsale {
+namespace mesh {
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief The precision real valued fields are written with.
+////////////////////////////////////////////////////////////////////////////////
+enum class output_precision_t {
+  float32,
+  float64
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Convert a string to an output precision.
+//! \param [in] str  Either "float32" or "float64".
+//! \return The precision.
+////////////////////////////////////////////////////////////////////////////////
+inline output_precision_t to_output_precision( const std::string & str )
+{
+  if ( str == "float32" || str == "single" )
+    return output_precision_t::float32;
+  else if ( str == "float64" || str == "double" )
+    return output_precision_t::float64;
+  raise_runtime_error( "Unknown output precision \"" << str << "\"" );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief What gets written to one kind of output file.
+//!
+//! By default, every persistent field and every region are written at full
+//! precision.  Only the field values are down-converted, except by formats
+//! that store every real value the same way, like exodus and binary tecplot.
+////////////////////////////////////////////////////////////////////////////////
+struct output_format_t {
+
+  //! \brief The labels of the fields to write.  Empty means all the
+  //!        persistent fields.
+  std::vector<std::string> fields;
+
+  //! \brief The precision of the real valued fields.
+  output_precision_t precision = output_precision_t::float64;
+
+  //! \brief The regions to write, unless all of them are.
+  std::vector<std::size_t> regions;
+
+  //! \brief If true, every region is written, whatever \a regions holds.
+  bool all_regions = true;
+
+  //! \brief The error bound of real valued fields, for formats that can
+  //!        store them lossily.  Zero stores them exactly.
+  double error_bound = 0;
+
+  //! \brief If true, the error bound is relative to the range of each field.
+  bool relative_error = false;
+
+  //! \brief Only write some of the regions.
+  //! \param [in] ids  The regions to write.  If empty, none are written.
+  void set_regions( std::vector<std::size_t> ids )
+  {
+    regions = std::move( ids );
+    all_regions = false;
+  }
+
+  //! \brief Return true if the field with this label is written.
+  //! \param [in] label  The field label.
+  bool writes_field( const std::string & label ) const
+  {
+    return fields.empty() ||
+      std::find( fields.begin(), fields.end(), label ) != fields.end();
+  }
+
+  //! \brief Return true if this region is written.
+  //! \param [in] region  The region id.
+  bool writes_region( std::size_t region ) const
+  {
+    return all_regions ||
+      std::find( regions.begin(), regions.end(), region ) != regions.end();
+  }
+
+  //! \brief Return true if all the regions are written.
+  bool writes_all_regions() const noexcept
+  { return all_regions; }
+
+  //! \brief Return true if real fields are down-converted to single
+  //!        precision.
+  bool is_single_precision() const noexcept
+  { return precision == output_precision_t::float32; }
+
+  //! \brief Return true if real fields are stored lossily.
+  bool is_lossy() const noexcept
+  { return error_bound > 0; }
+
+  //! \brief Keep the field accessors that are written.
+  //! \param [in] accessors  The list of accessors, as returned by
+  //!                        flecsi_get_accessors_all.
+  //! \return The selected accessors, in the same order.
+  template< typename A >
+  auto select_fields( const A & accessors ) const
+  {
+    if ( fields.empty() ) return accessors;
+    A selected;
+    for ( const auto & a : accessors )
+      if ( writes_field( a.label() ) ) selected.emplace_back( a );
+    return selected;
+  }
+
+  //! \brief Keep the cells whose regions are written.
+  //! \param [in] cells  The list of cells.
+  //! \return The selected cells, in the same order.
+  template< typename C >
+  auto select_cells( const C & cells ) const
+  {
+    using cell_handle_t = std::decay_t< decltype( cells[0] ) >;
+    std::vector<cell_handle_t> selected;
+    selected.reserve( cells.size() );
+    for ( auto c : cells )
+      if ( writes_region( c->region() ) ) selected.emplace_back( c );
+    return selected;
+  }
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief The output formats of every kind of file, looked up by file
+//!        extension.
+//!
+//! Extensions that were not configured use the default format.
+////////////////////////////////////////////////////////////////////////////////
+class output_profile_t {
+public:
+
+  //! \brief Return the format used for files that were not configured.
+  output_format_t & defaults() noexcept
+  { return defaults_; }
+
+  //! \copydoc defaults()
+  const output_format_t & defaults() const noexcept
+  { return defaults_; }
+
+  //! \brief Return the format for a file extension, creating it from the
+  //!        defaults if it was not configured yet.
+  //! \param [in] ext  The file extension, without the dot.
+  output_format_t & operator[]( const std::string & ext )
+  {
+    auto it = formats_.find( ext );
+    if ( it == formats_.end() )
+      it = formats_.emplace( ext, defaults_ ).first;
+    return it->second;
+  }
+
+  //! \brief Return the format to use when writing a file.
+  //! \param [in] filename  The name of the file, the extension of which is
+  //!                       used for the lookup.
+  const output_format_t & get( const std::string & filename ) const
+  {
+    auto it = formats_.find( utils::file_extension( filename ) );
+    return ( it == formats_.end() ) ? defaults_ : it->second;
+  }
+
+private:
+
+  //! \brief The format of files that were not configured.
+  output_format_t defaults_;
+
+  //! \brief The format of each configured extension.
+  std::map< std::string, output_format_t > formats_;
+
+};
+
+} // namespace mesh
+} // namespace flecsale
@@ -0,0 +1,850 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Tools for partitioning the cells of a mesh among several processes.
+///
+/// Two partitioners are provided.  The multilevel one works on the dual
+/// graph of the mesh, and tries to minimize the number of faces cut.  The
+/// geometric one recursively bisects the cell centroids along their longest
+/// extent, which is cheaper but usually cuts more faces.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// user includes
+#include "flecsale/utils/errors.h"
+
+// system includes
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <set>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace flecsale {
+namespace mesh {
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief The available partitioning methods.
+////////////////////////////////////////////////////////////////////////////////
+enum class partition_method_t {
+  //! contiguous blocks of cell ids
+  block,
+  //! recursive coordinate bisection of the cell centroids
+  geometric,
+  //! multilevel bisection of the dual graph
+  multilevel
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief A weighted graph in compressed sparse row format.
+////////////////////////////////////////////////////////////////////////////////
+struct graph_t {
+
+  //! \brief The index type.
+  using index_t = std::size_t;
+
+  //! \brief Where the neighbors of each vertex start.  There is one extra
+  //!        entry at the end.
+  std::vector<index_t> offsets = {0};
+  //! \brief The neighbors of all the vertices.
+  std::vector<index_t> adjacency;
+  //! \brief The weight of each edge, parallel to adjacency.
+  std::vector<index_t> edge_weights;
+  //! \brief The weight of each vertex.
+  std::vector<index_t> vertex_weights;
+
+  //! \brief Return the number of vertices.
+  index_t size() const noexcept
+  { return offsets.size() - 1; }
+
+  //! \brief Return the total vertex weight.
+  index_t total_weight() const
+  {
+    return std::accumulate(
+      vertex_weights.begin(), vertex_weights.end(), index_t(0)
+    );
+  }
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief How good a partition is.
+////////////////////////////////////////////////////////////////////////////////
+struct partition_quality_t {
+  //! \brief The total weight of the edges between parts.
+  std::size_t edge_cut = 0;
+  //! \brief The heaviest part, relative to a perfectly even split.
+  double imbalance = 1;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Partition the cells into contiguous blocks of ids.
+//!
+//! \param [in] num_cells  The number of cells.
+//! \param [in] num_parts  The number of parts.
+//! \return The part that owns each cell.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+std::vector<int> block_partition( T num_cells, int num_parts )
+{
+  if ( num_parts < 1 || static_cast<T>(num_parts) > num_cells )
+    raise_runtime_error(
+      "Can't split " << num_cells << " cells into " << num_parts << " parts"
+    );
+
+  std::vector<int> owner( num_cells );
+
+  auto n = static_cast<T>( num_parts );
+  auto base = num_cells / n;
+  auto extra = num_cells % n;
+
+  // the first few parts get one extra cell
+  T cell = 0;
+  for ( T p=0; p<n; p++ ) {
+    auto size = base + ( p < extra ? 1 : 0 );
+    std::fill_n( owner.begin() + cell, size, static_cast<int>(p) );
+    cell += size;
+  }
+
+  return owner;
+}
+
+namespace detail {
+
+//! \brief The parameters of the multilevel partitioner.
+//! @{
+//! stop coarsening once the graph is this small
+static constexpr std::size_t coarsest_graph_size = 64;
+//! stop coarsening once a level shrinks the graph by less than this
+static constexpr double min_coarsening_ratio = 0.95;
+//! the allowed relative excess weight of each side of a bisection
+static constexpr double bisection_tolerance = 0.01;
+//! the maximum number of refinement passes per level
+static constexpr int max_refinement_passes = 8;
+//! the number of seeds tried for the initial bisection
+static constexpr int num_initial_seeds = 4;
+//! @}
+
+//! \brief The side of a bisection each vertex is on.
+using sides_t = std::vector<unsigned char>;
+
+//! \brief Split the parts in two for recursive bisection.
+//! \param [in] num_parts  The number of parts to split.
+//! \return The number of parts on each side, and the fraction of the weight
+//!         that goes to the first side.
+inline auto split_parts( int num_parts )
+{
+  auto first = num_parts / 2;
+  auto frac = static_cast<double>(first) / num_parts;
+  return std::make_tuple( first, num_parts - first, frac );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Extract the subgraph induced by one side of a bisection.
+//!
+//! \param [in] graph  The graph to split.
+//! \param [in] sides  The side of each vertex.
+//! \param [in] side  The side to extract.
+//! \param [out] ids  The id of each subgraph vertex in the original graph.
+//! \return The subgraph.
+////////////////////////////////////////////////////////////////////////////////
+inline graph_t induced_subgraph(
+  const graph_t & graph, const sides_t & sides, unsigned char side,
+  std::vector<graph_t::index_t> & ids )
+{
+  using index_t = graph_t::index_t;
+  constexpr auto npos = std::numeric_limits<index_t>::max();
+
+  auto n = graph.size();
+  std::vector<index_t> local( n, npos );
+
+  ids.clear();
+  for ( index_t i=0; i<n; i++ )
+    if ( sides[i] == side ) {
+      local[i] = ids.size();
+      ids.emplace_back( i );
+    }
+
+  graph_t sub;
+  sub.offsets.reserve( ids.size()+1 );
+  sub.vertex_weights.reserve( ids.size() );
+
+  for ( auto i : ids ) {
+    for ( auto j=graph.offsets[i]; j<graph.offsets[i+1]; j++ ) {
+      auto k = local[ graph.adjacency[j] ];
+      if ( k == npos ) continue;
+      sub.adjacency.emplace_back( k );
+      sub.edge_weights.emplace_back( graph.edge_weights[j] );
+    }
+    sub.offsets.emplace_back( sub.adjacency.size() );
+    sub.vertex_weights.emplace_back( graph.vertex_weights[i] );
+  }
+
+  return sub;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Collapse a graph by matching each vertex with the neighbor it
+//!        shares the heaviest edge with.
+//!
+//! \param [in] graph  The fine graph.
+//! \param [out] coarse_map  The coarse vertex each fine vertex maps to.
+//! \return The coarse graph.
+////////////////////////////////////////////////////////////////////////////////
+inline graph_t coarsen(
+  const graph_t & graph, std::vector<graph_t::index_t> & coarse_map )
+{
+  using index_t = graph_t::index_t;
+  constexpr auto npos = std::numeric_limits<index_t>::max();
+
+  auto n = graph.size();
+
+  // visit the lightest vertices first, so they get a chance to be matched
+  std::vector<index_t> order( n );
+  std::iota( order.begin(), order.end(), 0 );
+  std::stable_sort( order.begin(), order.end(),
+    [&]( auto a, auto b ) {
+      return graph.vertex_weights[a] < graph.vertex_weights[b];
+    } );
+
+  // heavy edge matching
+  coarse_map.assign( n, npos );
+  index_t num_coarse = 0;
+
+  for ( auto i : order ) {
+    if ( coarse_map[i] != npos ) continue;
+    auto match = i;
+    index_t heaviest = 0;
+    for ( auto j=graph.offsets[i]; j<graph.offsets[i+1]; j++ ) {
+      auto k = graph.adjacency[j];
+      if ( coarse_map[k] == npos && k != i && graph.edge_weights[j] > heaviest ) {
+        heaviest = graph.edge_weights[j];
+        match = k;
+      }
+    }
+    coarse_map[i] = coarse_map[match] = num_coarse++;
+  }
+
+  // the members of each coarse vertex
+  std::vector<index_t> first( num_coarse+1, 0 ), members( n );
+  for ( index_t i=0; i<n; i++ ) first[ coarse_map[i]+1 ]++;
+  std::partial_sum( first.begin(), first.end(), first.begin() );
+  {
+    auto next = first;
+    for ( index_t i=0; i<n; i++ ) members[ next[coarse_map[i]]++ ] = i;
+  }
+
+  // now merge the edges of the matched vertices
+  graph_t coarse;
+  coarse.offsets.reserve( num_coarse+1 );
+  coarse.vertex_weights.assign( num_coarse, 0 );
+
+  std::vector<index_t> slot( num_coarse, npos );
+
+  for ( index_t c=0; c<num_coarse; c++ ) {
+    auto start = coarse.adjacency.size();
+    for ( auto m=first[c]; m<first[c+1]; m++ ) {
+      auto i = members[m];
+      coarse.vertex_weights[c] += graph.vertex_weights[i];
+      for ( auto j=graph.offsets[i]; j<graph.offsets[i+1]; j++ ) {
+        auto k = coarse_map[ graph.adjacency[j] ];
+        if ( k == c ) continue;
+        if ( slot[k] == npos || slot[k] < start ) {
+          slot[k] = coarse.adjacency.size();
+          coarse.adjacency.emplace_back( k );
+          coarse.edge_weights.emplace_back( graph.edge_weights[j] );
+        }
+        else
+          coarse.edge_weights[ slot[k] ] += graph.edge_weights[j];
+      }
+    }
+    coarse.offsets.emplace_back( coarse.adjacency.size() );
+  }
+
+  return coarse;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Return the total weight of the edges cut by a bisection.
+////////////////////////////////////////////////////////////////////////////////
+inline std::size_t bisection_cut( const graph_t & graph, const sides_t & sides )
+{
+  std::size_t cut = 0;
+  for ( std::size_t i=0; i<graph.size(); i++ )
+    for ( auto j=graph.offsets[i]; j<graph.offsets[i+1]; j++ )
+      if ( sides[i] != sides[ graph.adjacency[j] ] )
+        cut += graph.edge_weights[j];
+  return cut / 2;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Bisect a graph by growing a region from a seed vertex.
+//!
+//! Vertices are added in breadth-first order until the first side holds its
+//! share of the weight.  Several seeds are tried, and the smallest cut wins.
+//!
+//! \param [in] graph  The graph to bisect.
+//! \param [in] frac  The fraction of the weight for the first side.
+//! \return The side of each vertex.
+////////////////////////////////////////////////////////////////////////////////
+inline sides_t grow_bisection( const graph_t & graph, double frac )
+{
+  using index_t = graph_t::index_t;
+
+  auto n = graph.size();
+  auto target = static_cast<index_t>( frac * graph.total_weight() + 0.5 );
+
+  // grow the first side from a seed, and return the last vertex reached
+  auto grow = [&]( index_t seed, sides_t & sides ) {
+    sides.assign( n, 1 );
+    std::vector<index_t> queue;
+    queue.reserve( n );
+    std::vector<bool> seen( n, false );
+    index_t weight = 0, head = 0, last = seed, next_unseen = 0;
+    queue.emplace_back( seed );
+    seen[seed] = true;
+    while ( weight < target ) {
+      // a disconnected graph needs a new seed
+      if ( head == queue.size() ) {
+        while ( next_unseen < n && seen[next_unseen] ) next_unseen++;
+        if ( next_unseen == n ) break;
+        queue.emplace_back( next_unseen );
+        seen[next_unseen] = true;
+      }
+      auto i = queue[head++];
+      sides[i] = 0;
+      weight += graph.vertex_weights[i];
+      last = i;
+      for ( auto j=graph.offsets[i]; j<graph.offsets[i+1]; j++ ) {
+        auto k = graph.adjacency[j];
+        if ( !seen[k] ) {
+          seen[k] = true;
+          queue.emplace_back( k );
+        }
+      }
+    }
+    // keep going to find a far away vertex for the next seed
+    for ( ; head<queue.size(); head++ ) {
+      auto i = queue[head];
+      last = i;
+      for ( auto j=graph.offsets[i]; j<graph.offsets[i+1]; j++ ) {
+        auto k = graph.adjacency[j];
+        if ( !seen[k] ) {
+          seen[k] = true;
+          queue.emplace_back( k );
+        }
+      }
+    }
+    return last;
+  };
+
+  sides_t best, trial;
+  auto best_cut = std::numeric_limits<std::size_t>::max();
+
+  // each seed is the far end of the last attempt, which tends to find the
+  // periphery of the graph
+  index_t seed = 0;
+  for ( int s=0; s<num_initial_seeds; s++ ) {
+    auto next = grow( seed, trial );
+    auto cut = bisection_cut( graph, trial );
+    if ( cut < best_cut ) {
+      best_cut = cut;
+      std::swap( best, trial );
+    }
+    if ( next == seed ) break;
+    seed = next;
+  }
+
+  return best;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Improve a bisection with Fiduccia-Mattheyses refinement.
+//!
+//! Each pass moves vertices one at a time, always picking the move that
+//! reduces the cut the most without exceeding the allowed weight of the
+//! other side.  Moved vertices are locked for the rest of the pass.  Once
+//! no further moves look promising, the pass is rolled back to the best
+//! partition it saw.
+//!
+//! \param [in] graph  The graph.
+//! \param [in,out] sides  The side of each vertex.
+//! \param [in] frac  The fraction of the weight for the first side.
+////////////////////////////////////////////////////////////////////////////////
+inline void refine_bisection(
+  const graph_t & graph, sides_t & sides, double frac )
+{
+  using index_t = graph_t::index_t;
+  using gain_t = long long;
+
+  auto n = graph.size();
+  if ( n < 2 ) return;
+
+  // the allowed weight of each side.  Coarse vertices can be heavy, so
+  // always allow at least one of them on top of the target.
+  auto total = graph.total_weight();
+  auto max_vertex = *std::max_element(
+    graph.vertex_weights.begin(), graph.vertex_weights.end() );
+  double target[2] = { frac * total, (1-frac) * total };
+  index_t max_weight[2];
+  for ( int s=0; s<2; s++ )
+    max_weight[s] = static_cast<index_t>( std::max(
+      target[s] * (1+bisection_tolerance), target[s] + max_vertex
+    ) );
+
+  // how far a partition is from being acceptable
+  index_t weight[2] = {0, 0};
+  for ( index_t i=0; i<n; i++ ) weight[ sides[i] ] += graph.vertex_weights[i];
+  auto excess = [&]() {
+    index_t e = 0;
+    for ( int s=0; s<2; s++ )
+      if ( weight[s] > max_weight[s] ) e += weight[s] - max_weight[s];
+    return e;
+  };
+
+  // the reduction in cut if a vertex switches sides
+  std::vector<gain_t> gain( n );
+  auto compute_gain = [&]( index_t i ) {
+    gain_t g = 0;
+    for ( auto j=graph.offsets[i]; j<graph.offsets[i+1]; j++ ) {
+      auto w = static_cast<gain_t>( graph.edge_weights[j] );
+      g += ( sides[ graph.adjacency[j] ] == sides[i] ) ? -w : w;
+    }
+    return g;
+  };
+
+  // give up on a pass after this many moves without an improvement
+  auto max_stall = std::min<index_t>( std::max<index_t>( n/100, 20 ), 200 );
+
+  auto cut = static_cast<gain_t>( bisection_cut( graph, sides ) );
+
+  for ( int pass=0; pass<max_refinement_passes; pass++ ) {
+
+    // the movable vertices on each side, ordered by gain
+    std::set< std::pair<gain_t, index_t> > queue[2];
+    std::vector<bool> locked( n, false );
+    for ( index_t i=0; i<n; i++ ) {
+      gain[i] = compute_gain( i );
+      queue[ sides[i] ].emplace( gain[i], i );
+    }
+
+    std::vector<index_t> moves;
+    auto best_cut = cut;
+    auto best_excess = excess();
+    std::size_t best_moves = 0;
+    index_t stall = 0;
+
+    while ( stall < max_stall ) {
+
+      // the best candidate on each side that fits on the other one
+      int from = -1;
+      for ( int s=0; s<2; s++ ) {
+        if ( queue[s].empty() ) continue;
+        auto i = queue[s].rbegin()->second;
+        auto fits = weight[1-s] + graph.vertex_weights[i] <= max_weight[1-s];
+        // an overweight side can always shed a vertex
+        auto over = weight[s] > max_weight[s];
+        if ( !fits && !over ) continue;
+        if ( from < 0 ) { from = s; continue; }
+        auto g_from = queue[from].rbegin()->first;
+        auto g_this = queue[s].rbegin()->first;
+        auto from_over = weight[from] > max_weight[from];
+        if ( ( over && !from_over ) ||
+             ( over == from_over &&
+               ( g_this > g_from ||
+                 ( g_this == g_from && weight[s] > weight[from] ) ) ) )
+          from = s;
+      }
+      if ( from < 0 ) break;
+
+      // move the vertex
+      auto i = queue[from].rbegin()->second;
+      queue[from].erase( std::make_pair( gain[i], i ) );
+      locked[i] = true;
+      cut -= gain[i];
+      sides[i] = 1 - from;
+      weight[from] -= graph.vertex_weights[i];
+      weight[1-from] += graph.vertex_weights[i];
+      moves.emplace_back( i );
+
+      // update the neighbors
+      for ( auto j=graph.offsets[i]; j<graph.offsets[i+1]; j++ ) {
+        auto k = graph.adjacency[j];
+        if ( locked[k] ) continue;
+        auto & q = queue[ sides[k] ];
+        q.erase( std::make_pair( gain[k], k ) );
+        auto w = static_cast<gain_t>( graph.edge_weights[j] );
+        // k is now on the same side as i if it is on the side i moved to
+        gain[k] += ( sides[k] == sides[i] ) ? -2*w : 2*w;
+        q.emplace( gain[k], k );
+      }
+
+      // remember the best partition seen
+      auto e = excess();
+      if ( e < best_excess || ( e == best_excess && cut < best_cut ) ) {
+        best_excess = e;
+        best_cut = cut;
+        best_moves = moves.size();
+        stall = 0;
+      }
+      else
+        stall++;
+
+    }
+
+    // roll back to the best partition
+    for ( auto m=moves.size(); m>best_moves; m-- ) {
+      auto i = moves[m-1];
+      auto s = sides[i];
+      sides[i] = 1 - s;
+      weight[s] -= graph.vertex_weights[i];
+      weight[1-s] += graph.vertex_weights[i];
+    }
+    cut = best_cut;
+
+    // stop once a pass does not help
+    if ( best_moves == 0 ) break;
+
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Bisect a graph with the multilevel method.
+//!
+//! The graph is coarsened by heavy edge matching, the coarsest graph is
+//! bisected by region growing, and the bisection is refined at each level
+//! on the way back up.
+//!
+//! \param [in] graph  The graph to bisect.
+//! \param [in] frac  The fraction of the weight for the first side.
+//! \return The side of each vertex.
+////////////////////////////////////////////////////////////////////////////////
+inline sides_t multilevel_bisection( const graph_t & graph, double frac )
+{
+  using index_t = graph_t::index_t;
+
+  // coarsen
+  std::vector< graph_t > levels;
+  std::vector< std::vector<index_t> > maps;
+
+  const graph_t * current = &graph;
+  while ( current->size() > coarsest_graph_size ) {
+    std::vector<index_t> map;
+    auto coarse = coarsen( *current, map );
+    if ( coarse.size() > min_coarsening_ratio * current->size() ) break;
+    levels.emplace_back( std::move(coarse) );
+    maps.emplace_back( std::move(map) );
+    current = &levels.back();
+  }
+
+  // bisect the coarsest graph
+  auto sides = grow_bisection( *current, frac );
+  refine_bisection( *current, sides, frac );
+
+  // and project back up, refining as we go
+  for ( auto l=levels.size(); l>0; l-- ) {
+    const auto & fine = ( l > 1 ) ? levels[l-2] : graph;
+    const auto & map = maps[l-1];
+    sides_t fine_sides( fine.size() );
+    for ( index_t i=0; i<fine.size(); i++ ) fine_sides[i] = sides[ map[i] ];
+    std::swap( sides, fine_sides );
+    refine_bisection( fine, sides, frac );
+  }
+
+  return sides;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Recursively bisect a graph into parts.
+//!
+//! \param [in] graph  The graph to partition.
+//! \param [in] ids  The id of each graph vertex in the original graph.
+//! \param [in] first_part  The id of the first part.
+//! \param [in] num_parts  The number of parts.
+//! \param [in,out] owner  The part of each vertex of the original graph.
+////////////////////////////////////////////////////////////////////////////////
+inline void recursive_bisection(
+  const graph_t & graph, const std::vector<graph_t::index_t> & ids,
+  int first_part, int num_parts, std::vector<int> & owner )
+{
+  if ( num_parts == 1 || graph.size() == 0 ) {
+    for ( auto i : ids ) owner[i] = first_part;
+    return;
+  }
+
+  int num_left, num_right;
+  double frac;
+  std::tie( num_left, num_right, frac ) = split_parts( num_parts );
+
+  auto sides = multilevel_bisection( graph, frac );
+
+  for ( unsigned char s=0; s<2; s++ ) {
+    std::vector<graph_t::index_t> sub_ids;
+    auto sub = induced_subgraph( graph, sides, s, sub_ids );
+    for ( auto & i : sub_ids ) i = ids[i];
+    recursive_bisection(
+      sub, sub_ids, s ? first_part + num_left : first_part,
+      s ? num_right : num_left, owner
+    );
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Recursively bisect a set of points along their longest extent.
+//!
+//! \param [in] points  The points.
+//! \param [in] weights  The weight of each point.
+//! \param [in,out] ids  The points to partition.  They get reordered.
+//! \param [in] first_part  The id of the first part.
+//! \param [in] num_parts  The number of parts.
+//! \param [in,out] owner  The part of each point.
+////////////////////////////////////////////////////////////////////////////////
+template< typename P, typename W, typename I >
+void recursive_coordinate_bisection(
+  const P & points, const W & weights, I first, I last,
+  int first_part, int num_parts, std::vector<int> & owner )
+{
+  if ( num_parts == 1 || first == last ) {
+    for ( auto it=first; it!=last; ++it ) owner[*it] = first_part;
+    return;
+  }
+
+  int num_left, num_right;
+  double frac;
+  std::tie( num_left, num_right, frac ) = split_parts( num_parts );
+
+  // find the longest extent
+  constexpr auto dims = std::tuple_size< typename P::value_type >::value;
+  auto lo = points[*first], hi = points[*first];
+  for ( auto it=first; it!=last; ++it )
+    for ( std::size_t d=0; d<dims; d++ ) {
+      lo[d] = std::min( lo[d], points[*it][d] );
+      hi[d] = std::max( hi[d], points[*it][d] );
+    }
+  std::size_t dir = 0;
+  for ( std::size_t d=1; d<dims; d++ )
+    if ( hi[d]-lo[d] > hi[dir]-lo[dir] ) dir = d;
+
+  // sort along it, and split at the weighted median
+  std::stable_sort( first, last,
+    [&]( auto a, auto b ) { return points[a][dir] < points[b][dir]; } );
+
+  double total = 0;
+  for ( auto it=first; it!=last; ++it ) total += weights[*it];
+
+  auto mid = first;
+  double sum = 0;
+  while ( mid != last && sum + 0.5*weights[*mid] < frac*total )
+    sum += weights[*mid++];
+
+  recursive_coordinate_bisection(
+    points, weights, first, mid, first_part, num_left, owner );
+  recursive_coordinate_bisection(
+    points, weights, mid, last, first_part+num_left, num_right, owner );
+}
+
+} // namespace detail
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Partition a graph with multilevel recursive bisection.
+//!
+//! \param [in] graph  The graph to partition.
+//! \param [in] num_parts  The number of parts.
+//! \return The part that owns each vertex.
+////////////////////////////////////////////////////////////////////////////////
+inline std::vector<int> multilevel_partition(
+  const graph_t & graph, int num_parts )
+{
+  if ( num_parts < 1 || static_cast<std::size_t>(num_parts) > graph.size() )
+    raise_runtime_error(
+      "Can't split " << graph.size() << " cells into " << num_parts << " parts"
+    );
+
+  std::vector<int> owner( graph.size(), 0 );
+  std::vector<graph_t::index_t> ids( graph.size() );
+  std::iota( ids.begin(), ids.end(), 0 );
+  detail::recursive_bisection( graph, ids, 0, num_parts, owner );
+  return owner;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Partition a set of points with recursive coordinate bisection.
+//!
+//! \param [in] points  The points, each indexable by dimension.
+//! \param [in] weights  The weight of each point.
+//! \param [in] num_parts  The number of parts.
+//! \return The part that owns each point.
+////////////////////////////////////////////////////////////////////////////////
+template< typename P, typename W >
+std::vector<int> geometric_partition(
+  const P & points, const W & weights, int num_parts )
+{
+  auto n = points.size();
+  if ( num_parts < 1 || static_cast<std::size_t>(num_parts) > n )
+    raise_runtime_error(
+      "Can't split " << n << " cells into " << num_parts << " parts"
+    );
+
+  std::vector<int> owner( n, 0 );
+  std::vector<std::size_t> ids( n );
+  std::iota( ids.begin(), ids.end(), 0 );
+  detail::recursive_coordinate_bisection(
+    points, weights, ids.begin(), ids.end(), 0, num_parts, owner
+  );
+  return owner;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Measure the quality of a partition.
+//!
+//! \param [in] graph  The partitioned graph.
+//! \param [in] owner  The part of each vertex.
+//! \param [in] num_parts  The number of parts.
+//! \return The edge cut and imbalance.
+////////////////////////////////////////////////////////////////////////////////
+inline partition_quality_t evaluate_partition(
+  const graph_t & graph, const std::vector<int> & owner, int num_parts )
+{
+  partition_quality_t quality;
+
+  std::vector<std::size_t> part_weight( num_parts, 0 );
+  for ( std::size_t i=0; i<graph.size(); i++ ) {
+    part_weight[ owner[i] ] += graph.vertex_weights[i];
+    for ( auto j=graph.offsets[i]; j<graph.offsets[i+1]; j++ )
+      if ( owner[i] < owner[ graph.adjacency[j] ] )
+        quality.edge_cut += graph.edge_weights[j];
+  }
+
+  auto heaviest = *std::max_element( part_weight.begin(), part_weight.end() );
+  auto total = graph.total_weight();
+  if ( total > 0 )
+    quality.imbalance = static_cast<double>( heaviest ) * num_parts / total;
+
+  return quality;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Print the quality of a partition.
+////////////////////////////////////////////////////////////////////////////////
+inline std::ostream & operator<<(
+  std::ostream & os, const partition_quality_t & quality )
+{
+  os << "edge cut " << quality.edge_cut
+     << ", imbalance " << quality.imbalance;
+  return os;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Build the dual graph of a mesh.
+//!
+//! Cells are connected if they share a face.
+//!
+//! \param [in] mesh  The mesh.
+//! \param [in] weights  The weight of each cell.  If empty, every cell
+//!                      weighs one.
+//! \return The graph.
+////////////////////////////////////////////////////////////////////////////////
+template< typename M >
+graph_t dual_graph( M & mesh, const std::vector<std::size_t> & weights = {} )
+{
+  auto cs = mesh.cells();
+  auto num_cells = cs.size();
+
+  if ( !weights.empty() && weights.size() != num_cells )
+    raise_runtime_error( "There must be one weight per cell" );
+
+  graph_t graph;
+  graph.offsets.reserve( num_cells+1 );
+  graph.vertex_weights = weights;
+  if ( weights.empty() ) graph.vertex_weights.assign( num_cells, 1 );
+
+  for ( auto c : cs ) {
+    for ( auto f : mesh.faces(c) )
+      for ( auto nb : mesh.cells(f) )
+        if ( nb.id() != c.id() ) {
+          graph.adjacency.emplace_back( nb.id() );
+          graph.edge_weights.emplace_back( 1 );
+        }
+    graph.offsets.emplace_back( graph.adjacency.size() );
+  }
+
+  return graph;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Estimate the cost of each cell by its number of corners.
+//!
+//! A cell has one corner per vertex, so meshes built without corners are
+//! weighted by their cell vertices instead.
+//!
+//! \param [in] mesh  The mesh.
+//! \return The weight of each cell.
+////////////////////////////////////////////////////////////////////////////////
+template< typename M >
+std::vector<std::size_t> corner_weights( M & mesh )
+{
+  std::vector<std::size_t> weights;
+  weights.reserve( mesh.num_cells() );
+  if ( mesh.has_corners() )
+    for ( auto c : mesh.cells() )
+      weights.emplace_back( mesh.corners(c).size() );
+  else
+    for ( auto c : mesh.cells() )
+      weights.emplace_back( mesh.vertices(c).size() );
+  return weights;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Partition the cells of a mesh.
+//!
+//! \param [in] mesh  The mesh.
+//! \param [in] num_parts  The number of parts.
+//! \param [in] method  The partitioning method.
+//! \param [in] weights  The weight of each cell.  If empty, every cell
+//!                      weighs one.  The block method ignores them.
+//! \return The part that owns each cell.
+////////////////////////////////////////////////////////////////////////////////
+template< typename M >
+std::vector<int> partition(
+  M & mesh, int num_parts,
+  partition_method_t method = partition_method_t::multilevel,
+  const std::vector<std::size_t> & weights = {} )
+{
+  switch ( method ) {
+
+  case partition_method_t::block:
+    return block_partition( mesh.num_cells(), num_parts );
+
+  case partition_method_t::geometric: {
+    constexpr auto dims = M::num_dimensions;
+    auto cs = mesh.cells();
+    auto xc = mesh.cell_centroids();
+    std::vector< std::array<double, dims> > points( cs.size() );
+    for ( auto c : cs )
+      for ( std::size_t d=0; d<dims; d++ ) points[c.id()][d] = xc[c][d];
+    std::vector<double> w( cs.size(), 1 );
+    if ( !weights.empty() ) w.assign( weights.begin(), weights.end() );
+    return geometric_partition( points, w, num_parts );
+  }
+
+  case partition_method_t::multilevel:
+    return multilevel_partition( dual_graph( mesh, weights ), num_parts );
+
+  default:
+    raise_implemented_error( "Unknown partitioning method" );
+  }
+
+  return {};
+}
+
+} // namespace
+} // namespace
@@ -0,0 +1,160 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Tests of the bulk sub-entity construction.
+////////////////////////////////////////////////////////////////////////////////
+
+// user includes
+#include "flecsale/mesh/connectivity.h"
+
+// system includes
+#include <algorithm>
+#include <cinchtest.h>
+#include <map>
+#include <vector>
+
+// explicitly use some stuff
+using std::vector;
+
+using namespace flecsale::mesh;
+
+//! \brief The id type.
+using index_t = sub_entities_t::index_t;
+
+//! \brief The faces of a hexahedron.
+const local_entities_t hex_faces = {
+  {3, 2, 1, 0}, {5, 6, 7, 4}, {1, 5, 4, 0},
+  {2, 6, 5, 1}, {3, 7, 6, 2}, {0, 4, 7, 3}
+};
+
+//=============================================================================
+//! \brief Number the sub-entities the simple way, as each is first seen.
+//=============================================================================
+template< typename F >
+sub_entities_t build_serially(
+  const vector<std::size_t> & cell_vertex_offsets,
+  const vector<index_t> & cell_vertices,
+  F && local_entities )
+{
+  sub_entities_t ents;
+  std::map< vector<std::size_t>, std::size_t > ids;
+  vector< vector<std::size_t> > cells;
+
+  auto num_cells = cell_vertex_offsets.size() - 1;
+  for ( std::size_t c=0; c<num_cells; c++ ) {
+    const auto & local = local_entities(c);
+    auto cverts = cell_vertices.data() + cell_vertex_offsets[c];
+    for ( std::size_t i=0; i<local.size(); i++ ) {
+      vector<std::size_t> vs;
+      for ( std::size_t j=0; j<local.num_vertices(i); j++ )
+        vs.emplace_back( cverts[ local.vertices(i)[j] ] );
+      auto key = vs;
+      std::sort( key.begin(), key.end() );
+      auto it = ids.emplace( key, ids.size() ).first;
+      if ( it->second == cells.size() ) {
+        ents.vertices.insert( ents.vertices.end(), vs.begin(), vs.end() );
+        ents.vertex_offsets.emplace_back( ents.vertices.size() );
+        cells.emplace_back();
+      }
+      ents.cell_entities.emplace_back( it->second );
+      cells[ it->second ].emplace_back( c );
+    }
+    ents.cell_offsets.emplace_back( ents.cell_entities.size() );
+  }
+
+  for ( const auto & cs : cells ) {
+    ents.entity_cells.insert( ents.entity_cells.end(), cs.begin(), cs.end() );
+    ents.entity_cell_offsets.emplace_back( ents.entity_cells.size() );
+  }
+
+  return ents;
+}
+
+//=============================================================================
+//! \brief Compare two sets of sub-entities.
+//=============================================================================
+void compare( const sub_entities_t & a, const sub_entities_t & b )
+{
+  ASSERT_EQ( a.vertex_offsets, b.vertex_offsets );
+  ASSERT_EQ( a.vertices, b.vertices );
+  ASSERT_EQ( a.cell_offsets, b.cell_offsets );
+  ASSERT_EQ( a.cell_entities, b.cell_entities );
+  ASSERT_EQ( a.entity_cell_offsets, b.entity_cell_offsets );
+  ASSERT_EQ( a.entity_cells, b.entity_cells );
+}
+
+//=============================================================================
+//! \brief Test the edges of a small quadrilateral mesh.
+//=============================================================================
+TEST(connectivity, polygons) {
+
+  //  6---7---8
+  //  | 2 | 3 |
+  //  3---4---5
+  //  | 0 | 1 |
+  //  0---1---2
+  vector<index_t> cell_vertices = {
+    0, 1, 4, 3,    1, 2, 5, 4,    3, 4, 7, 6,    4, 5, 8, 7 };
+  vector<std::size_t> cell_vertex_offsets = { 0, 4, 8, 12, 16 };
+
+  std::map< std::size_t, local_entities_t > rings;
+  auto local = [&]( auto c ) -> const local_entities_t &
+  {
+    auto n = cell_vertex_offsets[c+1] - cell_vertex_offsets[c];
+    return rings.at(n);
+  };
+  rings[4] = local_entities_t::ring(4);
+
+  auto ents = build_sub_entities( 9, cell_vertex_offsets, cell_vertices, local );
+  ASSERT_EQ( 12, ents.size() );
+
+  // the first cell sets the numbering and orientation
+  ASSERT_EQ( vector<std::size_t>({0, 1, 2, 3}),
+    vector<std::size_t>( ents.cell_entities.begin(),
+      ents.cell_entities.begin() + 4 ) );
+  ASSERT_EQ( 1, ents.vertices[ ents.vertex_offsets[1] ] );
+  ASSERT_EQ( 4, ents.vertices[ ents.vertex_offsets[1] + 1 ] );
+  ASSERT_EQ( 1, ents.cell_entities[7] );
+  ASSERT_EQ( vector<std::size_t>({0, 1}),
+    vector<std::size_t>(
+      ents.entity_cells.begin() + ents.entity_cell_offsets[1],
+      ents.entity_cells.begin() + ents.entity_cell_offsets[2] ) );
+
+  compare( ents, build_serially( cell_vertex_offsets, cell_vertices, local ) );
+
+}
+
+//=============================================================================
+//! \brief Test the faces of a block of hexahedra.
+//=============================================================================
+TEST(connectivity, hexahedra) {
+
+  constexpr std::size_t nx = 40, ny = 30, nz = 20;
+  auto vid = [&]( auto i, auto j, auto k )
+  { return i + (nx+1)*( j + (ny+1)*k ); };
+
+  // number the cells out of order, to mix up the first appearances
+  vector<index_t> cell_vertices;
+  vector<std::size_t> cell_vertex_offsets = {0};
+  for ( std::size_t c=0; c<nx*ny*nz; c++ ) {
+    auto id = ( c * 7919 ) % ( nx*ny*nz );
+    auto i = id % nx, j = ( id / nx ) % ny, k = id / ( nx*ny );
+    for ( auto v : {
+      vid(i,j,k), vid(i+1,j,k), vid(i+1,j+1,k), vid(i,j+1,k),
+      vid(i,j,k+1), vid(i+1,j,k+1), vid(i+1,j+1,k+1), vid(i,j+1,k+1) } )
+      cell_vertices.emplace_back( v );
+    cell_vertex_offsets.emplace_back( cell_vertices.size() );
+  }
+
+  auto local = []( auto ) -> const local_entities_t & { return hex_faces; };
+
+  auto ents = build_sub_entities(
+    (nx+1)*(ny+1)*(nz+1), cell_vertex_offsets, cell_vertices, local );
+  ASSERT_EQ( (nx+1)*ny*nz + nx*(ny+1)*nz + nx*ny*(nz+1), ents.size() );
+
+  compare( ents, build_serially( cell_vertex_offsets, cell_vertices, local ) );
+
+}
@@ -28,6 +28,13 @@
 #  include <vtkLongLongArray.h>
 #endif
 
+// system includes
+#include <algorithm>
+#include <numeric>
+#include <string>
+#include <type_traits>
+#include <vector>
+
 
 namespace flecsale {
 namespace mesh {
@@ -274,6 +281,312 @@ static auto write_points_to_vtk( M & m, vtkUnstructuredGrid* ug )
 }
 
 
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Update the vertex coordinates of a vtkUnstructuredMesh in place.
+//! \param [in] m A mesh to convert to vtk.
+//! \param [in,out] ug A vtk unstructured mesh object with the same vertices.
+//! \return True if any coordinate changed.
+////////////////////////////////////////////////////////////////////////////////
+template< typename M >
+static bool update_points_in_vtk( M & m, vtkUnstructuredGrid* ug ) 
+{
+
+  using   real_t = typename M::real_t;
+  using data_type = typename vtk_array_t<real_t>::type;
+
+  constexpr auto num_dims = M::num_dimensions;
+  auto num_vertices = m.num_vertices();
+  auto vs = m.vertices();
+
+  // the points were created with the mesh real type, so they can be
+  // written to directly
+  auto data = data_type::SafeDownCast( ug->GetPoints()->GetData() );
+  auto x = data->GetPointer(0);
+
+  int changed = 0;
+
+  #pragma omp parallel for reduction(max:changed)
+  for ( std::size_t i=0; i<num_vertices; i++ ) {
+    auto & coord = vs[i]->coordinates();
+    for ( int d=0; d<num_dims; d++ ) {
+      auto & to = x[ 3*i + d ];
+      if ( to != coord[d] ) {
+        to = coord[d];
+        changed = 1;
+      }
+    }
+  }
+
+  // only bump the modification time if something actually moved
+  if ( changed ) ug->GetPoints()->Modified();
+
+  return changed;
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Add the 2d cells from a mesh to a vtkUnstructuredMesh.
+//! \param [in] m A mesh to convert to vtk.
+//! \param [in,out] ug A vtk unstructured mesh object.
+////////////////////////////////////////////////////////////////////////////////
+template< 
+  typename M,
+  std::enable_if_t< M::num_dimensions == 2 >* = nullptr
+>
+static void write_cells_to_vtk( M & m, vtkUnstructuredGrid* ug ) 
+{
+
+  // alias some types
+  using std::vector;
+
+  ug->Allocate( m.num_cells() );
+
+  for ( auto c : m.cells() ) {
+    // get the vertices in this cell
+    auto vs = m.vertices(c);
+    auto n = vs.size();
+    // copy them to the vtk type
+    vector< vtkIdType > ids(n);
+    std::transform( vs.begin(), vs.end(), ids.begin(),
+                    [](auto && v) { return v.id(); } );
+    // set the cell vertices
+    ug->InsertNextCell(VTK_POLYGON, n, ids.data());
+  }
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Add the 3d cells from a mesh to a vtkUnstructuredMesh.
+//! \param [in] m A mesh to convert to vtk.
+//! \param [in,out] ug A vtk unstructured mesh object.
+////////////////////////////////////////////////////////////////////////////////
+template< 
+  typename M,
+  std::enable_if_t< M::num_dimensions == 3 >* = nullptr
+>
+static void write_cells_to_vtk( M & m, vtkUnstructuredGrid* ug ) 
+{
+
+  // alias some types
+  using std::vector;
+  using size_t = typename M::size_t;
+
+  ug->Allocate( m.num_cells() );
+
+  for ( auto c : m.cells() ) {
+    // get the vertices in this cell
+    auto cell_verts = m.vertices(c);
+    auto num_cell_verts = cell_verts.size();
+    // copy them to the vtk type
+    vector< vtkIdType > vert_ids(num_cell_verts);
+    std::transform( 
+      cell_verts.begin(), cell_verts.end(), vert_ids.begin(),
+      [](auto && v) { return v.id(); } 
+    );
+    // get the faces
+    auto cell_faces = m.faces(c);
+    auto num_cell_faces = cell_faces.size();
+    // get the total number of vertices
+    auto tot_verts = std::accumulate( 
+      cell_faces.begin(), cell_faces.end(), static_cast<size_t>(0),
+      [&m](auto sum, auto f) { return sum + m.vertices(f).size(); }
+    );
+    // the list of faces that vtk requires contains the number of points in each
+    // face AND the point ids themselves.
+    vector< vtkIdType > face_data;
+    face_data.reserve( tot_verts + num_cell_faces );
+    for ( auto f : cell_faces ) {
+      auto face_cells = m.cells(f);
+      auto face_verts = m.vertices(f);
+      auto num_face_verts = face_verts.size();
+      // copy the face vert ids to the vtk type
+      vector< vtkIdType > face_vert_ids( num_face_verts );
+      std::transform( 
+        face_verts.begin(), face_verts.end(), face_vert_ids.begin(),
+        [](auto && v) { return v.id(); } 
+      );
+      // check the direction of the vertices
+      if ( face_cells[0] != c ) 
+        std::reverse( face_vert_ids.begin(), face_vert_ids.end() );
+      // now copy them to the global array
+      face_data.emplace_back( num_face_verts );
+      for ( auto v : face_vert_ids )
+        face_data.emplace_back( v );
+    }
+    // set the cell vertices
+    ug->InsertNextCell(
+      VTK_POLYHEDRON, num_cell_verts, vert_ids.data(),
+      num_cell_faces, face_data.data()
+    );
+  }
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Point a vtk array at existing storage.
+//!
+//! The array does not own the data, so it must outlive the array.  If an 
+//! array with the same name already points at it, it is only flagged as 
+//! modified.
+//!
+//! \param [in,out] fd  The point or cell data to add the array to.
+//! \param [in] label  The name of the array.
+//! \param [in] data  The storage to wrap.
+//! \param [in] num_tuples  The number of entities.
+//! \param [in] num_comps  The number of components per entity.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+static void wrap_array_in_vtk(
+  vtkFieldData * fd, const std::string & label, T * data,
+  vtkIdType num_tuples, int num_comps )
+{
+  using array_t = typename vtk_array_t< std::remove_const_t<T> >::type;
+
+  auto existing = array_t::SafeDownCast( fd->GetAbstractArray( label.c_str() ) );
+  if ( existing && existing->GetPointer(0) == data &&
+       existing->GetNumberOfTuples() == num_tuples ) 
+  {
+    existing->Modified();
+    return;
+  }
+
+  auto vals = vtkSmartPointer< array_t >::New();
+  vals->SetName( label.c_str() );
+  vals->SetNumberOfComponents( num_comps );
+  // save=1 so vtk never frees the storage
+  vals->SetArray( const_cast< std::remove_const_t<T>* >(data), 
+    num_tuples*num_comps, 1 );
+  // replaces any array with the same name
+  fd->AddArray( vals );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Copy vectors into a vtk array padded to three components.
+//!
+//! VTK expects vectors to have three components, so vectors with fewer
+//! cannot be wrapped in place.  The padded copy is kept in the field data
+//! and refilled on the next call.
+//!
+//! \param [in,out] fd  The point or cell data to add the array to.
+//! \param [in] label  The name of the array.
+//! \param [in] data  The vectors to copy.
+//! \param [in] num_tuples  The number of entities.
+//! \param [in] num_comps  The number of components per entity.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+static void pad_array_in_vtk(
+  vtkFieldData * fd, const std::string & label, const T * data,
+  vtkIdType num_tuples, int num_comps )
+{
+  using array_t = typename vtk_array_t< std::remove_const_t<T> >::type;
+
+  auto vals = array_t::SafeDownCast( fd->GetAbstractArray( label.c_str() ) );
+  if ( !vals || vals->GetNumberOfComponents() != 3 ||
+       vals->GetNumberOfTuples() != num_tuples ) 
+  {
+    auto padded = vtkSmartPointer< array_t >::New();
+    padded->SetName( label.c_str() );
+    padded->SetNumberOfComponents( 3 );
+    padded->SetNumberOfTuples( num_tuples );
+    // replaces any array with the same name
+    fd->AddArray( padded );
+    vals = padded.GetPointer();
+  }
+
+  auto to = vals->GetPointer(0);
+  #pragma omp parallel for
+  for ( vtkIdType i=0; i<num_tuples; i++ ) {
+    for ( int d=0; d<num_comps; d++ ) to[3*i+d] = data[num_comps*i+d];
+    for ( int d=num_comps; d<3; d++ ) to[3*i+d] = 0;
+  }
+  vals->Modified();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Expose vectors to vtk, wrapping them in place when they already
+//!        have three components.
+//! \see wrap_array_in_vtk, pad_array_in_vtk
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+static void wrap_vectors_in_vtk(
+  vtkFieldData * fd, const std::string & label, T * data,
+  vtkIdType num_tuples, int num_comps )
+{
+  if ( num_comps == 3 )
+    wrap_array_in_vtk( fd, label, data, num_tuples, num_comps );
+  else
+    pad_array_in_vtk( fd, label, data, num_tuples, num_comps );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Expose the field data from a mesh to a vtkUnstructuredMesh without
+//!        copying it.
+//!
+//! Scalars are wrapped in place.  Vectors are too in 3d, but 2d vectors
+//! are copied into arrays padded to three components, like to_vtk does.
+//!
+//! \param [in] m A mesh to convert to vtk.
+//! \param [in,out] ug A vtk unstructured mesh object.
+////////////////////////////////////////////////////////////////////////////////
+template< typename M >
+static void wrap_fields_in_vtk( M & m, vtkUnstructuredGrid* ug ) 
+{
+
+  using   real_t = typename M::real_t;
+  using integer_t= typename M::integer_t;
+  using vector_t = typename M::vector_t;
+
+  constexpr int num_dims = M::num_dimensions;
+  auto num_vertices = m.num_vertices();
+  auto num_cells = m.num_cells();
+
+  auto pd = ug->GetPointData();
+  auto cd = ug->GetCellData();
+
+  // scalars and vectors persistent at vertices
+  if ( num_vertices > 0 ) {
+    auto rspav = flecsi_get_accessors_all(
+      m, real_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
+    );
+    for(auto sf: rspav) 
+      wrap_array_in_vtk( pd, sf.label(), &sf[0], num_vertices, 1 );
+
+    auto ispav = flecsi_get_accessors_all(
+      m, integer_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
+    );
+    for(auto sf: ispav) 
+      wrap_array_in_vtk( pd, sf.label(), &sf[0], num_vertices, 1 );
+
+    auto rvpav = flecsi_get_accessors_all(
+      m, vector_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
+    );
+    for(auto vf: rvpav) 
+      wrap_vectors_in_vtk( pd, vf.label(), &vf[0][0], num_vertices, num_dims );
+  }
+
+  // scalars and vectors persistent at cells
+  if ( num_cells > 0 ) {
+    auto rspac = flecsi_get_accessors_all(
+      m, real_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
+    );
+    for(auto sf: rspac) 
+      wrap_array_in_vtk( cd, sf.label(), &sf[0], num_cells, 1 );
+
+    auto ispac = flecsi_get_accessors_all(
+      m, integer_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
+    );
+    for(auto sf: ispac) 
+      wrap_array_in_vtk( cd, sf.label(), &sf[0], num_cells, 1 );
+
+    auto rvpac = flecsi_get_accessors_all(
+      m, vector_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
+    );
+    for(auto vf: rvpac) 
+      wrap_vectors_in_vtk( cd, vf.label(), &vf[0][0], num_cells, num_dims );
+  }
+
+}
+
 } // namespace detail
 
 #endif // HAVE_VTK
@@ -306,9 +619,6 @@ static auto to_vtk( M & m )
   // setup
   //----------------------------------------------------------------------------
 
-  // some general mesh stats
-  auto num_cells = m.num_cells();
-    
   // creat unstructured grid
   auto ug = vtkSmartPointer<vtkUnstructuredGrid>::New();
 
@@ -316,18 +626,8 @@ static auto to_vtk( M & m )
   detail::write_points_to_vtk( m, ug );
 
   // create the cells
-  for ( auto c : m.cells() ) {
-    // get the vertices in this cell
-    auto vs = m.vertices(c);
-    auto n = vs.size();
-    // copy them to the vtk type
-    vector< vtkIdType > ids(n);
-    std::transform( vs.begin(), vs.end(), ids.begin(),
-                    [](auto && v) { return v.id(); } );
-    // set the cell vertices
-    ug->InsertNextCell(VTK_POLYGON, n, ids.data());
-  }
-    
+  detail::write_cells_to_vtk( m, ug );
+
 
   //----------------------------------------------------------------------------
   // write field data
@@ -380,11 +680,6 @@ static auto to_vtk( M & m )
   // setup
   //----------------------------------------------------------------------------
 
-  // some general mesh stats
-  constexpr auto num_dims = M::num_dimensions;
-  auto num_vertices = m.num_vertices();
-  auto num_cells = m.num_cells();
-    
   // creat unstructured grid
   auto ug = vtkSmartPointer<vtkUnstructuredGrid>::New();
 
@@ -392,53 +687,7 @@ static auto to_vtk( M & m )
   detail::write_points_to_vtk( m, ug );
 
   // create the cells
-  for ( auto c : m.cells() ) {
-    // get the vertices in this cell
-    auto cell_verts = m.vertices(c);
-    auto num_cell_verts = cell_verts.size();
-    // copy them to the vtk type
-    vector< vtkIdType > vert_ids(num_cell_verts);
-    std::transform( 
-      cell_verts.begin(), cell_verts.end(), vert_ids.begin(),
-      [](auto && v) { return v.id(); } 
-    );
-    // get the faces
-    auto cell_faces = m.faces(c);
-    auto num_cell_faces = cell_faces.size();
-    // get the total number of vertices
-    auto tot_verts = std::accumulate( 
-      cell_faces.begin(), cell_faces.end(), static_cast<size_t>(0),
-      [&m](auto sum, auto f) { return sum + m.vertices(f).size(); }
-    );
-    // the list of faces that vtk requires contains the number of points in each
-    // face AND the point ids themselves.
-    vector< vtkIdType > face_data;
-    face_data.reserve( tot_verts + num_cell_faces );
-    for ( auto f : cell_faces ) {
-      auto face_cells = m.cells(f);
-      auto face_verts = m.vertices(f);
-      auto num_face_verts = face_verts.size();
-      // copy the face vert ids to the vtk type
-      vector< vtkIdType > face_vert_ids( num_face_verts );
-      std::transform( 
-        face_verts.begin(), face_verts.end(), face_vert_ids.begin(),
-        [](auto && v) { return v.id(); } 
-      );
-      // check the direction of the vertices
-      if ( face_cells[0] != c ) 
-        std::reverse( face_vert_ids.begin(), face_vert_ids.end() );
-      // now copy them to the global array
-      face_data.emplace_back( num_face_verts );
-      for ( auto v : face_vert_ids )
-        face_data.emplace_back( v );
-    }
-    // set the cell vertices
-    ug->InsertNextCell(
-      VTK_POLYHEDRON, num_cell_verts, vert_ids.data(),
-      num_cell_faces, face_data.data()
-    );
-  }
-    
+  detail::write_cells_to_vtk( m, ug );
 
   //----------------------------------------------------------------------------
   // write field data
@@ -469,6 +718,56 @@ static auto to_vtk( M & m )
 //##############################################################################
 //##############################################################################
 
+////////////////////////////////////////////////////////////////////////////////
+//! \brief A vtk unstructured grid that is kept in sync with a burton mesh.
+//!
+//! The points and cells are only built the first time, or if the number of
+//! entities changes.  After that, the coordinates are updated in place, and
+//! the persistent fields are exposed to vtk without copying them.  This 
+//! makes it cheap enough to hand to in-situ visualization every step.
+//!
+//! \tparam M  The mesh type.
+////////////////////////////////////////////////////////////////////////////////
+template< typename M >
+class vtk_grid_t {
+public:
+
+  //! \brief Bring the grid up to date with a mesh.
+  //! \param [in] m  The mesh to convert to vtk.
+  //! \return The grid.  It refers to the field storage of \a m, so \a m
+  //!         must outlive any use of it.
+  vtkUnstructuredGrid * update( M & m )
+  {
+    auto rebuild = !grid_ ||
+      grid_->GetNumberOfPoints() != static_cast<vtkIdType>( m.num_vertices() ) ||
+      grid_->GetNumberOfCells() != static_cast<vtkIdType>( m.num_cells() );
+
+    if ( rebuild ) {
+      grid_ = vtkSmartPointer<vtkUnstructuredGrid>::New();
+      detail::write_points_to_vtk( m, grid_ );
+      detail::write_cells_to_vtk( m, grid_ );
+    }
+    else {
+      detail::update_points_in_vtk( m, grid_ );
+    }
+
+    detail::wrap_fields_in_vtk( m, grid_ );
+
+    return grid_;
+  }
+
+  //! \brief Forget the grid, so the next update rebuilds it.
+  void reset()
+  { grid_ = nullptr; }
+
+private:
+
+  //! \brief The cached grid.
+  vtkSmartPointer<vtkUnstructuredGrid> grid_;
+
+};
+
+
 ////////////////////////////////////////////////////////////////////////////////
 //! \brief convert a vtk unstructured grid to a burton mesh
 //! \param [in] ug  A mesh in VTK's unstructured format.
@@ -0,0 +1,269 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief A set of small unsigned integers, stored as a bitmask.
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// system includes
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+
+namespace flecsale {
+namespace utils {
+
+namespace detail {
+
+//! \brief Count the set bits in a word.
+inline std::size_t popcount( std::uint64_t x )
+{
+#if defined( __GNUC__ )
+  return __builtin_popcountll( x );
+#else
+  std::size_t n = 0;
+  for ( ; x; x &= x-1 ) n++;
+  return n;
+#endif
+}
+
+//! \brief The position of the lowest set bit of a non-zero word.
+inline std::size_t lowest_bit( std::uint64_t x )
+{
+  assert( x != 0 );
+#if defined( __GNUC__ )
+  return __builtin_ctzll( x );
+#else
+  std::size_t n = 0;
+  for ( ; !( x & 1 ); x >>= 1 ) n++;
+  return n;
+#endif
+}
+
+} // namespace detail
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief A set of the values 0 to 64*W-1, stored one bit per value.
+//!
+//! Lookups, insertions, unions and intersections touch at most W words, and
+//! iteration skips straight from one set bit to the next.  The values come
+//! out in increasing order.  The storage is a plain array, so the set can be
+//! kept in dense per-entity data.
+//!
+//! \tparam T  The value type.
+//! \tparam W  The number of 64 bit words.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T, std::size_t W = 1 >
+class bitmask_set {
+
+public:
+
+  //============================================================================
+  // public typedefs
+  //============================================================================
+  using value_type = T;
+  using size_type = std::size_t;
+  using word_t = std::uint64_t;
+
+  //! \brief The number of bits in each word.
+  static constexpr size_type bits_per_word = 64;
+
+  //============================================================================
+  //! \brief A forward iterator over the set values.
+  //============================================================================
+  class const_iterator {
+  public:
+
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T *;
+    using reference = T;
+
+    //! \brief Start at the first value in word w, or past the end.
+    const_iterator( const bitmask_set * set, size_type w ) : set_(set), w_(w)
+    { skip_(); }
+
+    //! \brief The current value.
+    reference operator*() const
+    { return static_cast<T>( w_*bits_per_word + detail::lowest_bit(bits_) ); }
+
+    //! \brief Move to the next value.
+    const_iterator & operator++()
+    {
+      bits_ &= bits_ - 1;
+      if ( !bits_ ) { w_++; skip_(); }
+      return *this;
+    }
+
+    //! \copydoc operator++()
+    const_iterator operator++(int)
+    { auto tmp = *this; ++(*this); return tmp; }
+
+    bool operator==( const const_iterator & other ) const
+    { return w_ == other.w_ && bits_ == other.bits_; }
+
+    bool operator!=( const const_iterator & other ) const
+    { return !( *this == other ); }
+
+  private:
+
+    //! \brief Find the next non-empty word, starting from the current one.
+    void skip_()
+    {
+      for ( bits_ = 0; w_ < W; w_++ ) {
+        bits_ = set_->words_[w_];
+        if ( bits_ ) return;
+      }
+    }
+
+    //! \brief The set being iterated over.
+    const bitmask_set * set_ = nullptr;
+    //! \brief The current word.
+    size_type w_ = W;
+    //! \brief The bits of the current word that are still to be visited.
+    word_t bits_ = 0;
+  };
+
+  using iterator = const_iterator;
+
+  //============================================================================
+  // Construct / copy
+  //============================================================================
+  constexpr bitmask_set() = default;
+
+  bitmask_set( std::initializer_list<T> init )
+  {
+    for ( auto v : init ) insert( v );
+  }
+
+  //============================================================================
+  // Iterators
+  //============================================================================
+
+  const_iterator begin() const { return { this, 0 }; }
+  const_iterator end() const { return { this, W }; }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+  //============================================================================
+  // Capacity
+  //============================================================================
+
+  //! \brief The number of values in the set.
+  size_type size() const
+  {
+    size_type n = 0;
+    for ( auto w : words_ ) n += detail::popcount( w );
+    return n;
+  }
+
+  //! \brief True if no values are set.
+  bool empty() const
+  {
+    for ( auto w : words_ ) if ( w ) return false;
+    return true;
+  }
+
+  //! \brief One more than the largest value the set can hold.
+  static constexpr size_type capacity() { return W * bits_per_word; }
+  //! \copydoc capacity()
+  static constexpr size_type max_size() { return capacity(); }
+
+  //============================================================================
+  // Lookup
+  //============================================================================
+
+  //! \brief Return 1 if the value is in the set, 0 otherwise.
+  size_type count( const T & value ) const
+  {
+    auto i = static_cast<size_type>( value );
+    if ( i >= capacity() ) return 0;
+    return ( words_[ i / bits_per_word ] >> ( i % bits_per_word ) ) & 1;
+  }
+
+  //! \brief The smallest value in a non-empty set.
+  T front() const { return *begin(); }
+
+  //! \brief The words holding the bits, lowest values first.
+  const std::array<word_t, W> & words() const { return words_; }
+
+  //============================================================================
+  // Modifiers
+  //============================================================================
+
+  //! \brief Add a value to the set.
+  //! \return True if the value was not already there.
+  bool insert( const T & value )
+  {
+    auto i = static_cast<size_type>( value );
+    assert( i < capacity() );
+    auto & w = words_[ i / bits_per_word ];
+    auto bit = word_t(1) << ( i % bits_per_word );
+    auto inserted = !( w & bit );
+    w |= bit;
+    return inserted;
+  }
+
+  //! \brief Remove a value from the set.
+  //! \return The number of values removed.
+  size_type erase( const T & value )
+  {
+    auto n = count( value );
+    if ( n ) {
+      auto i = static_cast<size_type>( value );
+      words_[ i / bits_per_word ] &= ~( word_t(1) << ( i % bits_per_word ) );
+    }
+    return n;
+  }
+
+  //! \brief Remove all the values.
+  void clear() { words_.fill( 0 ); }
+
+  //============================================================================
+  // Set operations
+  //============================================================================
+
+  //! \brief Keep only the values that are also in another set.
+  bitmask_set & operator&=( const bitmask_set & other )
+  {
+    for ( size_type i=0; i<W; i++ ) words_[i] &= other.words_[i];
+    return *this;
+  }
+
+  //! \brief Add all the values of another set.
+  bitmask_set & operator|=( const bitmask_set & other )
+  {
+    for ( size_type i=0; i<W; i++ ) words_[i] |= other.words_[i];
+    return *this;
+  }
+
+  //! \brief The values in both sets.
+  friend bitmask_set operator&( bitmask_set a, const bitmask_set & b )
+  { return a &= b; }
+
+  //! \brief The values in either set.
+  friend bitmask_set operator|( bitmask_set a, const bitmask_set & b )
+  { return a |= b; }
+
+  friend bool operator==( const bitmask_set & a, const bitmask_set & b )
+  { return a.words_ == b.words_; }
+
+  friend bool operator!=( const bitmask_set & a, const bitmask_set & b )
+  { return !( a == b ); }
+
+private:
+
+  //! \brief The bits, one per value.
+  std::array<word_t, W> words_ = {};
+
+};
+
+} // namespace
+} // namespace
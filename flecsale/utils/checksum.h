@@ -0,0 +1,203 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Parallel tree-hash checksums of arrays.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// user includes
+#include "flecsale/utils/errors.h"
+
+// system includes
+#ifdef HAVE_OPENSSL
+#  include <openssl/evp.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace flecsale {
+namespace utils {
+
+//! \brief The default number of values hashed by each leaf of the tree.
+static constexpr std::size_t checksum_leaf_size = 1 << 16;
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief A checksum, i.e. an md5 digest.
+////////////////////////////////////////////////////////////////////////////////
+struct checksum_t {
+
+  //! \brief The number of bytes in a digest.
+  static constexpr std::size_t size = 16;
+
+  //! \brief The raw digest.
+  std::array<unsigned char, size> value = {};
+
+  //! \brief Return the digest as a hex string.
+  std::string strvalue() const
+  {
+    char str[2*size+1];
+    for ( std::size_t i=0; i<size; i++ )
+      std::snprintf( str + 2*i, 3, "%02x", value[i] );
+    return str;
+  }
+
+  //! \brief Compare two checksums.
+  bool operator==( const checksum_t & other ) const
+  { return value == other.value; }
+
+  //! \copydoc operator==
+  bool operator!=( const checksum_t & other ) const
+  { return value != other.value; }
+
+};
+
+#ifdef HAVE_OPENSSL
+
+namespace detail {
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Incrementally hashes one leaf.
+////////////////////////////////////////////////////////////////////////////////
+class md5_t {
+public:
+
+  md5_t() : ctx_( EVP_MD_CTX_new() )
+  {
+    if ( !ctx_ || !EVP_DigestInit_ex( ctx_, EVP_md5(), nullptr ) )
+      raise_runtime_error( "Could not initialize md5" );
+  }
+
+  ~md5_t() { EVP_MD_CTX_free( ctx_ ); }
+
+  md5_t( const md5_t & ) = delete;
+  md5_t & operator=( const md5_t & ) = delete;
+
+  //! \brief Add some bytes to the digest.
+  void update( const void * data, std::size_t bytes )
+  { EVP_DigestUpdate( ctx_, data, bytes ); }
+
+  //! \brief Finish the digest.
+  void finish( checksum_t & cs )
+  { EVP_DigestFinal_ex( ctx_, cs.value.data(), nullptr ); }
+
+private:
+  EVP_MD_CTX * ctx_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Combine the leaf digests pairwise in a fixed tree.
+//!
+//! Each parent is the digest of its two children.  An odd node out is
+//! carried up unchanged, so a single leaf is its own root.
+////////////////////////////////////////////////////////////////////////////////
+inline checksum_t combine_leaves( std::vector<checksum_t> & leaves )
+{
+  auto num_leaves = leaves.size();
+  for ( std::size_t stride=1; stride<num_leaves; stride*=2 ) {
+    #pragma omp parallel for
+    for ( std::size_t b=0; b<num_leaves-stride; b+=2*stride ) {
+      md5_t md5;
+      md5.update( leaves[b].value.data(), checksum_t::size );
+      md5.update( leaves[b+stride].value.data(), checksum_t::size );
+      md5.finish( leaves[b] );
+    }
+  }
+  return leaves.front();
+}
+
+} // namespace detail
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Compute the tree-hash checksum of some values.
+//!
+//! The values are split into fixed-size leaves, which are hashed in
+//! parallel and then combined pairwise in a fixed tree.  Neither depends on
+//! the number of threads, so neither does the checksum.  Arrays that fit in
+//! one leaf get the plain md5 digest of their bytes.
+//!
+//! The values are staged through a small buffer on their way to the hash,
+//! so they can come from anywhere, e.g. one component of a vector field.
+//!
+//! \param [in] n  The number of values.
+//! \param [in] value_at  Called as value_at(i) to get value i.
+//! \param [in] leaf_size  The number of values per leaf.
+//! \return The checksum.
+//!
+//! \tparam T  The type of the values.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T, typename F >
+checksum_t tree_checksum(
+  std::size_t n, F && value_at, std::size_t leaf_size = checksum_leaf_size )
+{
+  constexpr std::size_t buffer_size = 512;
+
+  auto num_leaves = std::max<std::size_t>( ( n + leaf_size - 1 ) / leaf_size, 1 );
+  std::vector<checksum_t> leaves( num_leaves );
+
+  #pragma omp parallel for schedule(static)
+  for ( std::size_t b=0; b<num_leaves; b++ ) {
+    auto first = b * leaf_size;
+    auto last = std::min( first + leaf_size, n );
+    T buffer[buffer_size];
+    detail::md5_t md5;
+    for ( auto i=first; i<last; ) {
+      auto len = std::min( buffer_size, last - i );
+      for ( std::size_t j=0; j<len; j++ ) buffer[j] = value_at( i+j );
+      md5.update( buffer, len*sizeof(T) );
+      i += len;
+    }
+    md5.finish( leaves[b] );
+  }
+
+  return detail::combine_leaves( leaves );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Compute the tree-hash checksum of strided values in memory.
+//!
+//! Contiguous values are hashed straight from memory.
+//!
+//! \param [in] data  The first value.
+//! \param [in] n  The number of values.
+//! \param [in] stride  The distance between values.
+//! \param [in] leaf_size  The number of values per leaf.
+//! \return The checksum.
+//! \see tree_checksum
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+checksum_t tree_checksum(
+  const T * data, std::size_t n, std::size_t stride = 1,
+  std::size_t leaf_size = checksum_leaf_size )
+{
+  if ( stride != 1 )
+    return tree_checksum<T>(
+      n, [=]( std::size_t i ) { return data[i*stride]; }, leaf_size );
+
+  auto num_leaves = std::max<std::size_t>( ( n + leaf_size - 1 ) / leaf_size, 1 );
+  std::vector<checksum_t> leaves( num_leaves );
+
+  #pragma omp parallel for schedule(static)
+  for ( std::size_t b=0; b<num_leaves; b++ ) {
+    auto first = b * leaf_size;
+    auto last = std::min( first + leaf_size, n );
+    detail::md5_t md5;
+    if ( last > first ) md5.update( data + first, (last-first)*sizeof(T) );
+    md5.finish( leaves[b] );
+  }
+
+  return detail::combine_leaves( leaves );
+}
+
+#endif // HAVE_OPENSSL
+
+} // namespace
+} // namespace
@@ -0,0 +1,614 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief A compiler for simple math expressions, which are evaluated in
+///        batches of points.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// user includes
+#include "flecsale/utils/errors.h"
+
+// system includes
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <initializer_list>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace flecsale {
+namespace utils {
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief A pointer to values that are a fixed distance apart.
+//!
+//! A stride of zero broadcasts a single value.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+struct strided_ptr_t {
+
+  //! \brief The first value.
+  T * data = nullptr;
+  //! \brief The distance between values.
+  std::size_t stride = 1;
+
+  //! \brief Access value i.
+  T & operator[]( std::size_t i ) const { return data[i*stride]; }
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief A compiled math expression.
+//!
+//! The expression is a comma separated list of outputs, each of which
+//! may use the named variables and constants.  The syntax follows lua:
+//! - arithmetic with +, -, *, / and ^,
+//! - comparisons with <, <=, >, >=, == and ~=,
+//! - logic with and, or and not, where zero is false and any other value is
+//!   true; and/or return one of their operands like lua does, so
+//!   "x < 0 and 1 or 2" works as a conditional,
+//! - conditionals, e.g. "if x < 0 then 1 elseif x < 1 then 2 else 3 end",
+//! - the functions sqrt, pow, exp, log, abs, sin, cos, tan, min and max,
+//! - the constant pi.
+//!
+//! Expressions are compiled into register-based bytecode.  Constant
+//! subexpressions are folded and unused code is dropped.  Each instruction
+//! then operates on a whole batch of points, so the inner loops are short,
+//! branch free and vectorize.  Conditionals evaluate both branches and
+//! select between them per point.
+//!
+//! The compiled expression is immutable, so one object can be evaluated
+//! from many threads at once.
+//!
+//! \tparam T  The real type.
+//! \tparam W  The number of points in a batch.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T, std::size_t W = 8 >
+class compiled_expression {
+
+public:
+
+  //! \brief The real type.
+  using real_t = T;
+
+  //! \brief The number of points evaluated at a time.
+  static constexpr std::size_t batch_size = W;
+
+  //===========================================================================
+  //! \brief Compile an expression.
+  //! \param [in] str  The expression.
+  //! \param [in] variables  The names of the inputs, in order.
+  //! \param [in] constants  Any named constants.
+  //===========================================================================
+  compiled_expression(
+    const std::string & str,
+    const std::vector<std::string> & variables,
+    const std::map<std::string, real_t> & constants = {}
+  ) : str_(str), variables_(variables), constants_(constants)
+  {
+    num_registers_ = variables_.size();
+    next();
+    do {
+      outputs_.emplace_back( materialize( parse_expression() ) );
+    } while ( accept(",") );
+    if ( token_ != token_t::end )
+      error( "unexpected \"" + text_ + "\"" );
+    strip_dead_code();
+  }
+
+  //! \brief Return the number of inputs.
+  std::size_t num_inputs() const { return variables_.size(); }
+
+  //! \brief Return the number of outputs.
+  std::size_t num_outputs() const { return outputs_.size(); }
+
+  //! \brief Return the number of instructions.
+  std::size_t num_instructions() const { return code_.size(); }
+
+  //===========================================================================
+  //! \brief Evaluate the expression at some points.
+  //! \param [in] n  The number of points.
+  //! \param [in] inputs  One array per variable.
+  //! \param [out] outputs  One array per output.
+  //===========================================================================
+  void evaluate(
+    std::size_t n,
+    const strided_ptr_t<const real_t> * inputs,
+    const strided_ptr_t<real_t> * outputs ) const
+  {
+
+    // the registers start zeroed, so unused lanes hold harmless values
+    std::vector<real_t> regs( num_registers_*W, 0 );
+    for ( const auto & c : constant_registers_ )
+      std::fill_n( &regs[c.first*W], W, c.second );
+
+    for ( std::size_t first=0; first<n; first+=W ) {
+      auto len = std::min( W, n - first );
+
+      for ( std::size_t v=0; v<variables_.size(); v++ ) {
+        auto r = &regs[v*W];
+        for ( std::size_t l=0; l<len; l++ ) r[l] = inputs[v][first+l];
+      }
+
+      for ( const auto & ins : code_ ) execute( ins, regs.data() );
+
+      for ( std::size_t o=0; o<outputs_.size(); o++ ) {
+        auto r = &regs[outputs_[o]*W];
+        for ( std::size_t l=0; l<len; l++ ) outputs[o][first+l] = r[l];
+      }
+    }
+
+  }
+
+  //===========================================================================
+  //! \brief Evaluate the expression at a single point.
+  //! \param [in] point  The value of each variable.
+  //! \return The value of each output.
+  //===========================================================================
+  std::vector<real_t> operator()( const std::vector<real_t> & point ) const
+  {
+    if ( point.size() != variables_.size() )
+      raise_runtime_error(
+        "Expression needs " << variables_.size() << " inputs, got " <<
+        point.size()
+      );
+    std::vector<real_t> res( outputs_.size() );
+    std::vector< strided_ptr_t<const real_t> > in( point.size() );
+    std::vector< strided_ptr_t<real_t> > out( res.size() );
+    for ( std::size_t i=0; i<in.size(); i++ ) in[i].data = &point[i];
+    for ( std::size_t i=0; i<out.size(); i++ ) out[i].data = &res[i];
+    evaluate( 1, in.data(), out.data() );
+    return res;
+  }
+
+private:
+
+  //===========================================================================
+  // Bytecode
+  //===========================================================================
+
+  //! \brief The instructions.
+  enum class op_t {
+    add, sub, mul, div, pow, neg,
+    lt, le, gt, ge, eq, ne,
+    logical_not, select,
+    sqrt, exp, log, abs, sin, cos, tan, min, max
+  };
+
+  //! \brief An instruction, dst = op(a, b, c).
+  struct instruction_t {
+    op_t op;
+    std::size_t dst, a, b, c;
+  };
+
+  //! \brief A parsed value, either a known constant or a register.
+  struct value_t {
+    bool is_constant;
+    real_t constant;
+    std::size_t reg;
+  };
+
+  //! \brief Apply a unary function to every lane.
+  template< typename F >
+  static void lanewise( real_t * r, const real_t * a, F && f )
+  { for ( std::size_t l=0; l<W; l++ ) r[l] = f( a[l] ); }
+
+  //! \brief Apply a binary function to every lane.
+  template< typename F >
+  static void lanewise(
+    real_t * r, const real_t * a, const real_t * b, F && f )
+  { for ( std::size_t l=0; l<W; l++ ) r[l] = f( a[l], b[l] ); }
+
+  //! \brief Apply an operation to scalars.
+  static real_t apply( op_t op, real_t a, real_t b = 0, real_t c = 0 )
+  {
+    using std::abs;
+    switch ( op ) {
+    case op_t::add: return a + b;
+    case op_t::sub: return a - b;
+    case op_t::mul: return a * b;
+    case op_t::div: return a / b;
+    case op_t::pow: return std::pow( a, b );
+    case op_t::neg: return -a;
+    case op_t::lt: return a < b;
+    case op_t::le: return a <= b;
+    case op_t::gt: return a > b;
+    case op_t::ge: return a >= b;
+    case op_t::eq: return a == b;
+    case op_t::ne: return a != b;
+    case op_t::logical_not: return a == 0;
+    case op_t::select: return a != 0 ? b : c;
+    case op_t::sqrt: return std::sqrt( a );
+    case op_t::exp: return std::exp( a );
+    case op_t::log: return std::log( a );
+    case op_t::abs: return abs( a );
+    case op_t::sin: return std::sin( a );
+    case op_t::cos: return std::cos( a );
+    case op_t::tan: return std::tan( a );
+    case op_t::min: return std::min( a, b );
+    case op_t::max: return std::max( a, b );
+    }
+    return 0;
+  }
+
+  //! \brief Execute one instruction on a batch.
+  static void execute( const instruction_t & ins, real_t * regs )
+  {
+    auto r = regs + ins.dst*W;
+    auto a = regs + ins.a*W;
+    auto b = regs + ins.b*W;
+    auto c = regs + ins.c*W;
+
+    // the common operations get their own loops so that they vectorize
+    switch ( ins.op ) {
+    case op_t::add:
+      lanewise( r, a, b, []( real_t x, real_t y ) { return x + y; } ); break;
+    case op_t::sub:
+      lanewise( r, a, b, []( real_t x, real_t y ) { return x - y; } ); break;
+    case op_t::mul:
+      lanewise( r, a, b, []( real_t x, real_t y ) { return x * y; } ); break;
+    case op_t::div:
+      lanewise( r, a, b, []( real_t x, real_t y ) { return x / y; } ); break;
+    case op_t::neg:
+      lanewise( r, a, []( real_t x ) { return -x; } ); break;
+    case op_t::lt:
+      lanewise( r, a, b, []( real_t x, real_t y ) { return real_t(x < y); } );
+      break;
+    case op_t::le:
+      lanewise( r, a, b, []( real_t x, real_t y ) { return real_t(x <= y); } );
+      break;
+    case op_t::gt:
+      lanewise( r, a, b, []( real_t x, real_t y ) { return real_t(x > y); } );
+      break;
+    case op_t::ge:
+      lanewise( r, a, b, []( real_t x, real_t y ) { return real_t(x >= y); } );
+      break;
+    case op_t::sqrt:
+      lanewise( r, a, []( real_t x ) { return std::sqrt(x); } ); break;
+    case op_t::min:
+      lanewise( r, a, b, []( real_t x, real_t y ) { return std::min(x, y); } );
+      break;
+    case op_t::max:
+      lanewise( r, a, b, []( real_t x, real_t y ) { return std::max(x, y); } );
+      break;
+    case op_t::select:
+      for ( std::size_t l=0; l<W; l++ ) r[l] = a[l] != 0 ? b[l] : c[l];
+      break;
+    default:
+      for ( std::size_t l=0; l<W; l++ )
+        r[l] = apply( ins.op, a[l], b[l], c[l] );
+    }
+  }
+
+  //! \brief Make sure a value lives in a register.
+  std::size_t materialize( const value_t & v )
+  {
+    if ( !v.is_constant ) return v.reg;
+    constant_registers_.emplace_back( num_registers_, v.constant );
+    return num_registers_++;
+  }
+
+  //! \brief Emit an instruction, folding it if all its operands are known.
+  value_t emit( op_t op, std::initializer_list<value_t> args )
+  {
+    auto known = std::all_of( args.begin(), args.end(),
+      []( const value_t & v ) { return v.is_constant; } );
+    real_t c[3] = {0, 0, 0};
+    std::size_t regs[3] = {0, 0, 0};
+    std::size_t i = 0;
+    for ( const auto & v : args ) c[i++] = v.constant;
+
+    if ( known ) return { true, apply( op, c[0], c[1], c[2] ), 0 };
+
+    // a known condition picks its branch
+    auto a = args.begin();
+    if ( op == op_t::select && a->is_constant )
+      return a->constant != 0 ? a[1] : a[2];
+
+    // unused operands just repeat the first one
+    i = 0;
+    for ( const auto & v : args ) regs[i++] = materialize( v );
+    for ( ; i<3; i++ ) regs[i] = regs[0];
+
+    instruction_t ins{ op, num_registers_++, regs[0], regs[1], regs[2] };
+    code_.emplace_back( ins );
+    return { false, 0, ins.dst };
+  }
+
+  //! \brief Drop the instructions that no output depends on.
+  void strip_dead_code()
+  {
+    std::vector<bool> live( num_registers_, false );
+    for ( auto r : outputs_ ) live[r] = true;
+    std::vector<instruction_t> code;
+    for ( auto it = code_.rbegin(); it != code_.rend(); ++it ) {
+      if ( !live[it->dst] ) continue;
+      live[it->a] = live[it->b] = live[it->c] = true;
+      code.emplace_back( *it );
+    }
+    code_.assign( code.rbegin(), code.rend() );
+  }
+
+  //===========================================================================
+  // Parsing
+  //===========================================================================
+
+  //! \brief The token types.
+  enum class token_t { number, name, symbol, end };
+
+  //! \brief Raise an error at the current position.
+  [[noreturn]] void error( const std::string & msg ) const
+  {
+    if ( token_ == token_t::end && msg.compare( 0, 10, "unexpected" ) == 0 )
+      raise_runtime_error(
+        "Error parsing expression \"" << str_ << "\": unexpected end"
+      );
+    raise_runtime_error(
+      "Error parsing expression \"" << str_ << "\" at position " <<
+      start_ << ": " << msg
+    );
+  }
+
+  //! \brief Read the next token.
+  void next()
+  {
+    while ( pos_ < str_.size() && std::isspace( str_[pos_] ) ) pos_++;
+    start_ = pos_;
+    if ( pos_ == str_.size() ) {
+      token_ = token_t::end;
+      text_.clear();
+      return;
+    }
+
+    auto ch = str_[pos_];
+
+    if ( std::isdigit(ch) || ( ch == '.' && pos_+1 < str_.size() &&
+           std::isdigit( str_[pos_+1] ) ) )
+    {
+      char * end;
+      number_ = std::strtod( str_.c_str() + pos_, &end );
+      pos_ = end - str_.c_str();
+      token_ = token_t::number;
+    }
+    else if ( std::isalpha(ch) || ch == '_' ) {
+      while ( pos_ < str_.size() &&
+              ( std::isalnum( str_[pos_] ) || str_[pos_] == '_' ) )
+        pos_++;
+      token_ = token_t::name;
+    }
+    else {
+      static const char * two_char[] = { "<=", ">=", "==", "~=", "!=" };
+      token_ = token_t::symbol;
+      pos_++;
+      for ( auto s : two_char )
+        if ( str_.compare( start_, 2, s ) == 0 ) { pos_++; break; }
+    }
+
+    text_ = str_.substr( start_, pos_ - start_ );
+  }
+
+  //! \brief Consume the current token if it matches.
+  bool accept( const char * text )
+  {
+    if ( token_ == token_t::end || token_ == token_t::number || text_ != text )
+      return false;
+    next();
+    return true;
+  }
+
+  //! \brief Consume the current token, which must match.
+  void expect( const char * text )
+  {
+    if ( !accept( text ) )
+      error(
+        std::string("expected \"") + text + "\", found \"" + text_ + "\""
+      );
+  }
+
+  //! \brief expression := and_expression { "or" and_expression }
+  //!
+  //! As in lua, "a or b" is a if it is nonzero and b otherwise.
+  value_t parse_expression()
+  {
+    auto v = parse_and();
+    while ( accept("or") ) {
+      auto w = parse_and();
+      v = emit( op_t::select, { v, v, w } );
+    }
+    return v;
+  }
+
+  //! \brief and_expression := comparison { "and" comparison }
+  //!
+  //! As in lua, "a and b" is b if a is nonzero and a otherwise.
+  value_t parse_and()
+  {
+    auto v = parse_comparison();
+    while ( accept("and") ) {
+      auto w = parse_comparison();
+      v = emit( op_t::select, { v, w, v } );
+    }
+    return v;
+  }
+
+  //! \brief comparison := sum [ ( "<" | "<=" | ... ) sum ]
+  value_t parse_comparison()
+  {
+    static const std::pair<const char *, op_t> ops[] = {
+      {"<", op_t::lt}, {"<=", op_t::le}, {">", op_t::gt}, {">=", op_t::ge},
+      {"==", op_t::eq}, {"~=", op_t::ne}, {"!=", op_t::ne}
+    };
+    auto v = parse_sum();
+    for ( const auto & op : ops )
+      if ( accept( op.first ) ) return emit( op.second, { v, parse_sum() } );
+    return v;
+  }
+
+  //! \brief sum := product { ( "+" | "-" ) product }
+  value_t parse_sum()
+  {
+    auto v = parse_product();
+    while ( true ) {
+      if ( accept("+") ) v = emit( op_t::add, { v, parse_product() } );
+      else if ( accept("-") ) v = emit( op_t::sub, { v, parse_product() } );
+      else return v;
+    }
+  }
+
+  //! \brief product := unary { ( "*" | "/" ) unary }
+  value_t parse_product()
+  {
+    auto v = parse_unary();
+    while ( true ) {
+      if ( accept("*") ) v = emit( op_t::mul, { v, parse_unary() } );
+      else if ( accept("/") ) v = emit( op_t::div, { v, parse_unary() } );
+      else return v;
+    }
+  }
+
+  //! \brief unary := ( "-" | "+" | "not" ) unary | power
+  value_t parse_unary()
+  {
+    if ( accept("-") ) return emit( op_t::neg, { parse_unary() } );
+    if ( accept("+") ) return parse_unary();
+    if ( accept("not") ) return emit( op_t::logical_not, { parse_unary() } );
+    return parse_power();
+  }
+
+  //! \brief power := primary [ "^" unary ], which is right associative and
+  //!        binds tighter than a leading minus, as in lua.
+  value_t parse_power()
+  {
+    auto v = parse_primary();
+    if ( accept("^") ) return emit( op_t::pow, { v, parse_unary() } );
+    return v;
+  }
+
+  //! \brief primary := number | name | function call | "(" expression ")"
+  //!        | "if" expression "then" expression
+  //!          { "elseif" expression "then" expression }
+  //!          "else" expression "end"
+  value_t parse_primary()
+  {
+    if ( token_ == token_t::number ) {
+      auto v = number_;
+      next();
+      return { true, v, 0 };
+    }
+
+    if ( accept("(") ) {
+      auto v = parse_expression();
+      expect(")");
+      return v;
+    }
+
+    if ( accept("if") ) return parse_if();
+
+    if ( token_ != token_t::name )
+      error( "unexpected \"" + text_ + "\"" );
+
+    auto name = text_;
+    next();
+
+    if ( accept("(") ) return parse_call( name );
+
+    auto var = std::find( variables_.begin(), variables_.end(), name );
+    if ( var != variables_.end() )
+      return { false, 0,
+        static_cast<std::size_t>( std::distance( variables_.begin(), var ) ) };
+
+    auto c = constants_.find( name );
+    if ( c != constants_.end() ) return { true, c->second, 0 };
+
+    if ( name == "pi" ) return { true, std::acos( real_t(-1) ), 0 };
+
+    error( "unknown name \"" + name + "\"" );
+  }
+
+  //! \brief Parse the rest of a conditional, after the "if".
+  value_t parse_if()
+  {
+    auto cond = parse_expression();
+    expect("then");
+    auto yes = parse_expression();
+    value_t no;
+    if ( accept("elseif") )
+      no = parse_if();
+    else {
+      expect("else");
+      no = parse_expression();
+      expect("end");
+    }
+    return emit( op_t::select, { cond, yes, no } );
+  }
+
+  //! \brief Parse the arguments of a function call, after the "(".
+  value_t parse_call( const std::string & name )
+  {
+    static const std::map< std::string, std::pair<op_t, int> > functions = {
+      {"sqrt", {op_t::sqrt, 1}}, {"exp", {op_t::exp, 1}},
+      {"log", {op_t::log, 1}}, {"abs", {op_t::abs, 1}},
+      {"sin", {op_t::sin, 1}}, {"cos", {op_t::cos, 1}},
+      {"tan", {op_t::tan, 1}}, {"pow", {op_t::pow, 2}},
+      {"min", {op_t::min, 2}}, {"max", {op_t::max, 2}}
+    };
+
+    auto f = functions.find( name );
+    if ( f == functions.end() )
+      error( "unknown function \"" + name + "\"" );
+
+    std::vector<value_t> args;
+    if ( !accept(")") ) {
+      do { args.emplace_back( parse_expression() ); } while ( accept(",") );
+      expect(")");
+    }
+
+    auto arity = f->second.second;
+    if ( args.size() != static_cast<std::size_t>( arity ) )
+      error(
+        "\"" + name + "\" takes " + std::to_string( arity ) +
+        " arguments, got " + std::to_string( args.size() )
+      );
+
+    if ( arity == 1 ) return emit( f->second.first, { args[0] } );
+    return emit( f->second.first, { args[0], args[1] } );
+  }
+
+  //===========================================================================
+  // Private data
+  //===========================================================================
+
+  //! \brief The expression.
+  std::string str_;
+  //! \brief The variable names, which are the first registers.
+  std::vector<std::string> variables_;
+  //! \brief The named constants.
+  std::map<std::string, real_t> constants_;
+
+  //! \brief The parser state.
+  std::size_t pos_ = 0, start_ = 0;
+  token_t token_ = token_t::end;
+  std::string text_;
+  real_t number_ = 0;
+
+  //! \brief The bytecode.
+  std::vector<instruction_t> code_;
+  //! \brief The registers holding constants, and their values.
+  std::vector< std::pair<std::size_t, real_t> > constant_registers_;
+  //! \brief The register holding each output.
+  std::vector<std::size_t> outputs_;
+  //! \brief The total number of registers.
+  std::size_t num_registers_ = 0;
+
+};
+
+} // namespace
+} // namespace
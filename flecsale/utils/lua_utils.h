@@ -28,8 +28,10 @@ extern "C" {
 #include <iomanip>
 #include <memory>
 #include <sstream>
+#include <string>
 #include <tuple>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace flecsale {
@@ -278,6 +280,20 @@ inline void lua_push(lua_State * s, const char * str)
 /// \param [in] str  The string to push.
 inline void lua_push(lua_State * s, const std::string & str) 
 { lua_pushlstring( s, str.c_str(), str.size() ); }
+
+/// \brief Push a vector of values as a table.
+/// \param [in] s  The lua state to push a value to.
+/// \param [in] vec  The vector to push.
+template< typename T, typename Allocator >
+void lua_push(lua_State * s, const std::vector<T,Allocator> & vec)
+{ 
+  lua_createtable( s, vec.size(), 0 );
+  for ( std::size_t i=0; i<vec.size(); ++i ) {
+    lua_push( s, vec[i] );
+    lua_rawseti( s, -2, i+1 );
+  }
+}
+
 /// \}
   
 ////////////////////////////////////////////////////////////////////////////////
@@ -427,6 +443,12 @@ public:
     return (*ref_ == LUA_REFNIL || *ref_ == LUA_NOREF);
   }
 
+  /// \brief Return the lua type id of the referenced value.
+  int type() const
+  {
+    return type_;
+  }
+
 };
 
 /// \brief Create a lua reference to the last value on the stack.
@@ -435,10 +457,15 @@ public:
 inline lua_ref_t make_lua_ref(const lua_state_ptr_t & state)
 {
   auto s = state.get();
-  return { state, luaL_ref(s, LUA_REGISTRYINDEX), lua_type(s, -1) };
+  // get the type before luaL_ref pops the value
+  auto type = lua_type(s, -1);
+  return { state, luaL_ref(s, LUA_REGISTRYINDEX), type };
 }
 
 
+// forward declarations
+class lua_function_t;
+
 ////////////////////////////////////////////////////////////////////////////////
 /// \brief This class stores a reference to a lua value.
 /// The class is used to convert the refered lua value to a desired type.  It is
@@ -446,6 +473,9 @@ inline lua_ref_t make_lua_ref(const lua_state_ptr_t & state)
 ////////////////////////////////////////////////////////////////////////////////
 class lua_result_t : public lua_base_t {
 
+  /// \brief The fast call path needs the raw reference.
+  friend class lua_function_t;
+
   /// \brief The name of the object.
   std::string name_;
   /// \brief A reference to the lua value in the LUA_REGISTRYINDEX table.
@@ -620,6 +650,33 @@ public:
     return name_;
   }
 
+  /// \brief Return the lua type id of the object, e.g. LUA_TSTRING.
+  int type() const
+  {
+    return refs_.back().type();
+  }
+
+  /// \brief Return the string keys of a table.
+  std::vector<std::string> keys() const
+  {
+    auto s = state();
+    // push the table onto the stack
+    push_last();
+    check_table(name_);
+    // walk the table, lua_next pops the key and pushes the next key/value
+    std::vector<std::string> res;
+    check_stack(2);
+    lua_pushnil(s);
+    while ( lua_next(s, -2) ) {
+      if ( lua_type(s, -2) == LUA_TSTRING )
+        res.emplace_back( lua_tostring(s, -2) );
+      lua_pop(s, 1);
+    }
+    // pop the table
+    lua_pop(s, 1);
+    return res;
+  }
+
   /// \brief Return the size of the table.
   std::size_t size() const
   {
@@ -771,6 +828,95 @@ public:
 
 };
 
+////////////////////////////////////////////////////////////////////////////////
+/// \brief A lua function that can be called many times with little overhead.
+///
+/// The function is resolved once, into a registry reference.  Each call
+/// pushes the function and its arguments and pops the results straight into
+/// a caller-provided tuple.  Unlike lua_result_t::operator(), no names are
+/// built, no references are created and nothing is allocated per call, so
+/// this is the path to use for per-cell or per-face callbacks.
+////////////////////////////////////////////////////////////////////////////////
+class lua_function_t {
+
+  /// \brief The raw state pointer.  The reference keeps the state alive.
+  lua_State * state_;
+  /// \brief A reference to the function in the LUA_REGISTRYINDEX table.
+  lua_ref_t ref_;
+  /// \brief The name of the function, for error messages.
+  std::string name_;
+
+  /// \brief Pop one result off the top of the stack.
+  /// \tparam J  The tuple index to store the result in.
+  template< std::size_t J, typename Tup >
+  void pop_result( Tup & tup ) const
+  {
+    using type_t = std::decay_t< std::tuple_element_t<J, std::decay_t<Tup>> >;
+    std::get<J>(tup) = lua_value<type_t>::get( state_ );
+  }
+
+  /// \brief Pop all the results.  The last result is on top of the stack, 
+  ///        so they are popped in reverse.
+  template< typename Tup, std::size_t...I >
+  void pop_results( Tup & tup, std::index_sequence<I...> ) const
+  {
+    constexpr auto N = sizeof...(I);
+    // braced initializers are evaluated in order
+    int dummy[] = { 0, ( pop_result< N-1-I >( tup ), 0 )... };
+    (void)dummy;
+  }
+
+public:
+
+  /// \brief Resolve a function.
+  /// \param [in] func  The function to resolve.
+  lua_function_t( const lua_result_t & func ) 
+    : state_( func.state() ), ref_( func.refs_.back() ), name_( func.name() )
+  {
+    func.push_last();
+    func.check_function( name_ );
+    lua_pop( state_, 1 );
+  }
+
+  /// \brief Call the function, storing the results in a tuple.
+  /// \param [out] results  The tuple to store the results in, e.g. the
+  ///                       result of std::tie.
+  /// \param [in] args  The function arguments.
+  template< typename Tup, typename...Args >
+  void call_into( Tup && results, Args&&...args ) const
+  {
+    constexpr auto N = std::tuple_size< std::decay_t<Tup> >::value;
+    auto s = state_;
+    auto top = lua_gettop(s);
+    if ( !lua_checkstack( s, sizeof...(Args) + std::max<int>(N, 1) ) )
+      raise_runtime_error( "Cannot grow stack calling \"" << name_ << "\"." );
+    // push the function and its arguments
+    ref_.push();
+    int dummy[] = { 0, ( lua_push( s, std::forward<Args>(args) ), 0 )... };
+    (void)dummy;
+    // call it, asking for exactly as many results as we want
+    if ( lua_pcall(s, sizeof...(Args), N, 0) ) {
+      std::string msg = lua_tostring(s, -1);
+      lua_settop(s, top);
+      raise_runtime_error( "Problem calling \"" << name_ << "\": " << msg );
+    }
+    pop_results( results, std::make_index_sequence<N>{} );
+  }
+
+  /// \brief Call the function and return a single result.
+  /// \tparam T  The result type.
+  /// \param [in] args  The function arguments.
+  /// \return The result.
+  template< typename T, typename...Args >
+  T call( Args&&...args ) const
+  {
+    std::tuple<T> res;
+    call_into( res, std::forward<Args>(args)... );
+    return std::move( std::get<0>(res) );
+  }
+
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 /// \brief The top level object for the lua interface.
 /// This is the object the user will instantiate.
@@ -0,0 +1,48 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Some functions for querying memory usage.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+//! system includes
+#include <cstddef>
+
+#if !defined( _WIN32 )
+#include <sys/resource.h>
+#endif
+
+namespace flecsale {
+namespace utils {
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Return the peak resident memory of this process.
+//! \return The memory in bytes, or zero if it is unknown.
+////////////////////////////////////////////////////////////////////////////////
+inline std::size_t get_peak_memory()
+{
+#if defined( _WIN32 )
+
+  return 0;
+
+#else
+
+  struct rusage usage;
+  if ( getrusage( RUSAGE_SELF, &usage ) ) return 0;
+#if defined( __APPLE__ )
+  // already in bytes
+  return usage.ru_maxrss;
+#else
+  // in kilobytes
+  return static_cast<std::size_t>( usage.ru_maxrss ) * 1024;
+#endif
+
+#endif
+}
+
+} // namespace
+} // namespace
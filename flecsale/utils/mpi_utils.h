@@ -0,0 +1,261 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Some thin wrappers around the MPI functionality we use.
+///
+/// Everything here falls back to a single rank when flecsale is built
+/// without MPI, or when MPI was never initialized.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// user includes
+#include "flecsale/utils/errors.h"
+
+// system includes
+#ifdef HAVE_MPI
+#include <mpi.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace flecsale {
+namespace utils {
+
+#ifdef HAVE_MPI
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Map a C++ type to its MPI datatype.
+//! \tparam T  The type to map.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+struct mpi_type;
+
+//! \brief Specializations for the types we reduce over.
+//! @{
+template<> struct mpi_type<char>
+{ static MPI_Datatype value() { return MPI_CHAR; } };
+template<> struct mpi_type<unsigned char>
+{ static MPI_Datatype value() { return MPI_UNSIGNED_CHAR; } };
+template<> struct mpi_type<int>
+{ static MPI_Datatype value() { return MPI_INT; } };
+template<> struct mpi_type<unsigned>
+{ static MPI_Datatype value() { return MPI_UNSIGNED; } };
+template<> struct mpi_type<long>
+{ static MPI_Datatype value() { return MPI_LONG; } };
+template<> struct mpi_type<unsigned long>
+{ static MPI_Datatype value() { return MPI_UNSIGNED_LONG; } };
+template<> struct mpi_type<long long>
+{ static MPI_Datatype value() { return MPI_LONG_LONG; } };
+template<> struct mpi_type<unsigned long long>
+{ static MPI_Datatype value() { return MPI_UNSIGNED_LONG_LONG; } };
+template<> struct mpi_type<float>
+{ static MPI_Datatype value() { return MPI_FLOAT; } };
+template<> struct mpi_type<double>
+{ static MPI_Datatype value() { return MPI_DOUBLE; } };
+//! @}
+
+//! \brief The tag used for point-to-point messages.
+static constexpr int mpi_tag = 4242;
+
+#endif // HAVE_MPI
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Return true if MPI is available and has been initialized.
+////////////////////////////////////////////////////////////////////////////////
+inline bool mpi_is_active()
+{
+#ifdef HAVE_MPI
+  int initialized = 0, finalized = 0;
+  MPI_Initialized( &initialized );
+  MPI_Finalized( &finalized );
+  return initialized && !finalized;
+#else
+  return false;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Return the rank of this process.
+////////////////////////////////////////////////////////////////////////////////
+inline int comm_rank()
+{
+  int rank = 0;
+#ifdef HAVE_MPI
+  if ( mpi_is_active() ) MPI_Comm_rank( MPI_COMM_WORLD, &rank );
+#endif
+  return rank;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Return the number of processes.
+////////////////////////////////////////////////////////////////////////////////
+inline int comm_size()
+{
+  int size = 1;
+#ifdef HAVE_MPI
+  if ( mpi_is_active() ) MPI_Comm_size( MPI_COMM_WORLD, &size );
+#endif
+  return size;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Sum an array of values over all processes, in place.
+//! \param [in,out] values  The values to sum.
+//! \param [in] n  The number of values.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+void global_sum( T * values, std::size_t n )
+{
+#ifdef HAVE_MPI
+  if ( comm_size() < 2 ) return;
+  MPI_Allreduce(
+    MPI_IN_PLACE, values, static_cast<int>(n), mpi_type<T>::value(),
+    MPI_SUM, MPI_COMM_WORLD
+  );
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Find the maximum of an array of values over all processes, in
+//!        place.
+//! \param [in,out] values  The values to compare.
+//! \param [in] n  The number of values.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+void global_max( T * values, std::size_t n )
+{
+#ifdef HAVE_MPI
+  if ( comm_size() < 2 ) return;
+  MPI_Allreduce(
+    MPI_IN_PLACE, values, static_cast<int>(n), mpi_type<T>::value(),
+    MPI_MAX, MPI_COMM_WORLD
+  );
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Sum a single value over all processes.
+//! \param [in] value  The local value.
+//! \return The global sum.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+T global_sum( T value )
+{
+  global_sum( &value, 1 );
+  return value;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Find the maximum of a single value over all processes.
+//! \param [in] value  The local value.
+//! \return The global maximum.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+T global_max( T value )
+{
+  global_max( &value, 1 );
+  return value;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Send a list of values to another process.
+//!
+//! Messages between two processes arrive in the order they were sent, so a
+//! sequence of lists can be matched up with the same sequence of
+//! recv_list() calls.
+//!
+//! \param [in] values  The values to send.
+//! \param [in] dest  The process to send them to.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+void send_list( const std::vector<T> & values, int dest )
+{
+#ifdef HAVE_MPI
+  if ( values.size() > static_cast<std::size_t>( std::numeric_limits<int>::max() ) )
+    raise_runtime_error( "Too many values to send in one message" );
+  MPI_Send(
+    values.data(), static_cast<int>(values.size()), mpi_type<T>::value(),
+    dest, mpi_tag, MPI_COMM_WORLD
+  );
+#else
+  (void)values; (void)dest;
+  raise_runtime_error( "Sending data to another process needs MPI" );
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Receive a list of values sent with send_list().
+//! \param [out] values  The values, resized to fit.
+//! \param [in] source  The process that sent them.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+void recv_list( std::vector<T> & values, int source )
+{
+#ifdef HAVE_MPI
+  MPI_Status status;
+  MPI_Probe( source, mpi_tag, MPI_COMM_WORLD, &status );
+  int count = 0;
+  MPI_Get_count( &status, mpi_type<T>::value(), &count );
+  values.resize( count );
+  MPI_Recv(
+    values.data(), count, mpi_type<T>::value(), source, mpi_tag,
+    MPI_COMM_WORLD, MPI_STATUS_IGNORE
+  );
+#else
+  (void)values; (void)source;
+  raise_runtime_error( "Receiving data from another process needs MPI" );
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Makes sure MPI is initialized for the lifetime of this object.
+//!
+//! If the runtime already initialized MPI, this does nothing.  Otherwise MPI
+//! is initialized here, and finalized again when the object is destroyed.
+////////////////////////////////////////////////////////////////////////////////
+class mpi_session_t {
+public:
+
+  //! \brief Constructor.
+  //! \param [in] argc,argv  The command line arguments.
+  mpi_session_t( int & argc, char ** & argv )
+  {
+#ifdef HAVE_MPI
+    int initialized = 0;
+    MPI_Initialized( &initialized );
+    if ( !initialized ) {
+      int provided;
+      MPI_Init_thread( &argc, &argv, MPI_THREAD_FUNNELED, &provided );
+      owner_ = true;
+    }
+#endif
+  }
+
+  //! \brief Destructor.
+  ~mpi_session_t()
+  {
+#ifdef HAVE_MPI
+    if ( owner_ ) MPI_Finalize();
+#endif
+  }
+
+  //! \brief Sessions can't be copied.
+  mpi_session_t( const mpi_session_t & ) = delete;
+  mpi_session_t & operator=( const mpi_session_t & ) = delete;
+
+private:
+
+  //! \brief True if this object initialized MPI.
+  bool owner_ = false;
+
+};
+
+} // namespace
+} // namespace
@@ -0,0 +1,191 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Parallel radix sorting and scans.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// system includes
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace flecsale {
+namespace utils {
+
+//! \brief The number of elements each thread works on at a time.
+static constexpr std::size_t parallel_block_size = 1 << 14;
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Turn a list of counts into offsets, in parallel.
+//!
+//! On entry, entry i+1 holds the count for item i.  On exit, entry i holds
+//! the offset of item i, and the last entry the total.
+//!
+//! \param [in,out] offsets  The counts to scan, with a leading zero.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+void counts_to_offsets( std::vector<T> & offsets )
+{
+  if ( offsets.empty() ) return;
+  offsets[0] = 0;
+
+  auto n = offsets.size() - 1;
+  auto num_blocks = ( n + parallel_block_size - 1 ) / parallel_block_size;
+  std::vector<T> block_offsets( num_blocks+1, 0 );
+
+  #pragma omp parallel for
+  for ( std::size_t b=0; b<num_blocks; b++ ) {
+    auto first = b * parallel_block_size;
+    auto last = std::min( first + parallel_block_size, n );
+    T sum = 0;
+    for ( auto i=first; i<last; i++ ) sum += offsets[i+1];
+    block_offsets[b+1] = sum;
+  }
+
+  std::partial_sum(
+    block_offsets.begin(), block_offsets.end(), block_offsets.begin() );
+
+  #pragma omp parallel for
+  for ( std::size_t b=0; b<num_blocks; b++ ) {
+    auto first = b * parallel_block_size;
+    auto last = std::min( first + parallel_block_size, n );
+    auto sum = block_offsets[b];
+    for ( auto i=first; i<last; i++ ) {
+      sum += offsets[i+1];
+      offsets[i+1] = sum;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Find the indices that satisfy a predicate, in parallel.
+//! \tparam T  The type to store the selected indices as.
+//! \param [in] n  The number of indices to test.
+//! \param [in] pred  Called as pred(i) for each index.
+//! \return The selected indices, in increasing order.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T = std::size_t, typename P >
+std::vector<T> select_indices( std::size_t n, P && pred )
+{
+  auto num_blocks = ( n + parallel_block_size - 1 ) / parallel_block_size;
+  std::vector<std::size_t> block_offsets( num_blocks+1, 0 );
+
+  #pragma omp parallel for
+  for ( std::size_t b=0; b<num_blocks; b++ ) {
+    auto first = b * parallel_block_size;
+    auto last = std::min( first + parallel_block_size, n );
+    std::size_t cnt = 0;
+    for ( auto i=first; i<last; i++ ) if ( pred(i) ) cnt++;
+    block_offsets[b+1] = cnt;
+  }
+
+  std::partial_sum(
+    block_offsets.begin(), block_offsets.end(), block_offsets.begin() );
+
+  std::vector<T> selected( block_offsets.back() );
+
+  #pragma omp parallel for
+  for ( std::size_t b=0; b<num_blocks; b++ ) {
+    auto first = b * parallel_block_size;
+    auto last = std::min( first + parallel_block_size, n );
+    auto pos = block_offsets[b];
+    for ( auto i=first; i<last; i++ ) if ( pred(i) ) selected[pos++] = i;
+  }
+
+  return selected;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Stably sort values by unsigned integer keys.
+//!
+//! This is a least-significant-digit radix sort, eight bits at a time.  Each
+//! pass histograms and scatters fixed-size blocks in parallel, so the result
+//! does not depend on the number of threads.  Passes above the largest key,
+//! or where every key has the same digit, are skipped.
+//!
+//! \param [in,out] keys  The keys to sort.
+//! \param [in,out] values  The values to sort along with the keys.
+////////////////////////////////////////////////////////////////////////////////
+template< typename K, typename V >
+void radix_sort_by_key( std::vector<K> & keys, std::vector<V> & values )
+{
+  static_assert( std::is_unsigned<K>::value, "radix sort needs unsigned keys" );
+
+  constexpr std::size_t radix_bits = 8;
+  constexpr std::size_t radix = 1 << radix_bits;
+  constexpr std::size_t num_passes = 8 * sizeof(K) / radix_bits;
+
+  auto n = keys.size();
+  if ( n < 2 ) return;
+
+  K max_key = 0;
+  #pragma omp parallel for reduction(max:max_key)
+  for ( std::size_t i=0; i<n; i++ ) max_key = std::max( max_key, keys[i] );
+
+  auto num_blocks = ( n + parallel_block_size - 1 ) / parallel_block_size;
+  std::vector<std::size_t> offsets( num_blocks * radix );
+
+  std::vector<K> keys_tmp( n );
+  std::vector<V> values_tmp( n );
+
+  for ( std::size_t pass=0; pass<num_passes; pass++ ) {
+
+    auto shift = pass * radix_bits;
+    if ( ( max_key >> shift ) == 0 ) break;
+
+    // count the digits in each block
+    std::fill( offsets.begin(), offsets.end(), 0 );
+    #pragma omp parallel for
+    for ( std::size_t b=0; b<num_blocks; b++ ) {
+      auto first = b * parallel_block_size;
+      auto last = std::min( first + parallel_block_size, n );
+      auto counts = offsets.data() + b*radix;
+      for ( auto i=first; i<last; i++ ) counts[ (keys[i] >> shift) & (radix-1) ]++;
+    }
+
+    // each digit's blocks are placed one after the other
+    std::size_t sum = 0;
+    bool one_digit = false;
+    for ( std::size_t d=0; d<radix && !one_digit; d++ ) {
+      std::size_t digit_count = 0;
+      for ( std::size_t b=0; b<num_blocks; b++ ) {
+        auto & off = offsets[ b*radix + d ];
+        auto cnt = off;
+        off = sum;
+        sum += cnt;
+        digit_count += cnt;
+      }
+      one_digit = ( digit_count == n );
+    }
+    if ( one_digit ) continue;
+
+    // scatter
+    #pragma omp parallel for
+    for ( std::size_t b=0; b<num_blocks; b++ ) {
+      auto first = b * parallel_block_size;
+      auto last = std::min( first + parallel_block_size, n );
+      auto pos = offsets.data() + b*radix;
+      for ( auto i=first; i<last; i++ ) {
+        auto j = pos[ (keys[i] >> shift) & (radix-1) ]++;
+        keys_tmp[j] = keys[i];
+        values_tmp[j] = std::move( values[i] );
+      }
+    }
+
+    std::swap( keys, keys_tmp );
+    std::swap( values, values_tmp );
+
+  } // passes
+
+}
+
+} // namespace
+} // namespace
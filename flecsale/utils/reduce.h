@@ -0,0 +1,114 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Reproducible parallel reductions.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// system includes
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace flecsale {
+namespace utils {
+
+//! \brief The default number of items each block of a reduction handles.
+static constexpr std::size_t reduction_block_size = 1024;
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief A parallel reduction whose result does not depend on the number of
+//!        threads.
+//!
+//! The range [0,n) is split into fixed-size blocks.  Each block is
+//! accumulated serially, in order, and the partial results are then combined
+//! pairwise in a fixed tree.  Since neither the blocking nor the combination
+//! order depend on how many threads there are, the result is bitwise
+//! identical for any thread count.  The pairwise combination also keeps the
+//! round-off growth logarithmic in the number of blocks.
+//!
+//! \param [in] n  The number of items to reduce.
+//! \param [in] init  The identity value of the reduction.
+//! \param [in] body  Called as body(i, acc) to accumulate item i into acc.
+//! \param [in] op  Called as op(a, b) to combine two partial results.
+//! \param [in] block_size  The number of items per block.
+//! \return The reduced value.
+//!
+//! \tparam T  The type of the reduced value.
+//! \tparam U  The counter type.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T, typename U, typename Body, typename Op >
+T deterministic_reduce(
+  U n, const T & init, Body && body, Op && op,
+  std::size_t block_size = reduction_block_size )
+{
+
+  if ( n < 1 ) return init;
+
+  auto bs = static_cast<U>( block_size );
+  auto num_blocks = ( n + bs - 1 ) / bs;
+
+  // accumulate each block in order
+  std::vector<T> partial( num_blocks, init );
+
+  #pragma omp parallel for
+  for ( U b=0; b<num_blocks; b++ ) {
+    auto first = b * bs;
+    auto last = std::min( first + bs, n );
+    auto & acc = partial[b];
+    for ( U i=first; i<last; i++ ) body( i, acc );
+  }
+
+  // now combine the blocks pairwise
+  for ( U stride=1; stride<num_blocks; stride*=2 ) {
+    #pragma omp parallel for
+    for ( U b=0; b<num_blocks-stride; b+=2*stride )
+      partial[b] = op( partial[b], partial[b+stride] );
+  }
+
+  return partial.front();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief A reproducible parallel sum.
+//!
+//! \param [in] n  The number of items to sum.
+//! \param [in] init  The zero value.
+//! \param [in] body  Called as body(i, acc) to add item i into acc.
+//! \return The sum.
+//! \see deterministic_reduce
+////////////////////////////////////////////////////////////////////////////////
+template< typename T, typename U, typename Body >
+T deterministic_sum( U n, const T & init, Body && body )
+{
+  return deterministic_reduce(
+    n, init, std::forward<Body>(body),
+    []( const T & a, const T & b ) { return a + b; }
+  );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief A reproducible parallel maximum.
+//!
+//! \param [in] n  The number of items to search.
+//! \param [in] init  The lowest value.
+//! \param [in] body  Called as body(i, acc) to fold item i into acc.
+//! \return The maximum.
+//! \see deterministic_reduce
+////////////////////////////////////////////////////////////////////////////////
+template< typename T, typename U, typename Body >
+T deterministic_max( U n, const T & init, Body && body )
+{
+  return deterministic_reduce(
+    n, init, std::forward<Body>(body),
+    []( const T & a, const T & b ) { return std::max( a, b ); }
+  );
+}
+
+} // namespace
+} // namespace
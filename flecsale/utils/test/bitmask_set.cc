@@ -0,0 +1,87 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Tests related to the bitmask set.
+////////////////////////////////////////////////////////////////////////////////
+
+// user includes
+#include "flecsale/utils/bitmask_set.h"
+
+// system includes
+#include<cinchtest.h>
+#include<cstdint>
+#include<vector>
+
+// explicitly use some stuff
+using std::vector;
+
+using flecsale::utils::bitmask_set;
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Test inserting, looking up and iterating over values.
+///////////////////////////////////////////////////////////////////////////////
+TEST(bitmask_set, single_word)
+{
+
+  using set_t = bitmask_set<std::uint8_t>;
+
+  set_t tags;
+  ASSERT_TRUE( tags.empty() );
+  ASSERT_EQ( 0u, tags.size() );
+  ASSERT_TRUE( tags.begin() == tags.end() );
+  ASSERT_EQ( 64u, set_t::capacity() );
+
+  ASSERT_TRUE( tags.insert( 5 ) );
+  ASSERT_TRUE( tags.insert( 63 ) );
+  ASSERT_TRUE( tags.insert( 0 ) );
+  ASSERT_FALSE( tags.insert( 5 ) );
+
+  ASSERT_EQ( 3u, tags.size() );
+  ASSERT_EQ( 1u, tags.count( 5 ) );
+  ASSERT_EQ( 0u, tags.count( 6 ) );
+  ASSERT_EQ( 0u, tags.count( 200 ) );
+  ASSERT_EQ( 0, tags.front() );
+
+  // the values come out in order
+  vector<int> vals( tags.begin(), tags.end() );
+  ASSERT_EQ( vector<int>({0, 5, 63}), vals );
+
+  ASSERT_EQ( 1u, tags.erase( 0 ) );
+  ASSERT_EQ( 0u, tags.erase( 0 ) );
+  ASSERT_EQ( 5, tags.front() );
+
+  tags.clear();
+  ASSERT_TRUE( tags.empty() );
+
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Test the set operations across several words.
+///////////////////////////////////////////////////////////////////////////////
+TEST(bitmask_set, multi_word)
+{
+
+  using set_t = bitmask_set<std::size_t, 3>;
+  ASSERT_EQ( 192u, set_t::capacity() );
+
+  set_t a = {1, 64, 130, 191};
+  set_t b = {64, 65, 191};
+
+  ASSERT_EQ( 4u, a.size() );
+  vector<std::size_t> vals( a.begin(), a.end() );
+  ASSERT_EQ( vector<std::size_t>({1, 64, 130, 191}), vals );
+
+  ASSERT_EQ( set_t({64, 191}), a & b );
+  ASSERT_EQ( set_t({1, 64, 65, 130, 191}), a | b );
+  ASSERT_NE( a, b );
+
+  // the empty middle word is skipped
+  set_t c = {3, 150};
+  vals.assign( c.begin(), c.end() );
+  ASSERT_EQ( vector<std::size_t>({3, 150}), vals );
+  ASSERT_TRUE( ( c & b ).empty() );
+
+}
@@ -0,0 +1,109 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Tests related to the tree-hash checksums.
+////////////////////////////////////////////////////////////////////////////////
+
+// user includes
+#include "flecsale/utils/checksum.h"
+
+// system includes
+#include<cinchtest.h>
+#include<vector>
+
+#ifdef _OPENMP
+#  include<omp.h>
+#endif
+
+// explicitly use some stuff
+using std::vector;
+
+using namespace flecsale::utils;
+
+#ifdef HAVE_OPENSSL
+
+//=============================================================================
+//! \brief Test that a single leaf is a plain md5 digest.
+//=============================================================================
+TEST(checksum, single_leaf) {
+
+  vector<double> x( 1000 );
+  for ( std::size_t i=0; i<x.size(); i++ ) x[i] = 0.5*i;
+
+  checksum_t md5;
+  EVP_Digest( x.data(), x.size()*sizeof(double), md5.value.data(), nullptr,
+    EVP_md5(), nullptr );
+
+  ASSERT_EQ( md5, tree_checksum( x.data(), x.size() ) );
+  ASSERT_EQ( 32u, md5.strvalue().size() );
+
+} // TEST
+
+//=============================================================================
+//! \brief Test that the checksum does not depend on the thread count.
+//=============================================================================
+TEST(checksum, threads) {
+
+  vector<double> x( 10*checksum_leaf_size + 123 );
+  for ( std::size_t i=0; i<x.size(); i++ ) x[i] = 1.0 / (i+1);
+
+  auto cs = tree_checksum( x.data(), x.size() );
+
+#ifdef _OPENMP
+  auto num_threads = omp_get_max_threads();
+  for ( int n : {1, 3, 4} ) {
+    omp_set_num_threads( n );
+    ASSERT_EQ( cs, tree_checksum( x.data(), x.size() ) );
+  }
+  omp_set_num_threads( num_threads );
+#endif
+
+  // any change shows up
+  x[ 5*checksum_leaf_size ] += 1.e-12;
+  ASSERT_NE( cs, tree_checksum( x.data(), x.size() ) );
+
+} // TEST
+
+//=============================================================================
+//! \brief Test that strided values hash like a copy of them.
+//=============================================================================
+TEST(checksum, strided) {
+
+  constexpr std::size_t num_comps = 3;
+  std::size_t n = 3*checksum_leaf_size + 7;
+  vector<double> x( num_comps*n );
+  for ( std::size_t i=0; i<x.size(); i++ ) x[i] = i;
+
+  for ( std::size_t d=0; d<num_comps; d++ ) {
+    vector<double> comp( n );
+    for ( std::size_t i=0; i<n; i++ ) comp[i] = x[ num_comps*i + d ];
+    auto cs = tree_checksum( x.data() + d, n, num_comps );
+    ASSERT_EQ( tree_checksum( comp.data(), n ), cs );
+    ASSERT_EQ( 
+      tree_checksum<double>( n, [&]( auto i ) { return comp[i]; } ), cs );
+  }
+
+  // the components differ
+  ASSERT_NE( 
+    tree_checksum( x.data(), n, num_comps ),
+    tree_checksum( x.data() + 1, n, num_comps ) );
+
+} // TEST
+
+//=============================================================================
+//! \brief Test empty arrays.
+//=============================================================================
+TEST(checksum, empty) {
+
+  checksum_t md5;
+  EVP_Digest( nullptr, 0, md5.value.data(), nullptr, EVP_md5(), nullptr );
+
+  ASSERT_EQ( md5, tree_checksum<double>( nullptr, 0 ) );
+  ASSERT_EQ( md5.strvalue(), "d41d8cd98f00b204e9800998ecf8427e" );
+
+} // TEST
+
+#endif // HAVE_OPENSSL
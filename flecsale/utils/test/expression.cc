@@ -0,0 +1,181 @@
+/*~--------------------------------------------------------------------------~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~--------------------------------------------------------------------------~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Tests of the expression compiler.
+////////////////////////////////////////////////////////////////////////////////
+
+// user includes
+#include "flecsale/utils/expression.h"
+
+// system includes
+#include <cinchtest.h>
+#include <cmath>
+#include <vector>
+
+// using declarations
+using flecsale::utils::compiled_expression;
+using flecsale::utils::strided_ptr_t;
+using flecsale::utils::ExceptionRunTime;
+
+using expression_t = compiled_expression<double>;
+
+//=============================================================================
+//! \brief Test the arithmetic, precedence and functions.
+//=============================================================================
+TEST(expression, arithmetic) {
+
+  expression_t expr(
+    "1 + 2*x - y/4, -x^2, 2^3^2, sqrt(y) + pow(x, 3), min(x, y) * max(x, y),"
+    "abs(-y) + exp(0) + log(1), cos(pi)",
+    {"x", "y"} );
+
+  ASSERT_EQ( 2u, expr.num_inputs() );
+  ASSERT_EQ( 7u, expr.num_outputs() );
+
+  auto res = expr( {3, 16} );
+  ASSERT_EQ( 1 + 2*3. - 16/4., res[0] );
+  ASSERT_EQ( -9, res[1] );
+  ASSERT_EQ( 512, res[2] );
+  ASSERT_EQ( 4 + 27, res[3] );
+  ASSERT_EQ( 48, res[4] );
+  ASSERT_EQ( 17, res[5] );
+  ASSERT_EQ( -1, res[6] );
+
+}
+
+//=============================================================================
+//! \brief Test the comparisons, logic and conditionals.
+//=============================================================================
+TEST(expression, conditionals) {
+
+  expression_t expr(
+    "if x < 0 and y < 0 then 0.125 else 1 end,"
+    "if x < -1 then 1 elseif x <= 0 then 2 elseif not (x ~= 1) then 3 "
+    "else 4 end,"
+    "(x >= 0 or y > 0) + (x == y)",
+    {"x", "y"} );
+
+  auto res = expr( {-0.5, -0.5} );
+  ASSERT_EQ( 0.125, res[0] );
+  ASSERT_EQ( 2, res[1] );
+  ASSERT_EQ( 1, res[2] );
+
+  res = expr( {1, -0.5} );
+  ASSERT_EQ( 1, res[0] );
+  ASSERT_EQ( 3, res[1] );
+  ASSERT_EQ( 1, res[2] );
+
+  res = expr( {-2, 1} );
+  ASSERT_EQ( 1, res[1] );
+  ASSERT_EQ( 1, res[2] );
+
+}
+
+//=============================================================================
+//! \brief Test that and/or return their operands, like lua.
+//=============================================================================
+TEST(expression, and_or) {
+
+  expression_t expr(
+    "x < 0 and 0.125 or 1, x and y, x or y, x < 0 and y < 0 and 3 or y or 4",
+    {"x", "y"} );
+
+  auto res = expr( {-2, 5} );
+  ASSERT_EQ( 0.125, res[0] );
+  ASSERT_EQ( 5, res[1] );
+  ASSERT_EQ( -2, res[2] );
+  ASSERT_EQ( 5, res[3] );
+
+  res = expr( {2, 5} );
+  ASSERT_EQ( 1, res[0] );
+  ASSERT_EQ( 5, res[1] );
+  ASSERT_EQ( 2, res[2] );
+  ASSERT_EQ( 5, res[3] );
+
+  res = expr( {0, 0} );
+  ASSERT_EQ( 1, res[0] );
+  ASSERT_EQ( 0, res[1] );
+  ASSERT_EQ( 0, res[2] );
+  ASSERT_EQ( 4, res[3] );
+
+  res = expr( {-2, -5} );
+  ASSERT_EQ( 0.125, res[0] );
+  ASSERT_EQ( -5, res[1] );
+  ASSERT_EQ( -2, res[2] );
+  ASSERT_EQ( 3, res[3] );
+
+}
+
+//=============================================================================
+//! \brief Test that constants are folded and dead code is dropped.
+//=============================================================================
+TEST(expression, folding) {
+
+  expression_t expr(
+    "gamma / (gamma - 1) * 2, if gamma > 1 then x else sqrt(x) end",
+    {"x", "t"}, {{"gamma", 1.4}} );
+
+  ASSERT_EQ( 0u, expr.num_instructions() );
+  auto res = expr( {2, 0} );
+  ASSERT_NEAR( 1.4 / 0.4 * 2, res[0], 1.e-14 );
+  ASSERT_EQ( 2, res[1] );
+
+}
+
+//=============================================================================
+//! \brief Test evaluating strided batches, with a partial last batch.
+//=============================================================================
+TEST(expression, batches) {
+
+  expression_t expr(
+    "if x < 0 then 1 else 0.125 end, x*t, if x < 0 then 1 else 0.1 end",
+    {"x", "y", "t"} );
+
+  std::size_t n = 5*expression_t::batch_size + 3;
+
+  // interleaved coordinates and a broadcast time
+  std::vector<double> coords(2*n);
+  for ( std::size_t i=0; i<n; i++ ) {
+    coords[2*i] = static_cast<double>(i) - n/2.;
+    coords[2*i+1] = -1;
+  }
+  double t = 0.5;
+
+  std::vector<double> d(n), p(n), v(2*n, -1);
+  strided_ptr_t<const double> in[] =
+    { {&coords[0], 2}, {&coords[1], 2}, {&t, 0} };
+  strided_ptr_t<double> out[] = { {d.data(), 1}, {&v[0], 2}, {p.data(), 1} };
+  expr.evaluate( n, in, out );
+
+  for ( std::size_t i=0; i<n; i++ ) {
+    auto x = coords[2*i];
+    ASSERT_EQ( x < 0 ? 1 : 0.125, d[i] );
+    ASSERT_EQ( x < 0 ? 1 : 0.1, p[i] );
+    ASSERT_EQ( x*t, v[2*i] );
+    ASSERT_EQ( -1, v[2*i+1] );
+  }
+
+}
+
+#ifdef ENABLE_EXCEPTIONS
+
+//=============================================================================
+//! \brief Test that bad expressions are rejected.
+//=============================================================================
+TEST(expression, errors) {
+
+  std::vector<std::string> vars = {"x"};
+  ASSERT_THROW( expression_t( "x +", vars ), ExceptionRunTime );
+  ASSERT_THROW( expression_t( "y", vars ), ExceptionRunTime );
+  ASSERT_THROW( expression_t( "foo(x)", vars ), ExceptionRunTime );
+  ASSERT_THROW( expression_t( "pow(x)", vars ), ExceptionRunTime );
+  ASSERT_THROW( expression_t( "(x", vars ), ExceptionRunTime );
+  ASSERT_THROW( expression_t( "if x then 1 end", vars ), ExceptionRunTime );
+  ASSERT_THROW( expression_t( "x x", vars ), ExceptionRunTime );
+
+}
+
+#endif // ENABLE_EXCEPTIONS
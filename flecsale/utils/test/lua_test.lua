@@ -10,9 +10,30 @@ function split(a, b)
     return a,b
 end
 
+function scale(v, a)
+    local w = {}
+    for i = 1, #v do
+        w[i] = a*v[i]
+    end
+    return w, {v, w}
+end
+
 mytable = {}
 mytable[3] = "hi"
 mytable["there"] = 4.5
 function mytable.func()
     return 6;
 end
+
+-- a pointwise initial condition and boundary predicate
+function ics(x, y, t)
+    if x < 0 then
+        return 1.0, {0, 0}, 1.0
+    else
+        return 0.125, {0, 0}, 0.1
+    end
+end
+
+function bc(x, y, t)
+    return x == 0 or x == 1
+end
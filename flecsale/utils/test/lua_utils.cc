@@ -16,12 +16,14 @@
 #include<cinchtest.h>
 
 // system includes
+#include<algorithm>
 #include<array>
 #include<iostream>
 
 
 // explicitly use some stuff
 using namespace flecsale::utils;
+using flecsale::common::real_t;
 using flecsale::common::test_tolerance;
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -65,6 +67,13 @@ TEST(lua_utils, embedded)
   auto tup1 = state["split"]( 1, 2.5 ).as<int,double>();
   ASSERT_EQ( std::forward_as_tuple(1,2.5), tup1 );
 
+  // pass and return whole tables
+  auto tup2 = state["scale"]( std::vector<double>{1, 2}, 2. )
+    .as< std::vector<double>, std::vector<std::vector<double>> >();
+  ASSERT_EQ( std::vector<double>({2, 4}), std::get<0>(tup2) );
+  ASSERT_EQ( 2u, std::get<1>(tup2).size() );
+  ASSERT_EQ( std::vector<double>({1, 2}), std::get<1>(tup2)[0] );
+
   // access a global variable
   ASSERT_EQ( 4, state["foo"].as<int>() );
 
@@ -73,6 +82,11 @@ TEST(lua_utils, embedded)
   ASSERT_EQ( "hi", tab1[3].as<std::string>() );
   ASSERT_EQ( 4.5, tab1["there"].as<double>() );
   ASSERT_EQ( 6, tab1["func"]().as<int>() );
+  ASSERT_EQ( LUA_TTABLE, tab1.type() );
+  ASSERT_EQ( LUA_TNUMBER, tab1["there"].type() );
+  auto keys = tab1.keys();
+  std::sort( keys.begin(), keys.end() );
+  ASSERT_EQ( std::vector<std::string>({"func", "there"}), keys );
 
   // access arrays
   auto arr1 = state["bar"];  
@@ -88,4 +102,61 @@ TEST(lua_utils, embedded)
   
 } // TEST
 
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Test that the fast call path matches the regular one on a
+//!        per-cell initial condition and a per-face boundary predicate.
+///////////////////////////////////////////////////////////////////////////////
+TEST(lua_utils, fast_call) 
+{
+
+  // setup the lua interpreter
+  auto state = lua_t();
+  state.loadfile( "lua_test.lua" );
+
+  // resolve the functions once
+  lua_function_t ics( state["ics"] );
+  lua_function_t bc( state["bc"] );
+  lua_function_t sum( state["sum"] );
+
+  ASSERT_EQ( 3, sum.call<int>( 1, 2 ) );
+  ASSERT_TRUE( bc.call<bool>( 1., 0.5, 0. ) );
+  ASSERT_FALSE( bc.call<bool>( 0.5, 0.5, 0. ) );
+
+  constexpr int num_points = 100000;
+  auto x_at = []( int i ) { return 2. * i / num_points - 1; };
+
+  // the regular path
+  real_t d_sum = 0, p_sum = 0;
+  int num_bc = 0;
+  for ( int i=0; i<num_points; i++ ) {
+    auto x = x_at(i);
+    real_t d, p;
+    std::array<real_t,2> v;
+    std::tie( d, v, p ) = 
+      state["ics"]( x, 0., 0. ).as< real_t, std::array<real_t,2>, real_t >();
+    d_sum += d;
+    p_sum += p;
+    num_bc += state["bc"]( x+1, 0., 0. ).as<bool>();
+  }
+
+  // the fast path
+  real_t d_sum_fast = 0, p_sum_fast = 0;
+  int num_bc_fast = 0;
+  for ( int i=0; i<num_points; i++ ) {
+    auto x = x_at(i);
+    real_t d, p;
+    std::array<real_t,2> v;
+    ics.call_into( std::tie( d, v, p ), x, 0., 0. );
+    d_sum_fast += d;
+    p_sum_fast += p;
+    num_bc_fast += bc.call<bool>( x+1, 0., 0. );
+  }
+
+  ASSERT_EQ( d_sum, d_sum_fast );
+  ASSERT_EQ( p_sum, p_sum_fast );
+  ASSERT_EQ( num_bc, num_bc_fast );
+  ASSERT_EQ( 2, num_bc );
+
+} // TEST
+
 #endif // HAVE_LUA
@@ -0,0 +1,73 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Tests related to the parallel radix sort and scans.
+////////////////////////////////////////////////////////////////////////////////
+
+// user includes
+#include "flecsale/utils/radix_sort.h"
+
+// system includes
+#include<algorithm>
+#include<cinchtest.h>
+#include<cstdint>
+#include<numeric>
+#include<random>
+#include<vector>
+
+// explicitly use some stuff
+using std::vector;
+
+using namespace flecsale::utils;
+
+//=============================================================================
+//! \brief Test the sort against a stable sort, with lots of equal keys.
+//=============================================================================
+TEST(radix_sort, stable) {
+
+  std::mt19937_64 gen(1234);
+  std::uniform_int_distribution<std::uint64_t> small( 0, 1000 );
+
+  auto n = 5*parallel_block_size + 17;
+  vector<std::uint64_t> keys( n );
+  for ( auto & k : keys ) k = small(gen) << 32 | small(gen);
+
+  vector<std::size_t> order( n );
+  std::iota( order.begin(), order.end(), 0 );
+
+  auto expected = order;
+  std::stable_sort( expected.begin(), expected.end(),
+    [&]( auto a, auto b ) { return keys[a] < keys[b]; } );
+
+  auto sorted_keys = keys;
+  radix_sort_by_key( sorted_keys, order );
+
+  ASSERT_EQ( expected, order );
+  for ( std::size_t i=0; i<n; i++ ) ASSERT_EQ( keys[order[i]], sorted_keys[i] );
+
+}
+
+//=============================================================================
+//! \brief Test the scans.
+//=============================================================================
+TEST(radix_sort, scans) {
+
+  auto n = 3*parallel_block_size + 5;
+  vector<std::size_t> offsets( n+1 );
+  for ( std::size_t i=0; i<n; i++ ) offsets[i+1] = i % 3;
+
+  auto expected = offsets;
+  std::partial_sum( expected.begin(), expected.end(), expected.begin() );
+
+  counts_to_offsets( offsets );
+  ASSERT_EQ( expected, offsets );
+
+  auto selected = select_indices( n, []( auto i ) { return i % 7 == 2; } );
+  ASSERT_EQ( (n + 4) / 7, selected.size() );
+  for ( std::size_t i=0; i<selected.size(); i++ )
+    ASSERT_EQ( 7*i + 2, selected[i] );
+
+}
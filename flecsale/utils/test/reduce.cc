@@ -0,0 +1,133 @@
+/*~--------------------------------------------------------------------------~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~--------------------------------------------------------------------------~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+////////////////////////////////////////////////////////////////////////////////
+
+// user includes
+#include "flecsale/utils/reduce.h"
+
+// system includes
+#include <cinchtest.h>
+#include <cmath>
+#include <vector>
+
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
+
+// using declarations
+using flecsale::utils::deterministic_reduce;
+using flecsale::utils::deterministic_sum;
+using flecsale::utils::deterministic_max;
+using flecsale::utils::reduction_block_size;
+
+//=============================================================================
+//! \brief Test that the sum matches a serial blocked, pairwise sum exactly.
+//=============================================================================
+TEST(reduce, sum) {
+
+  std::size_t n = 10*reduction_block_size + 17;
+  std::vector<double> x(n);
+  for ( std::size_t i=0; i<n; i++ ) 
+    x[i] = std::sin( static_cast<double>(i) ) * std::pow( 10., i % 13 );
+
+  auto sum = deterministic_sum( n, 0.,
+    [&]( auto i, auto & acc ) { acc += x[i]; } );
+
+  // the serial answer
+  auto num_blocks = ( n + reduction_block_size - 1 ) / reduction_block_size;
+  std::vector<double> partial( num_blocks, 0. );
+  for ( std::size_t i=0; i<n; i++ )
+    partial[ i / reduction_block_size ] += x[i];
+  for ( std::size_t stride=1; stride<num_blocks; stride*=2 )
+    for ( std::size_t b=0; b+stride<num_blocks; b+=2*stride )
+      partial[b] += partial[b+stride];
+
+  ASSERT_EQ( partial[0], sum );
+
+  // a sum that fits in one block is just the serial sum
+  double serial = 0;
+  for ( std::size_t i=0; i<reduction_block_size; i++ ) serial += x[i];
+  auto block_sum = deterministic_sum( reduction_block_size, 0.,
+    [&]( auto i, auto & acc ) { acc += x[i]; } );
+  ASSERT_EQ( serial, block_sum );
+
+  // an empty range returns the initial value
+  ASSERT_EQ( 1., deterministic_sum( 0, 1., 
+    [&]( auto i, auto & acc ) { acc += x[i]; } ) );
+
+}
+
+//=============================================================================
+//! \brief Test the maximum and a reduction over several quantities.
+//=============================================================================
+TEST(reduce, multiple) {
+
+  int n = 5000;
+
+  auto mx = deterministic_max( n, 0,
+    []( auto i, auto & acc ) { acc = std::max( acc, (i*7919) % 4999 ); } );
+  ASSERT_EQ( 4998, mx );
+
+  struct sums_t { long count; long total; };
+  auto res = deterministic_reduce( n, sums_t{0, 0},
+    []( auto i, auto & acc ) { acc.count++; acc.total += i; },
+    []( const auto & a, const auto & b ) 
+    { return sums_t{ a.count + b.count, a.total + b.total }; } );
+  ASSERT_EQ( n, res.count );
+  ASSERT_EQ( static_cast<long>(n)*(n-1)/2, res.total );
+
+}
+
+//=============================================================================
+//! \brief Test that the results do not depend on the thread count.
+//=============================================================================
+TEST(reduce, threads) {
+
+  std::size_t n = 37*reduction_block_size + 5;
+  std::vector<double> x(n);
+  for ( std::size_t i=0; i<n; i++ ) 
+    x[i] = std::sin( static_cast<double>(i) ) * std::pow( 10., i % 17 );
+
+  auto sum = [&]() {
+    return deterministic_sum( n, 0.,
+      [&]( auto i, auto & acc ) { acc += x[i]; } );
+  };
+
+  auto max = [&]() {
+    return deterministic_max( n, 0.,
+      [&]( auto i, auto & acc ) { acc = std::max( acc, x[i] ); } );
+  };
+
+  struct moments_t { double sum; double sum_sq; };
+  auto moments = [&]() {
+    return deterministic_reduce( n, moments_t{0, 0},
+      [&]( auto i, auto & acc ) { acc.sum += x[i]; acc.sum_sq += x[i]*x[i]; },
+      []( const auto & a, const auto & b ) 
+      { return moments_t{ a.sum + b.sum, a.sum_sq + b.sum_sq }; } );
+  };
+
+  auto expected_sum = sum();
+  auto expected_max = max();
+  auto expected_moments = moments();
+
+#ifdef _OPENMP
+  auto num_threads = omp_get_max_threads();
+  for ( int t : { 1, 2, 3, std::max( 4, omp_get_num_procs() ) } ) {
+    omp_set_num_threads( t );
+    // bitwise equal, not just close
+    ASSERT_EQ( expected_sum, sum() );
+    ASSERT_EQ( expected_max, max() );
+    auto m = moments();
+    ASSERT_EQ( expected_moments.sum, m.sum );
+    ASSERT_EQ( expected_moments.sum_sq, m.sum_sq );
+  }
+  omp_set_num_threads( num_threads );
+#endif
+
+  ASSERT_EQ( expected_sum, expected_moments.sum );
+
+}
@@ -187,6 +187,10 @@ def run(expectedFileName, actualFileName, options):
             print ( "=" * 16 )
             print 
 
+        ## only compare the leading lines if asked
+        if options.lines > 0 and lineNum > options.lines:
+            break
+
         ## check that the files haven't ended,
         #  or that they ended at the same time
         if expLine == "":
@@ -233,6 +237,10 @@ if __name__ == '__main__':
                       action="store", type="float", dest="abs_tol", default=-1.,
                       help="Absolute error when comparing doubles.")
 
+    parser.add_option("-l", "--lines",
+                      action="store", type="int", dest="lines", default=0,
+                      help="Only compare the first LINES lines.")
+
     (options, args) = parser.parse_args()
 
     # print usage